@@ -7,19 +7,18 @@
  */
 
 #include "ast.h"
+#include "symtable.h"
 
-/* External line number from lexer for error tracking */
-extern int line_num;
+/* Current source line for new nodes (set by the scanner) */
+THREAD_LOCAL int ast_line_num = 1;
 
 /* HELPER FUNCTION: Allocate and initialize a new AST node */
 static ASTNode* create_ast_node(NodeType type) {
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    if (!node) {
-        fprintf(stderr, "Fatal Error: Memory allocation failed for AST node\n");
-        exit(1);
-    }
+    ASTNode* node = (ASTNode*)safe_malloc(sizeof(ASTNode), "AST node");
     node->type = type;
-    node->line_number = line_num;
+    node->line_number = ast_line_num;
+    node->name_hash = 0;
+    node->symbol = NULL;
     return node;
 }
 
@@ -41,15 +40,24 @@ ASTNode* create_statement_list_node(ASTNode* stmt, ASTNode* next) {
 /* Create a variable declaration node: int x; */
 ASTNode* create_declaration_node(char* var_name) {
     ASTNode* node = create_ast_node(NODE_DECLARATION);
-    node->data.str_value = strdup(var_name);  /* Copy the string */
+    node->data.str_value = safe_strdup(var_name, "AST node");  /* Copy the string */
     return node;
 }
 
 /* Create an assignment node: x = expr; */
 ASTNode* create_assignment_node(char* var_name, ASTNode* expr) {
     ASTNode* node = create_ast_node(NODE_ASSIGNMENT);
-    node->data.assignment.var_name = strdup(var_name);
+    node->data.assignment.var_name = safe_strdup(var_name, "AST node");
+    node->data.assignment.index = NULL;
     node->data.assignment.expr = expr;
+    node->name_hash = hash(var_name);
+    return node;
+}
+
+/* Create an array element assignment node: arr[index] = expr; */
+ASTNode* create_array_assignment_node(char* array_name, ASTNode* index, ASTNode* expr) {
+    ASTNode* node = create_assignment_node(array_name, expr);
+    node->data.assignment.index = index;
     return node;
 }
 
@@ -98,7 +106,7 @@ ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_
 /* Create a condition node: expr relop expr (NEW FEATURE) */
 ASTNode* create_condition_node(ASTNode* left, char* op, ASTNode* right) {
     ASTNode* node = create_ast_node(NODE_CONDITION);
-    node->data.binary_op.operator = strdup(op);
+    node->data.binary_op.operator = safe_strdup(op, "AST node");
     node->data.binary_op.left = left;
     node->data.binary_op.right = right;
     return node;
@@ -107,7 +115,7 @@ ASTNode* create_condition_node(ASTNode* left, char* op, ASTNode* right) {
 /* Create a binary operation node: left + right */
 ASTNode* create_binary_op_node(char* op, ASTNode* left, ASTNode* right) {
     ASTNode* node = create_ast_node(NODE_BINARY_OP);
-    node->data.binary_op.operator = strdup(op);
+    node->data.binary_op.operator = safe_strdup(op, "AST node");
     node->data.binary_op.left = left;
     node->data.binary_op.right = right;
     return node;
@@ -116,7 +124,8 @@ ASTNode* create_binary_op_node(char* op, ASTNode* left, ASTNode* right) {
 /* Create an identifier node (variable reference) */
 ASTNode* create_id_node(char* name) {
     ASTNode* node = create_ast_node(NODE_IDENTIFIER);
-    node->data.str_value = strdup(name);
+    node->data.str_value = safe_strdup(name, "AST node");
+    node->name_hash = hash(name);
     return node;
 }
 
@@ -130,7 +139,7 @@ ASTNode* create_num_node(int value) {
 /* Create an array declaration node: int arr[10]; (ARRAY FEATURE) */
 ASTNode* create_array_declaration_node(char* var_name, int size) {
     ASTNode* node = create_ast_node(NODE_ARRAY_DECLARATION);
-    node->data.array_decl.var_name = strdup(var_name);
+    node->data.array_decl.var_name = safe_strdup(var_name, "AST node");
     node->data.array_decl.size = size;
     return node;
 }
@@ -138,16 +147,17 @@ ASTNode* create_array_declaration_node(char* var_name, int size) {
 /* Create an array access node: arr[5] */
 ASTNode* create_array_access_node(char* array_name, ASTNode* index) {
     ASTNode* node = create_ast_node(NODE_ARRAY_ACCESS);
-    node->data.array_access.array_name = strdup(array_name);
+    node->data.array_access.array_name = safe_strdup(array_name, "AST node");
     node->data.array_access.index = index;
+    node->name_hash = hash(array_name);
     return node;
 }
 
 /* Create a function declaration node: int foo(params); */
 ASTNode* create_function_decl_node(char* return_type, char* func_name, ASTNode* params) {
     ASTNode* node = create_ast_node(NODE_FUNCTION_DECL);
-    node->data.function.return_type = strdup(return_type);
-    node->data.function.func_name = strdup(func_name);
+    node->data.function.return_type = safe_strdup(return_type, "AST node");
+    node->data.function.func_name = safe_strdup(func_name, "AST node");
     node->data.function.params = params;
     node->data.function.body = NULL;
     return node;
@@ -156,8 +166,8 @@ ASTNode* create_function_decl_node(char* return_type, char* func_name, ASTNode*
 /* Create a function definition node: int foo(params) { body } */
 ASTNode* create_function_def_node(char* return_type, char* func_name, ASTNode* params, ASTNode* body) {
     ASTNode* node = create_ast_node(NODE_FUNCTION_DEF);
-    node->data.function.return_type = strdup(return_type);
-    node->data.function.func_name = strdup(func_name);
+    node->data.function.return_type = safe_strdup(return_type, "AST node");
+    node->data.function.func_name = safe_strdup(func_name, "AST node");
     node->data.function.params = params;
     node->data.function.body = body;
     return node;
@@ -166,8 +176,9 @@ ASTNode* create_function_def_node(char* return_type, char* func_name, ASTNode* p
 /* Create a function call node: foo(args) */
 ASTNode* create_function_call_node(char* func_name, ASTNode* args) {
     ASTNode* node = create_ast_node(NODE_FUNCTION_CALL);
-    node->data.func_call.func_name = strdup(func_name);
+    node->data.func_call.func_name = safe_strdup(func_name, "AST node");
     node->data.func_call.args = args;
+    node->name_hash = hash(func_name);
     return node;
 }
 
@@ -181,8 +192,8 @@ ASTNode* create_return_node(ASTNode* expr) {
 /* Create a parameter node: int x */
 ASTNode* create_param_node(char* type, char* name) {
     ASTNode* node = create_ast_node(NODE_PARAM);
-    node->data.param.type = strdup(type);
-    node->data.param.name = strdup(name);
+    node->data.param.type = safe_strdup(type, "AST node");
+    node->data.param.name = safe_strdup(name, "AST node");
     return node;
 }
 
@@ -259,8 +270,14 @@ void print_ast(ASTNode* node, int indent) {
             break;
 
         case NODE_ASSIGNMENT:
-            printf("ASSIGNMENT: %s = (line %d)\n",
-                   node->data.assignment.var_name, node->line_number);
+            if (node->data.assignment.index) {
+                printf("ASSIGNMENT: %s[] = (line %d)\n",
+                       node->data.assignment.var_name, node->line_number);
+                print_ast(node->data.assignment.index, indent + 1);
+            } else {
+                printf("ASSIGNMENT: %s = (line %d)\n",
+                       node->data.assignment.var_name, node->line_number);
+            }
             print_ast(node->data.assignment.expr, indent + 1);
             break;
 
@@ -433,6 +450,7 @@ void free_ast(ASTNode* node) {
 
         case NODE_ASSIGNMENT:
             free(node->data.assignment.var_name);
+            free_ast(node->data.assignment.index);
             free_ast(node->data.assignment.expr);
             break;
 
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "diagnostics.h"
 
 /* AST Node Types - Each represents a different language construct */
 typedef enum {
@@ -39,8 +40,9 @@ typedef enum {
     NODE_ARG_LIST          /* List of arguments in function call */
 } NodeType;
 
-/* Forward declaration */
+/* Forward declarations */
 struct ASTNode;
+struct Symbol;     /* Defined in symtable.h */
 
 /* AST Node Structure - Represents one node in the syntax tree */
 typedef struct ASTNode {
@@ -64,6 +66,7 @@ typedef struct ASTNode {
         /* For assignments */
         struct {
             char* var_name;
+            struct ASTNode* index;  /* Element index for arr[index] = expr (NULL for variables) */
             struct ASTNode* expr;
         } assignment;
 
@@ -157,10 +160,20 @@ typedef struct ASTNode {
     /* Source location for error reporting */
     int line_number;
 
+    /* Name resolution for identifiers, assignments, array accesses and calls.
+     * The hash is computed when the node is built; the symbol is resolved once
+     * by semantic analysis and read directly by later phases. */
+    unsigned int name_hash;       /* Hash of the referenced name (0 for unnamed nodes) */
+    struct Symbol* symbol;        /* Resolved symbol (NULL until semantic analysis) */
+
 } ASTNode;
 
 /* AST CONSTRUCTION FUNCTIONS - Create nodes for different language constructs */
 
+/* Source line stamped on new nodes - kept current by the scanner
+ * (per thread, so parses on different threads do not interfere) */
+extern THREAD_LOCAL int ast_line_num;
+
 /* Create a program node (root of AST) */
 ASTNode* create_program_node(ASTNode* statements);
 
@@ -173,6 +186,9 @@ ASTNode* create_declaration_node(char* var_name);
 /* Create an assignment node: x = expr; */
 ASTNode* create_assignment_node(char* var_name, ASTNode* expr);
 
+/* Create an array element assignment node: arr[index] = expr; */
+ASTNode* create_array_assignment_node(char* array_name, ASTNode* index, ASTNode* expr);
+
 /* Create a print node: print(expr); */
 ASTNode* create_print_node(ASTNode* expr);
 
@@ -0,0 +1,344 @@
+/*
+ * BENCH.C - Compile-Time Benchmark Driver
+ * CST-405 Compiler Project
+ *
+ * Generates workloads of growing size (see workload.h), compiles each one
+ * with the compiler under test and reports compile throughput, the time of
+ * every phase and the peak RSS, taken from the compiler's own
+ * --time-report=json output. Each compilation runs in a fresh process so
+ * the peak RSS belongs to that input alone. Linux/POSIX only.
+ *
+ * Usage: bench [options]
+ *        bench gen <shape> <scale> [seed]    (write one workload to stdout)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "workload.h"
+
+#define MAX_SIZES 16
+
+/* Phases shown in the table (names as printed by --time-report) */
+static const char* phase_names[] = {
+    "parse", "semantic", "tac generation", "optimization", "security", "code generation"
+};
+static const char* phase_labels[] = {
+    "parse", "sem", "tac", "opt", "sec", "cgen"
+};
+#define PHASE_COLUMNS 6
+
+/* Benchmark settings */
+typedef struct {
+    const char* compiler;       /* Compiler under test */
+    const char* flags;          /* Extra compiler flags */
+    int shapes[SHAPE_COUNT];    /* Shapes to run */
+    int shape_count;
+    long sizes[MAX_SIZES];      /* Scales to run for every shape */
+    int size_count;
+    int repeat;                 /* Runs per size (fastest is reported) */
+    double max_ms;              /* Stop growing a shape after a run this slow */
+    int json;                   /* One JSON line per measurement */
+    unsigned seed;              /* Generator seed */
+} BenchConfig;
+
+/* One measurement */
+typedef struct {
+    int ok;                     /* Compilation succeeded */
+    double total_ms;            /* Compiler-reported total wall time */
+    double phase_ms[PHASE_COLUMNS];
+    long peak_rss_kb;
+    char error[160];            /* Error message on failure */
+} BenchResult;
+
+/* Helper: number following "key": after position from (0 if missing) */
+static double json_number(const char* from, const char* key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* p = from ? strstr(from, pattern) : NULL;
+    return p ? atof(p + strlen(pattern)) : 0.0;
+}
+
+/* Helper: parse the compiler's --time-report=json line */
+static void parse_report(const char* json, BenchResult* result) {
+    for (int i = 0; i < PHASE_COLUMNS; i++) {
+        char pattern[64];
+        snprintf(pattern, sizeof(pattern), "{\"name\": \"%s\"", phase_names[i]);
+        result->phase_ms[i] = json_number(strstr(json, pattern), "wall_ms");
+    }
+
+    const char* total = strstr(json, "\"total\": {");
+    result->total_ms = json_number(total, "wall_ms");
+    result->peak_rss_kb = (long)json_number(total, "peak_rss_kb");
+}
+
+/* Helper: compile one file and collect its report */
+static void run_compiler(const BenchConfig* config, const char* dir, const char* source,
+                         BenchResult* result) {
+    char command[2048];
+    snprintf(command, sizeof(command), "%s %s -o %s -q --time-report=json %s 2>%s/stderr.txt",
+             config->compiler, source, dir, config->flags, dir);
+
+    memset(result, 0, sizeof(*result));
+
+    FILE* pipe = popen(command, "r");
+    if (!pipe) {
+        snprintf(result->error, sizeof(result->error), "cannot run %s", config->compiler);
+        return;
+    }
+
+    static char report[65536];
+    size_t length = fread(report, 1, sizeof(report) - 1, pipe);
+    report[length] = '\0';
+    int status = pclose(pipe);
+
+    if (status == 0 && strstr(report, "\"total\"")) {
+        result->ok = 1;
+        parse_report(report, result);
+        return;
+    }
+
+    /* Keep the most telling line of the compiler's error output: the
+     * message of a boxed error report, else the first line with text */
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/stderr.txt", dir);
+    FILE* errors = fopen(path, "r");
+    if (errors) {
+        char text[256];
+        while (fgets(text, sizeof(text), errors)) {
+            const char* message = strstr(text, "Message:");
+            const char* start = message ? message + strlen("Message:") : text;
+            start += strspn(start, " |=+-\t");
+            if (!*start || *start == '\n') continue;
+            if (message || !result->error[0]) {
+                snprintf(result->error, sizeof(result->error), "%s", start);
+            }
+            if (message) break;
+        }
+        fclose(errors);
+    }
+    result->error[strcspn(result->error, "|\n")] = '\0';
+    for (size_t n = strlen(result->error); n > 0 && result->error[n - 1] == ' '; n--) {
+        result->error[n - 1] = '\0';
+    }
+    if (!result->error[0]) {
+        snprintf(result->error, sizeof(result->error), "exit status %d",
+                 WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+}
+
+/* Helper: print the table header */
+static void print_header(void) {
+    printf("%-10s %7s %8s %8s %10s %10s", "shape", "scale", "lines", "KiB", "total ms", "lines/s");
+    for (int i = 0; i < PHASE_COLUMNS; i++) {
+        printf(" %8s", phase_labels[i]);
+    }
+    printf(" %9s\n", "peak KiB");
+}
+
+/* Helper: report one measurement */
+static void print_result(const BenchConfig* config, const char* shape, long scale,
+                         long lines, long bytes, const BenchResult* result) {
+    double lines_per_sec = result->total_ms > 0 ? lines * 1000.0 / result->total_ms : 0.0;
+
+    if (config->json) {
+        printf("{\"shape\": \"%s\", \"scale\": %ld, \"lines\": %ld, \"bytes\": %ld, \"ok\": %s",
+               shape, scale, lines, bytes, result->ok ? "true" : "false");
+        if (result->ok) {
+            printf(", \"total_ms\": %.3f, \"lines_per_sec\": %.0f, \"peak_rss_kb\": %ld",
+                   result->total_ms, lines_per_sec, result->peak_rss_kb);
+            for (int i = 0; i < PHASE_COLUMNS; i++) {
+                printf(", \"%s_ms\": %.3f", phase_labels[i], result->phase_ms[i]);
+            }
+        } else {
+            printf(", \"error\": \"");
+            for (const char* p = result->error; *p; p++) {
+                if (*p == '"' || *p == '\\') putchar('\\');
+                putchar(*p);
+            }
+            printf("\"");
+        }
+        printf("}\n");
+        fflush(stdout);
+        return;
+    }
+
+    printf("%-10s %7ld %8ld %8ld", shape, scale, lines, bytes / 1024);
+    if (result->ok) {
+        printf(" %10.2f %10.0f", result->total_ms, lines_per_sec);
+        for (int i = 0; i < PHASE_COLUMNS; i++) {
+            printf(" %8.2f", result->phase_ms[i]);
+        }
+        printf(" %9ld\n", result->peak_rss_kb);
+    } else {
+        printf("  FAILED: %s\n", result->error);
+    }
+    fflush(stdout);
+}
+
+/* Run every shape at every size. Returns 1 if the harness itself failed. */
+static int run_benchmarks(const BenchConfig* config) {
+    char dir[] = "/tmp/cst405-bench-XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "Error: Cannot create a temporary directory\n");
+        return 1;
+    }
+
+    if (!config->json) {
+        printf("Compiler: %s %s\n", config->compiler, config->flags);
+        printf("Times are wall-clock ms reported by the compiler (fastest of %d run(s))\n\n",
+               config->repeat);
+        print_header();
+    }
+
+    int failures = 0;
+    int status = 0;
+    for (int s = 0; s < config->shape_count && status == 0; s++) {
+        WorkloadShape shape = (WorkloadShape)config->shapes[s];
+        const char* name = workload_shape_name(shape);
+
+        for (int z = 0; z < config->size_count; z++) {
+            char source[1100];
+            snprintf(source, sizeof(source), "%s/%s.c", dir, name);
+
+            FILE* out = fopen(source, "w");
+            if (!out) {
+                fprintf(stderr, "Error: Cannot write %s\n", source);
+                status = 1;
+                break;
+            }
+            long lines = generate_workload(out, shape, config->sizes[z], config->seed);
+            long bytes = ftell(out);
+            fclose(out);
+
+            BenchResult best, run;
+            memset(&best, 0, sizeof(best));
+            for (int r = 0; r < config->repeat; r++) {
+                run_compiler(config, dir, source, &run);
+                if (!run.ok) {
+                    best = run;
+                    break;
+                }
+                if (!best.ok || run.total_ms < best.total_ms) best = run;
+            }
+
+            print_result(config, name, config->sizes[z], lines, bytes, &best);
+            if (!best.ok) failures++;
+
+            /* Larger sizes would only take longer */
+            if (!best.ok || best.total_ms > config->max_ms) break;
+        }
+    }
+
+    char cleanup[1100];
+    snprintf(cleanup, sizeof(cleanup), "rm -rf %s", dir);
+    if (system(cleanup) != 0) {
+        fprintf(stderr, "Warning: Cannot remove %s\n", dir);
+    }
+
+    /* Failed compilations are results (they show where the compiler stops
+     * scaling), not harness errors */
+    if (failures > 0 && !config->json) {
+        printf("\n%d measurement(s) failed\n", failures);
+    }
+    return status;
+}
+
+/* Helper: parse a comma-separated list of sizes */
+static int parse_sizes(BenchConfig* config, const char* list) {
+    config->size_count = 0;
+    char* copy = strdup(list);
+    for (char* item = strtok(copy, ","); item && config->size_count < MAX_SIZES;
+         item = strtok(NULL, ",")) {
+        config->sizes[config->size_count++] = atol(item);
+    }
+    free(copy);
+    return config->size_count > 0;
+}
+
+/* Helper: parse a comma-separated list of shapes */
+static int parse_shapes(BenchConfig* config, const char* list) {
+    config->shape_count = 0;
+    char* copy = strdup(list);
+    for (char* item = strtok(copy, ","); item; item = strtok(NULL, ",")) {
+        int shape = find_workload_shape(item);
+        if (shape < 0) {
+            fprintf(stderr, "Error: Unknown shape '%s'\n", item);
+            free(copy);
+            return 0;
+        }
+        if (config->shape_count < SHAPE_COUNT) {
+            config->shapes[config->shape_count++] = shape;
+        }
+    }
+    free(copy);
+    return config->shape_count > 0;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "       %s gen <shape> <scale> [seed]\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --compiler <path>  Compiler to measure (default ./compiler)\n");
+    fprintf(stderr, "  --flags \"<f>\"      Extra compiler flags, e.g. \"-j 4\"\n");
+    fprintf(stderr, "  --shapes <a,b>     Shapes: functions,nesting,straight,arrays,globals (default all)\n");
+    fprintf(stderr, "  --sizes <n,n>      Scales to run (default 10,100,1000,10000)\n");
+    fprintf(stderr, "  --repeat <n>       Runs per size, fastest reported (default 3)\n");
+    fprintf(stderr, "  --max-ms <ms>      Skip larger sizes after a run slower than this (default 30000)\n");
+    fprintf(stderr, "  --seed <n>         Generator seed (default 405)\n");
+    fprintf(stderr, "  --json             One JSON object per measurement\n");
+}
+
+int main(int argc, char* argv[]) {
+    /* Generator mode */
+    if (argc >= 4 && strcmp(argv[1], "gen") == 0) {
+        int shape = find_workload_shape(argv[2]);
+        if (shape < 0) {
+            fprintf(stderr, "Error: Unknown shape '%s'\n", argv[2]);
+            return 1;
+        }
+        unsigned seed = argc > 4 ? (unsigned)strtoul(argv[4], NULL, 10) : 405;
+        generate_workload(stdout, (WorkloadShape)shape, atol(argv[3]), seed);
+        return 0;
+    }
+
+    BenchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.compiler = "./compiler";
+    config.flags = "";
+    config.repeat = 3;
+    config.max_ms = 30000.0;
+    config.seed = 405;
+    parse_sizes(&config, "10,100,1000,10000");
+    for (int i = 0; i < SHAPE_COUNT; i++) {
+        config.shapes[config.shape_count++] = i;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compiler") == 0 && i + 1 < argc) {
+            config.compiler = argv[++i];
+        } else if (strcmp(argv[i], "--flags") == 0 && i + 1 < argc) {
+            config.flags = argv[++i];
+        } else if (strcmp(argv[i], "--shapes") == 0 && i + 1 < argc) {
+            if (!parse_shapes(&config, argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            if (!parse_sizes(&config, argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            config.repeat = atoi(argv[++i]);
+            if (config.repeat < 1) config.repeat = 1;
+        } else if (strcmp(argv[i], "--max-ms") == 0 && i + 1 < argc) {
+            config.max_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            config.json = 1;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    return run_benchmarks(&config);
+}
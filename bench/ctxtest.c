@@ -0,0 +1,301 @@
+/*
+ * CTXTEST.C - Compiler Context Independence Test
+ * CST-405 Compiler Project
+ *
+ * Checks that compilations in different CompilerContexts do not leak into
+ * each other or into the caller through the per-thread diagnostics state
+ * and parser line number (see context.h). A set of cases - a clean
+ * program, a program that draws a warning (shown, hidden, or made an
+ * error by --Werror), one that draws an error, one with semantic errors,
+ * MIPS and -j 2 builds - is compiled alone in fresh contexts for
+ * reference. Then:
+ *   interleaved - one context per case, compiled in turn on one thread in
+ *                 a different order every round
+ *   threads     - the same on several threads at once
+ * Every compilation must reproduce its reference status, diagnostic counts
+ * and assembly, and the caller's diagnostic settings, counts and line
+ * number must be unchanged after every call. Compiler messages go to
+ * /dev/null unless --verbose is given. Linux/POSIX only.
+ *
+ * Usage: ctxtest [--rounds <n>] [--threads <n>] [--verbose]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "context.h"
+
+#define MAX_THREADS 64
+
+static const char clean_program[] =
+    "int total;\n"
+    "int squares[10];\n"
+    "int square(int n) {\n"
+    "    return n * n;\n"
+    "}\n"
+    "int main() {\n"
+    "    int i;\n"
+    "    i = 0;\n"
+    "    total = 0;\n"
+    "    while (i < 10) {\n"
+    "        squares[i] = square(i);\n"
+    "        total = total + squares[i];\n"
+    "        i = i + 1;\n"
+    "    }\n"
+    "    print(total);\n"
+    "    return 0;\n"
+    "}\n";
+
+static const char warning_program[] =
+    "int main() {\n"
+    "    int x;\n"
+    "    int y;\n"
+    "    y = 0;\n"
+    "    x = 5 / y;\n"
+    "    print(x);\n"
+    "    return 0;\n"
+    "}\n";
+
+static const char division_program[] =
+    "int main() {\n"
+    "    int x;\n"
+    "    x = 5 / 0;\n"
+    "    print(x);\n"
+    "    return 0;\n"
+    "}\n";
+
+static const char error_program[] =
+    "int main() {\n"
+    "    int x;\n"
+    "    x = y + 1;\n"
+    "    print(x);\n"
+    "    return z;\n"
+    "}\n";
+
+/* One compilation and what it produced alone in a fresh context */
+typedef struct {
+    const char* name;
+    const char* source;
+    CompileOptions options;
+    int status;                 /* Reference compile_buffer() result */
+    DiagnosticStats stats;      /* Reference diagnostic counts */
+    char* output;               /* Reference assembly */
+    size_t length;
+} TestCase;
+
+#define CASE_COUNT 8
+
+static TestCase cases[CASE_COUNT];
+
+/* Totals */
+typedef struct {
+    int compilations;
+    int failures;
+} TestTotals;
+
+static int verbose = 0;
+
+/* Helper: set up the cases' options */
+static void init_cases(void) {
+    static const char* names[CASE_COUNT] = {
+        "clean", "warning", "warning hidden", "warning as error", "division error",
+        "semantic errors", "mips", "clean -O0 -j 2"
+    };
+    static const char* sources[CASE_COUNT] = {
+        clean_program, warning_program, warning_program, warning_program, division_program,
+        error_program, clean_program, clean_program
+    };
+
+    for (int i = 0; i < CASE_COUNT; i++) {
+        cases[i].name = names[i];
+        cases[i].source = sources[i];
+        init_compile_options(&cases[i].options);
+        cases[i].options.log_level = LOG_QUIET;
+    }
+    cases[2].options.show_warnings = 0;
+    cases[3].options.warnings_as_errors = 1;
+    cases[6].options.use_mips = 1;
+    cases[7].options.opt_level = 0;
+    cases[7].options.asm_comments = 0;
+    cases[7].options.jobs = 2;
+}
+
+/* Helper: compile a case in ctx; the assembly is returned in *output */
+static int compile_case(CompilerContext* ctx, const TestCase* test, char** output, size_t* length) {
+    OutputSink* out = create_buffer_sink();
+    int status = compile_buffer(ctx, test->source, strlen(test->source), &test->options, out, NULL);
+    *output = take_sink_text(out, length);
+    close_sink(out);
+    return status;
+}
+
+/* Helper: the caller state a thread sets before compiling; seed makes
+ * each thread's values different */
+static void set_caller_state(int seed) {
+    init_diagnostics(seed & 1, seed & 2);
+    diag_config.show_warnings = !(seed & 4);
+    diag_config.log_level = LOG_VERBOSE;
+    diag_stats.note_count = seed + 1;
+    diag_stats.warning_count = seed + 2;
+    diag_stats.error_count = seed + 3;
+    diag_stats.fatal_count = 0;
+    ast_line_num = 1000 + seed;
+}
+
+/* Helper: is the caller state still what set_caller_state(seed) left? */
+static int caller_state_intact(int seed) {
+    return diag_config.verbose_mode == (seed & 1) &&
+           diag_config.warnings_as_errors == (seed & 2) &&
+           diag_config.show_warnings == !(seed & 4) &&
+           diag_config.log_level == LOG_VERBOSE &&
+           diag_stats.note_count == seed + 1 &&
+           diag_stats.warning_count == seed + 2 &&
+           diag_stats.error_count == seed + 3 &&
+           diag_stats.fatal_count == 0 &&
+           ast_line_num == 1000 + seed;
+}
+
+/* Helper: compile a case in its context and compare with the reference;
+ * where names the run in failure messages */
+static void check_case(CompilerContext* ctx, int index, int seed, const char* where,
+                       TestTotals* totals) {
+    const TestCase* test = &cases[index];
+    char* output;
+    size_t length;
+    int status = compile_case(ctx, test, &output, &length);
+    const char* problem = NULL;
+
+    if (status != test->status) {
+        problem = "status differs";
+    } else if (memcmp(&ctx->diag_stats, &test->stats, sizeof(DiagnosticStats)) != 0) {
+        problem = "diagnostic counts differ";
+    } else if (length != test->length || memcmp(output, test->output, length) != 0) {
+        problem = "assembly differs";
+    } else if (!caller_state_intact(seed)) {
+        problem = "caller's diagnostics state changed";
+    } else if (ctx->alloc_stats.count == 0) {
+        problem = "no allocations counted";
+    }
+
+    totals->compilations++;
+    if (problem) {
+        totals->failures++;
+        printf("  FAIL  %-10s %-18s %s\n", where, test->name, problem);
+        set_caller_state(seed);
+    }
+    free(output);
+}
+
+/* A thread's share of the threads phase */
+typedef struct {
+    int seed;
+    int rounds;
+    TestTotals totals;
+} ThreadJob;
+
+/* Compile every case rounds times in its own context, the order rotating
+ * each round */
+static void run_interleaved(int seed, int rounds, const char* where, TestTotals* totals) {
+    CompilerContext* contexts[CASE_COUNT];
+    for (int i = 0; i < CASE_COUNT; i++) {
+        contexts[i] = create_compiler_context();
+    }
+
+    set_caller_state(seed);
+    for (int round = 0; round < rounds; round++) {
+        for (int k = 0; k < CASE_COUNT; k++) {
+            int index = (k * (round % 2 ? CASE_COUNT - 1 : 1) + round + seed) % CASE_COUNT;
+            check_case(contexts[index], index, seed, where, totals);
+        }
+    }
+
+    for (int i = 0; i < CASE_COUNT; i++) {
+        free_compiler_context(contexts[i]);
+    }
+}
+
+static void* thread_main(void* arg) {
+    ThreadJob* job = (ThreadJob*)arg;
+    run_interleaved(job->seed, job->rounds, "threads", &job->totals);
+    return NULL;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options]\n\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --rounds <n>       Rounds over all cases per phase (default 20)\n");
+    fprintf(stderr, "  --threads <n>      Threads in the threads phase (default 4)\n");
+    fprintf(stderr, "  --verbose          Show the compiler's messages\n");
+}
+
+int main(int argc, char** argv) {
+    int rounds = 20;
+    int threads = 4;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--rounds") == 0 && value) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && value) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    if (!verbose && !freopen("/dev/null", "w", stderr)) {
+        printf("Error: Cannot silence the compiler's messages\n");
+        return 1;
+    }
+
+    /* References: every case alone, in a fresh context */
+    init_cases();
+    for (int i = 0; i < CASE_COUNT; i++) {
+        CompilerContext* ctx = create_compiler_context();
+        cases[i].status = compile_case(ctx, &cases[i], &cases[i].output, &cases[i].length);
+        cases[i].stats = ctx->diag_stats;
+        free_compiler_context(ctx);
+    }
+
+    printf("Context test: %d cases, %d rounds, %d threads\n", CASE_COUNT, rounds, threads);
+    for (int i = 0; i < CASE_COUNT; i++) {
+        printf("  %-18s status %d, %d warning(s), %d error(s), %zu bytes\n", cases[i].name,
+               cases[i].status, cases[i].stats.warning_count, cases[i].stats.error_count,
+               cases[i].length);
+    }
+
+    TestTotals totals = { 0, 0 };
+    run_interleaved(0, rounds, "interleaved", &totals);
+
+    ThreadJob jobs[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        jobs[t].seed = t + 1;
+        jobs[t].rounds = rounds;
+        jobs[t].totals.compilations = 0;
+        jobs[t].totals.failures = 0;
+        if (pthread_create(&ids[t], NULL, thread_main, &jobs[t]) != 0) {
+            printf("Error: Cannot start thread %d\n", t);
+            return 1;
+        }
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        totals.compilations += jobs[t].totals.compilations;
+        totals.failures += jobs[t].totals.failures;
+    }
+
+    for (int i = 0; i < CASE_COUNT; i++) {
+        free(cases[i].output);
+    }
+
+    printf("%d compilations: %d passed, %d failed\n", totals.compilations,
+           totals.compilations - totals.failures, totals.failures);
+    return totals.failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,553 @@
+/*
+ * DIFFTEST.C - Differential Tester (Optimized vs Unoptimized)
+ * CST-405 Compiler Project
+ *
+ * Checks that the optimizer preserves the meaning of programs. Every
+ * program is built twice - once with the reference flags (-O0, no
+ * optimization) and once with the optimized flags (-O3) - and both builds
+ * are executed; their print() output and exit status must be identical.
+ * Programs come from the command line (the test_ programs, the kernels)
+ * and from the random program generator (--random, see progen.h).
+ *
+ * Programs are executed with one of:
+ *   interp - the compiler's bytecode interpreter (--interp, any host)
+ *   run    - the x86-64 machine code, run inside the compiler (--run)
+ *   native - an ELF object (--emit-obj) linked with cc and run
+ *   asm    - the NASM assembly, assembled with nasm, linked with cc -no-pie
+ *            and run (the only mode with vectorized loops)
+ * A program may also state the output it must print, one "// expect: <line>"
+ * comment per line; the reference output is then checked against it.
+ * A reference build that does not compile or times out is skipped; any
+ * other mismatch is a failure and the program, both outputs and the
+ * commands are saved in the failure directory. Linux/POSIX only.
+ *
+ * Usage: difftest [options] [program.c ...]
+ *        difftest gen <seed> [size]         (write one random program to stdout)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "progen.h"
+
+#define MAX_ARGS 64
+
+/* How programs are executed */
+typedef enum {
+    EXEC_INTERP,                /* compiler --interp */
+    EXEC_RUN,                   /* compiler --run */
+    EXEC_NATIVE,                /* compiler --emit-obj, cc, run the binary */
+    EXEC_ASM                    /* compiler, nasm, cc -no-pie, run the binary */
+} ExecMode;
+
+static const char* exec_names[] = { "interp", "run", "native", "asm" };
+
+/* Tester settings */
+typedef struct {
+    const char* compiler;       /* Compiler under test */
+    const char* base_flags;     /* Reference build flags */
+    const char* opt_flags;      /* Optimized build flags */
+    ExecMode mode;
+    const char* cc;             /* Linker for native and asm mode */
+    const char* nasm;           /* Assembler for asm mode */
+    int random;                 /* Generated programs to test */
+    unsigned seed;              /* Seed of the first generated program */
+    int size;                   /* Generated program size (1-10) */
+    int timeout;                /* Seconds before a build or run is killed */
+    const char* keep_dir;       /* Where failing programs are saved */
+    int stop;                   /* Stop at the first failure */
+    int verbose;                /* One line per program */
+} DiffConfig;
+
+/* Outcome of building and running one program one way */
+typedef struct {
+    int built;                  /* Compiled (and linked) */
+    int timed_out;              /* Killed by the timeout */
+    int status;                 /* Exit status, 256 + signal if killed */
+    char output[1024];          /* File with the program's stdout */
+    char errors[1024];          /* File with the build/run messages */
+} Execution;
+
+/* Totals */
+typedef struct {
+    int programs;
+    int passed;
+    int skipped;
+    int failed;
+} DiffTotals;
+
+static char work_dir[256];
+
+/* Helper: split a flag string into argv entries (modifies text) */
+static int split_flags(char* text, char** argv, int count) {
+    for (char* p = strtok(text, " \t"); p && count < MAX_ARGS - 1; p = strtok(NULL, " \t")) {
+        argv[count++] = p;
+    }
+    argv[count] = NULL;
+    return count;
+}
+
+/* Helper: run a command with stdout and stderr in files (stderr appended).
+ * Returns the exit status, 256 + signal if it was killed, -1 if it could
+ * not be started; *timed_out is set when the alarm killed it. */
+static int run_process(char* const argv[], const char* out_path, const char* err_path,
+                       int timeout, int* timed_out) {
+    *timed_out = 0;
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+
+    if (pid == 0) {
+        int out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int err = open(err_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (out < 0 || err < 0) _exit(126);
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+        close(out);
+        close(err);
+        alarm(timeout);                 /* Survives exec: kills runaway programs */
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) return -1;
+    if (WIFSIGNALED(status)) {
+        *timed_out = WTERMSIG(status) == SIGALRM;
+        return 256 + WTERMSIG(status);
+    }
+    return WEXITSTATUS(status);
+}
+
+/* Helper: can program be executed? Names without a '/' are looked up in
+ * PATH the way execvp does. A missing compiler would otherwise exit 127
+ * for both builds and every program would compare equal. */
+static int can_execute(const char* program) {
+    if (strchr(program, '/')) return access(program, X_OK) == 0;
+
+    const char* path = getenv("PATH");
+    char candidate[1024];
+    while (path && *path) {
+        const char* end = strchr(path, ':');
+        size_t length = end ? (size_t)(end - path) : strlen(path);
+        snprintf(candidate, sizeof(candidate), "%.*s/%s", (int)(length ? length : 1),
+                 length ? path : ".", program);
+        if (access(candidate, X_OK) == 0) return 1;
+        path = end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+/* Helper: does a file contain text? */
+static int file_contains(const char* path, const char* text) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+
+    char line[1024];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file)) {
+        found = strstr(line, text) != NULL;
+    }
+    fclose(file);
+    return found;
+}
+
+/* Helper: build and run source with the given flags; tag names the files */
+static void execute(const DiffConfig* config, const char* source, const char* flags,
+                    const char* tag, Execution* result) {
+    char flag_text[1024], object[1200], assembly[1200], binary[1024], scratch[1024];
+    char* argv[MAX_ARGS];
+    int argc = 0;
+
+    memset(result, 0, sizeof(*result));
+    snprintf(result->output, sizeof(result->output), "%s/%s.out", work_dir, tag);
+    snprintf(result->errors, sizeof(result->errors), "%s/%s.err", work_dir, tag);
+    unlink(result->errors);
+    snprintf(flag_text, sizeof(flag_text), "%s", flags);
+
+    argv[argc++] = (char*)config->compiler;
+    argv[argc++] = (char*)source;
+    argv[argc++] = "-q";
+    if (config->mode == EXEC_NATIVE || config->mode == EXEC_ASM) {
+        /* Batch mode names the output after the source: <dir>/<name>.o
+         * (or .asm) */
+        snprintf(object, sizeof(object), "%s/%s", work_dir, tag);
+        mkdir(object, 0755);
+        if (config->mode == EXEC_NATIVE) argv[argc++] = "--emit-obj";
+        argv[argc++] = "-o";
+        argv[argc++] = object;
+    } else {
+        argv[argc++] = config->mode == EXEC_RUN ? "--run" : "--interp";
+    }
+    argc = split_flags(flag_text, argv, argc);
+
+    int timed_out;
+    int status = run_process(argv, result->output, result->errors, config->timeout, &timed_out);
+    if (timed_out) {
+        result->timed_out = 1;
+        return;
+    }
+    if (file_contains(result->errors, "COMPILATION FAILED") || status < 0 || status > 255) {
+        result->status = status;
+        return;
+    }
+
+    if (config->mode != EXEC_NATIVE && config->mode != EXEC_ASM) {
+        result->built = 1;
+        result->status = status;
+        return;
+    }
+
+    /* native: link <dir>/<name>.o and run it; asm: assemble <dir>/<name>.asm
+     * into it first */
+    const char* base = strrchr(source, '/');
+    base = base ? base + 1 : source;
+    snprintf(binary, sizeof(binary), "%s/%s/%.*s", work_dir, tag,
+             (int)(strlen(base) > 2 && strcmp(base + strlen(base) - 2, ".c") == 0 ? strlen(base) - 2 : strlen(base)),
+             base);
+    snprintf(object, sizeof(object), "%s.o", binary);
+    snprintf(scratch, sizeof(scratch), "%s/%s.link", work_dir, tag);
+
+    if (config->mode == EXEC_ASM) {
+        snprintf(assembly, sizeof(assembly), "%s.asm", binary);
+        char* assemble[] = { (char*)config->nasm, "-f", "elf64", "-o", object, assembly, NULL };
+        if (run_process(assemble, scratch, result->errors, config->timeout, &timed_out) != 0) {
+            return;
+        }
+    }
+
+    /* The assembly addresses its data absolutely, so it cannot be a PIE */
+    char* link[] = { (char*)config->cc, "-o", binary, object, NULL, NULL };
+    if (config->mode == EXEC_ASM) link[4] = "-no-pie";
+    if (run_process(link, scratch, result->errors, config->timeout, &timed_out) != 0) {
+        return;
+    }
+    result->built = 1;
+
+    char* run[] = { binary, NULL };
+    result->status = run_process(run, result->output, result->errors, config->timeout, &timed_out);
+    result->timed_out = timed_out;
+}
+
+/* Helper: first line where two files differ (0 = identical) */
+static int first_difference(const char* a, const char* b, char* line_a, char* line_b, size_t size) {
+    FILE* fa = fopen(a, "r");
+    FILE* fb = fopen(b, "r");
+    int line = 0, differs = 0;
+
+    line_a[0] = line_b[0] = '\0';
+    while (fa && fb && !differs) {
+        line++;
+        char* ra = fgets(line_a, (int)size, fa);
+        char* rb = fgets(line_b, (int)size, fb);
+        if (!ra && !rb) break;
+        if (!ra) strcpy(line_a, "<end of output>");
+        if (!rb) strcpy(line_b, "<end of output>");
+        differs = !ra || !rb || strcmp(line_a, line_b) != 0;
+    }
+    if (!fa || !fb) differs = 1;
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+
+    line_a[strcspn(line_a, "\n")] = '\0';
+    line_b[strcspn(line_b, "\n")] = '\0';
+    return differs ? (line > 0 ? line : 1) : 0;
+}
+
+/* Helper: write the "// expect: " lines of source to path; returns 0 if
+ * the program has none */
+static int expected_output(const char* source, const char* path) {
+    static const char marker[] = "// expect: ";
+    FILE* in = fopen(source, "r");
+    FILE* out = in ? fopen(path, "w") : NULL;
+    char line[1024];
+    int found = 0;
+
+    while (out && fgets(line, sizeof(line), in)) {
+        if (strncmp(line, marker, sizeof(marker) - 1) == 0) {
+            fputs(line + sizeof(marker) - 1, out);
+            found = 1;
+        }
+    }
+    if (out) fclose(out);
+    if (in) fclose(in);
+    return found;
+}
+
+/* Helper: copy a file (for the failure directory) */
+static void copy_file(const char* from, const char* to) {
+    FILE* in = fopen(from, "rb");
+    FILE* out = in ? fopen(to, "wb") : NULL;
+    if (out) {
+        char buffer[8192];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            fwrite(buffer, 1, n, out);
+        }
+        fclose(out);
+    }
+    if (in) fclose(in);
+}
+
+/* Helper: save a failing program with both outputs and a note */
+static void save_failure(const DiffConfig* config, const char* source, const char* name,
+                         const Execution* base, const Execution* opt, const char* reason) {
+    char path[1200];
+    if (mkdir(config->keep_dir, 0755) != 0 && errno != EEXIST) return;
+
+    snprintf(path, sizeof(path), "%s/%s.c", config->keep_dir, name);
+    copy_file(source, path);
+    snprintf(path, sizeof(path), "%s/%s.base.out", config->keep_dir, name);
+    copy_file(base->output, path);
+    snprintf(path, sizeof(path), "%s/%s.opt.out", config->keep_dir, name);
+    copy_file(opt->output, path);
+    snprintf(path, sizeof(path), "%s/%s.opt.err", config->keep_dir, name);
+    copy_file(opt->errors, path);
+
+    snprintf(path, sizeof(path), "%s/%s.txt", config->keep_dir, name);
+    FILE* note = fopen(path, "w");
+    if (note) {
+        fprintf(note, "%s\n", reason);
+        fprintf(note, "reference: %s %s.c -q %s (%s)\n", config->compiler, name, config->base_flags,
+                exec_names[config->mode]);
+        fprintf(note, "optimized: %s %s.c -q %s (%s)\n", config->compiler, name, config->opt_flags,
+                exec_names[config->mode]);
+        fprintf(note, "exit status: reference %d, optimized %d\n", base->status, opt->status);
+        fclose(note);
+    }
+}
+
+/* Helper: test one program; name identifies it in the report */
+static void test_program(const DiffConfig* config, const char* source, const char* name,
+                         DiffTotals* totals) {
+    Execution base, opt;
+    char reason[1024] = "";
+    char expected[1024];
+    int skipped = 0;
+
+    totals->programs++;
+    execute(config, source, config->base_flags, "base", &base);
+
+    if (!base.built) {
+        skipped = 1;
+        snprintf(reason, sizeof(reason), "reference %s", base.timed_out ? "timed out" : "does not compile");
+    } else if (base.timed_out) {
+        skipped = 1;
+        snprintf(reason, sizeof(reason), "reference timed out");
+    } else {
+        execute(config, source, config->opt_flags, "opt", &opt);
+
+        char line_base[256], line_opt[256], line_expected[256];
+        int line = 0;
+        snprintf(expected, sizeof(expected), "%s/expect.out", work_dir);
+        if (expected_output(source, expected) &&
+            (line = first_difference(expected, base.output, line_expected, line_base,
+                                     sizeof(line_base))) != 0) {
+            snprintf(reason, sizeof(reason), "output differs from the expected at line %d: "
+                     "expected '%s', reference '%s'", line, line_expected, line_base);
+        } else if (!opt.built) {
+            snprintf(reason, sizeof(reason), "optimized build %s",
+                     opt.timed_out ? "timed out" : opt.status > 255 ? "crashed" : "failed");
+        } else if (opt.timed_out) {
+            snprintf(reason, sizeof(reason), "optimized program timed out");
+        } else if ((line = first_difference(base.output, opt.output, line_base, line_opt,
+                                            sizeof(line_base))) != 0) {
+            snprintf(reason, sizeof(reason), "output differs at line %d: reference '%s', optimized '%s'",
+                     line, line_base, line_opt);
+        } else if (base.status != opt.status) {
+            snprintf(reason, sizeof(reason), "exit status differs: reference %d, optimized %d",
+                     base.status, opt.status);
+        }
+    }
+
+    if (skipped) {
+        totals->skipped++;
+        if (config->verbose) printf("  skip  %-32s %s\n", name, reason);
+    } else if (reason[0]) {
+        totals->failed++;
+        printf("  FAIL  %-32s %s\n", name, reason);
+        save_failure(config, source, name, &base, &opt, reason);
+    } else {
+        totals->passed++;
+        if (config->verbose) printf("  ok    %s\n", name);
+    }
+    fflush(stdout);
+}
+
+/* Helper: remove the scratch directory */
+static void remove_work_dir(void) {
+    char command[1100];
+    snprintf(command, sizeof(command), "rm -rf '%s'", work_dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "Warning: Cannot remove %s\n", work_dir);
+    }
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] [program.c ...]\n", program);
+    fprintf(stderr, "       %s gen <seed> [size]\n\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --compiler <path>  Compiler under test (default ./compiler)\n");
+    fprintf(stderr, "  --base <flags>     Reference build flags (default \"-O0\")\n");
+    fprintf(stderr, "  --opt <flags>      Optimized build flags (default \"-O3\")\n");
+    fprintf(stderr, "  --exec <mode>      interp (default), run (x86-64 in-process), native (cc)\n");
+    fprintf(stderr, "                     or asm (nasm and cc, with vectorized loops)\n");
+    fprintf(stderr, "  --cc <path>        Linker for --exec native and asm (default cc)\n");
+    fprintf(stderr, "  --nasm <path>      Assembler for --exec asm (default nasm)\n");
+    fprintf(stderr, "  --random <n>       Also test n generated programs\n");
+    fprintf(stderr, "  --seed <s>         Seed of the first generated program (default 1)\n");
+    fprintf(stderr, "  --size <1-10>      Size of the generated programs (default 4)\n");
+    fprintf(stderr, "  --timeout <sec>    Kill a build or run after this long (default 10)\n");
+    fprintf(stderr, "  --keep <dir>       Where failing programs are saved (default difftest-failures)\n");
+    fprintf(stderr, "  --stop             Stop at the first failure\n");
+    fprintf(stderr, "  --verbose          One line per program\n");
+}
+
+int main(int argc, char** argv) {
+    DiffConfig config;
+    memset(&config, 0, sizeof(config));
+    config.compiler = "./compiler";
+    config.base_flags = "-O0";
+    config.opt_flags = "-O3";
+    config.mode = EXEC_INTERP;
+    config.cc = "cc";
+    config.nasm = "nasm";
+    config.seed = 1;
+    config.size = 4;
+    config.timeout = 10;
+    config.keep_dir = "difftest-failures";
+
+    /* difftest gen <seed> [size] */
+    if (argc >= 3 && strcmp(argv[1], "gen") == 0) {
+        ProgramConfig shape;
+        default_program_config(&shape, argc >= 4 ? atoi(argv[3]) : config.size);
+        generate_program(stdout, &shape, (unsigned)strtoul(argv[2], NULL, 10));
+        return 0;
+    }
+
+    const char** inputs = (const char**)malloc(argc * sizeof(const char*));
+    int input_count = 0;
+    if (!inputs) {
+        fprintf(stderr, "Fatal Error: Failed to allocate input list\n");
+        exit(1);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--compiler") == 0 && value) {
+            config.compiler = argv[++i];
+        } else if (strcmp(arg, "--base") == 0 && value) {
+            config.base_flags = argv[++i];
+        } else if (strcmp(arg, "--opt") == 0 && value) {
+            config.opt_flags = argv[++i];
+        } else if (strcmp(arg, "--exec") == 0 && value) {
+            i++;
+            if (strcmp(value, "interp") == 0) config.mode = EXEC_INTERP;
+            else if (strcmp(value, "run") == 0) config.mode = EXEC_RUN;
+            else if (strcmp(value, "native") == 0) config.mode = EXEC_NATIVE;
+            else if (strcmp(value, "asm") == 0) config.mode = EXEC_ASM;
+            else {
+                fprintf(stderr, "Error: Unknown execution mode '%s'\n", value);
+                free(inputs);
+                return 1;
+            }
+        } else if (strcmp(arg, "--cc") == 0 && value) {
+            config.cc = argv[++i];
+        } else if (strcmp(arg, "--nasm") == 0 && value) {
+            config.nasm = argv[++i];
+        } else if (strcmp(arg, "--random") == 0 && value) {
+            config.random = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && value) {
+            config.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--size") == 0 && value) {
+            config.size = atoi(argv[++i]);
+        } else if (strcmp(arg, "--timeout") == 0 && value) {
+            config.timeout = atoi(argv[++i]);
+        } else if (strcmp(arg, "--keep") == 0 && value) {
+            config.keep_dir = argv[++i];
+        } else if (strcmp(arg, "--stop") == 0) {
+            config.stop = 1;
+        } else if (strcmp(arg, "--verbose") == 0 || strcmp(arg, "-v") == 0) {
+            config.verbose = 1;
+        } else if (strcmp(arg, "--help") == 0 || arg[0] == '-') {
+            usage(argv[0]);
+            free(inputs);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        } else {
+            inputs[input_count++] = arg;
+        }
+    }
+
+    if (input_count == 0 && config.random == 0) {
+        usage(argv[0]);
+        free(inputs);
+        return 1;
+    }
+
+    const char* missing = !can_execute(config.compiler) ? config.compiler
+                        : (config.mode == EXEC_NATIVE || config.mode == EXEC_ASM) &&
+                          !can_execute(config.cc) ? config.cc
+                        : config.mode == EXEC_ASM && !can_execute(config.nasm) ? config.nasm
+                        : NULL;
+    if (missing) {
+        fprintf(stderr, "Error: Cannot run '%s'\n", missing);
+        free(inputs);
+        return 1;
+    }
+
+    snprintf(work_dir, sizeof(work_dir), "/tmp/difftest.XXXXXX");
+    if (!mkdtemp(work_dir)) {
+        fprintf(stderr, "Error: Cannot create a scratch directory\n");
+        free(inputs);
+        return 1;
+    }
+
+    printf("Differential test: %s vs %s (%s)\n", config.base_flags, config.opt_flags,
+           exec_names[config.mode]);
+
+    DiffTotals totals;
+    memset(&totals, 0, sizeof(totals));
+
+    for (int i = 0; i < input_count && !(config.stop && totals.failed); i++) {
+        const char* base = strrchr(inputs[i], '/');
+        char name[256];
+        snprintf(name, sizeof(name), "%s", base ? base + 1 : inputs[i]);
+        size_t length = strlen(name);
+        if (length > 2 && strcmp(name + length - 2, ".c") == 0) name[length - 2] = '\0';
+        test_program(&config, inputs[i], name, &totals);
+    }
+
+    ProgramConfig shape;
+    default_program_config(&shape, config.size);
+    for (int r = 0; r < config.random && !(config.stop && totals.failed); r++) {
+        unsigned seed = config.seed + (unsigned)r;
+        char name[64], source[1200];
+        snprintf(name, sizeof(name), "random_%u", seed);
+        snprintf(source, sizeof(source), "%s/%s.c", work_dir, name);
+
+        FILE* out = fopen(source, "w");
+        if (!out) {
+            fprintf(stderr, "Error: Cannot write %s\n", source);
+            break;
+        }
+        generate_program(out, &shape, seed);
+        fclose(out);
+        test_program(&config, source, name, &totals);
+    }
+
+    printf("%d programs: %d passed, %d failed, %d skipped\n",
+           totals.programs, totals.passed, totals.failed, totals.skipped);
+    if (totals.failed > 0) {
+        printf("Failing programs saved in %s/\n", config.keep_dir);
+    }
+
+    remove_work_dir();
+    free(inputs);
+    return totals.failed > 0 ? 1 : 0;
+}
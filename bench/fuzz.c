@@ -0,0 +1,517 @@
+/*
+ * FUZZ.C - Random Program Fuzzer (Crashes, Hangs and Slow Phases)
+ * CST-405 Compiler Project
+ *
+ * Generates random well-typed programs (see progen.h) of growing size and
+ * compiles each one in-process with compile_buffer() - parse, semantic
+ * analysis, TAC generation, optimization, security analysis and code
+ * generation - in a forked child, so a crash or a hang costs one sample
+ * rather than the run. It records:
+ *   crash    - the compiler died on a signal
+ *   hang     - the compilation did not finish within --timeout seconds
+ *   rejected - a valid generated program failed to compile
+ *   outlier  - a program compiled more than --outlier times slower per
+ *              line than the median program of the same scale
+ * and saves each of them in the findings directory. For every scale it
+ * reports the median time of each phase and, between each scale and the
+ * nearest smaller one with at most 2/3 of its lines, how that time grows
+ * with program size (1.0 = linear); growth above --max-growth is flagged
+ * as super-linear. Linux/POSIX only.
+ *
+ * Usage: fuzz [options]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "progen.h"
+#include "context.h"
+
+#define MAX_SCALES  16
+#define MAX_SAMPLES 10000
+
+/* Growth is only measured between scales this far apart in lines: over a
+ * smaller step the exponent is mostly timing noise */
+#define MIN_SIZE_RATIO 1.5
+
+/* Phases shown in the report (names as recorded by compile_buffer) */
+static const char* phase_names[] = {
+    "parse", "semantic", "tac generation", "optimization", "security", "code generation"
+};
+static const char* phase_labels[] = {
+    "parse", "sem", "tac", "opt", "sec", "cgen"
+};
+#define PHASE_COLUMNS 6
+
+/* What grows with the scale */
+typedef enum {
+    GROW_FUNCTIONS,             /* Number of functions */
+    GROW_STATEMENTS             /* Statements per block (longer functions) */
+} GrowAxis;
+
+/* Fuzzer settings */
+typedef struct {
+    int count;                  /* Programs per scale */
+    long scales[MAX_SCALES];    /* Program scales */
+    int scale_count;
+    GrowAxis axis;
+    unsigned seed;              /* Seed of the first program */
+    int opt_level;              /* -O level the programs are compiled at */
+    int timeout;                /* Seconds before a compilation counts as a hang */
+    double outlier;             /* Slowdown against the median that is an outlier */
+    double max_growth;          /* Growth exponent reported as super-linear */
+    const char* keep_dir;       /* Where findings are saved */
+    int verbose;                /* One line per program */
+} FuzzConfig;
+
+/* Result of one compilation, written by the child through a pipe */
+typedef struct {
+    int status;                 /* compile_buffer() result */
+    double total_ms;            /* Wall time of the whole compilation */
+    double phase_ms[PHASE_COLUMNS];
+    long peak_rss_kb;
+} FuzzSample;
+
+/* One program */
+typedef struct {
+    unsigned seed;
+    long lines;
+    size_t bytes;
+    FuzzSample sample;
+} FuzzRecord;
+
+/* Findings over the whole run */
+typedef struct {
+    int crashes;
+    int hangs;
+    int rejected;
+    int outliers;
+} FuzzFindings;
+
+static const char* axis_names[] = { "functions", "statements" };
+
+/* Helper: program configuration for a scale */
+static void scale_config(const FuzzConfig* config, long scale, ProgramConfig* shape) {
+    default_program_config(shape, 4);
+    if (config->axis == GROW_FUNCTIONS) {
+        shape->functions = (int)scale;
+    } else {
+        shape->functions = 2;
+        shape->statements = (int)scale;
+    }
+}
+
+/* Helper: generate a program into a malloc'd buffer */
+static char* generate_source(const ProgramConfig* shape, unsigned seed, long* lines, size_t* length) {
+    char* text = NULL;
+    FILE* out = open_memstream(&text, length);
+    if (!out) {
+        fprintf(stderr, "Fatal Error: Failed to allocate program buffer\n");
+        exit(1);
+    }
+    *lines = generate_program(out, shape, seed);
+    fclose(out);
+    return text;
+}
+
+/* Helper: compile in this (child) process and send the sample to fd */
+static void compile_child(const FuzzConfig* config, const char* source, size_t length, int fd) {
+    CompileOptions options;
+    init_compile_options(&options);
+    options.opt_level = config->opt_level;
+    options.log_level = LOG_QUIET;
+    options.show_warnings = 0;
+    options.time_report = TIME_REPORT_TABLE;
+
+    CompilerContext* ctx = create_compiler_context();
+    OutputSink* out = create_buffer_sink();
+
+    FuzzSample sample;
+    memset(&sample, 0, sizeof(sample));
+    double start = monotonic_ms();
+    sample.status = compile_buffer(ctx, source, length, &options, out, NULL);
+    sample.total_ms = monotonic_ms() - start;
+    sample.peak_rss_kb = peak_rss_kb();
+
+    for (int i = 0; i < ctx->timing.phase_count; i++) {
+        const PhaseTiming* phase = &ctx->timing.phases[i];
+        for (int p = 0; p < PHASE_COLUMNS; p++) {
+            if (phase->depth == 0 && strcmp(phase->name, phase_names[p]) == 0) {
+                sample.phase_ms[p] += phase->wall_ms;
+            }
+        }
+    }
+
+    if (write(fd, &sample, sizeof(sample)) != (ssize_t)sizeof(sample)) {
+        _exit(2);
+    }
+    _exit(0);
+}
+
+/* Helper: compile one program in a child process.
+ * Returns 0 (compiled or rejected, sample filled in), 1 (crash: *signal
+ * set) or 2 (hang). */
+static int compile_isolated(const FuzzConfig* config, const char* source, size_t length,
+                            const char* error_path, FuzzSample* sample, int* signal_number) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: Cannot create a pipe\n");
+        exit(1);
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: Cannot fork\n");
+        exit(1);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        if (!freopen(error_path, "w", stderr) || !freopen("/dev/null", "w", stdout)) _exit(3);
+        alarm(config->timeout);
+        compile_child(config, source, length, fds[1]);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], sample, sizeof(*sample));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFSIGNALED(status)) {
+        *signal_number = WTERMSIG(status);
+        return *signal_number == SIGALRM ? 2 : 1;
+    }
+    if (got != (ssize_t)sizeof(*sample)) {
+        /* Exited without reporting (e.g. exit() on a fatal error) */
+        memset(sample, 0, sizeof(*sample));
+        sample->status = 1;
+    }
+    return 0;
+}
+
+/* Helper: save a finding: the program and the compiler's messages */
+static void save_finding(const FuzzConfig* config, const char* kind, unsigned seed,
+                         const char* source, size_t length, const char* error_path) {
+    char path[1024];
+    if (mkdir(config->keep_dir, 0755) != 0 && errno != EEXIST) return;
+
+    snprintf(path, sizeof(path), "%s/%s_%u.c", config->keep_dir, kind, seed);
+    FILE* out = fopen(path, "w");
+    if (out) {
+        fwrite(source, 1, length, out);
+        fclose(out);
+    }
+
+    snprintf(path, sizeof(path), "%s/%s_%u.err", config->keep_dir, kind, seed);
+    FILE* in = fopen(error_path, "r");
+    out = in ? fopen(path, "w") : NULL;
+    if (out) {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            fwrite(buffer, 1, n, out);
+        }
+        fclose(out);
+    }
+    if (in) fclose(in);
+}
+
+/* Helper: median of values (sorts them) */
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static double median(double* values, int count) {
+    if (count == 0) return 0;
+    qsort(values, count, sizeof(double), compare_doubles);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+/* Per-scale medians */
+typedef struct {
+    long scale;
+    int samples;                /* Programs that compiled */
+    double lines;
+    double kib;
+    double total_ms;
+    double phase_ms[PHASE_COLUMNS];
+    long peak_rss_kb;
+} ScaleSummary;
+
+/* Helper: fuzz one scale; returns its summary */
+static void fuzz_scale(const FuzzConfig* config, long scale, unsigned* seed, const char* error_path,
+                       FuzzFindings* findings, ScaleSummary* summary) {
+    ProgramConfig shape;
+    scale_config(config, scale, &shape);
+
+    FuzzRecord* records = (FuzzRecord*)calloc(config->count, sizeof(FuzzRecord));
+    double* values = (double*)calloc(config->count + 1, sizeof(double));
+    if (!records || !values) {
+        fprintf(stderr, "Fatal Error: Failed to allocate fuzz records\n");
+        exit(1);
+    }
+
+    int compiled = 0;
+    for (int i = 0; i < config->count; i++) {
+        unsigned program_seed = (*seed)++;
+        long lines;
+        size_t length;
+        char* source = generate_source(&shape, program_seed, &lines, &length);
+
+        FuzzSample sample;
+        int signal_number = 0;
+        int outcome = compile_isolated(config, source, length, error_path, &sample, &signal_number);
+
+        const char* kind = NULL;
+        if (outcome == 1) {
+            kind = "crash";
+            findings->crashes++;
+            printf("  CRASH    scale %ld seed %u: signal %d (%s)\n", scale, program_seed,
+                   signal_number, strsignal(signal_number));
+        } else if (outcome == 2) {
+            kind = "hang";
+            findings->hangs++;
+            printf("  HANG     scale %ld seed %u: no result after %d s\n", scale, program_seed,
+                   config->timeout);
+        } else if (sample.status != 0) {
+            kind = "rejected";
+            findings->rejected++;
+            printf("  REJECTED scale %ld seed %u: valid program failed to compile\n", scale, program_seed);
+        } else {
+            FuzzRecord* record = &records[compiled++];
+            record->seed = program_seed;
+            record->lines = lines;
+            record->bytes = length;
+            record->sample = sample;
+            if (config->verbose) {
+                printf("  ok       scale %ld seed %u: %ld lines, %.2f ms\n", scale, program_seed,
+                       lines, sample.total_ms);
+            }
+        }
+        if (kind) {
+            save_finding(config, kind, program_seed, source, length, error_path);
+        }
+        fflush(stdout);
+        free(source);
+    }
+
+    /* Medians over the programs that compiled */
+    memset(summary, 0, sizeof(*summary));
+    summary->scale = scale;
+    summary->samples = compiled;
+    for (int i = 0; i < compiled; i++) values[i] = (double)records[i].lines;
+    summary->lines = median(values, compiled);
+    for (int i = 0; i < compiled; i++) values[i] = records[i].bytes / 1024.0;
+    summary->kib = median(values, compiled);
+    for (int i = 0; i < compiled; i++) values[i] = records[i].sample.total_ms;
+    summary->total_ms = median(values, compiled);
+    for (int p = 0; p < PHASE_COLUMNS; p++) {
+        for (int i = 0; i < compiled; i++) values[i] = records[i].sample.phase_ms[p];
+        summary->phase_ms[p] = median(values, compiled);
+    }
+    for (int i = 0; i < compiled; i++) {
+        if (records[i].sample.peak_rss_kb > summary->peak_rss_kb) {
+            summary->peak_rss_kb = records[i].sample.peak_rss_kb;
+        }
+    }
+
+    /* Outliers: time per line far above the median of this scale (noise
+     * below a millisecond is ignored) */
+    for (int i = 0; i < compiled; i++) {
+        values[i] = records[i].sample.total_ms / (records[i].lines > 0 ? records[i].lines : 1);
+    }
+    double typical = median(values, compiled);
+    for (int i = 0; i < compiled; i++) {
+        const FuzzRecord* record = &records[i];
+        double per_line = record->sample.total_ms / (record->lines > 0 ? record->lines : 1);
+        if (record->sample.total_ms < 1.0 || per_line <= config->outlier * typical) continue;
+
+        int slowest = 0;
+        for (int p = 1; p < PHASE_COLUMNS; p++) {
+            if (record->sample.phase_ms[p] > record->sample.phase_ms[slowest]) slowest = p;
+        }
+        findings->outliers++;
+        printf("  OUTLIER  scale %ld seed %u: %.2f ms for %ld lines (%.1fx the median per line, mostly %s)\n",
+               scale, record->seed, record->sample.total_ms, record->lines,
+               per_line / typical, phase_names[slowest]);
+
+        /* Regenerate the program to save it */
+        long lines;
+        size_t length;
+        char* source = generate_source(&shape, record->seed, &lines, &length);
+        FILE* empty = fopen(error_path, "w");
+        if (empty) fclose(empty);
+        save_finding(config, "outlier", record->seed, source, length, error_path);
+        free(source);
+    }
+
+    free(records);
+    free(values);
+}
+
+/* Helper: parse a comma-separated list of scales */
+static int parse_scales(const char* text, long* scales) {
+    int count = 0;
+    while (*text && count < MAX_SCALES) {
+        scales[count++] = strtol(text, NULL, 10);
+        const char* comma = strchr(text, ',');
+        if (!comma) break;
+        text = comma + 1;
+    }
+    return count;
+}
+
+/* Helper: growth exponent of time against lines between two scales (the
+ * caller picks scales at least MIN_SIZE_RATIO apart) */
+static double growth(double time_a, double time_b, double lines_a, double lines_b) {
+    if (time_a <= 0 || time_b <= 0 || lines_b <= lines_a) return 0;
+    return log(time_b / time_a) / log(lines_b / lines_a);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options]\n\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --count <n>        Programs per scale (default 50)\n");
+    fprintf(stderr, "  --scales <list>    Program scales (default 1,2,4,8,16,32,64)\n");
+    fprintf(stderr, "  --grow <axis>      What the scale sets: functions (default) or statements\n");
+    fprintf(stderr, "  --seed <s>         Seed of the first program (default 1)\n");
+    fprintf(stderr, "  -O<n>              Optimization level (default -O2)\n");
+    fprintf(stderr, "  --timeout <sec>    A compilation this slow is a hang (default 10)\n");
+    fprintf(stderr, "  --outlier <x>      Slowdown per line against the median that is an outlier (default 5)\n");
+    fprintf(stderr, "  --max-growth <e>   Growth exponent reported as super-linear (default 1.3)\n");
+    fprintf(stderr, "  --keep <dir>       Where findings are saved (default fuzz-findings)\n");
+    fprintf(stderr, "  --verbose          One line per program\n");
+}
+
+int main(int argc, char** argv) {
+    FuzzConfig config;
+    memset(&config, 0, sizeof(config));
+    config.count = 50;
+    config.scale_count = parse_scales("1,2,4,8,16,32,64", config.scales);
+    config.axis = GROW_FUNCTIONS;
+    config.seed = 1;
+    config.opt_level = 2;
+    config.timeout = 10;
+    config.outlier = 5.0;
+    config.max_growth = 1.3;
+    config.keep_dir = "fuzz-findings";
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        int has_value = i + 1 < argc;
+        if (strcmp(arg, "--count") == 0 && has_value) {
+            config.count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--scales") == 0 && has_value) {
+            config.scale_count = parse_scales(argv[++i], config.scales);
+        } else if (strcmp(arg, "--grow") == 0 && has_value) {
+            const char* axis = argv[++i];
+            if (strcmp(axis, "functions") == 0) config.axis = GROW_FUNCTIONS;
+            else if (strcmp(axis, "statements") == 0) config.axis = GROW_STATEMENTS;
+            else {
+                fprintf(stderr, "Error: Unknown axis '%s'\n", axis);
+                return 1;
+            }
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            config.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '3' && !arg[3]) {
+            config.opt_level = arg[2] - '0';
+        } else if (strcmp(arg, "--timeout") == 0 && has_value) {
+            config.timeout = atoi(argv[++i]);
+        } else if (strcmp(arg, "--outlier") == 0 && has_value) {
+            config.outlier = atof(argv[++i]);
+        } else if (strcmp(arg, "--max-growth") == 0 && has_value) {
+            config.max_growth = atof(argv[++i]);
+        } else if (strcmp(arg, "--keep") == 0 && has_value) {
+            config.keep_dir = argv[++i];
+        } else if (strcmp(arg, "--verbose") == 0 || strcmp(arg, "-v") == 0) {
+            config.verbose = 1;
+        } else {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (config.count < 1) config.count = 1;
+    if (config.count > MAX_SAMPLES) config.count = MAX_SAMPLES;
+
+    char error_path[64];
+    snprintf(error_path, sizeof(error_path), "/tmp/fuzz.%d.err", (int)getpid());
+
+    printf("Fuzzing: %d programs per scale, scale = %s, -O%d, seed %u\n", config.count,
+           axis_names[config.axis], config.opt_level, config.seed);
+
+    FuzzFindings findings;
+    memset(&findings, 0, sizeof(findings));
+    ScaleSummary summaries[MAX_SCALES];
+    unsigned seed = config.seed;
+    for (int s = 0; s < config.scale_count; s++) {
+        fuzz_scale(&config, config.scales[s], &seed, error_path, &findings, &summaries[s]);
+    }
+    unlink(error_path);
+
+    /* Median per scale */
+    printf("\n%7s %6s %7s %7s %9s %10s", "scale", "ok", "lines", "KiB", "total ms", "lines/s");
+    for (int p = 0; p < PHASE_COLUMNS; p++) printf(" %8s", phase_labels[p]);
+    printf(" %9s\n", "peak KiB");
+    for (int s = 0; s < config.scale_count; s++) {
+        const ScaleSummary* row = &summaries[s];
+        printf("%7ld %6d %7.0f %7.1f %9.3f %10.0f", row->scale, row->samples, row->lines, row->kib,
+               row->total_ms, row->total_ms > 0 ? row->lines * 1000.0 / row->total_ms : 0.0);
+        for (int p = 0; p < PHASE_COLUMNS; p++) printf(" %8.3f", row->phase_ms[p]);
+        printf(" %9ld\n", row->peak_rss_kb);
+    }
+
+    /* Growth of each phase between scales (phases under half a
+     * millisecond at either end are too noisy to judge) */
+    int super_linear = 0;
+    if (config.scale_count > 1) {
+        printf("\nGrowth of time with program size (1.0 = linear, 2.0 = quadratic):\n");
+        printf("%-15s", "scales");
+        for (int p = 0; p < PHASE_COLUMNS; p++) printf(" %8s", phase_labels[p]);
+        printf(" %8s\n", "total");
+        for (int s = 1; s < config.scale_count; s++) {
+            const ScaleSummary* b = &summaries[s];
+            int from = s - 1;
+            while (from >= 0 && (summaries[from].lines <= 0 ||
+                                 summaries[from].lines * MIN_SIZE_RATIO > b->lines)) {
+                from--;
+            }
+            if (from < 0) continue;      /* No scale small enough to compare with */
+
+            const ScaleSummary* a = &summaries[from];
+            char label[32];
+            snprintf(label, sizeof(label), "%ld -> %ld", a->scale, b->scale);
+            printf("%-15s", label);
+            for (int p = 0; p <= PHASE_COLUMNS; p++) {
+                double ta = p < PHASE_COLUMNS ? a->phase_ms[p] : a->total_ms;
+                double tb = p < PHASE_COLUMNS ? b->phase_ms[p] : b->total_ms;
+                double e = growth(ta, tb, a->lines, b->lines);
+                int flagged = e > config.max_growth && ta >= 0.5 && tb >= 0.5;
+                printf(" %7.2f%s", e, flagged ? "!" : " ");
+                if (flagged) {
+                    super_linear++;
+                }
+            }
+            printf("\n");
+        }
+        if (super_linear > 0) {
+            printf("(!) super-linear: growth above %.2f in %d place(s)\n", config.max_growth, super_linear);
+        }
+    }
+
+    printf("\nFindings: %d crash(es), %d hang(s), %d rejected, %d outlier(s), %d super-linear\n",
+           findings.crashes, findings.hangs, findings.rejected, findings.outliers, super_linear);
+    if (findings.crashes + findings.hangs + findings.rejected + findings.outliers > 0) {
+        printf("Programs saved in %s/\n", config.keep_dir);
+    }
+
+    /* Crashes, hangs and rejected programs are bugs; slow spots are reported only */
+    return findings.crashes + findings.hangs + findings.rejected > 0 ? 1 : 0;
+}
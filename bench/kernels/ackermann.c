@@ -0,0 +1,28 @@
+// Kernel: Ackermann function
+// ack(2, n) and ack(3, 7) recurse deeply with nested calls as arguments.
+// Stresses recursion depth and calls inside argument lists.
+
+int ack(int m, int n) {
+    if (m == 0) {
+        return n + 1;
+    }
+    if (n == 0) {
+        return ack(m - 1, 1);
+    }
+    return ack(m - 1, ack(m, n - 1));
+}
+
+int main() {
+    int i;
+    int sum;
+
+    sum = 0;
+    i = 0;
+    while (i < 200) {
+        sum = sum + ack(2, i);
+        i = i + 1;
+    }
+    print(sum);
+    print(ack(3, 7));
+    return 0;
+}
@@ -0,0 +1,15 @@
+// Kernel: naive recursive Fibonacci
+// fib(29) makes about 1.6 million calls. Stresses the call sequence,
+// argument passing and stack frames.
+
+int fib(int n) {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+int main() {
+    print(fib(29));
+    return 0;
+}
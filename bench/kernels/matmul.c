@@ -0,0 +1,51 @@
+// Kernel: dense matrix multiply
+// C = A * B for 120 x 120 matrices stored row-major in one-dimensional
+// arrays, repeated 5 times. Stresses nested loops and indexed loads.
+
+int a[14400];
+int b[14400];
+int c[14400];
+
+int main() {
+    int n;
+    int i;
+    int j;
+    int k;
+    int sum;
+    int rep;
+    int check;
+
+    n = 120;
+    i = 0;
+    while (i < n * n) {
+        a[i] = i % 7 + 1;
+        b[i] = (i * 3) % 5 + 1;
+        i = i + 1;
+    }
+
+    check = 0;
+    rep = 0;
+    while (rep < 5) {
+        i = 0;
+        while (i < n) {
+            j = 0;
+            while (j < n) {
+                sum = 0;
+                k = 0;
+                while (k < n) {
+                    sum = sum + a[i * n + k] * b[k * n + j];
+                    k = k + 1;
+                }
+                c[i * n + j] = sum + rep;
+                j = j + 1;
+            }
+            i = i + 1;
+        }
+        check = (check + c[rep * 1234]) % 1000003;
+        rep = rep + 1;
+    }
+
+    print(check);
+    print(c[n * n - 1]);
+    return 0;
+}
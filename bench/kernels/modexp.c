@@ -0,0 +1,37 @@
+// Kernel: modular exponentiation
+// Sums base^exponent mod a prime for 60000 bases by square-and-multiply.
+// Stresses division and remainder; every product stays below 2^31.
+
+int powmod(int base, int exponent, int m) {
+    int result;
+    int b;
+    int e;
+
+    result = 1;
+    b = base % m;
+    e = exponent;
+    while (e > 0) {
+        if (e % 2 == 1) {
+            result = (result * b) % m;
+        }
+        b = (b * b) % m;
+        e = e / 2;
+    }
+    return result;
+}
+
+int main() {
+    int m;
+    int i;
+    int sum;
+
+    m = 40009;
+    sum = 0;
+    i = 1;
+    while (i <= 60000) {
+        sum = (sum + powmod(i, i + 12345, m)) % m;
+        i = i + 1;
+    }
+    print(sum);
+    return 0;
+}
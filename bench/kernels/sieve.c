@@ -0,0 +1,49 @@
+// Kernel: sieve of Eratosthenes
+// Counts the primes up to 200000, 10 times over. Stresses array stores in
+// a loop with a variable stride and a data-dependent branch.
+
+int flags[200001];
+
+int main() {
+    int n;
+    int i;
+    int j;
+    int count;
+    int rep;
+    int total;
+
+    n = 200000;
+    total = 0;
+    count = 0;
+    rep = 0;
+    while (rep < 10) {
+        i = 0;
+        while (i <= n) {
+            flags[i] = 1;
+            i = i + 1;
+        }
+
+        count = 0;
+        i = 2;
+        while (i <= n) {
+            if (flags[i] == 1) {
+                count = count + 1;
+                if (i <= n / i) {
+                    j = i * i;
+                    while (j <= n) {
+                        flags[j] = 0;
+                        j = j + i;
+                    }
+                }
+            }
+            i = i + 1;
+        }
+
+        total = total + count;
+        rep = rep + 1;
+    }
+
+    print(count);
+    print(total);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Kernel: insertion sort
+// Sorts 3000 pseudo-random numbers (linear congruential generator) and
+// checks the order. Stresses array loads and stores in an inner loop
+// with a data-dependent exit.
+
+int data[3000];
+
+int main() {
+    int n;
+    int i;
+    int j;
+    int key;
+    int seed;
+    int moving;
+    int sorted;
+    int check;
+
+    n = 3000;
+    seed = 405;
+    i = 0;
+    while (i < n) {
+        seed = (seed * 1103 + 12345) % 65536;
+        data[i] = seed;
+        i = i + 1;
+    }
+
+    i = 1;
+    while (i < n) {
+        key = data[i];
+        j = i - 1;
+        moving = 1;
+        while (moving == 1) {
+            if (j < 0) {
+                moving = 0;
+            } else {
+                if (data[j] > key) {
+                    data[j + 1] = data[j];
+                    j = j - 1;
+                } else {
+                    moving = 0;
+                }
+            }
+        }
+        data[j + 1] = key;
+        i = i + 1;
+    }
+
+    sorted = 1;
+    check = 0;
+    i = 1;
+    while (i < n) {
+        if (data[i - 1] > data[i]) {
+            sorted = 0;
+        }
+        check = (check * 31 + data[i]) % 1000003;
+        i = i + 1;
+    }
+    print(sorted);
+    print(check);
+    print(data[0]);
+    print(data[n - 1]);
+    return 0;
+}
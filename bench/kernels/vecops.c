@@ -0,0 +1,59 @@
+// Kernel: elementwise array arithmetic
+// Fills, copies, scales and sums 4000-element arrays, 500 times over.
+// Stresses the counted loops over a[i] that the vectorizer runs in
+// vector registers.
+
+int x[4000];
+int y[4000];
+int z[4000];
+
+int main() {
+    int n;
+    int i;
+    int k;
+    int rep;
+    int sum;
+    int dot;
+
+    n = 4000;
+    i = 0;
+    while (i < n) {
+        x[i] = i % 97 - 48;
+        i = i + 1;
+    }
+
+    sum = 0;
+    dot = 0;
+    rep = 0;
+    while (rep < 500) {
+        k = rep % 7 + 1;
+        i = 0;
+        while (i < n) {
+            y[i] = k;
+            i = i + 1;
+        }
+        i = 0;
+        while (i < n) {
+            z[i] = x[i] * k + y[i] - i;
+            i = i + 1;
+        }
+        i = 0;
+        while (i < n) {
+            y[i] = z[i];
+            i = i + 1;
+        }
+        i = 0;
+        while (i < n) {
+            sum = sum + y[i];
+            dot = dot + x[i] * z[i];
+            i = i + 1;
+        }
+        sum = sum % 1000003;
+        dot = dot % 1000003;
+        rep = rep + 1;
+    }
+
+    print(sum);
+    print(dot);
+    return 0;
+}
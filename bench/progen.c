@@ -0,0 +1,500 @@
+/*
+ * PROGEN.C - Random Program Generator Implementation
+ * CST-405 Compiler Project
+ *
+ * Expressions are built bottom-up together with a bound on their absolute
+ * value. Operators are only combined while the bound stays below 2^30, and
+ * every stored value is reduced with "% 1000" when its bound could exceed
+ * 999, so the program never depends on overflow behaviour. Division and
+ * modulo use "(x % 7 + 8)" (2..14) or a positive constant as the divisor;
+ * array indexes are a loop counter known to be in range or
+ * "((x % n + n) % n)".
+ */
+
+#include "progen.h"
+#include <stdarg.h>
+#include <string.h>
+
+#define MAX_FUNCTIONS   4096
+#define MAX_DEPTH       6
+#define EXPR_SIZE       4096
+#define EXPR_DEPTH      3
+
+#define VALUE_LIMIT     999L            /* Bound of every stored value */
+#define SAFE_BOUND      (1L << 30)      /* Bound of every intermediate value */
+#define LOOP_LIMIT      400L            /* Most iterations of a loop nest */
+#define FUNCTION_BUDGET 20000L          /* Statements executed per call (estimate) */
+#define MAIN_BUDGET     200000L         /* Statements executed by main (estimate) */
+
+/* Generator state */
+typedef struct {
+    FILE* out;                  /* Destination */
+    long lines;                 /* Lines written so far */
+    unsigned state;             /* Pseudo-random state */
+    const ProgramConfig* config;
+
+    int array_length[16];       /* Length of each global array */
+    int param_count[MAX_FUNCTIONS];
+    long call_cost[MAX_FUNCTIONS];  /* Estimated statements per call */
+
+    /* Function being generated */
+    int function;               /* Index (config->functions = main) */
+    int params;                 /* Its parameter count */
+    int local_array;            /* Length of its local array (0 = none) */
+    int level;                  /* Enclosing loops (counters i0 .. i<level-1> are live) */
+    int trips[MAX_DEPTH];       /* Iterations of each enclosing loop */
+    long multiplier;            /* Product of the enclosing loops' iterations */
+    long cost;                  /* Estimated statements executed so far */
+    long budget;                /* Estimate the function must stay under */
+} Generator;
+
+/* Helper: write one line of source at the given indentation level */
+static void line(Generator* g, int indent, const char* format, ...) {
+    for (int i = 0; i < indent && i < 40; i++) {
+        fputs("    ", g->out);
+    }
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(g->out, format, args);
+    va_end(args);
+
+    fputc('\n', g->out);
+    g->lines++;
+}
+
+/* Helper: pseudo-random number in [low, high] (LCG, deterministic) */
+static int pick(Generator* g, int low, int high) {
+    g->state = g->state * 1103515245u + 12345u;
+    return low + (int)((g->state >> 16) % (unsigned)(high - low + 1));
+}
+
+/* Helper: true with probability percent/100 */
+static int chance(Generator* g, int percent) {
+    return pick(g, 0, 99) < percent;
+}
+
+static long gen_expr(Generator* g, char* text, int depth);
+
+/* Helper: an index expression that is always within 0..length-1 */
+static void gen_index(Generator* g, char* text, int length, int depth) {
+    /* A live loop counter whose loop stays within the array */
+    if (g->level > 0 && chance(g, 50)) {
+        int d = pick(g, 0, g->level - 1);
+        if (g->trips[d] <= length) {
+            sprintf(text, "i%d", d);
+            return;
+        }
+    }
+    if (chance(g, 30)) {
+        sprintf(text, "%d", pick(g, 0, length - 1));
+        return;
+    }
+
+    char inner[EXPR_SIZE];
+    gen_expr(g, inner, depth);
+    sprintf(text, "((%s) %% %d + %d) %% %d", inner, length, length, length);
+}
+
+/* Helper: a function call, if one fits in the budget; returns its bound or -1 */
+static long gen_call(Generator* g, char* text, int depth) {
+    if (g->function == 0) return -1;
+    int callee = pick(g, 0, g->function - 1);
+    long cost = g->multiplier * g->call_cost[callee];
+    if (g->cost + cost > g->budget) return -1;
+    g->cost += cost;
+
+    int length = sprintf(text, "f%d(", callee);
+    for (int a = 0; a < g->param_count[callee]; a++) {
+        char arg[EXPR_SIZE];
+        long bound = gen_expr(g, arg, depth);
+        const char* format = bound > VALUE_LIMIT ? "%s(%s) %% 1000" : "%s%s";
+        if (length + strlen(arg) + 16 >= EXPR_SIZE) {
+            strcpy(arg, "1");
+            format = "%s%s";
+        }
+        length += sprintf(text + length, format, a > 0 ? ", " : "", arg);
+    }
+    strcpy(text + length, ")");
+    return VALUE_LIMIT;
+}
+
+/* Helper: a variable, constant, array element or call */
+static long gen_leaf(Generator* g, char* text, int depth) {
+    const ProgramConfig* c = g->config;
+    for (;;) {
+        switch (pick(g, 0, 9)) {
+            case 0:
+            case 1: {
+                int value = pick(g, 0, 99);
+                sprintf(text, "%d", value);
+                return value;
+            }
+            case 2:
+                if (g->level == 0) break;
+                sprintf(text, "i%d", pick(g, 0, g->level - 1));
+                return VALUE_LIMIT;
+            case 3:
+                if (g->params == 0) break;
+                sprintf(text, "p%d", pick(g, 0, g->params - 1));
+                return VALUE_LIMIT;
+            case 4:
+                if (c->globals == 0) break;
+                sprintf(text, "g%d", pick(g, 0, c->globals - 1));
+                return VALUE_LIMIT;
+            case 5:
+            case 6: {
+                if (c->arrays == 0 && g->local_array == 0) break;
+                char index[EXPR_SIZE];
+                int local = g->local_array > 0 && (c->arrays == 0 || chance(g, 50));
+                int array = local ? 0 : pick(g, 0, c->arrays - 1);
+                gen_index(g, index, local ? g->local_array : g->array_length[array],
+                          depth > 0 ? depth - 1 : 0);
+                if (local) {
+                    sprintf(text, "b[%s]", index);
+                } else {
+                    sprintf(text, "a%d[%s]", array, index);
+                }
+                return VALUE_LIMIT;
+            }
+            case 7: {
+                if (depth == 0 || !chance(g, 40)) break;
+                long bound = gen_call(g, text, depth - 1);
+                if (bound >= 0) return bound;
+                break;
+            }
+            default:
+                sprintf(text, "v%d", pick(g, 0, c->locals - 1));
+                return VALUE_LIMIT;
+        }
+    }
+}
+
+/* Helper: an expression (depth = levels of operators); returns its bound */
+static long gen_expr(Generator* g, char* text, int depth) {
+    if (depth == 0 || chance(g, 30)) {
+        return gen_leaf(g, text, depth);
+    }
+
+    char left[EXPR_SIZE], right[EXPR_SIZE];
+    long a = gen_expr(g, left, depth - 1);
+    long b;
+    if (strlen(left) > EXPR_SIZE / 3) {
+        strcpy(text, left);
+        return a;
+    }
+
+    switch (pick(g, 0, 5)) {
+        case 0:
+        case 1:
+            b = gen_expr(g, right, depth - 1);
+            if (a + b > SAFE_BOUND || strlen(right) > EXPR_SIZE / 3) break;
+            sprintf(text, "(%s %s %s)", left, chance(g, 50) ? "+" : "-", right);
+            return a + b;
+        case 2:
+            b = gen_expr(g, right, depth - 1);
+            if (a * b > SAFE_BOUND || strlen(right) > EXPR_SIZE / 3) break;
+            sprintf(text, "(%s * %s)", left, right);
+            return a * b;
+        case 3: {
+            /* Divisor 2..14 */
+            b = gen_expr(g, right, depth - 1);
+            if (strlen(right) > EXPR_SIZE / 3) break;
+            sprintf(text, "(%s / ((%s) %% 7 + 8))", left, right);
+            return a / 2;
+        }
+        case 4: {
+            int divisor = pick(g, 1, 50);
+            sprintf(text, "(%s %s %d)", left, chance(g, 50) ? "/" : "%", divisor);
+            return a;
+        }
+        default: {
+            b = gen_expr(g, right, depth - 1);
+            if (strlen(right) > EXPR_SIZE / 3) break;
+            sprintf(text, "(%s %% ((%s) %% 7 + 8))", left, right);
+            return a < 13 ? a : 13;
+        }
+    }
+
+    /* Did not fit: keep the left operand alone */
+    strcpy(text, left);
+    return a;
+}
+
+/* Helper: an expression that is safe to store (bound at most 999) */
+static void gen_value(Generator* g, char* text) {
+    char expr[EXPR_SIZE];
+    long bound = gen_expr(g, expr, pick(g, 0, EXPR_DEPTH));
+    if (bound > VALUE_LIMIT) {
+        sprintf(text, "(%s) %% 1000", expr);
+    } else {
+        strcpy(text, expr);
+    }
+}
+
+/* Helper: a condition */
+static void gen_condition(Generator* g, char* text) {
+    static const char* relops[] = { "<", ">", "<=", ">=", "==", "!=" };
+    char left[EXPR_SIZE], right[EXPR_SIZE];
+    gen_expr(g, left, pick(g, 0, 2));
+    gen_expr(g, right, pick(g, 0, 1));
+    if (strlen(left) + strlen(right) + 8 >= EXPR_SIZE) strcpy(right, "0");
+    sprintf(text, "%s %s %s", left, relops[pick(g, 0, 5)], right);
+}
+
+static void gen_block(Generator* g, int indent, int depth);
+
+/* Helper: one loop around a generated body */
+static void gen_loop(Generator* g, int indent, int depth, int trips) {
+    int d = g->level;
+    char condition[64];
+    snprintf(condition, sizeof(condition), "i%d < %d", d, trips);
+
+    g->trips[d] = trips;
+    g->level++;
+    g->multiplier *= trips;
+
+    switch (pick(g, 0, 2)) {
+        case 0:
+            line(g, indent, "for (i%d = 0; %s; i%d = i%d + 1;) {", d, condition, d, d);
+            gen_block(g, indent + 1, depth + 1);
+            line(g, indent, "}");
+            break;
+        case 1:
+            line(g, indent, "i%d = 0;", d);
+            line(g, indent, "while (%s) {", condition);
+            gen_block(g, indent + 1, depth + 1);
+            line(g, indent + 1, "i%d = i%d + 1;", d, d);
+            line(g, indent, "}");
+            break;
+        default:
+            line(g, indent, "i%d = 0;", d);
+            line(g, indent, "do {");
+            gen_block(g, indent + 1, depth + 1);
+            line(g, indent + 1, "i%d = i%d + 1;", d, d);
+            line(g, indent, "} while (%s);", condition);
+            break;
+    }
+
+    g->multiplier /= trips;
+    g->level--;
+}
+
+/* Helper: one statement */
+static void gen_statement(Generator* g, int indent, int depth, int last) {
+    const ProgramConfig* c = g->config;
+    char value[EXPR_SIZE], index[EXPR_SIZE], condition[EXPR_SIZE];
+    g->cost += g->multiplier;
+
+    for (;;) {
+        switch (pick(g, 0, 11)) {
+            case 0:
+            case 1:
+            case 2: {
+                /* Scalar assignment (globals, locals and parameters) */
+                gen_value(g, value);
+                int kind = pick(g, 0, 2);
+                if (kind == 0 && c->globals > 0) {
+                    line(g, indent, "g%d = %s;", pick(g, 0, c->globals - 1), value);
+                } else if (kind == 1 && g->params > 0) {
+                    line(g, indent, "p%d = %s;", pick(g, 0, g->params - 1), value);
+                } else {
+                    line(g, indent, "v%d = %s;", pick(g, 0, c->locals - 1), value);
+                }
+                return;
+            }
+            case 3:
+            case 4: {
+                /* Array element assignment */
+                if (c->arrays == 0 && g->local_array == 0) break;
+                int local = g->local_array > 0 && (c->arrays == 0 || chance(g, 50));
+                int array = local ? 0 : pick(g, 0, c->arrays - 1);
+                gen_index(g, index, local ? g->local_array : g->array_length[array], 1);
+                gen_value(g, value);
+                if (local) {
+                    line(g, indent, "b[%s] = %s;", index, value);
+                } else {
+                    line(g, indent, "a%d[%s] = %s;", array, index, value);
+                }
+                return;
+            }
+            case 5:
+            case 6:
+                gen_expr(g, value, pick(g, 0, EXPR_DEPTH));
+                line(g, indent, "print(%s);", value);
+                return;
+            case 7:
+            case 8: {
+                /* if / if-else */
+                if (depth >= c->depth) break;
+                gen_condition(g, condition);
+                line(g, indent, "if (%s) {", condition);
+                gen_block(g, indent + 1, depth + 1);
+                if (chance(g, 50)) {
+                    line(g, indent, "} else {");
+                    gen_block(g, indent + 1, depth + 1);
+                }
+                line(g, indent, "}");
+                return;
+            }
+            case 9:
+            case 10: {
+                /* A counted loop, if the iterations fit */
+                if (depth >= c->depth || g->level >= MAX_DEPTH) break;
+                int trips = pick(g, 1, 8);
+                while (trips > 1 && g->multiplier * trips > LOOP_LIMIT) trips--;
+                if (g->multiplier * trips > LOOP_LIMIT) break;
+                gen_loop(g, indent, depth, trips);
+                return;
+            }
+            default:
+                /* Early return from a branch (as the block's last statement) */
+                if (!last || depth == 0 || !chance(g, 20)) break;
+                gen_value(g, value);
+                line(g, indent, "return %s;", value);
+                return;
+        }
+    }
+}
+
+/* Helper: a block of statements */
+static void gen_block(Generator* g, int indent, int depth) {
+    int count = pick(g, 1, g->config->statements);
+    if (depth > 0 && count > 3) count = pick(g, 1, 3);
+    for (int s = 0; s < count; s++) {
+        gen_statement(g, indent, depth, s == count - 1);
+    }
+}
+
+/* Helper: one function (main when index == config->functions) */
+static void gen_function(Generator* g, int index) {
+    const ProgramConfig* c = g->config;
+    int is_main = index == c->functions;
+    char value[EXPR_SIZE];
+
+    g->function = index;
+    g->params = is_main ? 0 : pick(g, 0, 3);
+    g->local_array = chance(g, 50) ? pick(g, 1, 12) : 0;
+    g->level = 0;
+    g->multiplier = 1;
+    g->cost = 0;
+    g->budget = is_main ? MAIN_BUDGET : FUNCTION_BUDGET;
+
+    if (is_main) {
+        line(g, 0, "int main() {");
+    } else {
+        char params[128] = "";
+        for (int p = 0; p < g->params; p++) {
+            char param[16];
+            snprintf(param, sizeof(param), "%sint p%d", p > 0 ? ", " : "", p);
+            strcat(params, param);
+        }
+        line(g, 0, "int f%d(%s) {", index, params);
+        g->param_count[index] = g->params;
+    }
+
+    /* Locals, all initialized before the body reads them */
+    for (int v = 0; v < c->locals; v++) {
+        line(g, 1, "int v%d;", v);
+    }
+    for (int d = 0; d <= c->depth && d < MAX_DEPTH; d++) {
+        line(g, 1, "int i%d;", d);
+    }
+    if (g->local_array > 0) {
+        line(g, 1, "int b[%d];", g->local_array);
+    }
+    for (int v = 0; v < c->locals; v++) {
+        if (g->params > 0 && chance(g, 50)) {
+            line(g, 1, "v%d = p%d;", v, pick(g, 0, g->params - 1));
+        } else {
+            line(g, 1, "v%d = %d;", v, pick(g, 0, 99));
+        }
+    }
+    if (is_main && c->globals > 0) {
+        line(g, 1, "v0 = setup();");
+    }
+    if (g->local_array > 0) {
+        line(g, 1, "for (i0 = 0; i0 < %d; i0 = i0 + 1;) {", g->local_array);
+        line(g, 2, "b[i0] = i0 * %d + %d;", pick(g, 1, 9), pick(g, 0, 99));
+        line(g, 1, "}");
+    }
+
+    gen_block(g, 1, 0);
+
+    if (is_main) {
+        /* Final state of the globals, so stores to them are checked too */
+        for (int v = 0; v < c->globals; v++) {
+            line(g, 1, "print(g%d);", v);
+        }
+        for (int a = 0; a < c->arrays; a++) {
+            line(g, 1, "print(a%d[%d]);", a, pick(g, 0, g->array_length[a] - 1));
+        }
+    }
+    gen_value(g, value);
+    line(g, 1, "return %s;", value);
+    line(g, 0, "}");
+    line(g, 0, "");
+
+    g->call_cost[index] = g->cost + 1;
+}
+
+/* Configuration for a size from 1 to 10 */
+void default_program_config(ProgramConfig* config, int size) {
+    if (size < 1) size = 1;
+    if (size > 10) size = 10;
+    config->functions = size;
+    config->statements = 3 + size;
+    config->depth = size < 3 ? 2 : 3;
+    config->globals = 1 + size / 2;
+    config->arrays = 1 + size / 4;
+    config->locals = 2 + size / 3;
+}
+
+/* Write one random program */
+long generate_program(FILE* out, const ProgramConfig* config, unsigned seed) {
+    Generator g;
+    memset(&g, 0, sizeof(g));
+    g.out = out;
+    g.state = seed;
+    g.config = config;
+
+    ProgramConfig bounded = *config;
+    if (bounded.functions > MAX_FUNCTIONS - 1) bounded.functions = MAX_FUNCTIONS - 1;
+    if (bounded.functions < 0) bounded.functions = 0;
+    if (bounded.statements < 1) bounded.statements = 1;
+    if (bounded.depth > MAX_DEPTH - 1) bounded.depth = MAX_DEPTH - 1;
+    if (bounded.depth < 0) bounded.depth = 0;
+    if (bounded.globals < 0) bounded.globals = 0;
+    if (bounded.arrays > 16) bounded.arrays = 16;
+    if (bounded.arrays < 0) bounded.arrays = 0;
+    if (bounded.locals < 1) bounded.locals = 1;
+    g.config = &bounded;
+
+    line(&g, 0, "// Generated program: seed %u, %d functions", seed, bounded.functions);
+
+    for (int v = 0; v < bounded.globals; v++) {
+        line(&g, 0, "int g%d;", v);
+    }
+    for (int a = 0; a < bounded.arrays; a++) {
+        g.array_length[a] = pick(&g, 1, 16);
+        line(&g, 0, "int a%d[%d];", a, g.array_length[a]);
+    }
+    line(&g, 0, "");
+
+    /* Globals are read only after an assignment earlier in the source
+     * (semantic analysis checks this); main calls setup() first */
+    if (bounded.globals > 0) {
+        line(&g, 0, "int setup() {");
+        for (int v = 0; v < bounded.globals; v++) {
+            line(&g, 1, "g%d = 0;", v);
+        }
+        line(&g, 1, "return 0;");
+        line(&g, 0, "}");
+        line(&g, 0, "");
+    }
+
+    for (int f = 0; f <= bounded.functions; f++) {
+        gen_function(&g, f);
+    }
+    return g.lines;
+}
@@ -0,0 +1,43 @@
+/*
+ * PROGEN.H - Random Program Generator
+ * CST-405 Compiler Project
+ *
+ * Generates random, well-typed programs that exercise the whole language:
+ * global and local scalars and arrays, functions with parameters calling
+ * each other, nested for/while/do-while loops, if/else and early returns,
+ * with print() calls along the way so the program's behaviour is visible
+ * in its output. Used by the differential tester (difftest) to compare
+ * optimized and unoptimized builds and by the fuzzer (fuzz).
+ *
+ * Every generated program is deterministic and terminates: loops count a
+ * counter that nothing else writes up to a small bound, functions only
+ * call functions defined before them, the estimated number of executed
+ * statements stays under a budget, every variable keeps a value in
+ * -999..999, no intermediate result leaves 32-bit range, divisors are
+ * never zero and array indexes are always in range. Output is the same
+ * for a given configuration and seed.
+ */
+
+#ifndef PROGEN_H
+#define PROGEN_H
+
+#include <stdio.h>
+
+/* Size of the generated programs */
+typedef struct {
+    int functions;              /* Functions besides main (at most 4095) */
+    int statements;             /* Statements per block (at most) */
+    int depth;                  /* Deepest nesting of loops and ifs */
+    int globals;                /* Global scalar variables */
+    int arrays;                 /* Global arrays */
+    int locals;                 /* Local scalars per function */
+} ProgramConfig;
+
+/* Configuration for a size from 1 (tiny) to 10 (large); larger sizes
+ * grow the number of functions and statements */
+void default_program_config(ProgramConfig* config, int size);
+
+/* Write one random program to out. Returns the number of lines written. */
+long generate_program(FILE* out, const ProgramConfig* config, unsigned seed);
+
+#endif /* PROGEN_H */
@@ -0,0 +1,525 @@
+/*
+ * RUNBENCH.C - Runtime Benchmark Harness
+ * CST-405 Compiler Project
+ *
+ * Measures how fast compiled programs run. Every kernel in the kernel
+ * directory (bench/kernels, one .c file per kernel) is built several ways:
+ *   cst405     - the compiler under test, assembled with nasm, linked with cc
+ *   <baseline> - other compiler builds (--baseline, e.g. a previous version)
+ *   gcc -O0    - the same source as C (print() becomes printf)
+ *   gcc -O2
+ * Each binary runs --repeat times in a fresh process; the report gives the
+ * fastest and median wall time, the CPU time and peak RSS of the fastest
+ * run, the slowdown against gcc -O2 and, with --perf, the cycle and
+ * instruction counts from perf stat. Output is checked against gcc -O0 so
+ * a miscompiled kernel shows up as WRONG rather than as a fast time.
+ * Kernels use only while loops, so they are valid C as well.
+ * Linux/POSIX only.
+ *
+ * Usage: runbench [options]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define MAX_KERNELS   64
+#define MAX_BASELINES 4
+#define MAX_VARIANTS  (MAX_BASELINES + 3)
+#define MAX_REPEAT    101
+
+/* How a variant is built */
+typedef enum {
+    BUILD_CST405,               /* compiler -> nasm -> cc */
+    BUILD_GCC                   /* cc with the print() prelude */
+} BuildKind;
+
+/* One way of building a kernel */
+typedef struct {
+    char label[32];             /* Column label ("cst405", "gcc -O2", ...) */
+    BuildKind kind;
+    const char* tool;           /* Compiler binary, or C optimization flag */
+} Variant;
+
+/* Harness settings */
+typedef struct {
+    const char* compiler;       /* Compiler under test */
+    const char* flags;          /* Extra compiler flags */
+    const char* baselines[MAX_BASELINES];
+    int baseline_count;
+    const char* kernel_dir;     /* Directory of kernel sources */
+    const char* only;           /* Comma-separated kernel names (NULL = all) */
+    const char* nasm;           /* Assembler */
+    const char* cc;             /* C compiler / linker */
+    int repeat;                 /* Runs per binary */
+    int timeout;                /* Seconds before a run is killed */
+    int gcc;                    /* Build the gcc references */
+    int perf;                   /* Collect perf stat counters */
+    int json;                   /* One JSON object per measurement */
+} RunConfig;
+
+/* Measurement of one kernel built one way */
+typedef struct {
+    char status[48];            /* "ok", "WRONG", "build failed", "exit 3", ... */
+    int ok;                     /* Built, ran and printed the expected output */
+    double best_ms;             /* Fastest wall time */
+    double median_ms;           /* Median wall time */
+    double cpu_ms;              /* User + system CPU time of the fastest run */
+    long peak_rss_kb;           /* Peak RSS of the fastest run */
+    long long cycles;           /* perf stat counters (-1 = not measured) */
+    long long instructions;
+} RunResult;
+
+/* Helper: monotonic wall-clock time in milliseconds */
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Helper: run a shell command with its output going to log. Returns 1 on success. */
+static int shell(const char* command, const char* log) {
+    char line[4096];
+    snprintf(line, sizeof(line), "%s >>%s 2>&1", command, log);
+    return system(line) == 0;
+}
+
+/* Helper: is this a kernel the user asked for? */
+static int selected(const RunConfig* config, const char* name) {
+    if (!config->only) return 1;
+
+    size_t length = strlen(name);
+    for (const char* p = config->only; *p; ) {
+        const char* end = strchr(p, ',');
+        size_t item = end ? (size_t)(end - p) : strlen(p);
+        if (item == length && strncmp(p, name, length) == 0) return 1;
+        if (!end) break;
+        p = end + 1;
+    }
+    return 0;
+}
+
+/* Helper: collect the kernel names (file names without .c), sorted */
+static int find_kernels(const RunConfig* config, char names[][64]) {
+    DIR* dir = opendir(config->kernel_dir);
+    if (!dir) return -1;
+
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) && count < MAX_KERNELS) {
+        size_t length = strlen(entry->d_name);
+        if (length < 3 || length >= 64 || strcmp(entry->d_name + length - 2, ".c") != 0) continue;
+
+        char name[64];
+        memcpy(name, entry->d_name, length - 2);
+        name[length - 2] = '\0';
+        if (!selected(config, name)) continue;
+
+        int i = count++;
+        while (i > 0 && strcmp(names[i - 1], name) > 0) {
+            strcpy(names[i], names[i - 1]);
+            i--;
+        }
+        strcpy(names[i], name);
+    }
+    closedir(dir);
+    return count;
+}
+
+/* Helper: build one kernel; returns 1 and the binary path on success */
+static int build_variant(const RunConfig* config, const Variant* variant, const char* work,
+                         const char* kernel, char* binary, size_t size) {
+    char source[1024], log[1100], command[4096];
+    snprintf(source, sizeof(source), "%s/%s.c", config->kernel_dir, kernel);
+    snprintf(log, sizeof(log), "%s/build.log", work);
+    snprintf(binary, size, "%s/%s", work, kernel);
+
+    if (variant->kind == BUILD_GCC) {
+        snprintf(command, sizeof(command), "%s %s -w -include %s/../print.h -o %s %s",
+                 config->cc, variant->tool, work, binary, source);
+        return shell(command, log);
+    }
+
+    snprintf(command, sizeof(command), "%s %s -o %s -q %s",
+             variant->tool, source, work, variant->tool == config->compiler ? config->flags : "");
+    if (!shell(command, log)) return 0;
+
+    snprintf(command, sizeof(command), "%s -f elf64 -o %s.o %s.asm", config->nasm, binary, binary);
+    if (!shell(command, log)) return 0;
+
+    snprintf(command, sizeof(command), "%s -no-pie -o %s %s.o", config->cc, binary, binary);
+    return shell(command, log);
+}
+
+/* Helper: run a binary once with stdout in output_path.
+ * Returns the wait status (-1 if it could not be started). */
+static int run_once(const RunConfig* config, char* const argv[], const char* output_path,
+                    double* wall_ms, struct rusage* usage) {
+    double start = now_ms();
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+
+    if (pid == 0) {
+        int fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) _exit(126);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        alarm(config->timeout);        /* Survives exec: kills runaway kernels */
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    int status = 0;
+    if (wait4(pid, &status, 0, usage) < 0) return -1;
+    *wall_ms = now_ms() - start;
+    return status;
+}
+
+/* Helper: compare two files */
+static int same_file(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    int same = fa && fb;
+    while (same) {
+        int ca = fgetc(fa);
+        int cb = fgetc(fb);
+        if (ca != cb) same = 0;
+        if (ca == EOF || cb == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+/* Helper: read one counter from perf stat -x, output ("value,unit,event,...") */
+static long long perf_counter(const char* path, const char* event) {
+    FILE* in = fopen(path, "r");
+    if (!in) return -1;
+
+    long long value = -1;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        char* unit = strchr(line, ',');
+        if (!unit) continue;
+        char* name = strchr(unit + 1, ',');
+        if (name && strncmp(name + 1, event, strlen(event)) == 0 &&
+            (name[1 + strlen(event)] == ',' || name[1 + strlen(event)] == ':')) {
+            value = strtoll(line, NULL, 10);     /* "<not counted>" reads as 0 */
+            break;
+        }
+    }
+    fclose(in);
+    return value;
+}
+
+/* Helper: sort run times for the median */
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Run one built kernel repeatedly and fill in result */
+static void measure(const RunConfig* config, const char* binary, const char* work,
+                    const char* expected, RunResult* result) {
+    char output[1100];
+    snprintf(output, sizeof(output), "%s/output.txt", work);
+
+    double times[MAX_REPEAT];
+    char* argv[] = { (char*)binary, NULL };
+    for (int r = 0; r < config->repeat; r++) {
+        struct rusage usage;
+        memset(&usage, 0, sizeof(usage));
+        int status = run_once(config, argv, output, &times[r], &usage);
+
+        if (status < 0) {
+            snprintf(result->status, sizeof(result->status), "cannot run");
+            return;
+        }
+        if (WIFSIGNALED(status)) {
+            snprintf(result->status, sizeof(result->status), "%s",
+                     WTERMSIG(status) == SIGALRM ? "timeout" : strsignal(WTERMSIG(status)));
+            return;
+        }
+        if (WEXITSTATUS(status) != 0) {
+            snprintf(result->status, sizeof(result->status), "exit %d", WEXITSTATUS(status));
+            return;
+        }
+        if (r == 0 && expected && !same_file(output, expected)) {
+            snprintf(result->status, sizeof(result->status), "WRONG");
+            return;
+        }
+
+        if (r == 0 || times[r] < result->best_ms) {
+            result->best_ms = times[r];
+            result->cpu_ms = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0 +
+                             usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+            result->peak_rss_kb = usage.ru_maxrss;
+        }
+    }
+
+    qsort(times, config->repeat, sizeof(double), compare_doubles);
+    result->median_ms = times[config->repeat / 2];
+    result->ok = 1;
+    snprintf(result->status, sizeof(result->status), "ok");
+
+    /* One more run under perf for hardware counters */
+    if (config->perf) {
+        char counters[1100];
+        snprintf(counters, sizeof(counters), "%s/perf.txt", work);
+        char* perf_argv[] = { "perf", "stat", "-x,", "-e", "cycles,instructions",
+                              "-o", counters, "--", (char*)binary, NULL };
+        struct rusage usage;
+        double wall;
+        if (run_once(config, perf_argv, output, &wall, &usage) == 0) {
+            result->cycles = perf_counter(counters, "cycles");
+            result->instructions = perf_counter(counters, "instructions");
+        }
+    }
+}
+
+/* Helper: print a JSON string value */
+static void json_string(const char* text) {
+    putchar('"');
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') putchar('\\');
+        putchar(*p);
+    }
+    putchar('"');
+}
+
+/* Report one measurement */
+static void print_result(const RunConfig* config, const char* kernel, const Variant* variant,
+                         const RunResult* result, const RunResult* reference, int first) {
+    double ratio = result->ok && reference && reference->ok && reference->best_ms > 0
+                   ? result->best_ms / reference->best_ms : 0.0;
+
+    if (config->json) {
+        printf("{\"kernel\": ");
+        json_string(kernel);
+        printf(", \"variant\": ");
+        json_string(variant->label);
+        printf(", \"status\": ");
+        json_string(result->status);
+        if (result->ok) {
+            printf(", \"best_ms\": %.3f, \"median_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_kb\": %ld",
+                   result->best_ms, result->median_ms, result->cpu_ms, result->peak_rss_kb);
+            if (ratio > 0) printf(", \"vs_gcc_O2\": %.3f", ratio);
+            if (result->cycles >= 0) printf(", \"cycles\": %lld", result->cycles);
+            if (result->instructions >= 0) printf(", \"instructions\": %lld", result->instructions);
+        }
+        printf("}\n");
+        fflush(stdout);
+        return;
+    }
+
+    printf("%-12s %-14s %-12s", first ? kernel : "", variant->label, result->status);
+    if (result->ok) {
+        printf(" %9.2f %9.2f %9.2f %9ld", result->best_ms, result->median_ms,
+               result->cpu_ms, result->peak_rss_kb);
+        if (ratio > 0) {
+            printf(" %8.2fx", ratio);
+        } else {
+            printf(" %9s", "-");
+        }
+        if (config->perf) {
+            if (result->cycles >= 0 && result->instructions >= 0) {
+                printf(" %14lld %14lld", result->cycles, result->instructions);
+            } else {
+                printf(" %14s %14s", "n/a", "n/a");
+            }
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/* Run every kernel in every variant. Returns 1 if the harness itself failed. */
+static int run_benchmarks(const RunConfig* config) {
+    char names[MAX_KERNELS][64];
+    int kernel_count = find_kernels(config, names);
+    if (kernel_count < 0) {
+        fprintf(stderr, "Error: Cannot read kernel directory %s\n", config->kernel_dir);
+        return 1;
+    }
+    if (kernel_count == 0) {
+        fprintf(stderr, "Error: No kernels selected in %s\n", config->kernel_dir);
+        return 1;
+    }
+
+    char root[] = "/tmp/cst405-run-XXXXXX";
+    if (!mkdtemp(root)) {
+        fprintf(stderr, "Error: Cannot create a temporary directory\n");
+        return 1;
+    }
+
+    /* print() for the C builds */
+    char prelude[1100];
+    snprintf(prelude, sizeof(prelude), "%s/print.h", root);
+    FILE* out = fopen(prelude, "w");
+    if (!out) {
+        fprintf(stderr, "Error: Cannot write %s\n", prelude);
+        return 1;
+    }
+    fprintf(out, "#include <stdio.h>\n#define print(x) printf(\"%%d\\n\", (int)(x))\n");
+    fclose(out);
+
+    /* Variants: the gcc -O0 reference first, it defines the expected output */
+    Variant variants[MAX_VARIANTS];
+    int variant_count = 0;
+    int reference_index = -1;
+    if (config->gcc) {
+        variants[variant_count++] = (Variant){ "gcc -O0", BUILD_GCC, "-O0" };
+    }
+    variants[variant_count++] = (Variant){ "cst405", BUILD_CST405, config->compiler };
+    for (int b = 0; b < config->baseline_count; b++) {
+        Variant* v = &variants[variant_count++];
+        snprintf(v->label, sizeof(v->label), "baseline%d", b + 1);
+        v->kind = BUILD_CST405;
+        v->tool = config->baselines[b];
+    }
+    if (config->gcc) {
+        reference_index = variant_count;
+        variants[variant_count++] = (Variant){ "gcc -O2", BUILD_GCC, "-O2" };
+    }
+
+    if (!config->json) {
+        printf("Compiler: %s %s\n", config->compiler, config->flags);
+        for (int b = 0; b < config->baseline_count; b++) {
+            printf("baseline%d: %s\n", b + 1, config->baselines[b]);
+        }
+        printf("Wall-clock ms over %d run(s); CPU ms and peak KiB of the fastest run\n\n",
+               config->repeat);
+        printf("%-12s %-14s %-12s %9s %9s %9s %9s %9s", "kernel", "variant", "status",
+               "best ms", "median", "cpu ms", "peak KiB", "vs -O2");
+        if (config->perf) printf(" %14s %14s", "cycles", "instructions");
+        printf("\n");
+    }
+
+    int failures = 0;
+    for (int k = 0; k < kernel_count; k++) {
+        RunResult results[MAX_VARIANTS];
+        char expected[1100] = "";
+
+        for (int v = 0; v < variant_count; v++) {
+            RunResult* result = &results[v];
+            memset(result, 0, sizeof(*result));
+            result->cycles = -1;
+            result->instructions = -1;
+
+            char work[1100], binary[1200];
+            snprintf(work, sizeof(work), "%s/%d", root, v);
+            mkdir(work, 0755);          /* Already exists after the first kernel */
+
+            if (!build_variant(config, &variants[v], work, names[k], binary, sizeof(binary))) {
+                snprintf(result->status, sizeof(result->status), "build failed");
+                continue;
+            }
+
+            measure(config, binary, work, expected[0] ? expected : NULL, result);
+
+            /* The first successful run of the first variant is the expected output */
+            if (!expected[0] && result->ok) {
+                snprintf(expected, sizeof(expected), "%s/expected.txt", root);
+                char command[2400];
+                snprintf(command, sizeof(command), "cp %s/output.txt %s", work, expected);
+                if (system(command) != 0) expected[0] = '\0';
+            }
+        }
+
+        for (int v = 0; v < variant_count; v++) {
+            if (!results[v].ok) failures++;
+            print_result(config, names[k], &variants[v], &results[v],
+                         reference_index >= 0 ? &results[reference_index] : NULL, v == 0);
+        }
+        if (!config->json) printf("\n");
+    }
+
+    char cleanup[1100];
+    snprintf(cleanup, sizeof(cleanup), "rm -rf %s", root);
+    if (system(cleanup) != 0) {
+        fprintf(stderr, "Warning: Cannot remove %s\n", root);
+    }
+
+    /* Wrong or failed builds are results, not harness errors */
+    if (failures > 0 && !config->json) {
+        printf("%d measurement(s) failed or gave wrong output\n", failures);
+    }
+    return 0;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --compiler <path>  Compiler to measure (default ./compiler)\n");
+    fprintf(stderr, "  --flags \"<f>\"      Extra flags for that compiler\n");
+    fprintf(stderr, "  --baseline <path>  Also measure another compiler build (up to %d)\n", MAX_BASELINES);
+    fprintf(stderr, "  --kernels <dir>    Kernel sources (default bench/kernels)\n");
+    fprintf(stderr, "  --only <a,b>       Run only these kernels\n");
+    fprintf(stderr, "  --repeat <n>       Runs per binary (default 5)\n");
+    fprintf(stderr, "  --timeout <s>      Kill a run after this many seconds (default 60)\n");
+    fprintf(stderr, "  --nasm <path>      Assembler (default nasm)\n");
+    fprintf(stderr, "  --cc <path>        C compiler and linker (default cc)\n");
+    fprintf(stderr, "  --no-gcc           Skip the gcc -O0/-O2 references\n");
+    fprintf(stderr, "  --perf             Add perf stat cycle and instruction counts\n");
+    fprintf(stderr, "  --json             One JSON object per measurement\n");
+}
+
+int main(int argc, char* argv[]) {
+    RunConfig config;
+    memset(&config, 0, sizeof(config));
+    config.compiler = "./compiler";
+    config.flags = "";
+    config.kernel_dir = "bench/kernels";
+    config.nasm = "nasm";
+    config.cc = "cc";
+    config.repeat = 5;
+    config.timeout = 60;
+    config.gcc = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compiler") == 0 && i + 1 < argc) {
+            config.compiler = argv[++i];
+        } else if (strcmp(argv[i], "--flags") == 0 && i + 1 < argc) {
+            config.flags = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            if (config.baseline_count == MAX_BASELINES) {
+                fprintf(stderr, "Error: At most %d baselines\n", MAX_BASELINES);
+                return 1;
+            }
+            config.baselines[config.baseline_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--kernels") == 0 && i + 1 < argc) {
+            config.kernel_dir = argv[++i];
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            config.only = argv[++i];
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            config.repeat = atoi(argv[++i]);
+            if (config.repeat < 1) config.repeat = 1;
+            if (config.repeat > MAX_REPEAT) config.repeat = MAX_REPEAT;
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            config.timeout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--nasm") == 0 && i + 1 < argc) {
+            config.nasm = argv[++i];
+        } else if (strcmp(argv[i], "--cc") == 0 && i + 1 < argc) {
+            config.cc = argv[++i];
+        } else if (strcmp(argv[i], "--no-gcc") == 0) {
+            config.gcc = 0;
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            config.perf = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            config.json = 1;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    return run_benchmarks(&config);
+}
@@ -0,0 +1,22 @@
+// Trap: a load with a negative index
+// Run with --bounds-check: prints the element at index 2, then stops with
+// "array index out of range" and exit status 1 on the load of a[-1],
+// which the unsigned compare sees as an index far above the array size.
+
+int a[10];
+
+int get(int k) {
+    return a[k];
+}
+
+int main() {
+    int i;
+    for (i = 0; i < 10; i = i + 1;) {
+        a[i] = i * 5;
+    }
+    print(get(2));
+    print(get(3 - 4));
+    return 0;
+}
+
+// expect: 10
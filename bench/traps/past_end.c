@@ -0,0 +1,25 @@
+// Trap: an off-by-one loop stores one element past the end of an array
+// Run with --bounds-check: prints the sum of the elements stored so far,
+// then stops with "array index out of range" and exit status 1 on the
+// store to a[10]. The i <= 10 test does not bound i below 10, so the
+// check is kept at every optimization level.
+
+int a[10];
+
+int main() {
+    int i;
+    int s;
+    s = 0;
+    for (i = 0; i < 10; i = i + 1;) {
+        a[i] = i + 1;
+        s = s + a[i];
+    }
+    print(s);
+    for (i = 0; i <= 10; i = i + 1;) {
+        a[i] = a[i] * 2;
+    }
+    print(a[0]);
+    return 0;
+}
+
+// expect: 55
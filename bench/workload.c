@@ -0,0 +1,241 @@
+/*
+ * WORKLOAD.C - Synthetic Workload Generator Implementation
+ * CST-405 Compiler Project
+ *
+ * Every generated program declares and initializes its variables before
+ * use, only calls functions defined earlier and never divides by a value
+ * that can be zero, so it passes semantic analysis at any scale.
+ */
+
+#include "workload.h"
+#include <stdarg.h>
+#include <string.h>
+
+/* Generator state */
+typedef struct {
+    FILE* out;                  /* Destination */
+    long lines;                 /* Lines written so far */
+    unsigned state;             /* Pseudo-random state */
+} Workload;
+
+static const char* shape_names[SHAPE_COUNT] = {
+    "functions", "nesting", "straight", "arrays", "globals"
+};
+
+/* Name of a shape */
+const char* workload_shape_name(WorkloadShape shape) {
+    return shape >= 0 && shape < SHAPE_COUNT ? shape_names[shape] : "unknown";
+}
+
+/* Look up a shape by name */
+int find_workload_shape(const char* name) {
+    for (int i = 0; i < SHAPE_COUNT; i++) {
+        if (strcmp(shape_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+/* Helper: write one line of source at the given indentation level */
+static void line(Workload* w, int indent, const char* format, ...) {
+    for (int i = 0; i < indent && i < 40; i++) {
+        fputs("    ", w->out);
+    }
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(w->out, format, args);
+    va_end(args);
+
+    fputc('\n', w->out);
+    w->lines++;
+}
+
+/* Helper: pseudo-random number in [low, high] (LCG, deterministic) */
+static int pick(Workload* w, int low, int high) {
+    w->state = w->state * 1103515245u + 12345u;
+    return low + (int)((w->state >> 16) % (unsigned)(high - low + 1));
+}
+
+/* Helper: an arithmetic operator that is safe with a non-zero right operand */
+static const char* pick_op(Workload* w) {
+    static const char* ops[] = { "+", "-", "*", "/", "%" };
+    return ops[pick(w, 0, 4)];
+}
+
+/* functions: N functions with a loop, a branch and a call to the previous one */
+static void gen_functions(Workload* w, long count) {
+    for (long i = 0; i < count; i++) {
+        line(w, 0, "int f%ld(int a, int b) {", i);
+        line(w, 1, "int r;");
+        line(w, 1, "int k;");
+        line(w, 1, "r = b;");
+        line(w, 1, "k = 0;");
+        line(w, 1, "while (k < a) {");
+        int scale = pick(w, 1, 9);
+        int offset = pick(w, 1, 99);
+        const char* op = pick_op(w);
+        line(w, 2, "r = r + k * %d - %d %s %d;", scale, offset, op, pick(w, 1, 9));
+        line(w, 2, "k = k + 1;");
+        line(w, 1, "}");
+        line(w, 1, "if (r > %d) {", pick(w, 100, 999));
+        line(w, 2, "r = r %% %d;", pick(w, 2, 97));
+        line(w, 1, "} else {");
+        line(w, 2, "r = r + %d;", pick(w, 1, 50));
+        line(w, 1, "}");
+        if (i > 0) {
+            line(w, 1, "r = r + f%ld(%d, r);", i - 1, pick(w, 1, 3));
+        }
+        line(w, 1, "return r;");
+        line(w, 0, "}");
+    }
+
+    line(w, 0, "int main() {");
+    line(w, 1, "int x;");
+    line(w, 1, "x = 0;");
+    if (count > 0) {
+        line(w, 1, "x = f%ld(2, 1);", count - 1);
+    }
+    line(w, 1, "print(x);");
+    line(w, 1, "return 0;");
+    line(w, 0, "}");
+}
+
+/* nesting: one chain of nested if/while/for blocks, depth levels deep */
+static void gen_nesting(Workload* w, long depth) {
+    line(w, 0, "int main() {");
+    line(w, 1, "int x;");
+    line(w, 1, "int i;");
+    line(w, 1, "x = 0;");
+    line(w, 1, "i = 0;");
+
+    for (long level = 0; level < depth; level++) {
+        int indent = (int)level + 1;
+        switch (level % 3) {
+            case 0:
+                line(w, indent, "if (x < %ld) {", level + 1000);
+                break;
+            case 1:
+                line(w, indent, "while (x < %ld) {", level + 1);
+                break;
+            default:
+                line(w, indent, "for (i = 0; i < %d; i = i + 1;) {", pick(w, 1, 3));
+                break;
+        }
+        line(w, indent + 1, "x = x + %d;", pick(w, 1, 9));
+    }
+
+    for (long level = depth - 1; level >= 0; level--) {
+        line(w, (int)level + 1, "}");
+    }
+
+    line(w, 1, "print(x);");
+    line(w, 1, "return 0;");
+    line(w, 0, "}");
+}
+
+/* straight: count arithmetic statements over a small set of variables */
+static void gen_straight(Workload* w, long count) {
+    const int vars = 16;
+
+    line(w, 0, "int main() {");
+    for (int v = 0; v < vars; v++) {
+        line(w, 1, "int v%d;", v);
+    }
+    for (int v = 0; v < vars; v++) {
+        line(w, 1, "v%d = %d;", v, pick(w, 1, 100));
+    }
+
+    for (long i = 0; i < count; i++) {
+        /* Picked one at a time - argument evaluation order is unspecified */
+        int target = pick(w, 0, vars - 1);
+        int left = pick(w, 0, vars - 1);
+        const char* op = pick_op(w);
+        int divisor = pick(w, 1, 9);
+        int right = pick(w, 0, vars - 1);
+        line(w, 1, "v%d = v%d %s %d + v%d * %d;", target, left, op, divisor, right, pick(w, 1, 9));
+    }
+
+    line(w, 1, "print(v0);");
+    line(w, 1, "return 0;");
+    line(w, 0, "}");
+}
+
+/* arrays: four arrays of size elements, filled and combined in loops,
+ * plus size / 4 constant-index accesses */
+static void gen_arrays(Workload* w, long size) {
+    if (size < 1) size = 1;
+
+    for (int a = 0; a < 4; a++) {
+        line(w, 0, "int a%d[%ld];", a, size);
+    }
+
+    line(w, 0, "int main() {");
+    line(w, 1, "int i;");
+    line(w, 1, "int s;");
+    line(w, 1, "s = 0;");
+    for (int a = 0; a < 4; a++) {
+        line(w, 1, "for (i = 0; i < %ld; i = i + 1;) {", size);
+        line(w, 2, "a%d[i] = i * %d + %d;", a, pick(w, 1, 9), pick(w, 0, 9));
+        line(w, 1, "}");
+    }
+
+    for (long i = 0; i < size / 4; i++) {
+        int dst = pick(w, 0, 3);
+        long dst_index = pick(w, 0, 32767) % size;
+        int left = pick(w, 0, 3);
+        long left_index = pick(w, 0, 32767) % size;
+        int right = pick(w, 0, 3);
+        long right_index = pick(w, 0, 32767) % size;
+        line(w, 1, "a%d[%ld] = a%d[%ld] + a%d[%ld] * %d;", dst, dst_index,
+             left, left_index, right, right_index, pick(w, 1, 9));
+    }
+
+    line(w, 1, "for (i = 0; i < %ld; i = i + 1;) {", size);
+    line(w, 2, "s = s + a0[i] - a1[i] + a2[i] * a3[i];");
+    line(w, 1, "}");
+    line(w, 1, "print(s);");
+    line(w, 1, "return 0;");
+    line(w, 0, "}");
+}
+
+/* globals: count global variables, each assigned and summed in main */
+static void gen_globals(Workload* w, long count) {
+    for (long g = 0; g < count; g++) {
+        line(w, 0, "int g%ld;", g);
+    }
+
+    line(w, 0, "int main() {");
+    line(w, 1, "int s;");
+    line(w, 1, "s = 0;");
+    for (long g = 0; g < count; g++) {
+        line(w, 1, "g%ld = %d;", g, pick(w, 0, 999));
+    }
+    for (long g = 0; g < count; g++) {
+        line(w, 1, "s = s + g%ld;", g);
+    }
+    line(w, 1, "print(s);");
+    line(w, 1, "return 0;");
+    line(w, 0, "}");
+}
+
+/* Write a program of the given shape and scale */
+long generate_workload(FILE* out, WorkloadShape shape, long scale, unsigned seed) {
+    Workload w;
+    w.out = out;
+    w.lines = 0;
+    w.state = seed;
+
+    line(&w, 0, "// Generated workload: %s, scale %ld, seed %u",
+         workload_shape_name(shape), scale, seed);
+
+    switch (shape) {
+        case SHAPE_FUNCTIONS: gen_functions(&w, scale); break;
+        case SHAPE_NESTING:   gen_nesting(&w, scale);   break;
+        case SHAPE_STRAIGHT:  gen_straight(&w, scale);  break;
+        case SHAPE_ARRAYS:    gen_arrays(&w, scale);    break;
+        case SHAPE_GLOBALS:   gen_globals(&w, scale);   break;
+        default: break;
+    }
+
+    return w.lines;
+}
@@ -0,0 +1,42 @@
+/*
+ * WORKLOAD.H - Synthetic Workload Generator
+ * CST-405 Compiler Project
+ *
+ * Generates valid source programs of any size for the compile-time
+ * benchmarks. Each shape stresses one dimension of the compiler:
+ *   functions - many small functions with loops, branches and calls
+ *   nesting   - one deeply nested chain of if/while/for blocks
+ *   straight  - long straight-line arithmetic in a single function
+ *   arrays    - large arrays with loops and indexed accesses
+ *   globals   - many global variables
+ * The scale is the number of functions, nesting levels, statements,
+ * array elements or globals respectively. Output is deterministic for a
+ * given shape, scale and seed.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdio.h>
+
+/* Workload shapes */
+typedef enum {
+    SHAPE_FUNCTIONS,
+    SHAPE_NESTING,
+    SHAPE_STRAIGHT,
+    SHAPE_ARRAYS,
+    SHAPE_GLOBALS,
+    SHAPE_COUNT
+} WorkloadShape;
+
+/* Name of a shape ("functions", "nesting", ...) */
+const char* workload_shape_name(WorkloadShape shape);
+
+/* Look up a shape by name. Returns -1 if unknown. */
+int find_workload_shape(const char* name);
+
+/* Write a program of the given shape and scale to out.
+ * Returns the number of lines written. */
+long generate_workload(FILE* out, WorkloadShape shape, long scale, unsigned seed);
+
+#endif /* WORKLOAD_H */
@@ -0,0 +1,74 @@
+/*
+ * BOUNDS.C - Array Bounds Checking Implementation
+ * CST-405 Compiler Project
+ *
+ * Each array access of the unoptimized TAC gets a check of its index
+ * against the size the symbol table gives the array. Which checks can
+ * never fail is decided later, by the optimizer's value range pass
+ * (range.c), so the checks stay where they are until then.
+ */
+
+#include "bounds.h"
+#include "diagnostics.h"
+#include <string.h>
+
+/* Helper: elements reserved for array name in function func (0 if not an
+ * array we know the size of) */
+static int array_size(SymbolTable* symtab, Symbol* func, const char* name) {
+    int size = 0;
+    if (func && func->kind == SYMBOL_FUNCTION) {
+        Symbol* sym = func->locals;
+        for (int i = 0; i < func->local_count && sym; i++, sym = sym->next) {
+            if (sym->kind == SYMBOL_VARIABLE && sym->is_array && strcmp(sym->storage_name, name) == 0 &&
+                sym->array_size > size) {
+                size = sym->array_size;      /* Same-named locals share the larger slot */
+            }
+        }
+        if (size > 0) return size;
+    }
+    Symbol* sym = lookup_symbol(symtab, name);
+    return sym && sym->kind == SYMBOL_VARIABLE && sym->is_array ? sym->array_size : 0;
+}
+
+/* Put a bounds check in front of every array access */
+int insert_bounds_checks(TACCode* tac, SymbolTable* symtab) {
+    int checks = 0;
+
+    for (int u = 0; u < tac->unit_count; u++) {
+        TACUnit* unit = &tac->units[u];
+        if (!unit->first) continue;
+        Symbol* func = unit->first->opcode == TAC_FUNCTION_LABEL ? lookup_symbol(symtab, unit->first->label)
+                                                                 : NULL;
+
+        TACInstruction* inst = unit->first;
+        for (;;) {
+            TACInstruction* following = inst == unit->last ? NULL : inst->next;
+            const char* array = inst->opcode == TAC_ARRAY_LOAD ? inst->op1
+                              : inst->opcode == TAC_ARRAY_STORE ? inst->result : NULL;
+            const char* index = inst->opcode == TAC_ARRAY_LOAD ? inst->op2 : inst->op1;
+            int size = array ? array_size(symtab, func, array) : 0;
+
+            if (size > 0 && index) {
+                char text[16];
+                snprintf(text, sizeof(text), "%d", size);
+                TACInstruction* check = create_tac_instruction(TAC_BOUNDS_CHECK, (char*)array,
+                                                               (char*)index, text, NULL);
+                if (inst->prev) {
+                    insert_tac(tac, inst->prev, check);
+                } else {
+                    check->next = inst;
+                    inst->prev = check;
+                    tac->head = check;
+                    tac->instruction_count++;
+                }
+                if (unit->first == inst) unit->first = check;
+                checks++;
+            }
+            if (!following) break;
+            inst = following;
+        }
+    }
+
+    log_message(LOG_NORMAL, "[BOUNDS] %d array accesses checked at run time\n\n", checks);
+    return checks;
+}
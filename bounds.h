@@ -0,0 +1,31 @@
+/*
+ * BOUNDS.H - Array Bounds Checking Header
+ * CST-405 Compiler Project
+ *
+ * --bounds-check puts a TAC_BOUNDS_CHECK (arr, index, size) in front of
+ * every array load and store, with the size from the symbol table. The
+ * x86-64 and MIPS code generators turn it into one compare and a branch
+ * to a routine that reports "array index out of range" and exits with
+ * status 1 (the bytecode interpreter checks every access anyway).
+ *
+ * The optimizer's value range pass (range.h) then drops every check whose
+ * index provably lies inside the array - constant indexes, checks
+ * repeated after an identical one, and loop counters kept inside the
+ * array by the loop test, as in
+ *     for (i = 0; i < 10; i = i + 1;) a[i] = ...;    (int a[10])
+ * so hot loops run without per-access checks.
+ */
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "ircode.h"
+#include "symtable.h"
+
+/* BOUNDS CHECKING FUNCTIONS */
+
+/* Put a bounds check in front of every array access of unoptimized TAC.
+ * Returns the number of checks inserted. */
+int insert_bounds_checks(TACCode* tac, SymbolTable* symtab);
+
+#endif /* BOUNDS_H */
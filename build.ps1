@@ -42,12 +42,28 @@ gcc -Wall -g -c ircode.c
 gcc -Wall -g -c optimizer.c
 gcc -Wall -g -c codegen.c
 gcc -Wall -g -c codegen_mips.c
+gcc -Wall -g -c codegen_elf.c
+gcc -Wall -g -c elfobj.c
+gcc -Wall -g -c jit.c
+gcc -Wall -g -c interp.c
 gcc -Wall -g -c diagnostics.c
 gcc -Wall -g -c security.c
+gcc -Wall -g -c cache.c
+gcc -Wall -g -c workpool.c
+gcc -Wall -g -c context.c
+gcc -Wall -g -c output.c
+gcc -Wall -g -c emit.c
+gcc -Wall -g -c timing.c
+gcc -Wall -g -c cfg.c
+gcc -Wall -g -c defuse.c
+gcc -Wall -g -c profile.c
+gcc -Wall -g -c bounds.c
+gcc -Wall -g -c range.c
+gcc -Wall -g -c vectorize.c
 
 Write-Host ""
 Write-Host "Linking compiler..."
-gcc -Wall -g -o compiler.exe compiler.o parser.tab.o lex.yy.o ast.o symtable.o semantic.o ircode.o optimizer.o codegen.o codegen_mips.o diagnostics.o security.o
+gcc -Wall -g -o compiler.exe compiler.o parser.tab.o lex.yy.o ast.o symtable.o semantic.o ircode.o optimizer.o codegen.o codegen_mips.o codegen_elf.o elfobj.o jit.o interp.o diagnostics.o security.o cache.o workpool.o context.o output.o emit.o timing.o cfg.o defuse.o profile.o bounds.o range.o vectorize.o
 
 if ($LASTEXITCODE -ne 0) {
     Write-Host "ERROR: Linking failed"
@@ -0,0 +1,460 @@
+/*
+ * CACHE.C - Incremental Compilation Cache Implementation
+ * CST-405 Compiler Project
+ *
+ * Each function is stored in its own file named after its fingerprint:
+ *
+ *   CST405-CACHE <version>
+ *   function <name>
+ *   stats <folds> <dead> <copies> <peephole> <total>
+ *   tac <count>
+ *   <opcode> <result> <op1> <op2> <label> <flags>   (one line per instruction, '-' = none)
+ *   asm
+ *   <assembly text up to end of file>
+ *
+ * Temporaries (tN) and labels (LN) are stored relative to the function's
+ * first temp/label number and rebased when the entry is loaded. Only the
+ * flags code generation reads (CACHED_FLAGS) are kept.
+ */
+
+#include "cache.h"
+#include "symtable.h"
+#include "diagnostics.h"
+#include <ctype.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define make_dir(path) mkdir(path, 0755)
+#endif
+
+/* Instruction flags that survive optimization and change the generated code */
+#define CACHED_FLAGS TAC_FLAG_NONNEG
+
+/* FNV-1a (64-bit) parameters */
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME  1099511628211ULL
+
+/* Mix raw bytes into a fingerprint */
+static void mix_bytes(Fingerprint* fp, const void* data, size_t len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < len; i++) {
+        *fp ^= bytes[i];
+        *fp *= FNV_PRIME;
+    }
+}
+
+/* Mix an integer into a fingerprint */
+static void mix_int(Fingerprint* fp, int value) {
+    mix_bytes(fp, &value, sizeof(value));
+}
+
+/* Mix a string (NULL-safe, terminator included so "ab","c" != "a","bc") */
+static void mix_string(Fingerprint* fp, const char* str) {
+    if (!str) {
+        mix_int(fp, -1);
+        return;
+    }
+    mix_bytes(fp, str, strlen(str) + 1);
+}
+
+/* Mix in the declaration of a global symbol referenced by the function
+ * (and the storage name of a local that shadows one) */
+static void mix_global_symbol(Fingerprint* fp, Symbol* sym) {
+    if (!sym) return;
+    if (sym->storage_name != sym->name) mix_string(fp, sym->storage_name);
+    if (sym->scope_depth != 0) return;
+
+    mix_int(fp, sym->kind);
+    mix_int(fp, sym->type);
+    mix_int(fp, sym->is_array);
+    mix_int(fp, sym->array_size);
+    if (sym->kind == SYMBOL_FUNCTION) {
+        mix_int(fp, sym->return_type);
+        mix_int(fp, sym->param_count);
+        for (int i = 0; i < sym->param_count; i++) {
+            mix_int(fp, sym->param_types[i]);
+        }
+    }
+}
+
+/* Mix an AST subtree into a fingerprint (structure, names, values) */
+static void mix_ast(Fingerprint* fp, ASTNode* node) {
+    if (!node) {
+        mix_int(fp, -1);
+        return;
+    }
+
+    mix_int(fp, node->type);
+    mix_global_symbol(fp, node->symbol);
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+            mix_ast(fp, node->data.program.statements);
+            break;
+        case NODE_STATEMENT_LIST:
+            mix_ast(fp, node->data.stmt_list.statement);
+            mix_ast(fp, node->data.stmt_list.next);
+            break;
+        case NODE_DECLARATION:
+        case NODE_IDENTIFIER:
+            mix_string(fp, node->data.str_value);
+            break;
+        case NODE_NUMBER:
+            mix_int(fp, node->data.num_value);
+            break;
+        case NODE_ASSIGNMENT:
+            mix_string(fp, node->data.assignment.var_name);
+            mix_ast(fp, node->data.assignment.index);
+            mix_ast(fp, node->data.assignment.expr);
+            break;
+        case NODE_PRINT:
+            mix_ast(fp, node->data.print.expr);
+            break;
+        case NODE_WHILE:
+            mix_ast(fp, node->data.while_loop.condition);
+            mix_ast(fp, node->data.while_loop.body);
+            break;
+        case NODE_IF:
+            mix_ast(fp, node->data.if_stmt.condition);
+            mix_ast(fp, node->data.if_stmt.then_branch);
+            mix_ast(fp, node->data.if_stmt.else_branch);
+            break;
+        case NODE_FOR:
+            mix_ast(fp, node->data.for_loop.init);
+            mix_ast(fp, node->data.for_loop.condition);
+            mix_ast(fp, node->data.for_loop.update);
+            mix_ast(fp, node->data.for_loop.body);
+            break;
+        case NODE_DO_WHILE:
+            mix_ast(fp, node->data.do_while_loop.condition);
+            mix_ast(fp, node->data.do_while_loop.body);
+            break;
+        case NODE_CONDITION:
+        case NODE_BINARY_OP:
+            mix_string(fp, node->data.binary_op.operator);
+            mix_ast(fp, node->data.binary_op.left);
+            mix_ast(fp, node->data.binary_op.right);
+            break;
+        case NODE_ARRAY_DECLARATION:
+            mix_string(fp, node->data.array_decl.var_name);
+            mix_int(fp, node->data.array_decl.size);
+            break;
+        case NODE_ARRAY_ACCESS:
+            mix_string(fp, node->data.array_access.array_name);
+            mix_ast(fp, node->data.array_access.index);
+            break;
+        case NODE_FUNCTION_DECL:
+        case NODE_FUNCTION_DEF:
+            mix_string(fp, node->data.function.return_type);
+            mix_string(fp, node->data.function.func_name);
+            mix_ast(fp, node->data.function.params);
+            mix_ast(fp, node->data.function.body);
+            break;
+        case NODE_FUNCTION_CALL:
+            mix_string(fp, node->data.func_call.func_name);
+            mix_ast(fp, node->data.func_call.args);
+            break;
+        case NODE_RETURN:
+            mix_ast(fp, node->data.return_stmt.expr);
+            break;
+        case NODE_PARAM:
+            mix_string(fp, node->data.param.type);
+            mix_string(fp, node->data.param.name);
+            break;
+        case NODE_PARAM_LIST:
+        case NODE_ARG_LIST:
+            mix_ast(fp, node->data.list.item);
+            mix_ast(fp, node->data.list.next);
+            break;
+    }
+}
+
+/* Open (and create if needed) the cache directory */
+CompileCache* open_compile_cache(const char* dir, const char* config) {
+    if (make_dir(dir) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: Cannot create cache directory '%s' - caching disabled\n", dir);
+        return NULL;
+    }
+
+    CompileCache* cache = (CompileCache*)safe_malloc(sizeof(CompileCache), "compile cache");
+
+    cache->dir = safe_strdup(dir, "cache string");
+    cache->config = safe_strdup(config ? config : "", "cache string");
+    cache->hits = 0;
+    cache->misses = 0;
+    return cache;
+}
+
+/* Fingerprint a function definition and the globals it references */
+Fingerprint fingerprint_function(CompileCache* cache, ASTNode* func) {
+    Fingerprint fp = FNV_OFFSET;
+    mix_int(&fp, CACHE_FORMAT_VERSION);
+    mix_string(&fp, cache->config);
+    mix_ast(&fp, func);
+    return fp;
+}
+
+/* Helper: path of the cache file for a key */
+static void entry_path(CompileCache* cache, Fingerprint key, char* path, size_t size) {
+    snprintf(path, size, "%s/%016llx.fnc", cache->dir, key);
+}
+
+/* Helper: can this character be part of an assembler/TAC name? */
+static int is_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$' || c == '.';
+}
+
+/* Renumber temporaries (tN) and labels (LN) in text by the given deltas.
+ * Only whole names are touched, so registers like $t0 and words like
+ * "Load" are left alone. Returns a newly allocated string. */
+static char* rebase_names(const char* text, int temp_delta, int label_delta) {
+    size_t len = strlen(text);
+    size_t capacity = len + len / 4 + 64;
+    size_t out_len = 0;
+    char* out = (char*)safe_malloc(capacity, "cache buffer");
+
+    size_t i = 0;
+    while (i < len) {
+        char c = text[i];
+        int delta = (c == 't') ? temp_delta : (c == 'L') ? label_delta : 0;
+
+        if (delta != 0 && (i == 0 || !is_name_char(text[i - 1])) &&
+            isdigit((unsigned char)text[i + 1])) {
+            size_t j = i + 1;
+            long number = 0;
+            while (isdigit((unsigned char)text[j])) {
+                number = number * 10 + (text[j] - '0');
+                j++;
+            }
+
+            if (!is_name_char(text[j])) {
+                if (out_len + 32 >= capacity) {
+                    capacity = capacity * 2 + 32;
+                    out = (char*)safe_realloc(out, capacity, "cache buffer");
+                }
+                out_len += snprintf(out + out_len, capacity - out_len, "%c%ld", c, number + delta);
+                i = j;
+                continue;
+            }
+        }
+
+        if (out_len + 2 >= capacity) {
+            capacity = capacity * 2 + 32;
+            out = (char*)safe_realloc(out, capacity, "cache buffer");
+        }
+        out[out_len++] = c;
+        i++;
+    }
+
+    out[out_len] = '\0';
+    return out;
+}
+
+/* Helper: opcode from its opcode_to_string() name (-1 if unknown) */
+static int opcode_from_string(const char* name) {
+    for (int op = 0; strcmp(opcode_to_string((TACOpcode)op), "UNKNOWN") != 0; op++) {
+        if (strcmp(opcode_to_string((TACOpcode)op), name) == 0) {
+            return op;
+        }
+    }
+    return -1;
+}
+
+/* Helper: read a whole file into memory (NULL if missing) */
+static char* read_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* data = (char*)safe_malloc(size + 1, "cache buffer");
+
+    size_t got = fread(data, 1, size, file);
+    data[got] = '\0';
+    fclose(file);
+    return data;
+}
+
+/* Helper: read one line starting at *cursor (the newline is replaced by '\0') */
+static char* next_line(char** cursor) {
+    char* line = *cursor;
+    if (!line || *line == '\0') return NULL;
+
+    char* newline = strchr(line, '\n');
+    if (newline) {
+        *newline = '\0';
+        *cursor = newline + 1;
+    } else {
+        *cursor = line + strlen(line);
+    }
+    return line;
+}
+
+/* Helper: TAC field from its cached form ("-" means no operand) */
+static const char* field_or_null(const char* field) {
+    return strcmp(field, "-") == 0 ? NULL : field;
+}
+
+/* Look up a function in the cache */
+CacheEntry* cache_lookup(CompileCache* cache, Fingerprint key, const TACUnit* unit) {
+    char path[1024];
+    entry_path(cache, key, path, sizeof(path));
+
+    char* raw = read_file(path);
+    if (!raw) return NULL;
+
+    char* text = rebase_names(raw, unit->temp_base, unit->label_base);
+    free(raw);
+
+    CacheEntry* entry = (CacheEntry*)safe_calloc(1, sizeof(CacheEntry), "cache entry");
+    entry->tac = create_tac_code();
+
+    char* cursor = text;
+    char* line;
+    int version = 0;
+    int count = -1;
+    int ok = 0;
+
+    /* Header */
+    line = next_line(&cursor);
+    if (!line || sscanf(line, "CST405-CACHE %d", &version) != 1 ||
+        version != CACHE_FORMAT_VERSION) {
+        goto done;
+    }
+    line = next_line(&cursor);                      /* function <name> */
+    line = next_line(&cursor);
+    if (!line || sscanf(line, "stats %d %d %d %d %d",
+                        &entry->stats.constant_folds, &entry->stats.dead_code_eliminated,
+                        &entry->stats.copy_propagations, &entry->stats.peephole_opts,
+                        &entry->stats.total_optimizations) != 5) {
+        goto done;
+    }
+    line = next_line(&cursor);
+    if (!line || sscanf(line, "tac %d", &count) != 1) {
+        goto done;
+    }
+
+    /* Optimized TAC */
+    for (int i = 0; i < count; i++) {
+        char opname[32], result[256], op1[256], op2[256], label[256];
+        unsigned flags;
+
+        line = next_line(&cursor);
+        if (!line || sscanf(line, "%31s %255s %255s %255s %255s %u",
+                            opname, result, op1, op2, label, &flags) != 6) {
+            goto done;
+        }
+
+        int opcode = opcode_from_string(opname);
+        if (opcode < 0) goto done;
+
+        TACInstruction* inst = create_tac_instruction((TACOpcode)opcode,
+                                                      field_or_null(result),
+                                                      field_or_null(op1),
+                                                      field_or_null(op2),
+                                                      field_or_null(label));
+        inst->flags = flags & CACHED_FLAGS;
+        append_tac(entry->tac, inst);
+    }
+
+    /* Assembly runs to the end of the file */
+    line = next_line(&cursor);
+    if (!line || strcmp(line, "asm") != 0) goto done;
+    entry->asm_text = safe_strdup(cursor, "cache string");
+    ok = 1;
+
+done:
+    free(text);
+    if (!ok) {
+        /* Unreadable or stale entry - treat as a miss and recompile */
+        free_cache_entry(entry);
+        return NULL;
+    }
+
+    cache->hits++;
+    return entry;
+}
+
+/* Store a compiled function in the cache */
+void cache_store(CompileCache* cache, Fingerprint key, const TACUnit* unit,
+                 const char* asm_text, const OptimizationStats* stats) {
+    cache->misses++;
+
+    /* Serialize into a temporary file first */
+    FILE* buffer = tmpfile();
+    if (!buffer) return;
+
+    int count = 0;
+    for (TACInstruction* inst = unit->first; inst; inst = inst->next) {
+        count++;
+        if (inst == unit->last) break;
+    }
+
+    fprintf(buffer, "CST405-CACHE %d\n", CACHE_FORMAT_VERSION);
+    fprintf(buffer, "function %s\n", unit->node->data.function.func_name);
+    fprintf(buffer, "stats %d %d %d %d %d\n",
+            stats->constant_folds, stats->dead_code_eliminated,
+            stats->copy_propagations, stats->peephole_opts,
+            stats->total_optimizations);
+    fprintf(buffer, "tac %d\n", unit->first ? count : 0);
+    for (TACInstruction* inst = unit->first; inst; inst = inst->next) {
+        fprintf(buffer, "%s %s %s %s %s %u\n", opcode_to_string(inst->opcode),
+                inst->result ? inst->result : "-",
+                inst->op1 ? inst->op1 : "-",
+                inst->op2 ? inst->op2 : "-",
+                inst->label ? inst->label : "-",
+                inst->flags & CACHED_FLAGS);
+        if (inst == unit->last) break;
+    }
+    fprintf(buffer, "asm\n%s", asm_text);
+
+    long size = ftell(buffer);
+    rewind(buffer);
+    char* text = (char*)safe_malloc(size + 1, "cache buffer");
+    size_t got = fread(text, 1, size, buffer);
+    text[got] = '\0';
+    fclose(buffer);
+
+    /* Renumber relative to the function and write the file atomically */
+    char* relative = rebase_names(text, -unit->temp_base, -unit->label_base);
+    free(text);
+
+    char path[1024], temp_path[1064];
+    entry_path(cache, key, path, sizeof(path));
+    /* The temporary name is private to this cache handle: files of a
+     * parallel batch may store the same function at the same time */
+    snprintf(temp_path, sizeof(temp_path), "%s.%p.tmp", path, (void*)cache);
+
+    FILE* file = fopen(temp_path, "wb");
+    if (file) {
+        fputs(relative, file);
+        fclose(file);
+        if (rename(temp_path, path) != 0) {
+            remove(path);
+            rename(temp_path, path);
+        }
+    }
+    free(relative);
+}
+
+/* Free a cache entry */
+void free_cache_entry(CacheEntry* entry) {
+    if (!entry) return;
+    if (entry->tac) free_tac(entry->tac);
+    free(entry->asm_text);
+    free(entry);
+}
+
+/* Close the cache handle */
+void close_compile_cache(CompileCache* cache) {
+    if (!cache) return;
+    free(cache->dir);
+    free(cache->config);
+    free(cache);
+}
@@ -0,0 +1,74 @@
+/*
+ * CACHE.H - Incremental Compilation Cache Header
+ * CST-405 Compiler Project
+ *
+ * This file defines the persistent per-function cache used by incremental
+ * compilation. Every function definition is fingerprinted (its AST subtree
+ * plus the global symbols it references); the optimized TAC and generated
+ * assembly for that fingerprint are kept on disk, so recompiling a file
+ * after editing one function only optimizes and translates that function.
+ *
+ * Cached code is stored with temporaries and labels renumbered from zero
+ * and is rebased to the current numbering when it is loaded, so edits that
+ * shift the numbering of later functions do not invalidate them.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ast.h"
+#include "ircode.h"
+#include "optimizer.h"
+
+/* Bump when the cache file layout or the generated code changes */
+#define CACHE_FORMAT_VERSION 5
+
+/* Default cache directory (relative to the working directory) */
+#define DEFAULT_CACHE_DIR ".cst405-cache"
+
+/* 64-bit fingerprint of a function and everything its code depends on */
+typedef unsigned long long Fingerprint;
+
+/* One cached function - optimized TAC and assembly, already rebased */
+typedef struct {
+    TACCode* tac;               /* Optimized TAC for the function */
+    char* asm_text;             /* Generated assembly for the function */
+    OptimizationStats stats;    /* Optimizations applied when it was compiled */
+} CacheEntry;
+
+/* Cache handle for one compilation */
+typedef struct {
+    char* dir;                  /* Directory holding the cache files */
+    char* config;               /* Target/options string mixed into every key */
+    int hits;                   /* Functions reused from the cache */
+    int misses;                 /* Functions compiled and stored */
+} CompileCache;
+
+/* CACHE FUNCTIONS */
+
+/* Open (and create if needed) the cache directory.
+ * config identifies everything outside the source that affects the
+ * generated code (target, options). Returns NULL if the directory is unusable. */
+CompileCache* open_compile_cache(const char* dir, const char* config);
+
+/* Fingerprint a NODE_FUNCTION_DEF subtree and the global symbols it uses */
+Fingerprint fingerprint_function(CompileCache* cache, ASTNode* func);
+
+/* Look up a function unit; the entry is rebased to the unit's temp/label
+ * numbering. Returns NULL on a miss. */
+CacheEntry* cache_lookup(CompileCache* cache, Fingerprint key, const TACUnit* unit);
+
+/* Store a compiled function unit (its optimized TAC and assembly) */
+void cache_store(CompileCache* cache, Fingerprint key, const TACUnit* unit,
+                 const char* asm_text, const OptimizationStats* stats);
+
+/* Free a cache entry (its TAC too, unless ownership was taken by setting tac = NULL) */
+void free_cache_entry(CacheEntry* entry);
+
+/* Close the cache handle */
+void close_compile_cache(CompileCache* cache);
+
+#endif /* CACHE_H */
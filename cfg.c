@@ -0,0 +1,498 @@
+/*
+ * CFG.C - Control Flow Graph and Dataflow Analyses Implementation
+ * CST-405 Compiler Project
+ *
+ * Block leaders are the first instruction, every label and function label,
+ * and every instruction after a jump or return. Liveness is the usual
+ * backward dataflow problem solved by iterating to a fixed point over bit
+ * sets; dominators use the iterative algorithm of Cooper, Harvey and
+ * Kennedy over reverse postorder.
+ */
+
+#include "cfg.h"
+#include "diagnostics.h"
+#include <string.h>
+
+static const char* analysis_names[ANALYSIS_COUNT] = {
+    "cfg", "liveness", "dominators"
+};
+
+/* Name of an analysis */
+const char* analysis_name(int index) {
+    return index >= 0 && index < ANALYSIS_COUNT ? analysis_names[index] : "unknown";
+}
+
+/* Helper: FNV-1a hash of a name */
+static unsigned hash_name(const char* name) {
+    unsigned hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+/* Is name a compiler temporary (t0, t1, ...)? */
+int is_temporary(const char* name) {
+    if (!name || name[0] != 't' || name[1] == '\0') return 0;
+    for (const char* p = name + 1; *p; p++) {
+        if (*p < '0' || *p > '9') return 0;
+    }
+    return 1;
+}
+
+/* Operand slots an instruction reads as scalars */
+int tac_use_slots(const TACInstruction* inst, int slots[2]) {
+    int count = 0;
+
+    switch (inst->opcode) {
+        case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_MOD:
+        case TAC_RELOP:
+        case TAC_ARRAY_STORE:           /* op1 = index, op2 = value */
+            slots[count++] = TAC_SLOT_OP1;
+            slots[count++] = TAC_SLOT_OP2;
+            break;
+        case TAC_ASSIGN: case TAC_PRINT: case TAC_IF_FALSE: case TAC_IF_TRUE:
+        case TAC_PARAM: case TAC_RETURN:
+        case TAC_BOUNDS_CHECK:          /* op1 = index (op2 = size is a literal) */
+            slots[count++] = TAC_SLOT_OP1;
+            break;
+        case TAC_ARRAY_LOAD:            /* op1 = array, op2 = index */
+            slots[count++] = TAC_SLOT_OP2;
+            break;
+        default:
+            break;
+    }
+
+    /* Drop missing operands and literals */
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        const char* operand = *tac_slot((TACInstruction*)inst, slots[i]);
+        if (operand && !is_literal(operand)) slots[kept++] = slots[i];
+    }
+    return kept;
+}
+
+/* Variables an instruction reads as scalars */
+int tac_uses(const TACInstruction* inst, const char* uses[2]) {
+    int slots[2];
+    int slot_count = tac_use_slots(inst, slots);
+
+    int count = 0;
+    for (int i = 0; i < slot_count; i++) {
+        const char* name = *tac_slot((TACInstruction*)inst, slots[i]);
+        if (count == 1 && strcmp(uses[0], name) == 0) continue;
+        uses[count++] = name;
+    }
+    return count;
+}
+
+/* Operand field for a slot */
+char** tac_slot(TACInstruction* inst, int slot) {
+    switch (slot) {
+        case TAC_SLOT_RESULT: return &inst->result;
+        case TAC_SLOT_OP1:    return &inst->op1;
+        default:              return &inst->op2;
+    }
+}
+
+/* Scalar variable an instruction writes */
+const char* tac_def(const TACInstruction* inst) {
+    switch (inst->opcode) {
+        case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_MOD:
+        case TAC_RELOP: case TAC_ASSIGN: case TAC_LOAD_CONST:
+        case TAC_ARRAY_LOAD: case TAC_CALL:
+            return inst->result;
+        default:
+            return NULL;
+    }
+}
+
+/* Helper: does control leave the block after this instruction? */
+static int ends_block(const TACInstruction* inst) {
+    return inst->opcode == TAC_GOTO || inst->opcode == TAC_IF_FALSE ||
+           inst->opcode == TAC_IF_TRUE || inst->opcode == TAC_RETURN ||
+           inst->opcode == TAC_RETURN_VOID;
+}
+
+/* Helper: release the liveness sets and variable numbering */
+static void free_liveness(FlowGraph* graph) {
+    for (int r = 0; r < graph->region_count; r++) {
+        FlowRegion* region = &graph->regions[r];
+        free(region->vars);
+        free(region->var_table);
+        free(region->live_bits);
+        region->vars = NULL;
+        region->var_table = NULL;
+        region->live_bits = NULL;
+        region->var_count = 0;
+        region->table_size = 0;
+        region->words = 0;
+    }
+    for (int b = 0; b < graph->block_count; b++) {
+        graph->blocks[b].live_in = NULL;
+        graph->blocks[b].live_out = NULL;
+    }
+}
+
+/* Helper: release the blocks and regions */
+static void free_blocks(FlowGraph* graph) {
+    free_liveness(graph);
+    for (int b = 0; b < graph->block_count; b++) {
+        free(graph->blocks[b].preds);
+    }
+    free(graph->blocks);
+    free(graph->regions);
+    graph->blocks = NULL;
+    graph->regions = NULL;
+    graph->block_count = 0;
+    graph->region_count = 0;
+}
+
+/* Helper: split the list into blocks and connect them */
+static void build_cfg(FlowGraph* graph) {
+    free_blocks(graph);
+
+    /* Count the blocks and regions */
+    int block_count = 0;
+    int region_count = 0;
+    TACInstruction* prev = NULL;
+    for (TACInstruction* inst = graph->code->head; inst; inst = inst->next) {
+        if (!prev || inst->opcode == TAC_LABEL || inst->opcode == TAC_FUNCTION_LABEL ||
+            ends_block(prev)) {
+            block_count++;
+        }
+        if (!prev || inst->opcode == TAC_FUNCTION_LABEL) {
+            region_count++;
+        }
+        prev = inst;
+    }
+
+    graph->blocks = (BasicBlock*)safe_calloc(block_count, sizeof(BasicBlock), "basic blocks");
+    graph->regions = (FlowRegion*)safe_calloc(region_count, sizeof(FlowRegion), "flow regions");
+    graph->block_count = block_count;
+    graph->region_count = region_count;
+
+    /* Fill in the block boundaries, and map each label to its block */
+    int label_slots = 16;
+    while (label_slots < block_count * 2) label_slots *= 2;
+    int* label_table = (int*)safe_calloc(label_slots, sizeof(int), "label table");
+    memset(label_table, -1, label_slots * sizeof(int));
+
+    int b = -1;
+    int r = -1;
+    prev = NULL;
+    for (TACInstruction* inst = graph->code->head; inst; inst = inst->next) {
+        if (!prev || inst->opcode == TAC_LABEL || inst->opcode == TAC_FUNCTION_LABEL ||
+            ends_block(prev)) {
+            b++;
+            if (!prev || inst->opcode == TAC_FUNCTION_LABEL) {
+                r++;
+                graph->regions[r].first_block = b;
+            }
+            graph->blocks[b].first = inst;
+            graph->blocks[b].region = r;
+            graph->blocks[b].idom = -1;
+            graph->blocks[b].rpo = -1;
+            graph->regions[r].block_count++;
+
+            if (inst->opcode == TAC_LABEL && inst->label) {
+                unsigned slot = hash_name(inst->label) & (label_slots - 1);
+                while (label_table[slot] >= 0) slot = (slot + 1) & (label_slots - 1);
+                label_table[slot] = b;
+            }
+        }
+        graph->blocks[b].last = inst;
+        prev = inst;
+    }
+
+    /* Successors: the jump target and/or the next block in the same region */
+    for (b = 0; b < block_count; b++) {
+        BasicBlock* block = &graph->blocks[b];
+        TACOpcode op = block->last->opcode;
+        int falls_through = op != TAC_GOTO && op != TAC_RETURN && op != TAC_RETURN_VOID &&
+                            b + 1 < block_count &&
+                            graph->blocks[b + 1].region == block->region;
+        if (falls_through) {
+            block->succ[block->succ_count++] = b + 1;
+        }
+
+        if ((op == TAC_GOTO || op == TAC_IF_FALSE || op == TAC_IF_TRUE) && block->last->label) {
+            unsigned slot = hash_name(block->last->label) & (label_slots - 1);
+            while (label_table[slot] >= 0) {
+                int target = label_table[slot];
+                if (strcmp(graph->blocks[target].first->label, block->last->label) == 0) {
+                    if (block->succ_count == 0 || block->succ[0] != target) {
+                        block->succ[block->succ_count++] = target;
+                    }
+                    break;
+                }
+                slot = (slot + 1) & (label_slots - 1);
+            }
+        }
+    }
+    free(label_table);
+
+    /* Predecessors */
+    for (b = 0; b < block_count; b++) {
+        for (int s = 0; s < graph->blocks[b].succ_count; s++) {
+            graph->blocks[graph->blocks[b].succ[s]].pred_count++;
+        }
+    }
+    for (b = 0; b < block_count; b++) {
+        BasicBlock* block = &graph->blocks[b];
+        block->preds = (int*)safe_calloc(block->pred_count, sizeof(int), "predecessor list");
+        block->pred_count = 0;
+    }
+    for (b = 0; b < block_count; b++) {
+        for (int s = 0; s < graph->blocks[b].succ_count; s++) {
+            BasicBlock* succ = &graph->blocks[graph->blocks[b].succ[s]];
+            succ->preds[succ->pred_count++] = b;
+        }
+    }
+}
+
+/* Helper: number of name in region, adding it if add is set (-1 if absent) */
+static int region_variable(FlowRegion* region, const char* name, int add) {
+    if (region->table_size == 0) return -1;
+
+    unsigned mask = (unsigned)region->table_size - 1;
+    unsigned slot = hash_name(name) & mask;
+    while (region->var_table[slot] >= 0) {
+        int index = region->var_table[slot];
+        if (strcmp(region->vars[index], name) == 0) return index;
+        slot = (slot + 1) & mask;
+    }
+    if (!add) return -1;
+
+    region->var_table[slot] = region->var_count;
+    region->vars[region->var_count] = (char*)name;
+    return region->var_count++;
+}
+
+/* Helper: compute live-in/live-out sets for one region */
+static void compute_region_liveness(FlowGraph* graph, FlowRegion* region) {
+    BasicBlock* blocks = &graph->blocks[region->first_block];
+    int count = region->block_count;
+
+    /* Number the variables (at most two uses and a definition per instruction) */
+    int capacity = 0;
+    for (int b = 0; b < count; b++) {
+        for (TACInstruction* inst = blocks[b].first; ; inst = inst->next) {
+            capacity += 3;
+            if (inst == blocks[b].last) break;
+        }
+    }
+    region->table_size = 16;
+    while (region->table_size < capacity * 2) region->table_size *= 2;
+    region->var_table = (int*)safe_calloc(region->table_size, sizeof(int), "variable table");
+    memset(region->var_table, -1, region->table_size * sizeof(int));
+    region->vars = (char**)safe_calloc(capacity, sizeof(char*), "variable list");
+
+    for (int b = 0; b < count; b++) {
+        for (TACInstruction* inst = blocks[b].first; ; inst = inst->next) {
+            const char* uses[2];
+            int use_count = tac_uses(inst, uses);
+            for (int u = 0; u < use_count; u++) region_variable(region, uses[u], 1);
+            const char* def = tac_def(inst);
+            if (def) region_variable(region, def, 1);
+            if (inst == blocks[b].last) break;
+        }
+    }
+
+    /* Four sets per block: live in, live out, used before defined, defined */
+    int words = (region->var_count + 31) / 32;
+    if (words == 0) words = 1;
+    region->words = words;
+    region->live_bits = (unsigned*)safe_calloc((size_t)count * words * 4, sizeof(unsigned), "live sets");
+
+    for (int b = 0; b < count; b++) {
+        unsigned* sets = region->live_bits + (size_t)b * words * 4;
+        unsigned* gen = sets + 2 * words;
+        unsigned* kill = sets + 3 * words;
+        blocks[b].live_in = sets;
+        blocks[b].live_out = sets + words;
+
+        for (TACInstruction* inst = blocks[b].first; ; inst = inst->next) {
+            const char* uses[2];
+            int use_count = tac_uses(inst, uses);
+            for (int u = 0; u < use_count; u++) {
+                int v = region_variable(region, uses[u], 0);
+                if (!LIVE_SET_HAS(kill, v)) gen[v / 32] |= 1u << (v % 32);
+            }
+            const char* def = tac_def(inst);
+            if (def) {
+                int v = region_variable(region, def, 0);
+                kill[v / 32] |= 1u << (v % 32);
+            }
+            if (inst == blocks[b].last) break;
+        }
+    }
+
+    /* Backward fixed point; visiting blocks last to first converges quickly */
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = count - 1; b >= 0; b--) {
+            BasicBlock* block = &blocks[b];
+            unsigned* gen = block->live_in + 2 * words;
+            unsigned* kill = block->live_in + 3 * words;
+
+            for (int w = 0; w < words; w++) {
+                unsigned out = 0;
+                for (int s = 0; s < block->succ_count; s++) {
+                    out |= graph->blocks[block->succ[s]].live_in[w];
+                }
+                unsigned in = gen[w] | (out & ~kill[w]);
+                if (out != block->live_out[w] || in != block->live_in[w]) {
+                    block->live_out[w] = out;
+                    block->live_in[w] = in;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+/* Helper: intersect two dominator paths (Cooper, Harvey and Kennedy) */
+static int intersect(const BasicBlock* blocks, int a, int b) {
+    while (a != b) {
+        while (blocks[a].rpo > blocks[b].rpo) a = blocks[a].idom;
+        while (blocks[b].rpo > blocks[a].rpo) b = blocks[b].idom;
+    }
+    return a;
+}
+
+/* Helper: compute immediate dominators for one region */
+static void compute_region_dominators(FlowGraph* graph, FlowRegion* region) {
+    BasicBlock* blocks = graph->blocks;
+    int entry = region->first_block;
+    int count = region->block_count;
+
+    /* Depth-first postorder from the entry (explicit stack) */
+    int* order = (int*)safe_calloc(count, sizeof(int), "block order");
+    int* stack = (int*)safe_calloc(count, sizeof(int), "block stack");
+    int* next_succ = (int*)safe_calloc(count, sizeof(int), "block stack");
+    char* visited = (char*)safe_calloc(count, 1, "block flags");
+    int order_count = 0;
+    int depth = 0;
+
+    for (int b = entry; b < entry + count; b++) {
+        blocks[b].idom = -1;
+        blocks[b].rpo = -1;
+    }
+
+    stack[depth++] = entry;
+    visited[0] = 1;
+    while (depth > 0) {
+        int b = stack[depth - 1];
+        int* s = &next_succ[b - entry];
+        if (*s < blocks[b].succ_count) {
+            int succ = blocks[b].succ[(*s)++];
+            if (!visited[succ - entry]) {
+                visited[succ - entry] = 1;
+                stack[depth++] = succ;
+            }
+        } else {
+            order[order_count++] = b;
+            depth--;
+        }
+    }
+
+    /* Reverse postorder numbers; the entry gets 0 */
+    for (int i = 0; i < order_count; i++) {
+        blocks[order[i]].rpo = order_count - 1 - i;
+    }
+
+    blocks[entry].idom = entry;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = order_count - 2; i >= 0; i--) {
+            int b = order[i];
+            int idom = -1;
+            for (int p = 0; p < blocks[b].pred_count; p++) {
+                int pred = blocks[b].preds[p];
+                if (blocks[pred].idom < 0) continue;
+                idom = idom < 0 ? pred : intersect(blocks, pred, idom);
+            }
+            if (idom != blocks[b].idom) {
+                blocks[b].idom = idom;
+                changed = 1;
+            }
+        }
+    }
+    blocks[entry].idom = -1;
+
+    free(order);
+    free(stack);
+    free(next_succ);
+    free(visited);
+}
+
+/* Create a flow graph with no analyses computed */
+FlowGraph* create_flow_graph(TACCode* code) {
+    FlowGraph* graph = (FlowGraph*)safe_calloc(1, sizeof(FlowGraph), "flow graph");
+    graph->code = code;
+    return graph;
+}
+
+/* Compute whatever is missing from the requested analyses */
+void require_analyses(FlowGraph* graph, unsigned analyses) {
+    if (analyses & (ANALYSIS_LIVENESS | ANALYSIS_DOMINATORS)) {
+        analyses |= ANALYSIS_CFG;
+    }
+
+    if ((analyses & ANALYSIS_CFG) && !(graph->valid & ANALYSIS_CFG)) {
+        build_cfg(graph);
+        graph->valid = ANALYSIS_CFG;
+        graph->computed[0]++;
+    }
+
+    if ((analyses & ANALYSIS_LIVENESS) && !(graph->valid & ANALYSIS_LIVENESS)) {
+        free_liveness(graph);
+        for (int r = 0; r < graph->region_count; r++) {
+            compute_region_liveness(graph, &graph->regions[r]);
+        }
+        graph->valid |= ANALYSIS_LIVENESS;
+        graph->computed[1]++;
+    }
+
+    if ((analyses & ANALYSIS_DOMINATORS) && !(graph->valid & ANALYSIS_DOMINATORS)) {
+        for (int r = 0; r < graph->region_count; r++) {
+            compute_region_dominators(graph, &graph->regions[r]);
+        }
+        graph->valid |= ANALYSIS_DOMINATORS;
+        graph->computed[2]++;
+    }
+}
+
+/* Mark analyses as out of date */
+void invalidate_analyses(FlowGraph* graph, unsigned analyses) {
+    if (analyses & ANALYSIS_CFG) {
+        analyses = ANALYSIS_ALL;
+    }
+    graph->valid &= ~analyses;
+}
+
+/* Free a flow graph */
+void free_flow_graph(FlowGraph* graph) {
+    if (!graph) return;
+    free_blocks(graph);
+    free(graph);
+}
+
+/* Number of name in the live sets of block's region */
+int live_variable_index(const FlowGraph* graph, int block, const char* name) {
+    return region_variable(&graph->regions[graph->blocks[block].region], name, 0);
+}
+
+/* Does block a dominate block b? */
+int block_dominates(const FlowGraph* graph, int a, int b) {
+    if (graph->blocks[b].rpo < 0) return 0;
+    /* Dominators come earlier in reverse postorder, so stop once past a */
+    while (b >= 0 && graph->blocks[b].rpo >= graph->blocks[a].rpo) {
+        if (b == a) return 1;
+        b = graph->blocks[b].idom;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * CFG.H - Control Flow Graph and Dataflow Analyses
+ * CST-405 Compiler Project
+ *
+ * This file splits a TAC list into basic blocks and computes the analyses
+ * that optimization passes build on:
+ *   ANALYSIS_CFG        - basic blocks with their successors and predecessors
+ *   ANALYSIS_LIVENESS   - variables live on entry to and exit from each block
+ *   ANALYSIS_DOMINATORS - immediate dominator of each block
+ *
+ * A FlowGraph remembers which analyses are up to date. The optimizer's pass
+ * manager asks for what a pass needs with require_analyses() and drops what
+ * the pass broke with invalidate_analyses(), so an analysis is recomputed
+ * only after something changed underneath it.
+ *
+ * Blocks never span two functions. Each function (and the code in front of
+ * the first one) is a region with its own variable numbering, so the live
+ * sets stay small in programs with many functions. Liveness follows the TAC
+ * operands only: a call is not treated as a read of the globals, so callers
+ * must not use it to drop stores to user variables.
+ */
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ircode.h"
+
+/* Analyses a FlowGraph can hold (bit flags) */
+typedef enum {
+    ANALYSIS_CFG        = 1,
+    ANALYSIS_LIVENESS   = 2,
+    ANALYSIS_DOMINATORS = 4
+} AnalysisKind;
+
+#define ANALYSIS_COUNT 3
+#define ANALYSIS_ALL   (ANALYSIS_CFG | ANALYSIS_LIVENESS | ANALYSIS_DOMINATORS)
+
+/* Membership test for a live set */
+#define LIVE_SET_HAS(set, index) (((set)[(index) / 32] >> ((index) % 32)) & 1u)
+
+/* Basic block - a straight-line run of instructions entered at the top */
+typedef struct {
+    TACInstruction* first;        /* First instruction (the label, if any) */
+    TACInstruction* last;         /* Last instruction (the jump, if any) */
+    int succ[2];                  /* Successor blocks (fall-through first) */
+    int succ_count;               /* Number of successors */
+    int* preds;                   /* Predecessor blocks */
+    int pred_count;               /* Number of predecessors */
+    int region;                   /* Region (function) the block belongs to */
+    int idom;                     /* Immediate dominator (-1 = entry or unreachable) */
+    int rpo;                      /* Reverse postorder number (-1 = unreachable) */
+    unsigned* live_in;            /* Variables live on entry (region numbering) */
+    unsigned* live_out;           /* Variables live on exit */
+} BasicBlock;
+
+/* Region - one function (or the code before the first function) */
+typedef struct {
+    int first_block;              /* Entry block */
+    int block_count;              /* Blocks in the region */
+    char** vars;                  /* Variable names by number (not owned) */
+    int var_count;                /* Variables referenced in the region */
+    int* var_table;               /* Open-addressing map name -> number (-1 = empty) */
+    int table_size;               /* Slots in var_table (power of two) */
+    int words;                    /* Words per live set */
+    unsigned* live_bits;          /* Storage for the live sets of the region */
+} FlowRegion;
+
+/* Flow graph of one TAC list plus the analyses computed over it */
+typedef struct {
+    TACCode* code;                /* Instructions the graph describes */
+    BasicBlock* blocks;           /* Blocks in list order */
+    int block_count;              /* Number of blocks */
+    FlowRegion* regions;          /* Regions in list order */
+    int region_count;             /* Number of regions */
+    unsigned valid;               /* AnalysisKind bits that are up to date */
+    int computed[ANALYSIS_COUNT]; /* Times each analysis was computed */
+} FlowGraph;
+
+/* FLOW GRAPH FUNCTIONS */
+
+/* Create a flow graph for code with no analyses computed yet */
+FlowGraph* create_flow_graph(TACCode* code);
+
+/* Make sure the given analyses (AnalysisKind bits) are up to date,
+ * computing the missing ones and anything they depend on */
+void require_analyses(FlowGraph* graph, unsigned analyses);
+
+/* Mark analyses as out of date. Dropping the CFG drops everything. */
+void invalidate_analyses(FlowGraph* graph, unsigned analyses);
+
+/* Free a flow graph (the TAC list is not touched) */
+void free_flow_graph(FlowGraph* graph);
+
+/* Name of analysis number index (0 .. ANALYSIS_COUNT-1) */
+const char* analysis_name(int index);
+
+/* Number of name in the live sets of block's region (-1 if not referenced) */
+int live_variable_index(const FlowGraph* graph, int block, const char* name);
+
+/* Does block a dominate block b? (needs ANALYSIS_DOMINATORS) */
+int block_dominates(const FlowGraph* graph, int a, int b);
+
+/* OPERAND HELPERS */
+
+/* Operand slots of an instruction */
+#define TAC_SLOT_RESULT 0             /* result (the variable written) */
+#define TAC_SLOT_OP1    1             /* op1 */
+#define TAC_SLOT_OP2    2             /* op2 */
+#define TAC_SLOT_COUNT  3
+
+/* Operand field for a slot (&inst->result, &inst->op1 or &inst->op2) */
+char** tac_slot(TACInstruction* inst, int slot);
+
+/* Operand slots an instruction reads as scalars (TAC_SLOT_OP1/OP2; array
+ * names and literals are skipped, a name read twice appears twice).
+ * Returns how many there are (at most 2). */
+int tac_use_slots(const TACInstruction* inst, int slots[2]);
+
+/* Variables an instruction reads as scalars (array names and literals are
+ * skipped). Fills uses and returns how many there are (at most 2). */
+int tac_uses(const TACInstruction* inst, const char* uses[2]);
+
+/* Scalar variable an instruction writes (NULL if none) */
+const char* tac_def(const TACInstruction* inst);
+
+/* Is name a compiler temporary (t0, t1, ...)? */
+int is_temporary(const char* name);
+
+#endif /* CFG_H */
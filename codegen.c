@@ -8,311 +8,1103 @@
  */
 
 #include "codegen.h"
+#include "diagnostics.h"
 
-/* Create a new code generator instance */
-CodeGenerator* create_code_generator(const char* output_filename, SymbolTable* symtab) {
-    CodeGenerator* gen = (CodeGenerator*)malloc(sizeof(CodeGenerator));
-    if (!gen) {
-        fprintf(stderr, "Fatal Error: Failed to allocate code generator\n");
-        exit(1);
-    }
+/* Prefix that makes NASM read a name as a symbol, never a keyword
+ * ("$main" and "main" are the same symbol) */
+#define USER_SYMBOL_PREFIX "$"
 
-    gen->output_file = fopen(output_filename, "w");
-    if (!gen->output_file) {
-        fprintf(stderr, "Fatal Error: Cannot open output file '%s'\n", output_filename);
-        free(gen);
-        exit(1);
-    }
+/* Create a new code generator instance */
+CodeGenerator* create_code_generator(OutputSink* out, SymbolTable* symtab, int comments) {
+    CodeGenerator* gen = (CodeGenerator*)safe_malloc(sizeof(CodeGenerator), "code generator");
 
+    init_emitter(&gen->emit, out, ';', comments);
     gen->stack_offset = 0;
     gen->symtab = symtab;
+    gen->slots = NULL;
+    gen->slot_count = 0;
+    gen->slot_capacity = 0;
+    gen->slot_index = NULL;
+    gen->index_capacity = 0;
+    gen->function_end = NULL;
+    gen->profile = NULL;
+    gen->bounds_checks = 0;
+    gen->vector_isa = VECTOR_NONE;
 
     return gen;
 }
 
+/* Copy a generator for a worker thread */
+void copy_code_generator(CodeGenerator* copy, const CodeGenerator* gen, OutputSink* out) {
+    *copy = *gen;
+    copy->emit.out = out;
+    copy->slots = NULL;
+    copy->slot_count = 0;
+    copy->slot_capacity = 0;
+    copy->slot_index = NULL;
+    copy->index_capacity = 0;
+    copy->function_end = NULL;
+}
+
+/* Release the frame state of a worker copy */
+void release_code_generator_copy(CodeGenerator* copy) {
+    free(copy->slots);
+    free(copy->slot_index);
+    copy->slots = NULL;
+    copy->slot_index = NULL;
+}
+
+/* STACK FRAMES */
+
+/* Helper: map index of name, or of the empty position where it belongs */
+static int find_slot_index(const CodeGenerator* gen, const char* name, unsigned int h) {
+    int mask = gen->index_capacity - 1;
+    int i = h & mask;
+    while (gen->slot_index[i] >= 0) {
+        const FrameSlot* slot = &gen->slots[gen->slot_index[i]];
+        if (slot->name_hash == h && strcmp(slot->name, name) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Slot of name in the current frame (NULL if it has none) */
+FrameSlot* find_frame_slot(const CodeGenerator* gen, const char* name) {
+    if (gen->slot_count == 0) return NULL;
+    int i = find_slot_index(gen, name, hash(name));
+    return gen->slot_index[i] >= 0 ? &gen->slots[gen->slot_index[i]] : NULL;
+}
+
+/* Helper: grow the slot map (kept at most half full) */
+static void grow_slot_index(CodeGenerator* gen) {
+    int capacity = gen->index_capacity ? gen->index_capacity * 2 : 64;
+    int* index = (int*)safe_malloc(capacity * sizeof(int), "stack frame");
+
+    free(gen->slot_index);
+    gen->slot_index = index;
+    gen->index_capacity = capacity;
+    for (int i = 0; i < capacity; i++) index[i] = -1;
+    for (int s = 0; s < gen->slot_count; s++) {
+        index[find_slot_index(gen, gen->slots[s].name, gen->slots[s].name_hash)] = s;
+    }
+}
+
+/* Helper: add name to the frame (or widen its slot to size qwords) */
+static FrameSlot* add_slot(CodeGenerator* gen, const char* name, int size, int is_param) {
+    if (2 * (gen->slot_count + 1) > gen->index_capacity) {
+        grow_slot_index(gen);
+    }
+
+    unsigned int h = hash(name);
+    int i = find_slot_index(gen, name, h);
+    if (gen->slot_index[i] >= 0) {
+        FrameSlot* slot = &gen->slots[gen->slot_index[i]];
+        if (size > slot->size) slot->size = size;
+        return slot;
+    }
+
+    if (gen->slot_count == gen->slot_capacity) {
+        gen->slot_capacity = gen->slot_capacity ? gen->slot_capacity * 2 : 32;
+        gen->slots = (FrameSlot*)safe_realloc(gen->slots, gen->slot_capacity * sizeof(FrameSlot),
+                                              "stack frame");
+    }
+
+    FrameSlot* slot = &gen->slots[gen->slot_count];
+    slot->name = name;
+    slot->name_hash = h;
+    slot->size = size;
+    slot->is_param = is_param;
+    slot->offset = 0;
+    slot->location[0] = '\0';
+    gen->slot_index[i] = gen->slot_count++;
+    return slot;
+}
+
+/* Helper: give a name used by the function a slot unless it is a literal,
+ * already has one or names a global variable */
+static void add_operand_slot(CodeGenerator* gen, const char* name) {
+    if (!name || is_literal(name) || find_frame_slot(gen, name)) return;
+
+    Symbol* global = lookup_symbol(gen->symtab, name);
+    if (global && global->kind == SYMBOL_VARIABLE && global->scope_depth == 0) return;
+
+    add_slot(gen, name, 1, 0);
+}
+
+/* Lay out the frame of the function starting at label: parameters above
+ * the return address, then the saved-rsp slot, locals (arrays included)
+ * and temporaries below rbp */
+void build_function_frame(CodeGenerator* gen, TACInstruction* label) {
+    gen->slot_count = 0;
+    for (int i = 0; i < gen->index_capacity; i++) gen->slot_index[i] = -1;
+    if (gen->index_capacity == 0) grow_slot_index(gen);
+
+    Symbol* func = lookup_symbol(gen->symtab, label->label);
+    if (func && func->kind == SYMBOL_FUNCTION) {
+        for (int i = 0; i < func->param_count; i++) {
+            FrameSlot* slot = add_slot(gen, func->param_names[i], 1, 1);
+            slot->offset = 16 + 8 * (func->param_count - 1 - i);
+            snprintf(slot->location, sizeof(slot->location), "rbp+%d", slot->offset);
+        }
+
+        Symbol* sym = func->locals;
+        for (int i = 0; i < func->local_count && sym; i++, sym = sym->next) {
+            if (sym->kind != SYMBOL_VARIABLE) continue;
+            FrameSlot* existing = find_frame_slot(gen, sym->storage_name);
+            if (existing && existing->is_param) continue;
+            add_slot(gen, sym->storage_name, sym->is_array ? sym->array_size : 1, 0);
+        }
+    }
+
+    /* Temporaries (and anything else that is not a global) */
+    TACInstruction* inst = label;
+    while (inst->next && inst->next->opcode != TAC_FUNCTION_LABEL) {
+        inst = inst->next;
+        switch (inst->opcode) {
+            case TAC_LABEL:
+            case TAC_GOTO:
+            case TAC_RETURN_VOID:
+            case TAC_PROFILE:
+                break;
+            case TAC_CALL:
+            case TAC_LOAD_CONST:
+                add_operand_slot(gen, inst->result);
+                break;
+            default:
+                add_operand_slot(gen, inst->result);
+                add_operand_slot(gen, inst->op1);
+                add_operand_slot(gen, inst->op2);
+                break;
+        }
+    }
+    gen->function_end = inst;
+
+    /* [rbp-8] keeps rsp across calls into the C library */
+    int offset = 8;
+    for (int s = 0; s < gen->slot_count; s++) {
+        FrameSlot* slot = &gen->slots[s];
+        if (slot->is_param) continue;
+        offset += 8 * slot->size;
+        slot->offset = -offset;
+        snprintf(slot->location, sizeof(slot->location), "rbp-%d", offset);
+    }
+    gen->stack_offset = (offset + 15) & ~15;
+}
+
+/* Get the frame location of a variable/temporary (NULL for globals) */
+const char* get_location(CodeGenerator* gen, const char* name) {
+    FrameSlot* slot = find_frame_slot(gen, name);
+    return slot ? slot->location : NULL;
+}
+
+/* Helper: append a variable operand - an immediate for literals, the
+ * frame slot for locals and temporaries, [$name] for globals */
+static void emit_var(CodeGenerator* gen, const char* name) {
+    AsmEmitter* e = &gen->emit;
+    if (is_literal(name)) {
+        emit_sym(e, name);
+        return;
+    }
+
+    const char* location = get_location(gen, name);
+    if (location) {
+        emit_mem(e, location);
+    } else {
+        emit_mem_symbol(e, USER_SYMBOL_PREFIX, name);
+    }
+}
+
+/* Helper: "    mnemonic reg, operand" */
+static void insn_reg_var(CodeGenerator* gen, const char* mnemonic, const char* reg,
+                         const char* name, const char* comment) {
+    AsmEmitter* e = &gen->emit;
+    emit_insn(e, mnemonic);
+    emit_reg(e, reg);
+    emit_var(gen, name);
+    emit_end(e, comment);
+}
+
+/* Helper: "    mnemonic operand, reg" */
+static void insn_var_reg(CodeGenerator* gen, const char* mnemonic, const char* name,
+                         const char* reg, const char* comment) {
+    AsmEmitter* e = &gen->emit;
+    emit_insn(e, mnemonic);
+    emit_var(gen, name);
+    emit_reg(e, reg);
+    emit_end(e, comment);
+}
+
+/* Helper: "    mnemonic operand" (register, label or immediate text) */
+static void insn_sym(AsmEmitter* e, const char* mnemonic, const char* operand,
+                     const char* comment) {
+    emit_insn(e, mnemonic);
+    emit_sym(e, operand);
+    emit_end(e, comment);
+}
+
+/* Helper: "    mnemonic $name" for a user-defined function */
+static void insn_function(AsmEmitter* e, const char* mnemonic, const char* name) {
+    emit_insn(e, mnemonic);
+    emit_sym(e, USER_SYMBOL_PREFIX);
+    emit_text(e, name);
+    emit_end(e, NULL);
+}
+
+/* Helper: rcx = address of element index of array */
+static void array_element_address(CodeGenerator* gen, const char* array, const char* index) {
+    AsmEmitter* e = &gen->emit;
+    insn_reg_var(gen, "mov", "rax", index, "     ; Get index");
+    emit_line(e, "    imul rax, 8", "        ; Multiply by element size (8 bytes)");
+    insn_reg_var(gen, "lea", "rcx", array, "      ; Get array base address");
+    emit_line(e, "    add rcx, rax", "       ; Add offset");
+}
+
+/* Helper: return to the caller with rax as the result */
+static void function_return(AsmEmitter* e) {
+    emit_line(e, "    mov rsp, rbp", "      ; Function epilogue");
+    emit_text(e, "    pop rbp\n");
+    emit_text(e, "    ret\n\n");
+}
+
+/* Helper: "    name: db ..., 0" for a C string - printable characters in
+ * quotes, the rest (newlines, quotes) as numbers */
+static void emit_string(AsmEmitter* e, const char* name, const char* text) {
+    char run[80];
+    int length = 0;
+    int first = 1;
+
+    emit_text(e, "    ");
+    emit_text(e, name);
+    emit_text(e, ": db ");
+    for (const char* p = text; ; p++) {
+        int quoted = *p >= 32 && *p < 127 && *p != '"';
+        if (length > 0 && (!quoted || length == (int)sizeof(run) - 4)) {
+            run[length++] = '"';
+            run[length] = '\0';
+            emit_text(e, first ? "" : ", ");
+            emit_text(e, run);
+            first = 0;
+            length = 0;
+        }
+        if (!*p) break;
+        if (quoted) {
+            if (length == 0) run[length++] = '"';
+            run[length++] = *p;
+        } else {
+            emit_text(e, first ? "" : ", ");
+            emit_int(e, (unsigned char)*p);
+            first = 0;
+        }
+    }
+    emit_text(e, first ? "0\n" : ", 0\n");
+}
+
+/* Helper: profile.dump - the atexit handler of an instrumented program,
+ * writing the header and then one count per line to the profile file */
+static void gen_profile_dump(CodeGenerator* gen) {
+    AsmEmitter* e = &gen->emit;
+
+    emit_text(e, "\n");
+    emit_note(e, "Profile dump (atexit handler): write the counters to the profile file", NULL);
+    emit_label(e, "profile.dump");
+    emit_text(e, "    push rbx\n");
+    emit_text(e, "    push rbp\n");
+    emit_line(e, "    sub rsp, 8", "        ; Align stack to 16 bytes");
+    emit_line(e, "    mov rdi, profile.path", "  ; File name");
+    emit_line(e, "    mov rsi, profile.mode", "  ; \"w\"");
+    emit_text(e, "    call fopen\n");
+    emit_text(e, "    test rax, rax\n");
+    emit_line(e, "    jz .done", "          ; Cannot write it - nothing to do");
+    emit_line(e, "    mov rbx, rax", "      ; FILE*");
+    emit_text(e, "    mov rdi, profile.header\n");
+    emit_text(e, "    mov rsi, rbx\n");
+    emit_text(e, "    call fputs\n");
+    emit_line(e, "    xor rbp, rbp", "      ; Counter number");
+    emit_label(e, ".next");
+    emit_insn(e, "cmp");
+    emit_reg(e, "rbp");
+    emit_imm(e, gen->profile->counter_count);
+    emit_end(e, NULL);
+    emit_text(e, "    jge .close\n");
+    emit_text(e, "    mov rdi, rbx\n");
+    emit_line(e, "    mov rsi, profile.format", "  ; \"%lld\\n\"");
+    emit_text(e, "    mov rdx, [profile.counts + rbp*8]\n");
+    emit_line(e, "    xor rax, rax", "      ; No vector registers used");
+    emit_text(e, "    call fprintf\n");
+    emit_text(e, "    inc rbp\n");
+    emit_text(e, "    jmp .next\n");
+    emit_label(e, ".close");
+    emit_text(e, "    mov rdi, rbx\n");
+    emit_text(e, "    call fclose\n");
+    emit_label(e, ".done");
+    emit_text(e, "    add rsp, 8\n");
+    emit_text(e, "    pop rbp\n");
+    emit_text(e, "    pop rbx\n");
+    emit_text(e, "    ret\n");
+}
+
+/* Helper: bounds.fail - where a failed bounds check jumps: report the
+ * error and exit with status 1 */
+static void gen_bounds_fail(CodeGenerator* gen) {
+    AsmEmitter* e = &gen->emit;
+
+    emit_text(e, "\n");
+    emit_note(e, "Bounds check failure: report it and exit with status 1", NULL);
+    emit_label(e, "bounds.fail");
+    emit_line(e, "    and rsp, -16", "      ; Align stack to 16 bytes");
+    emit_line(e, "    mov rdi, 2", "        ; stderr");
+    emit_text(e, "    mov rsi, bounds.message\n");
+    emit_line(e, "    xor rax, rax", "      ; No vector registers used");
+    emit_text(e, "    call dprintf\n");
+    emit_line(e, "    mov rdi, 1", "        ; Exit status");
+    emit_text(e, "    call exit\n");
+}
+
 /* Generate the assembly prologue (program initialization) */
 void gen_prologue(CodeGenerator* gen) {
-    fprintf(gen->output_file, "; CST-405 Compiler - Generated Assembly Code\n");
-    fprintf(gen->output_file, "; Target: x86-64 (64-bit)\n");
-    fprintf(gen->output_file, "; Calling Convention: System V AMD64 ABI\n\n");
+    AsmEmitter* e = &gen->emit;
 
-    fprintf(gen->output_file, "section .note.GNU-stack noalloc noexec nowrite progbits\n\n");
+    emit_text(e, "; CST-405 Compiler - Generated Assembly Code\n");
+    emit_text(e, "; Target: x86-64 (64-bit)\n");
+    emit_text(e, "; Calling Convention: System V AMD64 ABI\n\n");
 
-    fprintf(gen->output_file, "section .data\n");
-    fprintf(gen->output_file, "    ; Data section for constants\n");
-    fprintf(gen->output_file, "    fmt_int: db \"%%d\", 10, 0  ; Format string for printing integers\n\n");
+    emit_text(e, "section .note.GNU-stack noalloc noexec nowrite progbits\n\n");
 
-    fprintf(gen->output_file, "section .bss\n");
-    fprintf(gen->output_file, "    ; BSS section for uninitialized data\n");
+    emit_text(e, "section .data\n");
+    emit_note(e, "Data section for constants", NULL);
+    emit_line(e, "    fmt_int: db \"%d\", 10, 0", "  ; Format string for printing integers");
+    if (gen->profile) {
+        emit_string(e, "profile.path", gen->profile->path);
+        emit_string(e, "profile.mode", "w");
+        emit_string(e, "profile.format", "%lld\n");
+        emit_string(e, "profile.header", gen->profile->header);
+    }
+    if (gen->bounds_checks) {
+        emit_string(e, "bounds.message", "Runtime error: array index out of range\n");
+    }
+    emit_text(e, "\n");
+
+    emit_text(e, "section .bss\n");
+    emit_note(e, "BSS section for global variables", NULL);
 
-    /* Allocate space for all variables in the symbol table (not functions) */
+    /* Global variables (locals and temporaries live in stack frames) */
     if (gen->symtab) {
-        for (int i = 0; i < gen->symtab->size; i++) {
-            Symbol* sym = gen->symtab->table[i];
-            while (sym) {
-                /* Only allocate space for variables, not functions */
-                if (sym->kind == SYMBOL_VARIABLE) {
-                    if (sym->is_array) {
-                        /* Arrays need space for multiple elements */
-                        fprintf(gen->output_file, "    %s: resq %d  ; Array: %s[%d]\n",
-                                sym->name, sym->array_size, sym->name, sym->array_size);
-                    } else {
-                        /* Regular variables need 1 qword */
-                        fprintf(gen->output_file, "    %s: resq 1  ; Variable: %s\n",
-                                sym->name, sym->name);
+        for (Symbol* sym = gen->symtab->symbols; sym; sym = sym->next) {
+            if (sym->kind == SYMBOL_VARIABLE && sym->scope_depth == 0) {
+                emit_text(e, "    " USER_SYMBOL_PREFIX);
+                emit_text(e, sym->name);
+                if (sym->is_array) {
+                    /* Arrays need space for multiple elements */
+                    emit_text(e, ": resq ");
+                    emit_int(e, sym->array_size);
+                    if (e->comments) {
+                        emit_text(e, "  ; Array: ");
+                        emit_text(e, sym->name);
+                        emit_text(e, "[");
+                        emit_int(e, sym->array_size);
+                        emit_text(e, "]");
+                    }
+                } else {
+                    /* Regular variables need 1 qword */
+                    emit_text(e, ": resq 1");
+                    if (e->comments) {
+                        emit_text(e, "  ; Variable: ");
+                        emit_text(e, sym->name);
                     }
                 }
-                sym = sym->next;
+                emit_text(e, "\n");
             }
         }
     }
 
-    /* Allocate space for temporaries (t0-t99) */
-    fprintf(gen->output_file, "\n    ; Temporary variables\n");
-    for (int i = 0; i < 100; i++) {
-        fprintf(gen->output_file, "    t%d: resq 1\n", i);
+    if (gen->profile) {
+        emit_text(e, "    profile.counts: resq ");
+        emit_int(e, gen->profile->counter_count > 0 ? gen->profile->counter_count : 1);
+        emit_end(e, "  ; Profile counters");
     }
 
-    fprintf(gen->output_file, "\nsection .text\n");
-    fprintf(gen->output_file, "    global main\n");
-    fprintf(gen->output_file, "    extern printf  ; External C library function\n\n");
-
-    fprintf(gen->output_file, "main:\n");
-    fprintf(gen->output_file, "    ; Function prologue\n");
-    fprintf(gen->output_file, "    push rbp\n");
-    fprintf(gen->output_file, "    mov rbp, rsp\n\n");
+    emit_text(e, "\nsection .text\n");
+    emit_text(e, "    global main\n");
+    emit_line(e, "    extern printf", "  ; External C library function");
+    if (gen->profile) {
+        emit_text(e, "    extern fopen, fputs, fprintf, fclose, atexit\n");
+        gen_profile_dump(gen);
+    }
+    if (gen->bounds_checks) {
+        emit_text(e, "    extern dprintf, exit\n");
+        gen_bounds_fail(gen);
+    }
 }
 
 /* Generate the assembly epilogue (program termination) */
 void gen_epilogue(CodeGenerator* gen) {
-    fprintf(gen->output_file, "\n    ; Function epilogue\n");
-    fprintf(gen->output_file, "    mov rsp, rbp\n");
-    fprintf(gen->output_file, "    pop rbp\n");
-    fprintf(gen->output_file, "    mov rax, 0    ; Return 0 (success)\n");
-    fprintf(gen->output_file, "    ret\n");
+    AsmEmitter* e = &gen->emit;
+
+    /* A program without a main function still links and exits with 0 */
+    Symbol* main_symbol = gen->symtab ? lookup_symbol(gen->symtab, "main") : NULL;
+    if (main_symbol && main_symbol->kind == SYMBOL_FUNCTION) return;
+
+    emit_text(e, "\nmain:\n");
+    emit_line(e, "    mov rax, 0", "    ; Return 0 (success)");
+    emit_text(e, "    ret\n");
+}
+
+/* Helper: division or modulo whose operands are never negative and fit
+ * in 32 bits (TAC_FLAG_NONNEG, see range.h) - a shift or mask for a
+ * power-of-two divisor, otherwise a 32-bit unsigned divide, which needs
+ * no sign extension and is faster than the 64-bit idiv */
+static void gen_unsigned_division(CodeGenerator* gen, TACInstruction* inst) {
+    AsmEmitter* e = &gen->emit;
+    int shift = divisor_shift(inst);
+    insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+    if (shift >= 0 && inst->opcode == TAC_DIV) {
+        emit_insn(e, "shr");
+        emit_reg(e, "rax");
+        emit_imm(e, shift);
+        emit_end(e, "      ; Non-negative: divide by shifting");
+    } else if (shift >= 0) {
+        emit_insn(e, "and");
+        emit_reg(e, "rax");
+        emit_imm(e, (1L << shift) - 1);
+        emit_end(e, "      ; Non-negative: remainder by masking");
+    } else {
+        insn_reg_var(gen, "mov", "rcx", inst->op2, NULL);
+        emit_line(e, "    xor edx, edx", "    ; Non-negative: no sign extension");
+        emit_line(e, "    div ecx", "           ; Unsigned 32-bit divide edx:eax by ecx");
+        if (inst->opcode == TAC_MOD) {
+            insn_var_reg(gen, "mov", inst->result, "rdx", "    ; Remainder is in rdx");
+            emit_text(e, "\n");
+            return;
+        }
+    }
+    insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+    emit_text(e, "\n");
+}
+
+/* VECTOR LOOPS */
+
+static const char* const xmm_registers[VECTOR_REGISTERS] = {
+    "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+    "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"
+};
+static const char* const ymm_registers[VECTOR_REGISTERS] = {
+    "ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
+    "ymm8", "ymm9", "ymm10", "ymm11", "ymm12", "ymm13", "ymm14", "ymm15"
+};
+
+/* Registers holding the array base addresses (VectorLoop.arrays order) */
+static const char* const vector_bases[VECTOR_MAX_ARRAYS] = { "rsi", "rdi", "r8", "r9", "r10", "r11" };
+
+/* Vector loop being generated: accumulators in the first registers, then
+ * the constants and scalars, the index lanes and their step, and scratch
+ * registers for evaluating values */
+typedef struct {
+    CodeGenerator* gen;
+    const VectorLoop* loop;
+    int avx;                          /* AVX2: ymm registers and three-operand forms */
+    int lanes;                        /* Iterations per vector iteration */
+    int leaf[VECTOR_MAX_NODES];       /* Register of a constant, scalar or index node */
+    int step;                         /* Register with lanes in every lane */
+    int scratch;                      /* First scratch register */
+} VectorGen;
+
+/* Helper: name of vector register n */
+static const char* vector_register(const VectorGen* v, int n) {
+    return v->avx ? ymm_registers[n] : xmm_registers[n];
+}
+
+/* Helper: "    mnemonic a, b[, c]" with register operands */
+static void insn_regs(AsmEmitter* e, const char* mnemonic, const char* a, const char* b, const char* c) {
+    emit_insn(e, mnemonic);
+    emit_reg(e, a);
+    emit_reg(e, b);
+    if (c) emit_reg(e, c);
+    emit_end(e, NULL);
+}
+
+/* Helper: dst = a op b - "op dst, b" after copying a to dst (SSE2) or
+ * "vop dst, a, b" (AVX2) */
+static void vector_binary(VectorGen* v, const char* op, int dst, int a, int b) {
+    AsmEmitter* e = &v->gen->emit;
+    if (v->avx) {
+        char mnemonic[16];
+        snprintf(mnemonic, sizeof(mnemonic), "v%s", op);
+        insn_regs(e, mnemonic, vector_register(v, dst), vector_register(v, a), vector_register(v, b));
+        return;
+    }
+    if (dst != a) insn_regs(e, "movdqa", vector_register(v, dst), vector_register(v, a), NULL);
+    insn_regs(e, op, vector_register(v, dst), vector_register(v, b), NULL);
+}
+
+/* Helper: dst = a shifted by count bits (op psllq or psrlq) */
+static void vector_shift(VectorGen* v, const char* op, int dst, int a, int count) {
+    AsmEmitter* e = &v->gen->emit;
+    if (v->avx) {
+        char mnemonic[16];
+        snprintf(mnemonic, sizeof(mnemonic), "v%s", op);
+        emit_insn(e, mnemonic);
+        emit_reg(e, vector_register(v, dst));
+        emit_reg(e, vector_register(v, a));
+    } else {
+        if (dst != a) insn_regs(e, "movdqa", vector_register(v, dst), vector_register(v, a), NULL);
+        emit_insn(e, op);
+        emit_reg(e, vector_register(v, dst));
+    }
+    emit_imm(e, count);
+    emit_end(e, NULL);
+}
+
+/* Helper: register n = rax in every lane */
+static void vector_broadcast(VectorGen* v, int n) {
+    AsmEmitter* e = &v->gen->emit;
+    insn_regs(e, v->avx ? "vmovq" : "movq", xmm_registers[n], "rax", NULL);
+    if (v->avx) {
+        insn_regs(e, "vpbroadcastq", ymm_registers[n], xmm_registers[n], NULL);
+    } else {
+        insn_regs(e, "punpcklqdq", xmm_registers[n], xmm_registers[n], NULL);
+    }
+}
+
+/* Helper: load register n from arrays[array][i..] or store it there */
+static void vector_access(VectorGen* v, int n, int array, int is_store) {
+    AsmEmitter* e = &v->gen->emit;
+    char address[24];
+    snprintf(address, sizeof(address), "%s+rdx*8", vector_bases[array]);
+    emit_insn(e, v->avx ? "vmovdqu" : "movdqu");
+    if (is_store) {
+        emit_mem(e, address);
+        emit_reg(e, vector_register(v, n));
+    } else {
+        emit_reg(e, vector_register(v, n));
+        emit_mem(e, address);
+    }
+    emit_end(e, NULL);
+}
+
+/* Helper: evaluate node n for all lanes, using scratch registers from k
+ * up; returns the register holding the value */
+static int gen_vector_value(VectorGen* v, int n, int k) {
+    const VectorNode* node = &v->loop->nodes[n];
+    switch (node->op) {
+        case VECTOR_LOAD:
+            vector_access(v, k, node->array, 0);
+            return k;
+        case VECTOR_ADD:
+        case VECTOR_SUB:
+        case VECTOR_MUL:
+            break;
+        default:
+            return v->leaf[n];
+    }
+
+    int a = gen_vector_value(v, node->left, k);
+    if (node->shift >= 0) {
+        vector_shift(v, "psllq", k, a, node->shift);
+        return k;
+    }
+    int b = gen_vector_value(v, node->right, k + 1);
+    if (node->op == VECTOR_ADD) {
+        vector_binary(v, "paddq", k, a, b);
+    } else if (node->op == VECTOR_SUB) {
+        vector_binary(v, "psubq", k, a, b);
+    } else {
+        /* No 64-bit lane multiply before AVX-512: build the low 64 bits
+         * of the product from 32 x 32 bit ones,
+         * low(a)*low(b) + ((high(a)*low(b) + low(a)*high(b)) << 32) */
+        int t = k + 2;
+        int u = k + 3;
+        vector_shift(v, "psrlq", t, a, 32);
+        vector_binary(v, "pmuludq", t, t, b);
+        vector_shift(v, "psrlq", u, b, 32);
+        vector_binary(v, "pmuludq", u, u, a);
+        vector_binary(v, "paddq", t, t, u);
+        vector_shift(v, "psllq", t, t, 32);
+        vector_binary(v, "pmuludq", k, a, b);
+        vector_binary(v, "paddq", k, k, t);
+    }
+    return k;
+}
+
+/* Helper: register n = i, i+1, ... (the lanes' values of the induction
+ * variable, which is in rdx) */
+static void gen_vector_index(VectorGen* v, int n) {
+    AsmEmitter* e = &v->gen->emit;
+    int t = v->scratch;
+    int u = v->scratch + 1;
+
+    /* Lane offsets 0, 1 (, 2, 3) in t */
+    emit_line(e, "    mov eax, 1", NULL);
+    insn_regs(e, v->avx ? "vmovq" : "movq", xmm_registers[t], "rax", NULL);
+    if (v->avx) {
+        emit_insn(e, "vpslldq");
+        emit_reg(e, xmm_registers[t]);
+        emit_reg(e, xmm_registers[t]);
+        emit_imm(e, 8);
+        emit_end(e, NULL);
+        emit_line(e, "    mov eax, 2", NULL);
+        insn_regs(e, "vmovq", xmm_registers[u], "rax", NULL);
+        insn_regs(e, "vpbroadcastq", xmm_registers[u], xmm_registers[u], NULL);
+        insn_regs(e, "vpaddq", xmm_registers[u], xmm_registers[u], xmm_registers[t]);
+        emit_insn(e, "vinserti128");
+        emit_reg(e, ymm_registers[t]);
+        emit_reg(e, ymm_registers[t]);
+        emit_reg(e, xmm_registers[u]);
+        emit_imm(e, 1);
+        emit_end(e, NULL);
+    } else {
+        emit_insn(e, "pslldq");
+        emit_reg(e, xmm_registers[t]);
+        emit_imm(e, 8);
+        emit_end(e, NULL);
+    }
+
+    emit_line(e, "    mov rax, rdx", NULL);
+    vector_broadcast(v, n);
+    vector_binary(v, "paddq", n, n, t);
+}
+
+/* Helper: rax = sum of the lanes of register n */
+static void gen_vector_sum(VectorGen* v, int n) {
+    AsmEmitter* e = &v->gen->emit;
+    const char* t = xmm_registers[v->scratch];
+    if (v->avx) {
+        emit_insn(e, "vextracti128");
+        emit_reg(e, t);
+        emit_reg(e, ymm_registers[n]);
+        emit_imm(e, 1);
+        emit_end(e, NULL);
+        insn_regs(e, "vpaddq", xmm_registers[n], xmm_registers[n], t);
+    }
+    emit_insn(e, v->avx ? "vpshufd" : "pshufd");
+    emit_reg(e, t);
+    emit_reg(e, xmm_registers[n]);
+    emit_imm(e, 0xEE);
+    emit_end(e, "    ; High lane to the low one");
+    if (v->avx) {
+        insn_regs(e, "vpaddq", xmm_registers[n], xmm_registers[n], t);
+    } else {
+        insn_regs(e, "paddq", xmm_registers[n], t, NULL);
+    }
+    insn_regs(e, v->avx ? "vmovq" : "movq", "rax", xmm_registers[n], NULL);
+}
+
+/* Helper: vector loop in front of the loop at label, if it has one (see
+ * vectorize.h) */
+static void gen_vector_loop(CodeGenerator* gen, const TACInstruction* label) {
+    AsmEmitter* e = &gen->emit;
+    VectorLoop loop;
+    if (!find_vector_loop(label, &loop)) return;
+
+    VectorGen v;
+    v.gen = gen;
+    v.loop = &loop;
+    v.avx = gen->vector_isa == VECTOR_AVX2;
+    v.lanes = v.avx ? 4 : 2;
+    v.step = -1;
+
+    char head[64];
+    char done[64];
+    snprintf(head, sizeof(head), "%s.vector", label->label);
+    snprintf(done, sizeof(done), "%s.vector_done", label->label);
+
+    emit_note(e, "Vector loop: ", v.avx ? "4" : "2", " iterations of ", label->label,
+              v.avx ? " at a time (AVX2)" : " at a time (SSE2)", NULL);
+    insn_reg_var(gen, "mov", "rdx", loop.index, "     ; Induction variable");
+    for (int a = 0; a < loop.array_count; a++) {
+        insn_reg_var(gen, "lea", vector_bases[a], loop.arrays[a], "      ; Array base address");
+    }
+
+    /* Registers for the accumulators, constants, scalars and the index */
+    int r = loop.accumulator_count;
+    int index = -1;
+    for (int n = 0; n < loop.node_count; n++) {
+        const VectorNode* node = &loop.nodes[n];
+        v.leaf[n] = -1;
+        if (!node->used) continue;
+        if (node->op == VECTOR_CONST && node->value == 0) {
+            v.leaf[n] = r++;
+            vector_binary(&v, "pxor", v.leaf[n], v.leaf[n], v.leaf[n]);
+        } else if (node->op == VECTOR_CONST || node->op == VECTOR_SCALAR) {
+            v.leaf[n] = r++;
+            if (node->op == VECTOR_CONST) {
+                emit_insn(e, "mov");
+                emit_reg(e, "rax");
+                emit_imm(e, (long)node->value);
+                emit_end(e, NULL);
+            } else {
+                insn_reg_var(gen, "mov", "rax", node->name, NULL);
+            }
+            vector_broadcast(&v, v.leaf[n]);
+        } else if (node->op == VECTOR_INDEX) {
+            index = n;
+        }
+    }
+    if (index >= 0) {
+        v.leaf[index] = r++;
+        v.step = r++;
+    }
+    v.scratch = r;
+    if (index >= 0) {
+        gen_vector_index(&v, v.leaf[index]);
+        emit_insn(e, "mov");
+        emit_reg(e, "eax");
+        emit_imm(e, v.lanes);
+        emit_end(e, NULL);
+        vector_broadcast(&v, v.step);
+    }
+    for (int a = 0; a < loop.accumulator_count; a++) {
+        vector_binary(&v, "pxor", a, a, a);
+    }
+
+    /* Run while more than lanes iterations are left (i + lanes < bound,
+     * or <= for an inclusive bound) */
+    emit_label(e, head);
+    emit_insn(e, "lea");
+    emit_reg(e, "rax");
+    char next[24];
+    snprintf(next, sizeof(next), "rdx+%d", v.lanes);
+    emit_mem(e, next);
+    emit_end(e, NULL);
+    if (loop.bound) {
+        insn_reg_var(gen, "cmp", "rax", loop.bound, NULL);
+    } else {
+        emit_insn(e, "cmp");
+        emit_reg(e, "rax");
+        emit_imm(e, (long)loop.bound_value);
+        emit_end(e, NULL);
+    }
+    insn_sym(e, loop.inclusive ? "jg" : "jge", done, "  ; Leave the rest to the scalar loop");
+
+    for (int t = 0; t < loop.term_count; t++) {
+        const VectorTerm* term = &loop.terms[t];
+        int value = gen_vector_value(&v, term->value, v.scratch);
+        vector_binary(&v, term->subtract ? "psubq" : "paddq", term->accumulator, term->accumulator, value);
+    }
+    for (int s = 0; s < loop.store_count; s++) {
+        int value = gen_vector_value(&v, loop.stores[s].value, v.scratch);
+        vector_access(&v, value, loop.stores[s].array, 1);
+    }
+    if (index >= 0) {
+        vector_binary(&v, "paddq", v.leaf[index], v.leaf[index], v.step);
+    }
+    emit_insn(e, "add");
+    emit_reg(e, "rdx");
+    emit_imm(e, v.lanes);
+    emit_end(e, NULL);
+    insn_sym(e, "jmp", head, NULL);
+
+    /* Write back the index and the sums */
+    emit_label(e, done);
+    insn_var_reg(gen, "mov", loop.index, "rdx", NULL);
+    for (int a = 0; a < loop.accumulator_count; a++) {
+        gen_vector_sum(&v, a);
+        insn_var_reg(gen, "add", loop.accumulators[a], "rax", "     ; Add the lanes' sum");
+    }
+    if (v.avx) {
+        emit_line(e, "    vzeroupper", "        ; Avoid AVX-SSE transition stalls");
+    }
+    emit_text(e, "\n");
 }
 
 /* Generate code for a single TAC instruction */
 void gen_tac_instruction(CodeGenerator* gen, TACInstruction* inst) {
+    AsmEmitter* e = &gen->emit;
+
     switch (inst->opcode) {
         case TAC_LOAD_CONST:
             /* Load constant into variable: result = constant */
-            fprintf(gen->output_file, "    ; %s = %s\n", inst->result, inst->op1);
-            fprintf(gen->output_file, "    mov rax, %s\n", inst->op1);
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, NULL);
+            emit_insn(e, "mov");
+            emit_reg(e, "rax");
+            emit_sym(e, inst->op1);
+            emit_end(e, NULL);
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_ASSIGN:
             /* Assignment: result = op1 */
-            fprintf(gen->output_file, "    ; %s = %s\n", inst->result, inst->op1);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_ADD:
             /* Addition: result = op1 + op2 */
-            fprintf(gen->output_file, "    ; %s = %s + %s\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    add rax, [%s]\n", inst->op2);
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " + ", inst->op2, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            insn_reg_var(gen, "add", "rax", inst->op2, NULL);
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_SUB:
             /* Subtraction: result = op1 - op2 */
-            fprintf(gen->output_file, "    ; %s = %s - %s\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    sub rax, [%s]\n", inst->op2);
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " - ", inst->op2, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            insn_reg_var(gen, "sub", "rax", inst->op2, NULL);
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_MUL:
             /* Multiplication: result = op1 * op2 */
-            fprintf(gen->output_file, "    ; %s = %s * %s\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    imul rax, [%s]\n", inst->op2);
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " * ", inst->op2, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            insn_reg_var(gen, "imul", "rax", inst->op2, NULL);
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_DIV:
             /* Division: result = op1 / op2 */
-            fprintf(gen->output_file, "    ; %s = %s / %s\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    cqo              ; Sign-extend rax to rdx:rax\n");
-            fprintf(gen->output_file, "    mov rbx, [%s]\n", inst->op2);
-            fprintf(gen->output_file, "    idiv rbx          ; Signed divide rdx:rax by rbx\n");
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " / ", inst->op2, NULL);
+            if (inst->flags & TAC_FLAG_NONNEG) {
+                gen_unsigned_division(gen, inst);
+                break;
+            }
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            emit_line(e, "    cqo", "              ; Sign-extend rax to rdx:rax");
+            insn_reg_var(gen, "mov", "rcx", inst->op2, NULL);
+            emit_line(e, "    idiv rcx", "          ; Signed divide rdx:rax by rcx");
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_MOD:
             /* Modulo: result = op1 % op2 */
-            fprintf(gen->output_file, "    ; %s = %s %% %s\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    cqo              ; Sign-extend rax to rdx:rax\n");
-            fprintf(gen->output_file, "    mov rbx, [%s]\n", inst->op2);
-            fprintf(gen->output_file, "    idiv rbx          ; Signed divide rdx:rax by rbx\n");
-            fprintf(gen->output_file, "    mov [%s], rdx    ; Remainder is in rdx\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " % ", inst->op2, NULL);
+            if (inst->flags & TAC_FLAG_NONNEG) {
+                gen_unsigned_division(gen, inst);
+                break;
+            }
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            emit_line(e, "    cqo", "              ; Sign-extend rax to rdx:rax");
+            insn_reg_var(gen, "mov", "rcx", inst->op2, NULL);
+            emit_line(e, "    idiv rcx", "          ; Signed divide rdx:rax by rcx");
+            insn_var_reg(gen, "mov", inst->result, "rdx", "    ; Remainder is in rdx");
+            emit_text(e, "\n");
             break;
 
         case TAC_PRINT:
-            /* Print: print(op1) */
-            fprintf(gen->output_file, "    ; print(%s)\n", inst->op1);
-            fprintf(gen->output_file, "    mov rdi, fmt_int  ; Format string\n");
-            fprintf(gen->output_file, "    mov rsi, [%s]     ; Value to print\n", inst->op1);
-            fprintf(gen->output_file, "    xor rax, rax      ; No vector registers used\n");
-            fprintf(gen->output_file, "    call printf\n\n");
+            /* Print: print(op1) - printf needs a 16-byte aligned stack, and
+             * pending arguments may have left it unaligned */
+            emit_note(e, "print(", inst->op1, ")", NULL);
+            emit_line(e, "    mov rdi, fmt_int", "  ; Format string");
+            insn_reg_var(gen, "mov", "rsi", inst->op1, "     ; Value to print");
+            emit_line(e, "    mov [rbp-8], rsp", "  ; Save stack pointer");
+            emit_line(e, "    and rsp, -16", "      ; Align stack to 16 bytes");
+            emit_line(e, "    xor rax, rax", "      ; No vector registers used");
+            emit_text(e, "    call printf\n");
+            emit_line(e, "    mov rsp, [rbp-8]", "  ; Restore stack pointer");
+            emit_text(e, "\n");
             break;
 
         case TAC_LABEL:
-            /* Label: label: */
-            fprintf(gen->output_file, "%s:\n", inst->label);
+            /* Label: label: (a loop the vectorizer accepts gets its vector
+             * loop first, run when control falls into the loop) */
+            if (gen->vector_isa != VECTOR_NONE && inst->prev && inst->prev->opcode != TAC_GOTO &&
+                inst->prev->opcode != TAC_RETURN && inst->prev->opcode != TAC_RETURN_VOID) {
+                gen_vector_loop(gen, inst);
+            }
+            emit_label(e, inst->label);
             break;
 
         case TAC_GOTO:
             /* Unconditional jump: goto label */
-            fprintf(gen->output_file, "    ; goto %s\n", inst->label);
-            fprintf(gen->output_file, "    jmp %s\n\n", inst->label);
+            emit_note(e, "goto ", inst->label, NULL);
+            insn_sym(e, "jmp", inst->label, NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_RELOP:
             /* Relational operation: result = op1 relop op2 */
-            fprintf(gen->output_file, "    ; %s = %s %s %s\n",
-                    inst->result, inst->op1, inst->label, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    cmp rax, [%s]\n", inst->op2);
+            emit_note(e, inst->result, " = ", inst->op1, " ", inst->label, " ", inst->op2, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            insn_reg_var(gen, "cmp", "rax", inst->op2, NULL);
 
             /* Set result based on comparison (using setcc instructions) */
             if (strcmp(inst->label, "<") == 0) {
-                fprintf(gen->output_file, "    setl al       ; Set if less\n");
+                emit_line(e, "    setl al", "       ; Set if less");
             } else if (strcmp(inst->label, ">") == 0) {
-                fprintf(gen->output_file, "    setg al       ; Set if greater\n");
+                emit_line(e, "    setg al", "       ; Set if greater");
             } else if (strcmp(inst->label, "<=") == 0) {
-                fprintf(gen->output_file, "    setle al      ; Set if less or equal\n");
+                emit_line(e, "    setle al", "      ; Set if less or equal");
             } else if (strcmp(inst->label, ">=") == 0) {
-                fprintf(gen->output_file, "    setge al      ; Set if greater or equal\n");
+                emit_line(e, "    setge al", "      ; Set if greater or equal");
             } else if (strcmp(inst->label, "==") == 0) {
-                fprintf(gen->output_file, "    sete al       ; Set if equal\n");
+                emit_line(e, "    sete al", "       ; Set if equal");
             } else if (strcmp(inst->label, "!=") == 0) {
-                fprintf(gen->output_file, "    setne al      ; Set if not equal\n");
+                emit_line(e, "    setne al", "      ; Set if not equal");
             }
 
-            fprintf(gen->output_file, "    movzx rax, al     ; Zero-extend to 64-bit\n");
-            fprintf(gen->output_file, "    mov [%s], rax\n\n", inst->result);
+            emit_line(e, "    movzx rax, al", "     ; Zero-extend to 64-bit");
+            insn_var_reg(gen, "mov", inst->result, "rax", NULL);
+            emit_text(e, "\n");
             break;
 
         case TAC_IF_FALSE:
             /* Conditional jump: if_false op1 goto label */
-            fprintf(gen->output_file, "    ; if_false %s goto %s\n",
-                    inst->op1, inst->label);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    cmp rax, 0\n");
-            fprintf(gen->output_file, "    je %s         ; Jump if zero (false)\n\n",
-                    inst->label);
+            emit_note(e, "if_false ", inst->op1, " goto ", inst->label, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            emit_text(e, "    cmp rax, 0\n");
+            insn_sym(e, "je", inst->label, "         ; Jump if zero (false)");
+            emit_text(e, "\n");
+            break;
+
+        case TAC_IF_TRUE:
+            /* Conditional jump: if_true op1 goto label */
+            emit_note(e, "if_true ", inst->op1, " goto ", inst->label, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            emit_text(e, "    cmp rax, 0\n");
+            insn_sym(e, "jne", inst->label, "        ; Jump if not zero (true)");
+            emit_text(e, "\n");
             break;
 
         case TAC_ARRAY_LOAD:
             /* Array load: result = array[index] */
-            fprintf(gen->output_file, "    ; %s = %s[%s]\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]     ; Get index\n", inst->op2);
-            fprintf(gen->output_file, "    imul rax, 8        ; Multiply by element size (8 bytes)\n");
-            fprintf(gen->output_file, "    lea rbx, [%s]      ; Get array base address\n", inst->op1);
-            fprintf(gen->output_file, "    add rbx, rax       ; Add offset\n");
-            fprintf(gen->output_file, "    mov rax, [rbx]     ; Load array element\n");
-            fprintf(gen->output_file, "    mov [%s], rax      ; Store in result\n\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, "[", inst->op2, "]", NULL);
+            array_element_address(gen, inst->op1, inst->op2);
+            emit_line(e, "    mov rax, [rcx]", "     ; Load array element");
+            insn_var_reg(gen, "mov", inst->result, "rax", "      ; Store in result");
+            emit_text(e, "\n");
             break;
 
         case TAC_ARRAY_STORE:
             /* Array store: array[index] = value */
-            fprintf(gen->output_file, "    ; %s[%s] = %s\n",
-                    inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    mov rax, [%s]     ; Get index\n", inst->op1);
-            fprintf(gen->output_file, "    imul rax, 8        ; Multiply by element size (8 bytes)\n");
-            fprintf(gen->output_file, "    lea rbx, [%s]      ; Get array base address\n", inst->result);
-            fprintf(gen->output_file, "    add rbx, rax       ; Add offset\n");
-            fprintf(gen->output_file, "    mov rax, [%s]      ; Get value to store\n", inst->op2);
-            fprintf(gen->output_file, "    mov [rbx], rax     ; Store in array\n\n");
+            emit_note(e, inst->result, "[", inst->op1, "] = ", inst->op2, NULL);
+            array_element_address(gen, inst->result, inst->op1);
+            insn_reg_var(gen, "mov", "rax", inst->op2, "      ; Get value to store");
+            emit_line(e, "    mov [rcx], rax", "     ; Store in array");
+            emit_text(e, "\n");
             break;
 
         case TAC_FUNCTION_LABEL:
             /* Function label: function_name: */
-            fprintf(gen->output_file, "\n; Function: %s\n", inst->label);
-            fprintf(gen->output_file, "%s:\n", inst->label);
-            fprintf(gen->output_file, "    ; Function prologue\n");
-            fprintf(gen->output_file, "    push rbp\n");
-            fprintf(gen->output_file, "    mov rbp, rsp\n");
-            fprintf(gen->output_file, "    sub rsp, 64       ; Reserve space for local variables\n\n");
+            build_function_frame(gen, inst);
+
+            emit_text(e, "\n");
+            if (e->comments) {
+                emit_text(e, "; Function: ");
+                emit_text(e, inst->label);
+                emit_text(e, "\n");
+            }
+            emit_text(e, USER_SYMBOL_PREFIX);
+            emit_label(e, inst->label);
+            emit_note(e, "Function prologue", NULL);
+            emit_text(e, "    push rbp\n");
+            emit_text(e, "    mov rbp, rsp\n");
+            emit_insn(e, "sub");
+            emit_reg(e, "rsp");
+            emit_imm(e, gen->stack_offset);
+            emit_end(e, "       ; Reserve space for locals and temporaries");
+            emit_text(e, "\n");
+
+            if (gen->profile && strcmp(inst->label, "main") == 0) {
+                emit_note(e, "Write the profile when the program exits", NULL);
+                emit_line(e, "    mov [rbp-8], rsp", "  ; Save stack pointer");
+                emit_line(e, "    and rsp, -16", "      ; Align stack to 16 bytes");
+                emit_text(e, "    mov rdi, profile.dump\n");
+                emit_text(e, "    call atexit\n");
+                emit_line(e, "    mov rsp, [rbp-8]", "  ; Restore stack pointer");
+                emit_text(e, "\n");
+            }
             break;
 
         case TAC_PARAM:
             /* Parameter passing: param value
-             * System V AMD64 calling convention:
-             * First 6 integer args in: rdi, rsi, rdx, rcx, r8, r9
-             * Additional args pushed on stack in reverse order
-             * For simplicity, we'll push all params on stack
-             */
-            fprintf(gen->output_file, "    ; param %s\n", inst->op1);
-            fprintf(gen->output_file, "    mov rax, [%s]\n", inst->op1);
-            fprintf(gen->output_file, "    push rax\n\n");
+             * Arguments are pushed left to right; the caller pops them
+             * after the call returns */
+            emit_note(e, "param ", inst->op1, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, NULL);
+            emit_text(e, "    push rax\n\n");
             break;
 
-        case TAC_CALL:
+        case TAC_CALL: {
             /* Function call: result = call function_name, num_args
              * inst->result = result temp
              * inst->label = function name
              * inst->op1 = number of arguments
              */
-            fprintf(gen->output_file, "    ; %s = call %s, %s args\n",
-                    inst->result, inst->label, inst->op1);
-
-            /* Align stack to 16 bytes (required by System V AMD64) */
-            fprintf(gen->output_file, "    and rsp, -16      ; Align stack to 16 bytes\n");
+            emit_note(e, inst->result, " = call ", inst->label, ", ", inst->op1, " args", NULL);
 
             /* Call the function */
-            fprintf(gen->output_file, "    call %s\n", inst->label);
+            insn_function(e, "call", inst->label);
 
             /* Clean up stack (pop parameters) */
             int arg_count = atoi(inst->op1);
             if (arg_count > 0) {
-                fprintf(gen->output_file, "    add rsp, %d       ; Clean up %d args from stack\n",
-                        arg_count * 8, arg_count);
+                emit_insn(e, "add");
+                emit_reg(e, "rsp");
+                emit_imm(e, arg_count * 8);
+                if (e->comments) {
+                    emit_text(e, "       ; Clean up ");
+                    emit_int(e, arg_count);
+                    emit_text(e, " args from stack");
+                }
+                emit_end(e, NULL);
             }
 
             /* Store return value (in rax) to result */
-            fprintf(gen->output_file, "    mov [%s], rax     ; Store return value\n\n",
-                    inst->result);
+            if (inst->result) {
+                insn_var_reg(gen, "mov", inst->result, "rax", "     ; Store return value");
+            }
+            emit_text(e, "\n");
             break;
+        }
 
         case TAC_RETURN:
             /* Return statement: return value */
-            fprintf(gen->output_file, "    ; return %s\n", inst->op1);
-            fprintf(gen->output_file, "    mov rax, [%s]     ; Load return value\n", inst->op1);
-            fprintf(gen->output_file, "    mov rsp, rbp      ; Function epilogue\n");
-            fprintf(gen->output_file, "    pop rbp\n");
-            fprintf(gen->output_file, "    ret\n\n");
+            emit_note(e, "return ", inst->op1, NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, "     ; Load return value");
+            function_return(e);
             break;
 
         case TAC_RETURN_VOID:
             /* Return from void function */
-            fprintf(gen->output_file, "    ; return (void)\n");
-            fprintf(gen->output_file, "    mov rsp, rbp      ; Function epilogue\n");
-            fprintf(gen->output_file, "    pop rbp\n");
-            fprintf(gen->output_file, "    ret\n\n");
+            emit_note(e, "return (void)", NULL);
+            function_return(e);
+            break;
+
+        case TAC_PROFILE: {
+            /* Profile counter: counts[op1] += 1 */
+            char code[64];
+            snprintf(code, sizeof(code), "    inc qword [profile.counts + %ld]", 8L * atol(inst->op1));
+            emit_line(e, code, "  ; Profile counter");
+            break;
+        }
+
+        case TAC_BOUNDS_CHECK:
+            /* Bounds check: stop unless 0 <= index < size */
+            emit_note(e, "check 0 <= ", inst->op1, " < ", inst->op2, " (", inst->result, ")", NULL);
+            insn_reg_var(gen, "mov", "rax", inst->op1, "     ; Get index");
+            emit_insn(e, "cmp");
+            emit_reg(e, "rax");
+            emit_imm(e, atol(inst->op2));
+            emit_end(e, "      ; Compare with the array size");
+            insn_sym(e, "jae", "bounds.fail", "  ; Out of range (negative is above too)");
+            emit_text(e, "\n");
             break;
 
         default:
-            fprintf(gen->output_file, "    ; Unknown TAC instruction\n\n");
+            emit_note(e, "Unknown TAC instruction", NULL);
+            emit_text(e, "\n");
             break;
     }
+
+    /* Falling off the end of a function returns 0 */
+    if (inst == gen->function_end && inst->opcode != TAC_RETURN &&
+        inst->opcode != TAC_RETURN_VOID && inst->opcode != TAC_GOTO) {
+        emit_note(e, "End of function", NULL);
+        emit_text(e, "    mov rax, 0\n");
+        function_return(e);
+    }
 }
 
 /* Generate assembly code from TAC */
 void generate_assembly(CodeGenerator* gen, TACCode* tac) {
-    printf("\n=============== CODE GENERATION STARTED ===================\n\n");
+    log_message(LOG_NORMAL, "\n=============== CODE GENERATION STARTED ===================\n\n");
 
     /* Generate prologue */
     gen_prologue(gen);
@@ -327,18 +1119,16 @@ void generate_assembly(CodeGenerator* gen, TACCode* tac) {
     /* Generate epilogue */
     gen_epilogue(gen);
 
-    printf("Assembly code generated successfully\n");
-    printf("Output file: output.asm\n");
+    log_message(LOG_NORMAL, "Assembly code generated successfully\n");
+    log_message(LOG_NORMAL, "Output file: output.asm\n");
 
-    printf("\n=============== CODE GENERATION COMPLETE ==================\n\n");
+    log_message(LOG_NORMAL, "\n=============== CODE GENERATION COMPLETE ==================\n\n");
 }
 
 /* Close and cleanup code generator */
 void close_code_generator(CodeGenerator* gen) {
     if (gen) {
-        if (gen->output_file) {
-            fclose(gen->output_file);
-        }
+        release_code_generator_copy(gen);
         free(gen);
     }
 }
@@ -4,6 +4,27 @@
  *
  * This file defines the code generation phase which translates
  * Three-Address Code (TAC) into target assembly code (x86-64).
+ *
+ * Global variables live in .bss. Each function gets a stack frame holding
+ * its locals and temporaries (rbp-relative), so recursive calls do not
+ * share storage. Arguments are pushed left to right and popped by the
+ * caller; the callee finds parameter i of n at [rbp + 16 + 8*(n-1-i)].
+ * User-defined names are written with NASM's "$" prefix so that a variable
+ * or function may be called "add" or "loop".
+ *
+ * With a profile (--profile-generate) the counters live in .bss as
+ * profile.counts, TAC_PROFILE adds 1 to one of them, and main registers
+ * profile.dump with atexit() to write them to the profile file. Names
+ * with a '.' cannot clash with the program's own.
+ *
+ * With --bounds-check each TAC_BOUNDS_CHECK compares the index with the
+ * array size (unsigned, so a negative index fails too) and jumps to
+ * bounds.fail, which reports the error on stderr and exits with status 1.
+ *
+ * Loops the vectorizer accepts (vectorize.h) get a vector loop in front
+ * of the label of the scalar one: L.vector runs 2 (SSE2) or 4 (AVX2)
+ * iterations at a time in 64-bit lanes while more than that many are
+ * left, then falls into the scalar loop at L, which does the rest.
  */
 
 #ifndef CODEGEN_H
@@ -14,18 +35,41 @@
 #include <string.h>
 #include "ircode.h"
 #include "symtable.h"
+#include "emit.h"
+#include "profile.h"
+#include "vectorize.h"
+
+/* Stack slot of a parameter, local variable or temporary */
+typedef struct {
+    const char* name;           /* TAC operand name (borrowed from the TAC / symbol table) */
+    unsigned int name_hash;     /* Hash of the name */
+    int size;                   /* Size in qwords (array length for local arrays) */
+    int is_param;               /* Parameter (above the return address) */
+    int offset;                 /* Displacement from rbp */
+    char location[24];          /* Memory operand text: "rbp-24", "rbp+16" */
+} FrameSlot;
 
 /* Assembly code output structure */
 typedef struct {
-    FILE* output_file;          /* File to write assembly code to */
-    int stack_offset;           /* Current stack frame offset */
+    AsmEmitter emit;            /* Emitter writing the assembly code */
+    int stack_offset;           /* Frame size of the current function (bytes below rbp) */
     SymbolTable* symtab;        /* Symbol table for variable locations */
+    FrameSlot* slots;           /* Slots of the current function, in allocation order */
+    int slot_count;             /* Slots in use */
+    int slot_capacity;          /* Slots allocated */
+    int* slot_index;            /* Open-addressing map name -> slot number (-1 = empty) */
+    int index_capacity;         /* Map size (power of two) */
+    TACInstruction* function_end; /* Last instruction of the current function */
+    const Profile* profile;     /* Counters of an instrumented program (NULL = none) */
+    int bounds_checks;          /* Emit bounds.fail for TAC_BOUNDS_CHECK (--bounds-check) */
+    int vector_isa;             /* Vectorize loops for this instruction set (VectorISA) */
 } CodeGenerator;
 
 /* CODE GENERATION FUNCTIONS */
 
-/* Create a new code generator */
-CodeGenerator* create_code_generator(const char* output_filename, SymbolTable* symtab);
+/* Create a new code generator writing to out (the caller keeps ownership);
+ * comments = 0 leaves out the annotation comments */
+CodeGenerator* create_code_generator(OutputSink* out, SymbolTable* symtab, int comments);
 
 /* Generate assembly code from TAC */
 void generate_assembly(CodeGenerator* gen, TACCode* tac);
@@ -39,10 +83,24 @@ void gen_epilogue(CodeGenerator* gen);
 /* Generate code for a single TAC instruction */
 void gen_tac_instruction(CodeGenerator* gen, TACInstruction* inst);
 
-/* Get memory location for a variable/temporary */
+/* Lay out the stack frame of the function starting at label (sets the
+ * slots, stack_offset and function_end) */
+void build_function_frame(CodeGenerator* gen, TACInstruction* label);
+
+/* Frame slot of a name in the current function (NULL for globals) */
+FrameSlot* find_frame_slot(const CodeGenerator* gen, const char* name);
+
+/* Get memory location for a variable/temporary: the frame slot text
+ * ("rbp-16") for parameters, locals and temporaries of the current
+ * function, NULL for globals */
 const char* get_location(CodeGenerator* gen, const char* name);
 
-/* Close and cleanup code generator */
+/* Copy a generator for a worker thread: same settings, its own output
+ * sink and frame state (release with release_code_generator_copy) */
+void copy_code_generator(CodeGenerator* copy, const CodeGenerator* gen, OutputSink* out);
+void release_code_generator_copy(CodeGenerator* copy);
+
+/* Free the code generator (the sink stays open) */
 void close_code_generator(CodeGenerator* gen);
 
 #endif /* CODEGEN_H */
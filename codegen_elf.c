@@ -0,0 +1,776 @@
+/*
+ * CODEGEN_ELF.C - Object Code Generator Implementation
+ * CST-405 Compiler Project
+ *
+ * Each TAC instruction is encoded as the x86-64 instructions codegen.c
+ * writes for it. Only rax, rcx, rdx, rsi, rdi, rsp and rbp are used, so
+ * every instruction is REX.W plus opcode plus ModRM without extension bits.
+ * Memory operands are [rbp+disp8/disp32] for frame slots and [rip+disp32]
+ * with an R_X86_64_PC32 relocation for globals.
+ *
+ * Jumps and calls to functions defined in this program are resolved here
+ * once all of .text is known; only printf and undefined functions are left
+ * to the linker (R_X86_64_PLT32).
+ */
+
+#include "codegen_elf.h"
+#include "diagnostics.h"
+
+/* Register numbers (ModRM encoding) */
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RBX 3
+#define RSP 4
+#define RBP 5
+#define RSI 6
+#define RDI 7
+
+#define REX_W 0x48
+
+/* Two-byte opcodes are written as 0x0Fxx */
+#define OP_ADD     0x03           /* add r64, r/m64 */
+#define OP_SUB     0x2B           /* sub r64, r/m64 */
+#define OP_CMP     0x3B           /* cmp r64, r/m64 */
+#define OP_STORE   0x89           /* mov r/m64, r64 */
+#define OP_LOAD    0x8B           /* mov r64, r/m64 */
+#define OP_LEA     0x8D           /* lea r64, m */
+#define OP_IMUL    0x0FAF         /* imul r64, r/m64 */
+
+/* Group-1 extensions (83 /n ib, 81 /n id) */
+#define EXT_ADD 0
+#define EXT_SUB 5
+#define EXT_CMP 7
+
+static int fits_int8(long long value) {
+    return value >= -128 && value <= 127;
+}
+
+static int fits_int32(long long value) {
+    return value >= -2147483647LL - 1 && value <= 2147483647LL;
+}
+
+/* NAME MAPS */
+
+/* Helper: map index of name, or of the empty position where it belongs */
+static int find_name_index(const ElfNameMap* map, const char* name, unsigned int h) {
+    int mask = map->index_capacity - 1;
+    int i = h & mask;
+    while (map->index[i] >= 0) {
+        const ElfName* entry = &map->entries[map->index[i]];
+        if (entry->name_hash == h && strcmp(entry->name, name) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Helper: entry for name (NULL if it is not in the map) */
+static ElfName* find_name(const ElfNameMap* map, const char* name) {
+    if (map->count == 0) return NULL;
+    int i = find_name_index(map, name, hash(name));
+    return map->index[i] >= 0 ? &map->entries[map->index[i]] : NULL;
+}
+
+/* Helper: add name with value (the caller checks it is not there yet) */
+static void add_name(ElfNameMap* map, const char* name, long value) {
+    if (2 * (map->count + 1) > map->index_capacity) {
+        int capacity = map->index_capacity ? map->index_capacity * 2 : 64;
+        int* index = (int*)safe_malloc(capacity * sizeof(int), "object symbol map");
+        free(map->index);
+        map->index = index;
+        map->index_capacity = capacity;
+        for (int i = 0; i < capacity; i++) index[i] = -1;
+        for (int e = 0; e < map->count; e++) {
+            index[find_name_index(map, map->entries[e].name, map->entries[e].name_hash)] = e;
+        }
+    }
+
+    if (map->count == map->capacity) {
+        map->capacity = map->capacity ? map->capacity * 2 : 32;
+        map->entries = (ElfName*)safe_realloc(map->entries, map->capacity * sizeof(ElfName),
+                                              "object symbol map");
+    }
+
+    unsigned int h = hash(name);
+    ElfName* entry = &map->entries[map->count];
+    entry->name = name;
+    entry->name_hash = h;
+    entry->value = value;
+    map->index[find_name_index(map, name, h)] = map->count++;
+}
+
+static void free_name_map(ElfNameMap* map) {
+    free(map->entries);
+    free(map->index);
+}
+
+/* Helper: remember a rel32 field to patch later */
+static void add_fixup(ElfFixup** list, int* count, int* capacity, size_t field, const char* target) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        *list = (ElfFixup*)safe_realloc(*list, *capacity * sizeof(ElfFixup), "jump list");
+    }
+    (*list)[*count].field = field;
+    (*list)[*count].target = target;
+    (*count)++;
+}
+
+/* Create an object code generator */
+ElfCodeGenerator* create_elf_code_generator(SymbolTable* symtab) {
+    ElfCodeGenerator* gen = (ElfCodeGenerator*)safe_calloc(1, sizeof(ElfCodeGenerator),
+                                                           "object code generator");
+
+    /* The frame layout comes from the assembly generator (it never writes) */
+    gen->frames = create_code_generator(NULL, symtab, 0);
+    gen->symtab = symtab;
+    gen->object = create_elf_object();
+    gen->function_symbol = -1;
+    return gen;
+}
+
+/* Free the object code generator */
+void close_elf_code_generator(ElfCodeGenerator* gen) {
+    if (!gen) return;
+    close_code_generator(gen->frames);
+    free_elf_object(gen->object);
+    free_name_map(&gen->labels);
+    free_name_map(&gen->functions);
+    free_name_map(&gen->globals);
+    free(gen->jumps);
+    free(gen->calls);
+    free(gen);
+}
+
+/* INSTRUCTION ENCODING */
+
+/* Helper: current position in .text */
+static size_t text_offset(ElfCodeGenerator* gen) {
+    return gen->object->sections[ELF_TEXT].size;
+}
+
+static void put_byte(ElfCodeGenerator* gen, int byte) {
+    unsigned char b = (unsigned char)byte;
+    elf_append(gen->object, ELF_TEXT, &b, 1);
+}
+
+/* Helper: a run of fixed bytes */
+static void put_bytes(ElfCodeGenerator* gen, const unsigned char* bytes, size_t length) {
+    elf_append(gen->object, ELF_TEXT, bytes, length);
+}
+
+static void put_int(ElfCodeGenerator* gen, long long value, int size) {
+    unsigned char bytes[8];
+    for (int i = 0; i < size; i++) {
+        bytes[i] = (unsigned char)((unsigned long long)value >> (8 * i));
+    }
+    put_bytes(gen, bytes, size);
+}
+
+/* Helper: symbol of a global variable (or an external symbol for a name
+ * that is not defined here) */
+static int global_symbol(ElfCodeGenerator* gen, const char* name) {
+    ElfName* entry = find_name(&gen->globals, name);
+    if (entry) return (int)entry->value;
+
+    int symbol = elf_add_symbol(gen->object, name, ELF_UNDEFINED, 0, 0, ELF_GLOBAL, ELF_NOTYPE);
+    add_name(&gen->globals, name, symbol);
+    return symbol;
+}
+
+/* Helper: ModRM (and displacement) for a variable: its frame slot, or the
+ * global RIP-relative */
+static void put_operand(ElfCodeGenerator* gen, int reg, const char* name) {
+    FrameSlot* slot = find_frame_slot(gen->frames, name);
+    if (slot) {
+        if (fits_int8(slot->offset)) {
+            put_byte(gen, 0x40 | (reg << 3) | RBP);
+            put_int(gen, slot->offset, 1);
+        } else {
+            put_byte(gen, 0x80 | (reg << 3) | RBP);
+            put_int(gen, slot->offset, 4);
+        }
+        return;
+    }
+
+    /* The displacement is the last field, so the addend is -4 */
+    put_byte(gen, (reg << 3) | RBP);
+    elf_add_relocation(gen->object, text_offset(gen), global_symbol(gen, name), ELF_RELOC_PC32, -4);
+    put_int(gen, 0, 4);
+}
+
+/* Helper: "opcode reg, [variable]" */
+static void insn_reg_mem(ElfCodeGenerator* gen, int opcode, int reg, const char* name) {
+    put_byte(gen, REX_W);
+    if (opcode > 0xFF) put_byte(gen, opcode >> 8);
+    put_byte(gen, opcode & 0xFF);
+    put_operand(gen, reg, name);
+}
+
+/* Helper: "opcode reg, reg2" with the r64, r/m64 form */
+static void insn_reg_reg(ElfCodeGenerator* gen, int opcode, int reg, int rm) {
+    put_byte(gen, REX_W);
+    if (opcode > 0xFF) put_byte(gen, opcode >> 8);
+    put_byte(gen, opcode & 0xFF);
+    put_byte(gen, 0xC0 | (reg << 3) | rm);
+}
+
+/* Helper: mov reg, imm (sign-extended imm32, or imm64) */
+static void mov_imm(ElfCodeGenerator* gen, int reg, long long value) {
+    put_byte(gen, REX_W);
+    if (fits_int32(value)) {
+        put_byte(gen, 0xC7);
+        put_byte(gen, 0xC0 | reg);
+        put_int(gen, value, 4);
+    } else {
+        put_byte(gen, 0xB8 + reg);
+        put_int(gen, value, 8);
+    }
+}
+
+/* Helper: add/sub/cmp reg, imm32 (the short form for small values) */
+static void alu_imm(ElfCodeGenerator* gen, int ext, int reg, long long value) {
+    put_byte(gen, REX_W);
+    put_byte(gen, fits_int8(value) ? 0x83 : 0x81);
+    put_byte(gen, 0xC0 | (ext << 3) | reg);
+    put_int(gen, value, fits_int8(value) ? 1 : 4);
+}
+
+/* Helper: reg = variable or literal */
+static void load(ElfCodeGenerator* gen, int reg, const char* name) {
+    if (is_literal(name)) {
+        mov_imm(gen, reg, strtoll(name, NULL, 10));
+    } else {
+        insn_reg_mem(gen, OP_LOAD, reg, name);
+    }
+}
+
+/* Helper: variable = reg */
+static void store(ElfCodeGenerator* gen, const char* name, int reg) {
+    insn_reg_mem(gen, OP_STORE, reg, name);
+}
+
+/* Helper: rax = rax op operand for add, sub, cmp and imul; literals use
+ * the immediate forms, or go through rdx when they need 64 bits */
+static void alu_rax(ElfCodeGenerator* gen, int opcode, int ext, const char* name) {
+    if (!is_literal(name)) {
+        insn_reg_mem(gen, opcode, RAX, name);
+        return;
+    }
+
+    long long value = strtoll(name, NULL, 10);
+    if (!fits_int32(value)) {
+        mov_imm(gen, RDX, value);
+        insn_reg_reg(gen, opcode, RAX, RDX);
+    } else if (opcode == OP_IMUL) {
+        put_byte(gen, REX_W);
+        put_byte(gen, fits_int8(value) ? 0x6B : 0x69);
+        put_byte(gen, 0xC0 | (RAX << 3) | RAX);
+        put_int(gen, value, fits_int8(value) ? 1 : 4);
+    } else {
+        alu_imm(gen, ext, RAX, value);
+    }
+}
+
+/* Helper: jump or call with a rel32 to be resolved later */
+static void branch(ElfCodeGenerator* gen, const unsigned char* opcode, size_t length,
+                   ElfFixup** list, int* count, int* capacity, const char* target) {
+    put_bytes(gen, opcode, length);
+    add_fixup(list, count, capacity, text_offset(gen), target);
+    put_int(gen, 0, 4);
+}
+
+static void jump(ElfCodeGenerator* gen, const unsigned char* opcode, size_t length, const char* label) {
+    branch(gen, opcode, length, &gen->jumps, &gen->jump_count, &gen->jump_capacity, label);
+}
+
+/* Helper: call an external function through the PLT */
+static void call_external(ElfCodeGenerator* gen, int symbol) {
+    put_byte(gen, 0xE8);
+    elf_add_relocation(gen->object, text_offset(gen), symbol, ELF_RELOC_PLT32, -4);
+    put_int(gen, 0, 4);
+}
+
+/* Helper: lea reg, [rip+symbol] */
+static void lea_symbol(ElfCodeGenerator* gen, int reg, int symbol) {
+    put_byte(gen, REX_W);
+    put_byte(gen, OP_LEA);
+    put_byte(gen, (reg << 3) | RBP);
+    elf_add_relocation(gen->object, text_offset(gen), symbol, ELF_RELOC_PC32, -4);
+    put_int(gen, 0, 4);
+}
+
+/* Helper: jump within code generated here; returns the rel32 field to
+ * patch with patch_jump */
+static size_t local_jump(ElfCodeGenerator* gen, const unsigned char* opcode, size_t length) {
+    put_bytes(gen, opcode, length);
+    size_t field = text_offset(gen);
+    put_int(gen, 0, 4);
+    return field;
+}
+
+static void patch_jump(ElfCodeGenerator* gen, size_t field, size_t target) {
+    elf_patch32(gen->object, ELF_TEXT, field, (long)target - (long)(field + 4));
+}
+
+/* Helper: rcx = address of element index of array */
+static void array_element_address(ElfCodeGenerator* gen, const char* array, const char* index) {
+    static const unsigned char scale[] = { REX_W, 0x6B, 0xC0, 0x08 };   /* imul rax, rax, 8 */
+    static const unsigned char add[] = { REX_W, 0x01, 0xC1 };           /* add rcx, rax */
+    load(gen, RAX, index);
+    put_bytes(gen, scale, sizeof(scale));
+    insn_reg_mem(gen, OP_LEA, RCX, array);
+    put_bytes(gen, add, sizeof(add));
+}
+
+/* Helper: return to the caller with rax as the result */
+static void function_return(ElfCodeGenerator* gen) {
+    static const unsigned char leave[] = { REX_W, 0x89, 0xEC, 0x5D, 0xC3 };  /* mov rsp, rbp; pop rbp; ret */
+    put_bytes(gen, leave, sizeof(leave));
+}
+
+/* Helper: close the symbol of the function being generated */
+static void end_function_symbol(ElfCodeGenerator* gen) {
+    if (gen->function_symbol < 0) return;
+    ElfSymbol* symbol = &gen->object->symbols[gen->function_symbol];
+    symbol->size = text_offset(gen) - symbol->value;
+    gen->function_symbol = -1;
+}
+
+/* PROGRAM LAYOUT */
+
+/* Helper: .data (the printf format) and .bss (global variables) */
+static void layout_data(ElfCodeGenerator* gen) {
+    static const char format[] = { '%', 'd', 10, 0 };
+    elf_append(gen->object, ELF_DATA, format, sizeof(format));
+    gen->format_symbol = elf_add_symbol(gen->object, "fmt_int", ELF_DATA, 0, sizeof(format),
+                                        ELF_LOCAL, ELF_OBJECT);
+
+    if (gen->symtab) {
+        for (Symbol* sym = gen->symtab->symbols; sym; sym = sym->next) {
+            if (sym->kind != SYMBOL_VARIABLE || sym->scope_depth != 0) continue;
+
+            size_t size = 8 * (sym->is_array ? sym->array_size : 1);
+            size_t offset = elf_reserve(gen->object, ELF_BSS, size, 8);
+            add_name(&gen->globals, sym->name,
+                     elf_add_symbol(gen->object, sym->name, ELF_BSS, offset, size, ELF_LOCAL, ELF_OBJECT));
+        }
+    }
+
+    gen->printf_symbol = elf_add_symbol(gen->object, "printf", ELF_UNDEFINED, 0, 0, ELF_GLOBAL, ELF_NOTYPE);
+}
+
+/* Helper: a string in .data with a local symbol */
+static int data_string(ElfCodeGenerator* gen, const char* name, const char* text) {
+    size_t offset = gen->object->sections[ELF_DATA].size;
+    elf_append(gen->object, ELF_DATA, text, strlen(text) + 1);
+    return elf_add_symbol(gen->object, name, ELF_DATA, offset, strlen(text) + 1, ELF_LOCAL, ELF_OBJECT);
+}
+
+/* Helper: profile.dump (see codegen.c) - the counters, their strings and
+ * the exit handler writing them */
+static void gen_profile_dump(ElfCodeGenerator* gen) {
+    static const unsigned char je[] = { 0x0F, 0x84 };
+    static const unsigned char jge[] = { 0x0F, 0x8D };
+    static const unsigned char jmp[] = { 0xE9 };
+    static const unsigned char enter[] = { 0x53, 0x55 };                /* push rbx; push rbp */
+    static const unsigned char leave[] = { 0x5D, 0x5B, 0xC3 };          /* pop rbp; pop rbx; ret */
+    static const unsigned char test_rax[] = { REX_W, 0x85, 0xC0 };      /* test rax, rax */
+    static const unsigned char rbx_from_rax[] = { REX_W, 0x89, 0xC3 };  /* mov rbx, rax */
+    static const unsigned char rsi_from_rbx[] = { REX_W, 0x89, 0xDE };  /* mov rsi, rbx */
+    static const unsigned char rdi_from_rbx[] = { REX_W, 0x89, 0xDF };  /* mov rdi, rbx */
+    static const unsigned char clear_rbp[] = { REX_W, 0x31, 0xED };     /* xor rbp, rbp */
+    static const unsigned char clear_rax[] = { REX_W, 0x31, 0xC0 };     /* xor rax, rax */
+    static const unsigned char load_count[] = { REX_W, 0x8B, 0x14, 0xE8 };  /* mov rdx, [rax+rbp*8] */
+
+    const Profile* profile = gen->profile;
+    int path = data_string(gen, "profile.path", profile->path);
+    int mode = data_string(gen, "profile.mode", "w");
+    int format = data_string(gen, "profile.format", "%lld\n");
+    int header = data_string(gen, "profile.header", profile->header);
+    size_t size = 8 * (size_t)(profile->counter_count > 0 ? profile->counter_count : 1);
+    gen->counts_symbol = elf_add_symbol(gen->object, "profile.counts", ELF_BSS,
+                                        elf_reserve(gen->object, ELF_BSS, size, 8), size,
+                                        ELF_LOCAL, ELF_OBJECT);
+
+    int fopen_symbol = global_symbol(gen, "fopen");
+    int fputs_symbol = global_symbol(gen, "fputs");
+    int fprintf_symbol = global_symbol(gen, "fprintf");
+    int fclose_symbol = global_symbol(gen, "fclose");
+
+    gen->profile_dump = text_offset(gen);
+    put_bytes(gen, enter, sizeof(enter));
+    alu_imm(gen, EXT_SUB, RSP, 8);                      /* Align stack to 16 bytes */
+    lea_symbol(gen, RDI, path);
+    lea_symbol(gen, RSI, mode);
+    call_external(gen, fopen_symbol);
+    put_bytes(gen, test_rax, sizeof(test_rax));
+    size_t failed = local_jump(gen, je, sizeof(je));
+    put_bytes(gen, rbx_from_rax, sizeof(rbx_from_rax));
+    lea_symbol(gen, RDI, header);
+    put_bytes(gen, rsi_from_rbx, sizeof(rsi_from_rbx));
+    call_external(gen, fputs_symbol);
+    put_bytes(gen, clear_rbp, sizeof(clear_rbp));
+
+    size_t next = text_offset(gen);                     /* One count per line */
+    alu_imm(gen, EXT_CMP, RBP, profile->counter_count);
+    size_t done = local_jump(gen, jge, sizeof(jge));
+    put_bytes(gen, rdi_from_rbx, sizeof(rdi_from_rbx));
+    lea_symbol(gen, RSI, format);
+    lea_symbol(gen, RAX, gen->counts_symbol);
+    put_bytes(gen, load_count, sizeof(load_count));
+    put_bytes(gen, clear_rax, sizeof(clear_rax));
+    call_external(gen, fprintf_symbol);
+    alu_imm(gen, EXT_ADD, RBP, 1);
+    patch_jump(gen, local_jump(gen, jmp, sizeof(jmp)), next);
+
+    patch_jump(gen, done, text_offset(gen));
+    put_bytes(gen, rdi_from_rbx, sizeof(rdi_from_rbx));
+    call_external(gen, fclose_symbol);
+
+    patch_jump(gen, failed, text_offset(gen));
+    alu_imm(gen, EXT_ADD, RSP, 8);
+    put_bytes(gen, leave, sizeof(leave));
+
+    elf_add_symbol(gen->object, "profile.dump", ELF_TEXT, gen->profile_dump,
+                   text_offset(gen) - gen->profile_dump, ELF_LOCAL, ELF_FUNCTION);
+}
+
+/* Helper: bounds.fail (see codegen.c) - report a failed bounds check and
+ * exit with status 1. The undefined symbols are added directly, so a
+ * global variable called exit cannot stand in for the function. */
+static void gen_bounds_fail(ElfCodeGenerator* gen) {
+    static const unsigned char align[] = { REX_W, 0x83, 0xE4, 0xF0 };   /* and rsp, -16 */
+    static const unsigned char clear_rax[] = { REX_W, 0x31, 0xC0 };     /* xor rax, rax */
+
+    int message = data_string(gen, "bounds.message", "Runtime error: array index out of range\n");
+    int dprintf_symbol = elf_add_symbol(gen->object, "dprintf", ELF_UNDEFINED, 0, 0, ELF_GLOBAL, ELF_NOTYPE);
+    int exit_symbol = elf_add_symbol(gen->object, "exit", ELF_UNDEFINED, 0, 0, ELF_GLOBAL, ELF_NOTYPE);
+
+    gen->bounds_fail = text_offset(gen);
+    put_bytes(gen, align, sizeof(align));
+    mov_imm(gen, RDI, 2);                               /* stderr */
+    lea_symbol(gen, RSI, message);
+    put_bytes(gen, clear_rax, sizeof(clear_rax));
+    call_external(gen, dprintf_symbol);
+    mov_imm(gen, RDI, 1);                               /* Exit status */
+    call_external(gen, exit_symbol);
+
+    elf_add_symbol(gen->object, "bounds.fail", ELF_TEXT, gen->bounds_fail,
+                   text_offset(gen) - gen->bounds_fail, ELF_LOCAL, ELF_FUNCTION);
+}
+
+/* Helper: resolve jumps and calls now that every label is placed */
+static void resolve_branches(ElfCodeGenerator* gen) {
+    for (int i = 0; i < gen->jump_count; i++) {
+        ElfFixup* jump = &gen->jumps[i];
+        ElfName* label = find_name(&gen->labels, jump->target);
+        if (!label) {
+            fprintf(stderr, "Warning: Jump to undefined label '%s' in generated code\n", jump->target);
+            continue;
+        }
+        elf_patch32(gen->object, ELF_TEXT, jump->field, label->value - (long)(jump->field + 4));
+    }
+
+    for (int i = 0; i < gen->call_count; i++) {
+        ElfFixup* call = &gen->calls[i];
+        ElfName* function = find_name(&gen->functions, call->target);
+        if (function) {
+            elf_patch32(gen->object, ELF_TEXT, call->field, function->value - (long)(call->field + 4));
+        } else {
+            /* Not defined in this program - leave it to the linker */
+            elf_add_relocation(gen->object, call->field, global_symbol(gen, call->target),
+                               ELF_RELOC_PLT32, -4);
+        }
+    }
+}
+
+/* Helper: division or modulo whose operands are never negative and fit
+ * in 32 bits (TAC_FLAG_NONNEG) - shr/and for a power-of-two divisor,
+ * otherwise the 32-bit unsigned div (its results zero-extend) */
+static void gen_unsigned_division(ElfCodeGenerator* gen, TACInstruction* inst) {
+    static const unsigned char shr_rax[] = { REX_W, 0xC1, 0xE8 };   /* shr rax, imm8 */
+    static const unsigned char and_rax[] = { REX_W, 0x25 };         /* and rax, imm32 */
+    static const unsigned char xor_edx[] = { 0x31, 0xD2 };          /* xor edx, edx */
+    static const unsigned char div_ecx[] = { 0xF7, 0xF1 };          /* div ecx */
+    int shift = divisor_shift(inst);
+
+    load(gen, RAX, inst->op1);
+    if (shift >= 0 && inst->opcode == TAC_DIV) {
+        put_bytes(gen, shr_rax, sizeof(shr_rax));
+        put_byte(gen, shift);
+    } else if (shift >= 0) {
+        put_bytes(gen, and_rax, sizeof(and_rax));
+        put_int(gen, (1LL << shift) - 1, 4);
+    } else {
+        load(gen, RCX, inst->op2);
+        put_bytes(gen, xor_edx, sizeof(xor_edx));
+        put_bytes(gen, div_ecx, sizeof(div_ecx));
+        store(gen, inst->result, inst->opcode == TAC_DIV ? RAX : RDX);
+        return;
+    }
+    store(gen, inst->result, RAX);
+}
+
+/* Helper: encode a single TAC instruction */
+static void gen_elf_instruction(ElfCodeGenerator* gen, TACInstruction* inst) {
+    static const unsigned char jmp[] = { 0xE9 };
+    static const unsigned char je[] = { 0x0F, 0x84 };
+    static const unsigned char jne[] = { 0x0F, 0x85 };
+    static const unsigned char call[] = { 0xE8 };
+
+    switch (inst->opcode) {
+        case TAC_LOAD_CONST:
+            mov_imm(gen, RAX, strtoll(inst->op1, NULL, 10));
+            store(gen, inst->result, RAX);
+            break;
+
+        case TAC_ASSIGN:
+            load(gen, RAX, inst->op1);
+            store(gen, inst->result, RAX);
+            break;
+
+        case TAC_ADD:
+            load(gen, RAX, inst->op1);
+            alu_rax(gen, OP_ADD, EXT_ADD, inst->op2);
+            store(gen, inst->result, RAX);
+            break;
+
+        case TAC_SUB:
+            load(gen, RAX, inst->op1);
+            alu_rax(gen, OP_SUB, EXT_SUB, inst->op2);
+            store(gen, inst->result, RAX);
+            break;
+
+        case TAC_MUL:
+            load(gen, RAX, inst->op1);
+            alu_rax(gen, OP_IMUL, 0, inst->op2);
+            store(gen, inst->result, RAX);
+            break;
+
+        case TAC_DIV:
+        case TAC_MOD: {
+            static const unsigned char cqo[] = { REX_W, 0x99 };
+            if (inst->flags & TAC_FLAG_NONNEG) {
+                gen_unsigned_division(gen, inst);
+                break;
+            }
+            static const unsigned char idiv[] = { REX_W, 0xF7, 0xF9 };   /* idiv rcx */
+            load(gen, RAX, inst->op1);
+            put_bytes(gen, cqo, sizeof(cqo));
+            load(gen, RCX, inst->op2);
+            put_bytes(gen, idiv, sizeof(idiv));
+            store(gen, inst->result, inst->opcode == TAC_DIV ? RAX : RDX);
+            break;
+        }
+
+        case TAC_PRINT: {
+            /* printf needs a 16-byte aligned stack */
+            static const unsigned char align[] = {
+                REX_W, 0x89, 0x65, 0xF8,      /* mov [rbp-8], rsp */
+                REX_W, 0x83, 0xE4, 0xF0,      /* and rsp, -16 */
+                REX_W, 0x31, 0xC0             /* xor rax, rax */
+            };
+            static const unsigned char restore[] = { REX_W, 0x8B, 0x65, 0xF8 };  /* mov rsp, [rbp-8] */
+            static const unsigned char lea_format[] = { REX_W, 0x8D, 0x3D };     /* lea rdi, [rip+...] */
+
+            put_bytes(gen, lea_format, sizeof(lea_format));
+            elf_add_relocation(gen->object, text_offset(gen), gen->format_symbol, ELF_RELOC_PC32, -4);
+            put_int(gen, 0, 4);
+            load(gen, RSI, inst->op1);
+            put_bytes(gen, align, sizeof(align));
+            call_external(gen, gen->printf_symbol);
+            put_bytes(gen, restore, sizeof(restore));
+            break;
+        }
+
+        case TAC_LABEL:
+            if (!find_name(&gen->labels, inst->label)) {
+                add_name(&gen->labels, inst->label, (long)text_offset(gen));
+            }
+            break;
+
+        case TAC_GOTO:
+            jump(gen, jmp, sizeof(jmp), inst->label);
+            break;
+
+        case TAC_RELOP: {
+            static const unsigned char movzx[] = { REX_W, 0x0F, 0xB6, 0xC0 };   /* movzx rax, al */
+            int condition = 0;
+            if (strcmp(inst->label, "<") == 0) condition = 0x9C;
+            else if (strcmp(inst->label, ">") == 0) condition = 0x9F;
+            else if (strcmp(inst->label, "<=") == 0) condition = 0x9E;
+            else if (strcmp(inst->label, ">=") == 0) condition = 0x9D;
+            else if (strcmp(inst->label, "==") == 0) condition = 0x94;
+            else if (strcmp(inst->label, "!=") == 0) condition = 0x95;
+
+            load(gen, RAX, inst->op1);
+            alu_rax(gen, OP_CMP, EXT_CMP, inst->op2);
+            if (condition) {
+                put_byte(gen, 0x0F);          /* setcc al */
+                put_byte(gen, condition);
+                put_byte(gen, 0xC0);
+            }
+            put_bytes(gen, movzx, sizeof(movzx));
+            store(gen, inst->result, RAX);
+            break;
+        }
+
+        case TAC_IF_FALSE:
+            load(gen, RAX, inst->op1);
+            alu_imm(gen, EXT_CMP, RAX, 0);
+            jump(gen, je, sizeof(je), inst->label);
+            break;
+
+        case TAC_IF_TRUE:
+            load(gen, RAX, inst->op1);
+            alu_imm(gen, EXT_CMP, RAX, 0);
+            jump(gen, jne, sizeof(jne), inst->label);
+            break;
+
+        case TAC_ARRAY_LOAD: {
+            static const unsigned char load_element[] = { REX_W, 0x8B, 0x01 };   /* mov rax, [rcx] */
+            array_element_address(gen, inst->op1, inst->op2);
+            put_bytes(gen, load_element, sizeof(load_element));
+            store(gen, inst->result, RAX);
+            break;
+        }
+
+        case TAC_ARRAY_STORE: {
+            static const unsigned char store_element[] = { REX_W, 0x89, 0x01 };  /* mov [rcx], rax */
+            array_element_address(gen, inst->result, inst->op1);
+            load(gen, RAX, inst->op2);
+            put_bytes(gen, store_element, sizeof(store_element));
+            break;
+        }
+
+        case TAC_FUNCTION_LABEL: {
+            static const unsigned char enter[] = { 0x55, REX_W, 0x89, 0xE5 };   /* push rbp; mov rbp, rsp */
+            build_function_frame(gen->frames, inst);
+
+            end_function_symbol(gen);
+            size_t start = text_offset(gen);
+            int is_main = strcmp(inst->label, "main") == 0;
+            gen->function_symbol = elf_add_symbol(gen->object, inst->label, ELF_TEXT, start, 0,
+                                                  is_main ? ELF_GLOBAL : ELF_LOCAL, ELF_FUNCTION);
+            if (!find_name(&gen->functions, inst->label)) {
+                add_name(&gen->functions, inst->label, (long)start);
+            }
+
+            put_bytes(gen, enter, sizeof(enter));
+            alu_imm(gen, EXT_SUB, RSP, gen->frames->stack_offset);
+
+            if (gen->profile && is_main) {
+                /* atexit(profile.dump) with the stack aligned */
+                static const unsigned char align[] = {
+                    REX_W, 0x89, 0x65, 0xF8,      /* mov [rbp-8], rsp */
+                    REX_W, 0x83, 0xE4, 0xF0,      /* and rsp, -16 */
+                    REX_W, 0x8D, 0x3D             /* lea rdi, [rip+...] */
+                };
+                static const unsigned char restore[] = { REX_W, 0x8B, 0x65, 0xF8 };  /* mov rsp, [rbp-8] */
+                put_bytes(gen, align, sizeof(align));
+                size_t field = text_offset(gen);
+                put_int(gen, (long)gen->profile_dump - (long)(field + 4), 4);
+                call_external(gen, global_symbol(gen, "atexit"));
+                put_bytes(gen, restore, sizeof(restore));
+            }
+            break;
+        }
+
+        case TAC_PARAM:
+            load(gen, RAX, inst->op1);
+            put_byte(gen, 0x50);              /* push rax */
+            break;
+
+        case TAC_CALL: {
+            branch(gen, call, sizeof(call), &gen->calls, &gen->call_count, &gen->call_capacity, inst->label);
+
+            int arg_count = atoi(inst->op1);
+            if (arg_count > 0) {
+                alu_imm(gen, EXT_ADD, RSP, arg_count * 8);
+            }
+            if (inst->result) {
+                store(gen, inst->result, RAX);
+            }
+            break;
+        }
+
+        case TAC_RETURN:
+            load(gen, RAX, inst->op1);
+            function_return(gen);
+            break;
+
+        case TAC_RETURN_VOID:
+            function_return(gen);
+            break;
+
+        case TAC_PROFILE: {
+            /* inc qword [rip+profile.counts+8*n] */
+            static const unsigned char increment[] = { REX_W, 0xFF, 0x05 };
+            put_bytes(gen, increment, sizeof(increment));
+            elf_add_relocation(gen->object, text_offset(gen), gen->counts_symbol, ELF_RELOC_PC32,
+                               8 * atol(inst->op1) - 4);
+            put_int(gen, 0, 4);
+            break;
+        }
+
+        case TAC_BOUNDS_CHECK: {
+            /* cmp index, size; jae bounds.fail (negative indexes are above too) */
+            static const unsigned char jae[] = { 0x0F, 0x83 };
+            load(gen, RAX, inst->op1);
+            alu_imm(gen, EXT_CMP, RAX, strtoll(inst->op2, NULL, 10));
+            patch_jump(gen, local_jump(gen, jae, sizeof(jae)), gen->bounds_fail);
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    /* Falling off the end of a function returns 0 */
+    if (inst == gen->frames->function_end && inst->opcode != TAC_RETURN &&
+        inst->opcode != TAC_RETURN_VOID && inst->opcode != TAC_GOTO) {
+        mov_imm(gen, RAX, 0);
+        function_return(gen);
+    }
+}
+
+/* Translate the TAC into gen->object */
+void generate_elf_code(ElfCodeGenerator* gen, TACCode* tac) {
+    log_message(LOG_NORMAL, "\n=============== CODE GENERATION STARTED ===================\n\n");
+
+    layout_data(gen);
+    if (gen->profile) {
+        gen_profile_dump(gen);
+    }
+    if (gen->bounds_checks) {
+        gen_bounds_fail(gen);
+    }
+
+    for (TACInstruction* inst = tac->head; inst; inst = inst->next) {
+        gen_elf_instruction(gen, inst);
+    }
+    end_function_symbol(gen);
+
+    /* A program without a main function still links and exits with 0 */
+    Symbol* main_symbol = gen->symtab ? lookup_symbol(gen->symtab, "main") : NULL;
+    if (!main_symbol || main_symbol->kind != SYMBOL_FUNCTION) {
+        size_t start = text_offset(gen);
+        mov_imm(gen, RAX, 0);
+        put_byte(gen, 0xC3);                  /* ret */
+        elf_add_symbol(gen->object, "main", ELF_TEXT, start, text_offset(gen) - start,
+                       ELF_GLOBAL, ELF_FUNCTION);
+    }
+
+    resolve_branches(gen);
+
+    log_message(LOG_NORMAL, "Object code generated: %lu bytes of machine code, %d relocations\n",
+                (unsigned long)text_offset(gen), gen->object->relocation_count);
+
+    log_message(LOG_NORMAL, "\n=============== CODE GENERATION COMPLETE ==================\n\n");
+}
+
+/* Translate the TAC and write the object file */
+void generate_elf_object(ElfCodeGenerator* gen, TACCode* tac, OutputSink* out) {
+    generate_elf_code(gen, tac);
+    write_elf_object(gen->object, out);
+}
@@ -0,0 +1,85 @@
+/*
+ * CODEGEN_ELF.H - Object Code Generator Header
+ * CST-405 Compiler Project
+ *
+ * This file defines the binary back end: it translates TAC straight into
+ * x86-64 machine code and writes a relocatable ELF64 object, so no
+ * assembler is needed ("gcc output.o -o program" links it).
+ *
+ * The code is the same instruction sequence generate_assembly() writes as
+ * text, with the same stack frames (see codegen.h), except that globals,
+ * the format string and external calls are addressed RIP-relative. The
+ * object therefore also links as a position-independent executable.
+ * An instrumented program (profile set) gets the counters and the
+ * profile.dump exit handler codegen.h describes; profile.dump comes first
+ * in .text so main can refer to it directly. bounds.fail, the target of
+ * failed --bounds-check checks, follows it for the same reason.
+ */
+
+#ifndef CODEGEN_ELF_H
+#define CODEGEN_ELF_H
+
+#include "codegen.h"
+#include "elfobj.h"
+
+/* A label or function: name -> offset in .text */
+typedef struct {
+    const char* name;           /* Name (borrowed from the TAC) */
+    unsigned int name_hash;     /* Hash of the name */
+    long value;                 /* Offset in .text, or ELF symbol index */
+} ElfName;
+
+/* Map of names (open addressing, kept at most half full) */
+typedef struct {
+    ElfName* entries;           /* Entries in insertion order */
+    int count;                  /* Entries in use */
+    int capacity;               /* Entries allocated */
+    int* index;                 /* Map name -> entry number (-1 = empty) */
+    int index_capacity;         /* Map size (power of two) */
+} ElfNameMap;
+
+/* A rel32 field waiting for the offset of a label or function */
+typedef struct {
+    size_t field;               /* Position of the field in .text */
+    const char* target;         /* Label or function name */
+} ElfFixup;
+
+/* Object code generator */
+typedef struct {
+    CodeGenerator* frames;      /* Stack frame layout (shared with codegen.c) */
+    SymbolTable* symtab;        /* Symbol table */
+    ElfObject* object;          /* Object under construction */
+    ElfNameMap labels;          /* Jump targets defined so far */
+    ElfNameMap functions;       /* Functions defined so far */
+    ElfNameMap globals;         /* Global variables -> ELF symbol */
+    ElfFixup* jumps;            /* Jumps to patch with label offsets */
+    int jump_count;
+    int jump_capacity;
+    ElfFixup* calls;            /* Calls to user functions */
+    int call_count;
+    int call_capacity;
+    int printf_symbol;          /* Undefined symbol for printf */
+    int format_symbol;          /* "%d\n" in .data */
+    int function_symbol;        /* Symbol of the current function (-1 = none) */
+    const Profile* profile;     /* Counters of an instrumented program (NULL = none) */
+    int counts_symbol;          /* profile.counts in .bss */
+    size_t profile_dump;        /* Offset of profile.dump in .text */
+    int bounds_checks;          /* Emit bounds.fail for TAC_BOUNDS_CHECK (--bounds-check) */
+    size_t bounds_fail;         /* Offset of bounds.fail in .text */
+} ElfCodeGenerator;
+
+/* OBJECT CODE GENERATION FUNCTIONS */
+
+/* Create an object code generator */
+ElfCodeGenerator* create_elf_code_generator(SymbolTable* symtab);
+
+/* Translate the TAC into gen->object (kept in memory, e.g. for the JIT) */
+void generate_elf_code(ElfCodeGenerator* gen, TACCode* tac);
+
+/* Translate the TAC and write the object file to out */
+void generate_elf_object(ElfCodeGenerator* gen, TACCode* tac, OutputSink* out);
+
+/* Free the object code generator */
+void close_elf_code_generator(ElfCodeGenerator* gen);
+
+#endif /* CODEGEN_ELF_H */
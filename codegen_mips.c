@@ -7,6 +7,7 @@
  */
 
 #include "codegen_mips.h"
+#include "diagnostics.h"
 
 /* Register mapping for temporaries */
 static const char* temp_registers[] = {
@@ -14,284 +15,381 @@ static const char* temp_registers[] = {
     "$t8", "$t9"
 };
 
-/* Create a new MIPS code generator instance */
-MIPSCodeGenerator* create_mips_code_generator(const char* output_filename, SymbolTable* symtab) {
-    MIPSCodeGenerator* gen = (MIPSCodeGenerator*)malloc(sizeof(MIPSCodeGenerator));
-    if (!gen) {
-        fprintf(stderr, "Fatal Error: Failed to allocate MIPS code generator\n");
-        exit(1);
-    }
+/* Declarations for the temporaries t0-t99, written with a single append */
+#define TEMP_DECL(n) "    t" #n ": .word 0\n"
+#define TEMP_DECLS(d) TEMP_DECL(d##0) TEMP_DECL(d##1) TEMP_DECL(d##2) TEMP_DECL(d##3) \
+    TEMP_DECL(d##4) TEMP_DECL(d##5) TEMP_DECL(d##6) TEMP_DECL(d##7) TEMP_DECL(d##8) TEMP_DECL(d##9)
+static const char temp_declarations[] =
+    TEMP_DECLS() TEMP_DECLS(1) TEMP_DECLS(2) TEMP_DECLS(3) TEMP_DECLS(4)
+    TEMP_DECLS(5) TEMP_DECLS(6) TEMP_DECLS(7) TEMP_DECLS(8) TEMP_DECLS(9);
 
-    gen->output_file = fopen(output_filename, "w");
-    if (!gen->output_file) {
-        fprintf(stderr, "Fatal Error: Cannot open output file '%s'\n", output_filename);
-        free(gen);
-        exit(1);
-    }
+/* Create a new MIPS code generator instance */
+MIPSCodeGenerator* create_mips_code_generator(OutputSink* out, SymbolTable* symtab, int comments) {
+    MIPSCodeGenerator* gen = (MIPSCodeGenerator*)safe_malloc(sizeof(MIPSCodeGenerator),
+                                                             "MIPS code generator");
 
+    init_emitter(&gen->emit, out, '#', comments);
     gen->stack_offset = 0;
     gen->symtab = symtab;
     gen->next_register = 0;
+    gen->bounds_checks = 0;
 
     return gen;
 }
 
+/* Helper: "    mnemonic reg, operand" (variable, label or immediate text) */
+static void insn_reg_sym(AsmEmitter* e, const char* mnemonic, const char* reg,
+                         const char* operand, const char* comment) {
+    emit_insn(e, mnemonic);
+    emit_reg(e, reg);
+    emit_sym(e, operand);
+    emit_end(e, comment);
+}
+
 /* Generate the MIPS prologue (program initialization) */
 void gen_mips_prologue(MIPSCodeGenerator* gen) {
-    fprintf(gen->output_file, "# CST-405 Compiler - Generated MIPS Assembly Code\n");
-    fprintf(gen->output_file, "# Target: MIPS (QtSpim/MARS)\n");
-    fprintf(gen->output_file, "# Date: %s\n\n", __DATE__);
+    AsmEmitter* e = &gen->emit;
 
-    fprintf(gen->output_file, ".data\n");
-    fprintf(gen->output_file, "    # Data section for variables\n");
-    fprintf(gen->output_file, "    newline: .asciiz \"\\n\"\n");
+    emit_text(e, "# CST-405 Compiler - Generated MIPS Assembly Code\n");
+    emit_text(e, "# Target: MIPS (QtSpim/MARS)\n");
+    emit_text(e, "# Date: " __DATE__ "\n\n");
 
-    /* Allocate space for all variables in the symbol table */
+    emit_text(e, ".data\n");
+    emit_note(e, "Data section for variables", NULL);
+    emit_text(e, "    newline: .asciiz \"\\n\"\n");
+    if (gen->bounds_checks) {
+        emit_text(e, "    bounds.message: .asciiz \"Runtime error: array index out of range\\n\"\n");
+    }
+
+    /* Allocate space for all variables in the symbol table.
+     * Variables with the same storage name share the owner's storage. */
     if (gen->symtab) {
-        for (int i = 0; i < gen->symtab->size; i++) {
-            Symbol* sym = gen->symtab->table[i];
-            while (sym) {
-                /* Only allocate space for global variables, not functions */
-                if (sym->kind == SYMBOL_VARIABLE && strcmp(sym->scope, "global") == 0) {
-                    if (sym->is_array) {
-                        /* Arrays need space for multiple words */
-                        fprintf(gen->output_file, "    %s: .space %d    # Array: %s[%d]\n",
-                                sym->name, sym->array_size * 4, sym->name, sym->array_size);
-                    } else {
-                        /* Regular variables need 1 word (4 bytes) */
-                        fprintf(gen->output_file, "    %s: .word 0    # Variable: %s\n",
-                                sym->name, sym->name);
+        for (Symbol* sym = gen->symtab->symbols; sym; sym = sym->next) {
+            /* Only allocate space for variables, not functions */
+            if (sym->kind == SYMBOL_VARIABLE && sym->owns_storage) {
+                emit_text(e, "    ");
+                emit_text(e, sym->storage_name);
+                if (sym->is_array || sym->storage_size > 1) {
+                    /* Arrays need space for multiple words */
+                    emit_text(e, ": .space ");
+                    emit_int(e, sym->storage_size * 4);
+                    if (e->comments) {
+                        emit_text(e, "    # Array: ");
+                        emit_text(e, sym->storage_name);
+                        emit_text(e, "[");
+                        emit_int(e, sym->storage_size);
+                        emit_text(e, "]");
+                    }
+                } else {
+                    /* Regular variables need 1 word (4 bytes) */
+                    emit_text(e, ": .word 0");
+                    if (e->comments) {
+                        emit_text(e, "    # Variable: ");
+                        emit_text(e, sym->storage_name);
                     }
                 }
-                sym = sym->next;
+                emit_text(e, "\n");
             }
         }
     }
 
     /* Allocate space for temporaries */
-    fprintf(gen->output_file, "\n    # Temporary variables\n");
-    for (int i = 0; i < 100; i++) {
-        fprintf(gen->output_file, "    t%d: .word 0\n", i);
-    }
+    emit_text(e, "\n");
+    emit_note(e, "Temporary variables", NULL);
+    emit_text(e, temp_declarations);
 
-    fprintf(gen->output_file, "\n.text\n");
-    fprintf(gen->output_file, ".globl main\n\n");
+    emit_text(e, "\n.text\n");
+    emit_text(e, ".globl main\n\n");
 
-    fprintf(gen->output_file, "main:\n");
-    fprintf(gen->output_file, "    # Function prologue\n");
-    fprintf(gen->output_file, "    # (MIPS doesn't require explicit frame setup for main)\n\n");
+    emit_text(e, "main:\n");
+    emit_note(e, "Function prologue", NULL);
+    emit_note(e, "(MIPS doesn't require explicit frame setup for main)", NULL);
+    emit_text(e, "\n");
 }
 
 /* Generate the MIPS epilogue (program termination) */
 void gen_mips_epilogue(MIPSCodeGenerator* gen) {
-    fprintf(gen->output_file, "\n    # Program exit\n");
-    fprintf(gen->output_file, "    li $v0, 10        # syscall: exit\n");
-    fprintf(gen->output_file, "    syscall\n");
+    AsmEmitter* e = &gen->emit;
+
+    emit_text(e, "\n");
+    emit_note(e, "Program exit", NULL);
+    emit_line(e, "    li $v0, 10", "        # syscall: exit");
+    emit_text(e, "    syscall\n");
+
+    if (gen->bounds_checks) {
+        emit_text(e, "\n");
+        emit_note(e, "Bounds check failure: report it and exit with status 1", NULL);
+        emit_label(e, "bounds.fail");
+        emit_text(e, "    la $a0, bounds.message\n");
+        emit_line(e, "    li $v0, 4", "         # syscall: print_string");
+        emit_text(e, "    syscall\n");
+        emit_text(e, "    li $a0, 1\n");
+        emit_line(e, "    li $v0, 17", "        # syscall: exit2");
+        emit_text(e, "    syscall\n");
+    }
 }
 
 /* Get register for a temporary or variable */
 const char* get_mips_register(MIPSCodeGenerator* gen, const char* name) {
     /* For simplicity, use $t0-$t9 in rotation */
-    static char reg[8];
-
     /* Check if it's a temporary variable (t0, t1, etc.) */
     if (name && name[0] == 't' && isdigit(name[1])) {
         int temp_num = atoi(&name[1]);
-        snprintf(reg, sizeof(reg), "$t%d", temp_num % 10);
-        return reg;
+        return temp_registers[temp_num % 10];
     }
 
     /* For other variables, use $t0 as working register */
     return "$t0";
 }
 
+/* Helper: division or modulo whose operands are never negative
+ * (TAC_FLAG_NONNEG) - srl/andi for a power-of-two divisor, otherwise
+ * divu, which skips the sign handling of div */
+static void gen_mips_unsigned_division(MIPSCodeGenerator* gen, TACInstruction* inst) {
+    AsmEmitter* e = &gen->emit;
+    int shift = divisor_shift(inst);
+
+    insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+    if (shift >= 0 && inst->opcode == TAC_DIV) {
+        emit_text(e, "    srl $t0, $t0, ");
+        emit_int(e, shift);
+        emit_text(e, "\n");
+    } else if (shift >= 0 && shift <= 16) {
+        emit_text(e, "    andi $t0, $t0, ");
+        emit_int(e, (1L << shift) - 1);
+        emit_text(e, "\n");
+    } else if (shift >= 0) {
+        emit_text(e, "    li $t1, ");
+        emit_int(e, (1L << shift) - 1);
+        emit_text(e, "\n");
+        emit_text(e, "    and $t0, $t0, $t1\n");
+    } else {
+        insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
+        emit_text(e, "    divu $t0, $t1\n");
+        emit_text(e, inst->opcode == TAC_DIV ? "    mflo $t0\n" : "    mfhi $t0\n");
+    }
+    insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
+}
+
 /* Generate code for a single MIPS TAC instruction */
 void gen_mips_instruction(MIPSCodeGenerator* gen, TACInstruction* inst) {
+    AsmEmitter* e = &gen->emit;
+
     switch (inst->opcode) {
         case TAC_LOAD_CONST:
             /* Load constant into variable: result = constant */
-            fprintf(gen->output_file, "    # %s = %s\n", inst->result, inst->op1);
-            fprintf(gen->output_file, "    li $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, NULL);
+            insn_reg_sym(e, "li", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_ASSIGN:
             /* Assignment: result = op1 */
-            fprintf(gen->output_file, "    # %s = %s\n", inst->result, inst->op1);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_ADD:
             /* Addition: result = op1 + op2 */
-            fprintf(gen->output_file, "    # %s = %s + %s\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t1, %s\n", inst->op2);
-            fprintf(gen->output_file, "    add $t0, $t0, $t1\n");
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " + ", inst->op2, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
+            emit_text(e, "    add $t0, $t0, $t1\n");
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_SUB:
             /* Subtraction: result = op1 - op2 */
-            fprintf(gen->output_file, "    # %s = %s - %s\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t1, %s\n", inst->op2);
-            fprintf(gen->output_file, "    sub $t0, $t0, $t1\n");
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " - ", inst->op2, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
+            emit_text(e, "    sub $t0, $t0, $t1\n");
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_MUL:
             /* Multiplication: result = op1 * op2 */
-            fprintf(gen->output_file, "    # %s = %s * %s\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t1, %s\n", inst->op2);
-            fprintf(gen->output_file, "    mul $t0, $t0, $t1\n");
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " * ", inst->op2, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
+            emit_text(e, "    mul $t0, $t0, $t1\n");
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_DIV:
             /* Division: result = op1 / op2 */
-            fprintf(gen->output_file, "    # %s = %s / %s\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t1, %s\n", inst->op2);
-            fprintf(gen->output_file, "    div $t0, $t1\n");
-            fprintf(gen->output_file, "    mflo $t0\n");
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " / ", inst->op2, NULL);
+            if (inst->flags & TAC_FLAG_NONNEG) {
+                gen_mips_unsigned_division(gen, inst);
+                break;
+            }
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
+            emit_text(e, "    div $t0, $t1\n");
+            emit_text(e, "    mflo $t0\n");
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_MOD:
             /* Modulo: result = op1 % op2 */
-            fprintf(gen->output_file, "    # %s = %s %% %s\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t1, %s\n", inst->op2);
-            fprintf(gen->output_file, "    div $t0, $t1\n");
-            fprintf(gen->output_file, "    mfhi $t0\n");
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, " % ", inst->op2, NULL);
+            if (inst->flags & TAC_FLAG_NONNEG) {
+                gen_mips_unsigned_division(gen, inst);
+                break;
+            }
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
+            emit_text(e, "    div $t0, $t1\n");
+            emit_text(e, "    mfhi $t0\n");
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_PRINT:
             /* Print statement: print(op1) */
-            fprintf(gen->output_file, "    # print(%s)\n", inst->op1);
-            fprintf(gen->output_file, "    lw $a0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    li $v0, 1        # syscall: print_int\n");
-            fprintf(gen->output_file, "    syscall\n");
-            fprintf(gen->output_file, "    la $a0, newline\n");
-            fprintf(gen->output_file, "    li $v0, 4        # syscall: print_string\n");
-            fprintf(gen->output_file, "    syscall\n");
+            emit_note(e, "print(", inst->op1, ")", NULL);
+            insn_reg_sym(e, "lw", "$a0", inst->op1, NULL);
+            emit_line(e, "    li $v0, 1", "        # syscall: print_int");
+            emit_text(e, "    syscall\n");
+            emit_text(e, "    la $a0, newline\n");
+            emit_line(e, "    li $v0, 4", "        # syscall: print_string");
+            emit_text(e, "    syscall\n");
             break;
 
         case TAC_LABEL:
             /* Label definition */
-            fprintf(gen->output_file, "%s:\n", inst->label);
+            emit_label(e, inst->label);
             break;
 
         case TAC_GOTO:
             /* Unconditional jump */
-            fprintf(gen->output_file, "    j %s\n", inst->label);
+            emit_insn(e, "j");
+            emit_sym(e, inst->label);
+            emit_end(e, NULL);
             break;
 
         case TAC_IF_FALSE:
             /* Conditional jump: if op1 == 0 goto label */
-            fprintf(gen->output_file, "    # if_false %s goto %s\n", inst->op1, inst->label);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    beqz $t0, %s\n", inst->label);
+            emit_note(e, "if_false ", inst->op1, " goto ", inst->label, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "beqz", "$t0", inst->label, NULL);
+            break;
+
+        case TAC_IF_TRUE:
+            /* Conditional jump: if op1 != 0 goto label */
+            emit_note(e, "if_true ", inst->op1, " goto ", inst->label, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "bnez", "$t0", inst->label, NULL);
             break;
 
         case TAC_RELOP:
             /* Relational operation: result = op1 relop op2 */
-            fprintf(gen->output_file, "    # %s = %s %s %s\n",
-                    inst->result, inst->op1, inst->label, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t1, %s\n", inst->op2);
+            emit_note(e, inst->result, " = ", inst->op1, " ", inst->label, " ", inst->op2, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t1", inst->op2, NULL);
 
             /* Determine which relational operator */
             if (strcmp(inst->label, "<") == 0) {
-                fprintf(gen->output_file, "    slt $t0, $t0, $t1\n");
+                emit_text(e, "    slt $t0, $t0, $t1\n");
             } else if (strcmp(inst->label, ">") == 0) {
-                fprintf(gen->output_file, "    sgt $t0, $t0, $t1\n");
+                emit_text(e, "    sgt $t0, $t0, $t1\n");
             } else if (strcmp(inst->label, "<=") == 0) {
-                fprintf(gen->output_file, "    sle $t0, $t0, $t1\n");
+                emit_text(e, "    sle $t0, $t0, $t1\n");
             } else if (strcmp(inst->label, ">=") == 0) {
-                fprintf(gen->output_file, "    sge $t0, $t0, $t1\n");
+                emit_text(e, "    sge $t0, $t0, $t1\n");
             } else if (strcmp(inst->label, "==") == 0) {
-                fprintf(gen->output_file, "    seq $t0, $t0, $t1\n");
+                emit_text(e, "    seq $t0, $t0, $t1\n");
             } else if (strcmp(inst->label, "!=") == 0) {
-                fprintf(gen->output_file, "    sne $t0, $t0, $t1\n");
+                emit_text(e, "    sne $t0, $t0, $t1\n");
             }
 
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_ARRAY_LOAD:
             /* Array load: result = array[index] */
-            fprintf(gen->output_file, "    # %s = %s[%s]\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s       # load index\n", inst->op2);
-            fprintf(gen->output_file, "    sll $t0, $t0, 2  # multiply by 4 (word size)\n");
-            fprintf(gen->output_file, "    la $t1, %s       # load array base\n", inst->op1);
-            fprintf(gen->output_file, "    add $t0, $t0, $t1\n");
-            fprintf(gen->output_file, "    lw $t0, 0($t0)\n");
-            fprintf(gen->output_file, "    sw $t0, %s\n", inst->result);
+            emit_note(e, inst->result, " = ", inst->op1, "[", inst->op2, "]", NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op2, "       # load index");
+            emit_line(e, "    sll $t0, $t0, 2", "  # multiply by 4 (word size)");
+            insn_reg_sym(e, "la", "$t1", inst->op1, "       # load array base");
+            emit_text(e, "    add $t0, $t0, $t1\n");
+            emit_text(e, "    lw $t0, 0($t0)\n");
+            insn_reg_sym(e, "sw", "$t0", inst->result, NULL);
             break;
 
         case TAC_ARRAY_STORE:
             /* Array store: array[index] = value */
-            fprintf(gen->output_file, "    # %s[%s] = %s\n", inst->result, inst->op1, inst->op2);
-            fprintf(gen->output_file, "    lw $t0, %s       # load index\n", inst->op1);
-            fprintf(gen->output_file, "    sll $t0, $t0, 2  # multiply by 4\n");
-            fprintf(gen->output_file, "    la $t1, %s       # load array base\n", inst->result);
-            fprintf(gen->output_file, "    add $t0, $t0, $t1\n");
-            fprintf(gen->output_file, "    lw $t2, %s       # load value\n", inst->op2);
-            fprintf(gen->output_file, "    sw $t2, 0($t0)\n");
+            emit_note(e, inst->result, "[", inst->op1, "] = ", inst->op2, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, "       # load index");
+            emit_line(e, "    sll $t0, $t0, 2", "  # multiply by 4");
+            insn_reg_sym(e, "la", "$t1", inst->result, "       # load array base");
+            emit_text(e, "    add $t0, $t0, $t1\n");
+            insn_reg_sym(e, "lw", "$t2", inst->op2, "       # load value");
+            emit_text(e, "    sw $t2, 0($t0)\n");
             break;
 
         case TAC_FUNCTION_LABEL:
             /* Function label */
-            fprintf(gen->output_file, "\n%s:\n", inst->label);
-            fprintf(gen->output_file, "    # Function: %s\n", inst->label);
+            emit_text(e, "\n");
+            emit_label(e, inst->label);
+            emit_note(e, "Function: ", inst->label, NULL);
             break;
 
         case TAC_PARAM:
             /* Function parameter (push to stack) */
-            fprintf(gen->output_file, "    # param %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $t0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    addi $sp, $sp, -4\n");
-            fprintf(gen->output_file, "    sw $t0, 0($sp)\n");
+            emit_note(e, "param ", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, NULL);
+            emit_text(e, "    addi $sp, $sp, -4\n");
+            emit_text(e, "    sw $t0, 0($sp)\n");
             break;
 
-        case TAC_CALL:
+        case TAC_CALL: {
             /* Function call */
-            fprintf(gen->output_file, "    # call %s\n", inst->label);
-            fprintf(gen->output_file, "    jal %s\n", inst->label);
+            emit_note(e, "call ", inst->label, NULL);
+            emit_insn(e, "jal");
+            emit_sym(e, inst->label);
+            emit_end(e, NULL);
             /* Pop parameters */
             int param_count = atoi(inst->op1);
-            fprintf(gen->output_file, "    addi $sp, $sp, %d    # pop parameters\n",
-                    param_count * 4);
-            fprintf(gen->output_file, "    sw $v0, %s       # save return value\n", inst->result);
+            emit_insn(e, "addi");
+            emit_reg(e, "$sp");
+            emit_reg(e, "$sp");
+            emit_imm(e, param_count * 4);
+            emit_end(e, "    # pop parameters");
+            insn_reg_sym(e, "sw", "$v0", inst->result, "       # save return value");
             break;
+        }
 
         case TAC_RETURN:
             /* Return with value */
-            fprintf(gen->output_file, "    # return %s\n", inst->op1);
-            fprintf(gen->output_file, "    lw $v0, %s\n", inst->op1);
-            fprintf(gen->output_file, "    jr $ra\n");
+            emit_note(e, "return ", inst->op1, NULL);
+            insn_reg_sym(e, "lw", "$v0", inst->op1, NULL);
+            emit_text(e, "    jr $ra\n");
             break;
 
         case TAC_RETURN_VOID:
             /* Return without value */
-            fprintf(gen->output_file, "    # return (void)\n");
-            fprintf(gen->output_file, "    jr $ra\n");
+            emit_note(e, "return (void)", NULL);
+            emit_text(e, "    jr $ra\n");
+            break;
+
+        case TAC_BOUNDS_CHECK:
+            /* Bounds check: stop unless 0 <= index < size */
+            emit_note(e, "check 0 <= ", inst->op1, " < ", inst->op2, " (", inst->result, ")", NULL);
+            insn_reg_sym(e, "lw", "$t0", inst->op1, "       # load index");
+            insn_reg_sym(e, "li", "$t1", inst->op2, "       # array size");
+            emit_line(e, "    bgeu $t0, $t1, bounds.fail", "  # negative is above too");
             break;
 
         default:
-            fprintf(gen->output_file, "    # Unknown opcode: %s\n",
-                    opcode_to_string(inst->opcode));
+            emit_note(e, "Unknown opcode: ", opcode_to_string(inst->opcode), NULL);
             break;
     }
 }
 
 /* Generate MIPS assembly from TAC */
 void generate_mips_assembly(MIPSCodeGenerator* gen, TACCode* tac) {
-    printf("[CODEGEN] Generating MIPS assembly code...\n");
+    log_message(LOG_NORMAL, "[CODEGEN] Generating MIPS assembly code...\n");
 
     gen_mips_prologue(gen);
 
@@ -304,14 +402,11 @@ void generate_mips_assembly(MIPSCodeGenerator* gen, TACCode* tac) {
 
     gen_mips_epilogue(gen);
 
-    printf("[CODEGEN] MIPS assembly generation complete\n");
-    printf("[CODEGEN] Total instructions: %d\n", tac->instruction_count);
+    log_message(LOG_NORMAL, "[CODEGEN] MIPS assembly generation complete\n");
+    log_message(LOG_NORMAL, "[CODEGEN] Total instructions: %d\n", tac->instruction_count);
 }
 
 /* Close and cleanup MIPS code generator */
 void close_mips_code_generator(MIPSCodeGenerator* gen) {
-    if (gen->output_file) {
-        fclose(gen->output_file);
-    }
     free(gen);
 }
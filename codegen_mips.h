@@ -4,6 +4,8 @@
  *
  * This file defines the code generation phase which translates
  * Three-Address Code (TAC) into MIPS assembly code for QtSpim/MARS.
+ * A failed --bounds-check check branches to bounds.fail, which prints the
+ * error and exits with status 1 (syscall 17).
  */
 
 #ifndef CODEGEN_MIPS_H
@@ -14,19 +16,22 @@
 #include <string.h>
 #include "ircode.h"
 #include "symtable.h"
+#include "emit.h"
 
 /* MIPS Assembly code output structure */
 typedef struct {
-    FILE* output_file;          /* File to write assembly code to */
+    AsmEmitter emit;            /* Emitter writing the assembly code */
     int stack_offset;           /* Current stack frame offset */
     SymbolTable* symtab;        /* Symbol table for variable locations */
     int next_register;          /* Next available temporary register */
+    int bounds_checks;          /* Emit bounds.fail for TAC_BOUNDS_CHECK (--bounds-check) */
 } MIPSCodeGenerator;
 
 /* CODE GENERATION FUNCTIONS */
 
-/* Create a new MIPS code generator */
-MIPSCodeGenerator* create_mips_code_generator(const char* output_filename, SymbolTable* symtab);
+/* Create a new MIPS code generator writing to out (the caller keeps ownership);
+ * comments = 0 leaves out the annotation comments */
+MIPSCodeGenerator* create_mips_code_generator(OutputSink* out, SymbolTable* symtab, int comments);
 
 /* Generate MIPS assembly code from TAC */
 void generate_mips_assembly(MIPSCodeGenerator* gen, TACCode* tac);
@@ -43,7 +48,7 @@ void gen_mips_instruction(MIPSCodeGenerator* gen, TACInstruction* inst);
 /* Get register for a variable/temporary */
 const char* get_mips_register(MIPSCodeGenerator* gen, const char* name);
 
-/* Close and cleanup MIPS code generator */
+/* Free the MIPS code generator (the sink stays open) */
 void close_mips_code_generator(MIPSCodeGenerator* gen);
 
 #endif /* CODEGEN_MIPS_H */
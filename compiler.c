@@ -3,13 +3,15 @@
  * CST-405 Complete Compiler Project
  *
  * This is the main entry point for the complete compiler.
- * It orchestrates all compilation phases:
+ * It parses the command line and runs the compiler library (context.c)
+ * on each input file, which carries out all compilation phases:
  *   1. Lexical Analysis (Scanning)
  *   2. Syntax Analysis (Parsing)
  *   3. Semantic Analysis
  *   4. Intermediate Code Generation (TAC)
  *   5. Code Optimization
- *   6. Code Generation (Assembly)
+ *   6. Code Generation (Assembly, or an ELF object with --emit-obj)
+ *   7. Execution in-process with --run
  *
  * FEATURES: Loops (while/for/do-while), if/else, functions, arrays
  */
@@ -17,260 +19,385 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "ast.h"
-#include "symtable.h"
-#include "semantic.h"
-#include "ircode.h"
-#include "optimizer.h"
-#include "codegen.h"
-#include "codegen_mips.h"
+#include "context.h"
 #include "diagnostics.h"
-#include "security.h"
-
-/* External declarations from parser */
-extern int yyparse();
-extern FILE* yyin;
-extern ASTNode* ast_root;
-extern SymbolTable* global_symtab;
-extern int syntax_errors;
-extern int line_num;
+#include "cache.h"
+#include "profile.h"
+#include "workpool.h"
+#include "optimizer.h"
+#include "vectorize.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define make_dir(path) mkdir(path, 0755)
+#endif
+#include <errno.h>
+
+/* One input of a batch and how its compilation went */
+typedef struct {
+    const char* input;
+    char asm_path[1024];
+    char ir_path[1024];
+    int failed;
+} BatchItem;
+
+/* A batch compiled on the work pool, one compiler context per file */
+typedef struct {
+    BatchItem* items;
+    const CompileOptions* options;
+    int write_files;              /* Write the .asm/.o and .ir files */
+} BatchJob;
 
 /* Function prototypes */
 void print_banner();
-void print_phase_separator(const char* phase_name);
-void print_summary(int success);
+static void batch_output_path(char* path, size_t size, const char* dir,
+                              const char* input, const char* suffix);
+static int duplicate_output_paths(BatchItem* items, int count);
+static void compile_batch_item(void* context, int index);
 
 int main(int argc, char* argv[]) {
-    /* Print compiler banner */
-    print_banner();
-
     /* Check command line arguments */
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <input_file> [options]\n", argv[0]);
+        print_banner();
+        fprintf(stderr, "Usage: %s <input_file> [input_file...] [options]\n", argv[0]);
         fprintf(stderr, "Options:\n");
         fprintf(stderr, "  --mips          Generate MIPS assembly instead of x86-64\n");
         fprintf(stderr, "  --verbose       Enable verbose output and debugging info\n");
+        fprintf(stderr, "  --quiet, -q     No progress output (errors and warnings only)\n");
+        fprintf(stderr, "  --dump-ast      Print the abstract syntax tree\n");
+        fprintf(stderr, "  --dump-symtab   Print the symbol table\n");
+        fprintf(stderr, "  --dump-tac      Print the TAC before and after optimization\n");
+        fprintf(stderr, "  --time-report[=json]  Time and memory used by each phase\n");
         fprintf(stderr, "  --log <file>    Write diagnostics to log file\n");
         fprintf(stderr, "  --no-warnings   Suppress warning messages\n");
         fprintf(stderr, "  --Werror        Treat warnings as errors\n");
+        fprintf(stderr, "  --no-asm-comments  Emit assembly without annotation comments\n");
+        fprintf(stderr, "  --emit-obj      Write an x86-64 ELF object (.o) instead of assembly\n");
+        fprintf(stderr, "  --run           Run the program in-process after compiling (x86-64 JIT)\n");
+        fprintf(stderr, "  --interp        Run the program on the bytecode interpreter (any host)\n");
+        fprintf(stderr, "  --incremental   Reuse unchanged functions from the on-disk cache\n");
+        fprintf(stderr, "  --cache-dir <d> Cache directory for --incremental (default %s)\n",
+                DEFAULT_CACHE_DIR);
+        fprintf(stderr, "  --profile-generate[=<file>]  Build a program that counts its blocks and branches\n");
+        fprintf(stderr, "                  into a profile (default <input>%s)\n", DEFAULT_PROFILE_SUFFIX);
+        fprintf(stderr, "  --profile-use[=<file>]  Optimize with the counts of a profile\n");
+        fprintf(stderr, "  --bounds-check  Stop with an error on an out-of-range array index\n");
+        fprintf(stderr, "  -O0 .. -O3      Optimization level (default -O%d; -O0 = none)\n", DEFAULT_OPT_LEVEL);
+        fprintf(stderr, "  --avx2          Vectorize array loops with AVX2 (default SSE2, at -O2 and up)\n");
+        fprintf(stderr, "  --no-vectorize  Keep array loops scalar\n");
+        fprintf(stderr, "  --passes=<list> Run these passes in this order (fold,copy-prop,cse,peephole,flow,dce,ranges,dse,layout)\n");
+        fprintf(stderr, "  -j <N>          Use N threads: the functions of a file, or the files of a batch (0 = all cores)\n");
+        fprintf(stderr, "  -o <dir>        Batch mode output directory (one .asm/.o/.ir per input)\n");
         fprintf(stderr, "\nExample: %s program.src --verbose --mips\n", argv[0]);
+        fprintf(stderr, "         %s a.c b.c c.c -o build/\n", argv[0]);
         return 1;
     }
 
-    const char* input_filename = argv[1];
-    int use_mips = 0;
-    int verbose = 0;
-    int warnings_as_errors = 0;
-    int show_warnings = 1;
+    CompileOptions opts;
+    init_compile_options(&opts);
+
     const char* log_file = NULL;
-    const char* output_filename = "output.asm";
+    const char* output_dir = NULL;
+    const char** inputs = (const char**)safe_malloc(argc * sizeof(const char*), "input list");
+    int input_count = 0;
 
-    /* Parse command line flags */
-    for (int i = 2; i < argc; i++) {
+    /* Parse command line flags; every other argument is an input file */
+    for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--mips") == 0) {
-            use_mips = 1;
-            output_filename = "output_mips.asm";
+            opts.use_mips = 1;
         } else if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-v") == 0) {
-            verbose = 1;
+            opts.verbose = 1;
+            opts.log_level = LOG_VERBOSE;
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            opts.log_level = LOG_QUIET;
+        } else if (strcmp(argv[i], "--dump-ast") == 0) {
+            opts.dump_ast = 1;
+        } else if (strcmp(argv[i], "--dump-symtab") == 0) {
+            opts.dump_symtab = 1;
+        } else if (strcmp(argv[i], "--dump-tac") == 0) {
+            opts.dump_tac = 1;
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            opts.time_report = TIME_REPORT_TABLE;
+        } else if (strcmp(argv[i], "--time-report=json") == 0) {
+            opts.time_report = TIME_REPORT_JSON;
         } else if (strcmp(argv[i], "--Werror") == 0) {
-            warnings_as_errors = 1;
+            opts.warnings_as_errors = 1;
         } else if (strcmp(argv[i], "--no-warnings") == 0) {
-            show_warnings = 0;
+            opts.show_warnings = 0;
+        } else if (strcmp(argv[i], "--no-asm-comments") == 0) {
+            opts.asm_comments = 0;
+        } else if (strcmp(argv[i], "--emit-obj") == 0) {
+            opts.emit_object = 1;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            opts.run_program = 1;
+        } else if (strcmp(argv[i], "--interp") == 0) {
+            opts.interpret = 1;
         } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
             log_file = argv[++i];
+        } else if (strcmp(argv[i], "--incremental") == 0) {
+            opts.incremental = 1;
+        } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            opts.cache_dir = argv[++i];
+            opts.incremental = 1;
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            opts.profile_generate = "";
+        } else if (strncmp(argv[i], "--profile-generate=", 19) == 0) {
+            opts.profile_generate = argv[i] + 19;
+        } else if (strcmp(argv[i], "--profile-use") == 0) {
+            opts.profile_use = "";
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0) {
+            opts.profile_use = argv[i] + 14;
+        } else if (strcmp(argv[i], "--bounds-check") == 0) {
+            opts.bounds_check = 1;
+        } else if (strcmp(argv[i], "--avx2") == 0) {
+            opts.vectorize = VECTOR_AVX2;
+        } else if (strcmp(argv[i], "--no-vectorize") == 0) {
+            opts.vectorize = VECTOR_NONE;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            opts.jobs = atoi(argv[++i]);
+        } else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+            opts.jobs = atoi(argv[i] + 2);
+        } else if (argv[i][0] == '-' && argv[i][1] == 'O' &&
+                   argv[i][2] >= '0' && argv[i][2] <= '3' && argv[i][3] == '\0') {
+            opts.opt_level = argv[i][2] - '0';
+        } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+            opts.passes = argv[i] + 9;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Warning: Ignoring unknown option '%s'\n", argv[i]);
+        } else {
+            inputs[input_count++] = argv[i];
         }
     }
 
-    /* Initialize diagnostics system */
-    init_diagnostics(verbose, warnings_as_errors);
-    diag_config.show_warnings = show_warnings;
-
-    if (log_file) {
-        set_diagnostic_log_file(log_file);
-    }
-
-    /* Open input file */
-    FILE* input_file = fopen(input_filename, "r");
-    if (!input_file) {
-        fprintf(stderr, "Error: Cannot open input file '%s'\n", input_filename);
+    if (input_count == 0) {
+        fprintf(stderr, "Error: No input files\n");
+        free(inputs);
         return 1;
     }
 
-    yyin = input_file;
-    printf("Input file: %s\n", input_filename);
-    printf("Output file: %s\n", output_filename);
-    printf("Target: %s\n\n", use_mips ? "MIPS (QtSpim/MARS)" : "x86-64 (NASM)");
-
-    /* ===================================================================
-     * PHASE 1 & 2: LEXICAL AND SYNTAX ANALYSIS
-     * The lexer (scanner) and parser work together during yyparse()
-     * ================================================================ */
-    print_phase_separator("PHASE 1 & 2: LEXICAL AND SYNTAX ANALYSIS");
-
-    /* Initialize symbol table before parsing */
-    global_symtab = create_symbol_table(100);
-
-    /* Run the parser (which calls the lexer) */
-    int parse_result = yyparse();
-
-    /* Check for syntax errors */
-    if (parse_result != 0 || syntax_errors > 0) {
-        fprintf(stderr, "\n[X] COMPILATION FAILED: Syntax errors detected\n");
-        fprintf(stderr, "[X] Please fix the errors and try again\n\n");
-
-        fclose(input_file);
-        if (global_symtab) free_symbol_table(global_symtab);
-        if (ast_root) free_ast(ast_root);
-        return 1;
+    /* Reject unknown pass names before compiling anything */
+    if (opts.passes) {
+        PassPipeline pipeline;
+        init_pass_pipeline(&pipeline, opts.opt_level);
+        if (parse_pass_pipeline(&pipeline, opts.passes) != 0) {
+            free(inputs);
+            return 1;
+        }
     }
 
-    printf("[OK] Lexical analysis complete\n");
-    printf("[OK] Syntax analysis complete\n");
-    printf("[OK] Abstract Syntax Tree (AST) constructed\n\n");
+    if (opts.emit_object && opts.use_mips) {
+        fprintf(stderr, "Warning: --emit-obj is only available for x86-64; writing MIPS assembly\n");
+        opts.emit_object = 0;
+    }
+    if (opts.interpret && (opts.run_program || opts.emit_object)) {
+        fprintf(stderr, "Warning: --interp generates no machine code; ignoring --run and --emit-obj\n");
+        opts.run_program = 0;
+        opts.emit_object = 0;
+    }
+    if (opts.run_program && opts.use_mips) {
+        fprintf(stderr, "Warning: --run is only available for x86-64; writing MIPS assembly\n");
+        opts.run_program = 0;
+    }
+    if (opts.profile_generate && opts.use_mips) {
+        fprintf(stderr, "Warning: --profile-generate is not available for MIPS; ignoring it\n");
+        opts.profile_generate = NULL;
+    }
+    if (opts.incremental && (opts.profile_generate || opts.profile_use)) {
+        fprintf(stderr, "Warning: Profiled builds do not use the cache; ignoring --incremental\n");
+        opts.incremental = 0;
+    }
 
-    /* ===================================================================
-     * PHASE 3: SEMANTIC ANALYSIS
-     * Type checking, variable declaration/initialization checking
-     * ================================================================ */
-    print_phase_separator("PHASE 3: SEMANTIC ANALYSIS");
+    if (opts.jobs <= 0) {
+        opts.jobs = available_processors();
+    }
 
-    int semantic_result = analyze_semantics(ast_root, global_symtab);
+    /* Initialize diagnostics system */
+    init_diagnostics(opts.verbose, opts.warnings_as_errors);
+    diag_config.show_warnings = opts.show_warnings;
+    diag_config.log_level = opts.log_level;
 
-    if (semantic_result > 0) {
-        fprintf(stderr, "\n[X] COMPILATION FAILED: Semantic errors detected\n");
-        fprintf(stderr, "[X] Please fix the errors and try again\n\n");
+    /* Print compiler banner */
+    if (LOG_ENABLED(LOG_NORMAL)) {
+        print_banner();
+    }
 
-        fclose(input_file);
-        free_symbol_table(global_symtab);
-        free_ast(ast_root);
-        return 1;
+    if (log_file) {
+        set_diagnostic_log_file(log_file);
+        opts.log_file = diag_config.log_file;
     }
 
-    print_semantic_summary();
+    /* One context, reused for every file */
+    CompilerContext* ctx = create_compiler_context();
+    int failures = 0;
+    int exit_status = 0;          /* Exit code of the program with --run or --interp */
+
+    const char* output_name = opts.use_mips ? "output_mips.asm" :
+                              opts.emit_object ? "output.o" : "output.asm";
+    const char* output_suffix = opts.use_mips ? "_mips.asm" : opts.emit_object ? ".o" : ".asm";
+
+    /* --run and --interp write no files unless an object file was asked
+     * for as well */
+    int write_files = !opts.run_program && !opts.interpret;
+
+    if (input_count == 1 && !output_dir) {
+        /* Single file - classic fixed output names */
+        failures = compile_file(ctx, inputs[0],
+                                write_files || opts.emit_object ? output_name : NULL,
+                                write_files ? "output.ir" : NULL, &opts);
+        if (failures == 0 && (opts.run_program || opts.interpret)) {
+            exit_status = ctx->exit_code;
+        }
+    } else {
+        /* Batch mode - one process, per-file state, outputs named after each input */
+        if (!output_dir) output_dir = ".";
+        BatchItem* items = (BatchItem*)safe_calloc(input_count, sizeof(BatchItem), "batch");
+        for (int i = 0; i < input_count; i++) {
+            items[i].input = inputs[i];
+            batch_output_path(items[i].asm_path, sizeof(items[i].asm_path), output_dir,
+                              inputs[i], output_suffix);
+            batch_output_path(items[i].ir_path, sizeof(items[i].ir_path), output_dir,
+                              inputs[i], ".ir");
+        }
 
-    /* Print AST for debugging */
-    printf("=============== ABSTRACT SYNTAX TREE ==================\n\n");
-    print_ast(ast_root, 0);
-    printf("\n");
+        /* Outputs are named after the input's file name only, so a/x.c and
+         * b/x.c would overwrite each other's files */
+        if ((write_files || opts.emit_object) && duplicate_output_paths(items, input_count)) {
+            free(items);
+            free(inputs);
+            free_compiler_context(ctx);
+            close_diagnostics();
+            return 1;
+        }
 
-    /* Print symbol table */
-    printf("=================== SYMBOL TABLE ======================\n\n");
-    print_symbol_table(global_symtab);
-    printf("\n");
+        if (make_dir(output_dir) != 0 && errno != EEXIST) {
+            fprintf(stderr, "Error: Cannot create output directory '%s'\n", output_dir);
+            free(items);
+            free(inputs);
+            free_compiler_context(ctx);
+            close_diagnostics();
+            return 1;
+        }
 
-    /* ===================================================================
-     * PHASE 4: INTERMEDIATE CODE GENERATION
-     * Generate Three-Address Code (TAC) from AST
-     * ================================================================ */
-    print_phase_separator("PHASE 4: INTERMEDIATE CODE GENERATION");
+        /* With -j N the files themselves are spread over the threads, each
+         * compiled on one thread with a context of its own. Programs that
+         * run, dumps and time reports print per file, so those batches stay
+         * sequential to keep their output in input order. */
+        int batch_threads = opts.jobs < input_count ? opts.jobs : input_count;
+        if (opts.run_program || opts.interpret || opts.dump_ast || opts.dump_tac ||
+            opts.dump_symtab || opts.time_report) {
+            batch_threads = 1;
+        }
 
-    TACCode* tac = generate_tac(ast_root);
+        if (batch_threads > 1) {
+            /* Phase banners of files compiled at the same time would
+             * interleave; report each file once it is done instead */
+            CompileOptions file_opts = opts;
+            file_opts.jobs = 1;
+            file_opts.log_level = LOG_QUIET;
+
+            log_message(LOG_NORMAL, "[BATCH] Compiling %d files on %d threads\n",
+                        input_count, batch_threads);
+            BatchJob job = { items, &file_opts, write_files };
+            run_parallel(batch_threads, input_count, compile_batch_item, &job);
+
+            for (int i = 0; i < input_count; i++) {
+                log_message(LOG_NORMAL, "[BATCH] (%d/%d) %s%s\n", i + 1, input_count, inputs[i],
+                            items[i].failed ? " - FAILED" : "");
+            }
+        } else {
+            for (int i = 0; i < input_count; i++) {
+                log_message(LOG_NORMAL, "[BATCH] (%d/%d) %s\n", i + 1, input_count, inputs[i]);
+                items[i].failed = compile_file(ctx, inputs[i],
+                                               write_files || opts.emit_object ? items[i].asm_path : NULL,
+                                               write_files ? items[i].ir_path : NULL, &opts) != 0;
+            }
+        }
 
-    if (!tac) {
-        fprintf(stderr, "\n[X] COMPILATION FAILED: IR generation failed\n\n");
+        for (int i = 0; i < input_count; i++) {
+            failures += items[i].failed;
+        }
+        free(items);
 
-        fclose(input_file);
-        free_symbol_table(global_symtab);
-        free_ast(ast_root);
-        return 1;
+        log_message(LOG_NORMAL, "[BATCH] %d file(s) compiled, %d failed\n\n",
+                    input_count - failures, failures);
     }
 
-    /* Print TAC before optimization */
-    print_tac(tac);
-
-    /* Save IR to file */
-    FILE* ir_file = fopen("output.ir", "w");
-    if (ir_file) {
-        TACInstruction* inst = tac->head;
-        while (inst) {
-            fprintf(ir_file, "%s", opcode_to_string(inst->opcode));
-            if (inst->result) fprintf(ir_file, " %s", inst->result);
-            if (inst->op1) fprintf(ir_file, " %s", inst->op1);
-            if (inst->op2) fprintf(ir_file, " %s", inst->op2);
-            if (inst->label) fprintf(ir_file, " %s", inst->label);
-            fprintf(ir_file, "\n");
-            inst = inst->next;
-        }
-        fclose(ir_file);
-        printf("[OK] Intermediate code saved to: output.ir\n\n");
-    }
+    free(inputs);
+    free_compiler_context(ctx);
+    close_diagnostics();
 
-    /* ===================================================================
-     * PHASE 5: CODE OPTIMIZATION
-     * Optimize the intermediate representation
-     * ================================================================ */
-    print_phase_separator("PHASE 5: CODE OPTIMIZATION");
+    return failures > 0 ? 1 : exit_status;
+}
 
-    OptimizationStats opt_stats;
-    optimize_tac(tac, &opt_stats);
-    print_optimization_stats(&opt_stats);
+/* Work pool item: compile one file of a batch with a context of its own */
+static void compile_batch_item(void* context, int index) {
+    BatchJob* job = (BatchJob*)context;
+    BatchItem* item = &job->items[index];
+    const CompileOptions* options = job->options;
+
+    CompilerContext* ctx = create_compiler_context();
+    item->failed = compile_file(ctx, item->input,
+                                job->write_files || options->emit_object ? item->asm_path : NULL,
+                                job->write_files ? item->ir_path : NULL, options) != 0;
+    free_compiler_context(ctx);
+}
 
-    /* Print optimized TAC */
-    if (verbose) {
-        printf("=============== OPTIMIZED TAC ==================\n\n");
-        print_tac(tac);
+/* Batch mode output path: <dir>/<input file name without extension><suffix> */
+static void batch_output_path(char* path, size_t size, const char* dir,
+                              const char* input, const char* suffix) {
+    const char* base = input;
+    for (const char* p = input; *p; p++) {
+        if (*p == '/' || *p == '\\') base = p + 1;
     }
 
-    /* ===================================================================
-     * PHASE 5.5: SECURITY ANALYSIS
-     * Check for unsafe constructs and security vulnerabilities
-     * ================================================================ */
-    print_phase_separator("PHASE 5.5: SECURITY ANALYSIS");
-
-    SecurityCheckResults* security_results = analyze_security(ast_root, global_symtab);
-    print_security_report(security_results);
-
-    /* ===================================================================
-     * PHASE 6: CODE GENERATION
-     * Generate assembly code from optimized TAC
-     * ================================================================ */
-    print_phase_separator("PHASE 6: ASSEMBLY CODE GENERATION");
-
-    if (use_mips) {
-        /* Generate MIPS assembly */
-        MIPSCodeGenerator* mips_gen = create_mips_code_generator(output_filename, global_symtab);
-        generate_mips_assembly(mips_gen, tac);
-        close_mips_code_generator(mips_gen);
-    } else {
-        /* Generate x86-64 assembly */
-        CodeGenerator* codegen = create_code_generator(output_filename, global_symtab);
-        generate_assembly(codegen, tac);
-        close_code_generator(codegen);
-    }
+    const char* dot = strrchr(base, '.');
+    int stem_len = dot && dot != base ? (int)(dot - base) : (int)strlen(base);
 
-    /* ===================================================================
-     * COMPILATION COMPLETE
-     * ================================================================ */
-    print_summary(1);
+    size_t dir_len = strlen(dir);
+    const char* sep = (dir_len > 0 && (dir[dir_len - 1] == '/' || dir[dir_len - 1] == '\\')) ? "" : "/";
 
-    printf("[OK] Compilation successful!\n");
-    printf("[OK] Assembly code written to: %s\n\n", output_filename);
+    snprintf(path, size, "%s%s%.*s%s", dir, sep, stem_len, base, suffix);
+}
 
-    if (use_mips) {
-        printf("To run on QtSpim or MARS:\n");
-        printf("  1. Open %s in QtSpim or MARS simulator\n", output_filename);
-        printf("  2. Assemble and run the program\n\n");
-    } else {
-        printf("To assemble and link (on Linux):\n");
-        printf("  nasm -f elf64 %s -o output.o\n", output_filename);
-        printf("  gcc output.o -o program -no-pie\n");
-        printf("  ./program\n\n");
-    }
+/* Helper: qsort order of batch items by output path (input order among
+ * equal paths) */
+static int compare_output_paths(const void* a, const void* b) {
+    const BatchItem* item_a = *(const BatchItem* const*)a;
+    const BatchItem* item_b = *(const BatchItem* const*)b;
+    int order = strcmp(item_a->asm_path, item_b->asm_path);
+    if (order != 0) return order;
+    return item_a < item_b ? -1 : item_a > item_b;
+}
 
-    /* ===================================================================
-     * FINAL DIAGNOSTICS
-     * ================================================================ */
-    print_diagnostic_summary();
-
-    /* Cleanup */
-    fclose(input_file);
-    free_ast(ast_root);
-    free_symbol_table(global_symtab);
-    free_tac(tac);
-    free_security_results(security_results);
-    close_diagnostics();
+/* Report every input whose outputs another input of the batch would also
+ * write; returns 1 if there is one. Sorting the paths finds them without
+ * comparing every pair. */
+static int duplicate_output_paths(BatchItem* items, int count) {
+    BatchItem** sorted = (BatchItem**)safe_malloc(count * sizeof(BatchItem*), "batch outputs");
+    for (int i = 0; i < count; i++) {
+        sorted[i] = &items[i];
+    }
+    qsort(sorted, count, sizeof(BatchItem*), compare_output_paths);
+
+    int found = 0;
+    for (int i = 1; i < count; i++) {
+        if (strcmp(sorted[i - 1]->asm_path, sorted[i]->asm_path) == 0) {
+            fprintf(stderr, "Error: '%s' and '%s' would both be written to '%s'\n",
+                    sorted[i - 1]->input, sorted[i]->input, sorted[i]->asm_path);
+            found = 1;
+        }
+    }
+    if (found) {
+        fprintf(stderr, "Error: Compile inputs with the same file name into different -o directories\n");
+    }
 
-    return 0;
+    free(sorted);
+    return found;
 }
 
 /* Print the compiler banner */
@@ -288,29 +415,3 @@ void print_banner() {
     printf("+============================================================+\n\n");
 }
 
-/* Print phase separator */
-void print_phase_separator(const char* phase_name) {
-    printf("+============================================================+\n");
-    printf("| %-57s |\n", phase_name);
-    printf("+============================================================+\n\n");
-}
-
-/* Print compilation summary */
-void print_summary(int success) {
-    printf("+============================================================+\n");
-    printf("|                   COMPILATION SUMMARY                     |\n");
-    printf("+============================================================+\n");
-
-    if (success) {
-        printf("|  Status:           [OK] SUCCESS                           |\n");
-        printf("|  Lexical errors:   0                                      |\n");
-        printf("|  Syntax errors:    0                                      |\n");
-        printf("|  Semantic errors:  0                                      |\n");
-        printf("|  Optimization:     Enabled                                |\n");
-        printf("|  Code generated:   Yes                                    |\n");
-    } else {
-        printf("|  Status:           [X] FAILED                             |\n");
-    }
-
-    printf("+============================================================+\n\n");
-}
@@ -0,0 +1,805 @@
+/*
+ * CONTEXT.C - Compiler Library Implementation
+ * CST-405 Compiler Project
+ *
+ * This file runs the compilation phases for one program:
+ *   1. Lexical Analysis (Scanning)
+ *   2. Syntax Analysis (Parsing)
+ *   3. Semantic Analysis
+ *   4. Intermediate Code Generation (TAC)
+ *   5. Code Optimization
+ *   6. Code Generation (Assembly)
+ *
+ * All state belongs to the CompilerContext or to the calling thread, so
+ * separate contexts can compile at the same time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "context.h"
+#include "semantic.h"
+#include "ircode.h"
+#include "optimizer.h"
+#include "codegen.h"
+#include "codegen_mips.h"
+#include "codegen_elf.h"
+#include "jit.h"
+#include "interp.h"
+#include "security.h"
+#include "cache.h"
+#include "profile.h"
+#include "bounds.h"
+#include "vectorize.h"
+#include "workpool.h"
+
+/* Per-unit compilation state - used when top-level units are compiled on
+ * their own (incremental cache and/or parallel jobs), one slot per unit */
+typedef struct {
+    CompileCache* cache;          /* On-disk function cache (NULL if not incremental) */
+    int jobs;                     /* Worker threads for optimization/code generation */
+    int use_mips;                 /* Target MIPS instead of x86-64 */
+    const PassPipeline* pipeline; /* Optimization passes to run on each unit */
+    void* gen;                    /* Code generator (CodeGenerator or MIPSCodeGenerator) */
+    TACUnit* units;               /* Unit boundaries (owned by the TAC list) */
+    TACCode** parts;              /* Per-unit TAC while the units are optimized */
+    Fingerprint* keys;            /* Fingerprint of each function unit */
+    int* from_cache;              /* Unit was reused from the cache */
+    char** asm_text;              /* Assembly for each unit */
+    OptimizationStats* stats;     /* Optimizations applied to each unit */
+    int unit_count;               /* Number of units */
+} UnitPipeline;
+
+/* The thread-wide state a compilation works in (diagnostics.h, ast.h).
+ * The library entry points put the caller's copy aside and restore it on
+ * the way out, so the caller and the contexts compiled one after another
+ * on its thread never see each other's settings or counts. */
+typedef struct {
+    DiagnosticConfig diag_config;
+    DiagnosticStats diag_stats;
+    AllocationStats alloc_stats;
+    int ast_line_num;
+} ThreadState;
+
+static void print_phase_separator(const char* phase_name);
+static void print_summary(int success);
+static void optimize_units(UnitPipeline* pipe, TACCode* tac, OptimizationStats* total);
+static void generate_units(UnitPipeline* pipe, TACCode* tac, OutputSink* output);
+static void store_units(UnitPipeline* pipe);
+static void free_unit_pipeline(UnitPipeline* pipe);
+
+/* Set compile options to their defaults */
+void init_compile_options(CompileOptions* options) {
+    memset(options, 0, sizeof(*options));
+    options->show_warnings = 1;
+    options->cache_dir = DEFAULT_CACHE_DIR;
+    options->jobs = 1;
+    options->opt_level = DEFAULT_OPT_LEVEL;
+    options->asm_comments = 1;
+    options->vectorize = VECTOR_SSE2;
+    options->log_level = LOG_NORMAL;
+}
+
+/* Create an empty compilation context */
+CompilerContext* create_compiler_context(void) {
+    CompilerContext* ctx = (CompilerContext*)safe_calloc(1, sizeof(CompilerContext), "compiler context");
+    reset_compiler_context(ctx);
+    return ctx;
+}
+
+/* Release the previous compilation's results and reset the counters */
+void reset_compiler_context(CompilerContext* ctx) {
+    if (ctx->ast_root) free_ast(ctx->ast_root);
+    if (ctx->symtab) free_symbol_table(ctx->symtab);
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->line_num = 1;
+    ctx->col_num = 1;
+}
+
+/* Free a compilation context */
+void free_compiler_context(CompilerContext* ctx) {
+    if (ctx) {
+        reset_compiler_context(ctx);
+        free(ctx);
+    }
+}
+
+/* Helper: put the caller's thread-wide state aside */
+static void save_thread_state(ThreadState* saved) {
+    saved->diag_config = diag_config;
+    saved->diag_stats = diag_stats;
+    saved->alloc_stats = alloc_stats;
+    saved->ast_line_num = ast_line_num;
+}
+
+/* Helper: give the caller its state back. The allocation counters keep
+ * counting - the caller's phase marks take differences of them. */
+static void restore_thread_state(const ThreadState* saved) {
+    diag_config = saved->diag_config;
+    diag_stats = saved->diag_stats;
+    ast_line_num = saved->ast_line_num;
+}
+
+/* Helper: record the end-of-compilation counts and pass the status through */
+static int finish_compilation(CompilerContext* ctx, int status) {
+    ctx->diag_stats = diag_stats;
+    return status;
+}
+
+/* Helper: compile_buffer() inside the compilation's thread-wide state */
+static int run_compilation(CompilerContext* ctx, const char* source, size_t length,
+                           const CompileOptions* options, OutputSink* asm_out, OutputSink* ir_out) {
+    reset_compiler_context(ctx);
+
+    /* Diagnostics are per thread - configure them for this compilation */
+    init_diagnostics(options->verbose, options->warnings_as_errors);
+    diag_config.show_warnings = options->show_warnings;
+    diag_config.log_file = options->log_file;
+    diag_config.log_level = options->log_level;
+
+    TimeReport* timing = options->time_report ? &ctx->timing : NULL;
+    PhaseMark mark;
+
+    /* Optimization pipeline: the level's passes, or the --passes list */
+    PassPipeline pipeline;
+    init_pass_pipeline(&pipeline, options->opt_level);
+    if (options->passes && parse_pass_pipeline(&pipeline, options->passes) != 0) {
+        return finish_compilation(ctx, 1);
+    }
+
+    /* ===================================================================
+     * PHASE 1 & 2: LEXICAL AND SYNTAX ANALYSIS
+     * The lexer (scanner) and parser work together during parsing
+     * ================================================================ */
+    print_phase_separator("PHASE 1 & 2: LEXICAL AND SYNTAX ANALYSIS");
+
+    /* Initialize symbol table before parsing */
+    ctx->symtab = create_symbol_table(100);
+
+    /* Run the parser (which calls the lexer) */
+    begin_phase(timing, &mark, "parse", 0);
+    int parse_result = parse_buffer(ctx, source, length);
+    end_phase(timing, &mark);
+
+    /* Check for syntax errors */
+    if (parse_result != 0 || ctx->syntax_errors > 0) {
+        fprintf(stderr, "\n[X] COMPILATION FAILED: Syntax errors detected\n");
+        fprintf(stderr, "[X] Please fix the errors and try again\n\n");
+        return finish_compilation(ctx, 1);
+    }
+
+    log_message(LOG_NORMAL, "[OK] Lexical analysis complete\n");
+    log_message(LOG_NORMAL, "[OK] Syntax analysis complete\n");
+    log_message(LOG_NORMAL, "[OK] Abstract Syntax Tree (AST) constructed\n\n");
+
+    /* ===================================================================
+     * PHASE 3: SEMANTIC ANALYSIS
+     * Type checking, variable declaration/initialization checking
+     * ================================================================ */
+    print_phase_separator("PHASE 3: SEMANTIC ANALYSIS");
+
+    begin_phase(timing, &mark, "semantic", 0);
+    ctx->semantic_errors = analyze_semantics(ctx->ast_root, ctx->symtab);
+    end_phase(timing, &mark);
+
+    if (ctx->semantic_errors > 0) {
+        fprintf(stderr, "\n[X] COMPILATION FAILED: Semantic errors detected\n");
+        fprintf(stderr, "[X] Please fix the errors and try again\n\n");
+        return finish_compilation(ctx, 1);
+    }
+
+    if (LOG_ENABLED(LOG_NORMAL)) {
+        print_semantic_summary();
+    }
+
+    /* Dumps are opt-in: printing them costs more than compiling a large file */
+    if (options->dump_ast) {
+        printf("=============== ABSTRACT SYNTAX TREE ==================\n\n");
+        print_ast(ctx->ast_root, 0);
+        printf("\n");
+    }
+
+    if (options->dump_symtab) {
+        printf("=================== SYMBOL TABLE ======================\n\n");
+        print_symbol_table(ctx->symtab);
+        printf("\n");
+    }
+
+    /* ===================================================================
+     * PHASE 4: INTERMEDIATE CODE GENERATION
+     * Generate Three-Address Code (TAC) from AST
+     * ================================================================ */
+    print_phase_separator("PHASE 4: INTERMEDIATE CODE GENERATION");
+
+    begin_phase(timing, &mark, "tac generation", 0);
+    TACCode* tac = generate_tac(ctx->ast_root);
+    end_phase(timing, &mark);
+
+    if (!tac) {
+        fprintf(stderr, "\n[X] COMPILATION FAILED: IR generation failed\n\n");
+        return finish_compilation(ctx, 1);
+    }
+
+    /* Print TAC before optimization */
+    if (options->dump_tac) {
+        print_tac(tac);
+    }
+
+    /* Save IR */
+    if (ir_out) {
+        begin_phase(timing, &mark, "ir output", 0);
+        write_tac(tac, ir_out);
+        end_phase(timing, &mark);
+    }
+
+    /* ===================================================================
+     * PHASE 4.5: SECURITY ANALYSIS
+     * Check for unsafe constructs and security vulnerabilities (on the
+     * unoptimized TAC, so every operation is still there to report)
+     * ================================================================ */
+    print_phase_separator("PHASE 4.5: SECURITY ANALYSIS");
+
+    begin_phase(timing, &mark, "security", 0);
+    SecurityCheckResults* security_results = analyze_security(ctx->ast_root, ctx->symtab, tac);
+    end_phase(timing, &mark);
+    if (LOG_ENABLED(LOG_NORMAL)) {
+        print_security_report(security_results);
+    }
+
+    /* Profile-guided optimization: counters go into the unoptimized TAC
+     * (MIPS code cannot write a profile), counts come back onto it */
+    Profile* profile = NULL;
+    if (options->profile_use) {
+        const char* path = options->profile_use[0] ? options->profile_use : "program" DEFAULT_PROFILE_SUFFIX;
+        Profile* counts = read_profile(path);
+        if (counts) {
+            apply_profile(tac, counts);
+            free_profile(counts);
+        }
+    }
+    if (options->profile_generate && !options->use_mips) {
+        const char* path = options->profile_generate[0] ? options->profile_generate : "program" DEFAULT_PROFILE_SUFFIX;
+        profile = instrument_tac(tac, path);
+    }
+
+    /* Runtime bounds checks also go into the unoptimized TAC (after the
+     * profile, so function checksums do not depend on them); the
+     * optimizer then drops the ones that can never fail */
+    if (options->bounds_check) {
+        insert_bounds_checks(tac, ctx->symtab);
+    }
+
+    /* ===================================================================
+     * PHASE 5: CODE OPTIMIZATION
+     * Optimize the intermediate representation
+     * ================================================================ */
+    print_phase_separator("PHASE 5: CODE OPTIMIZATION");
+
+    OptimizationStats opt_stats;
+    int emit_object = options->emit_object && !options->use_mips;
+    int interpret = options->interpret;
+    int machine_code = (emit_object || options->run_program) && !options->use_mips && !interpret;
+    UnitPipeline pipe;
+    memset(&pipe, 0, sizeof(pipe));
+    pipe.jobs = options->jobs;
+    pipe.use_mips = options->use_mips;
+    pipe.pipeline = &pipeline;
+
+    if (options->incremental && !options->profile_generate && !options->profile_use) {
+        /* Cached code depends on the target, the output kind, the comment
+         * mode, the vector instruction set and the passes (object and
+         * interpreter builds store no assembly) */
+        char passes[MAX_PIPELINE_PASSES * 12 + 32];
+        char config[sizeof(passes) + 40];
+        int vector_isa = options->use_mips || machine_code || interpret || options->opt_level < 2
+                             ? VECTOR_NONE : options->vectorize;
+        describe_pass_pipeline(&pipeline, passes, sizeof(passes));
+        snprintf(config, sizeof(config), "%s%s%s%s%s %s", options->use_mips ? "mips" : "x86-64",
+                 machine_code || interpret ? " obj" : "", options->asm_comments ? "" : " nocomments",
+                 options->bounds_check ? " bounds" : "",
+                 vector_isa == VECTOR_AVX2 ? " avx2" : vector_isa == VECTOR_SSE2 ? " sse2" : "", passes);
+        pipe.cache = open_compile_cache(options->cache_dir, config);
+    }
+    int per_unit = pipe.cache || options->jobs > 1;
+
+    begin_phase(timing, &mark, "optimization", 0);
+    set_optimizer_timing(timing);
+    if (per_unit) {
+        /* Optimize each top-level unit on its own (cached and/or in parallel) */
+        optimize_units(&pipe, tac, &opt_stats);
+    } else {
+        optimize_tac(tac, &pipeline, &opt_stats);
+    }
+    set_optimizer_timing(NULL);
+    end_phase(timing, &mark);
+    if (LOG_ENABLED(LOG_NORMAL)) {
+        print_optimization_stats(&opt_stats);
+    }
+
+    /* Print optimized TAC */
+    if (options->dump_tac) {
+        printf("=============== OPTIMIZED TAC ==================\n\n");
+        print_tac(tac);
+    }
+
+    /* ===================================================================
+     * PHASE 6: CODE GENERATION
+     * Generate assembly code from optimized TAC
+     * ================================================================ */
+    print_phase_separator(interpret ? "PHASE 6: BYTECODE GENERATION" : "PHASE 6: ASSEMBLY CODE GENERATION");
+
+    begin_phase(timing, &mark, "code generation", 0);
+    ElfCodeGenerator* elf_gen = NULL;
+    BytecodeProgram* bytecode = NULL;
+    int status = 0;
+    if (interpret) {
+        /* Lower to bytecode for the interpreter; no assembly is written */
+        bytecode = lower_to_bytecode(tac, ctx->symtab);
+        if (!bytecode) {
+            status = 1;
+        } else if (options->dump_tac) {
+            print_bytecode(bytecode, stdout);
+        }
+        if (per_unit) {
+            store_units(&pipe);
+        }
+    } else if (machine_code) {
+        /* Encode x86-64 machine code into an ELF object (one pass over the
+         * whole program, since jumps and calls are resolved at the end) */
+        elf_gen = create_elf_code_generator(ctx->symtab);
+        elf_gen->profile = profile;
+        elf_gen->bounds_checks = options->bounds_check;
+        generate_elf_code(elf_gen, tac);
+        if (emit_object) {
+            write_elf_object(elf_gen->object, asm_out);
+        }
+        if (per_unit) {
+            store_units(&pipe);
+        }
+    } else if (options->use_mips) {
+        /* Generate MIPS assembly */
+        MIPSCodeGenerator* mips_gen = create_mips_code_generator(asm_out, ctx->symtab, options->asm_comments);
+        mips_gen->bounds_checks = options->bounds_check;
+        if (per_unit) {
+            pipe.gen = mips_gen;
+            gen_mips_prologue(mips_gen);
+            generate_units(&pipe, tac, asm_out);
+            gen_mips_epilogue(mips_gen);
+        } else {
+            generate_mips_assembly(mips_gen, tac);
+        }
+        close_mips_code_generator(mips_gen);
+    } else {
+        /* Generate x86-64 assembly */
+        CodeGenerator* codegen = create_code_generator(asm_out, ctx->symtab, options->asm_comments);
+        codegen->profile = profile;
+        codegen->bounds_checks = options->bounds_check;
+        codegen->vector_isa = options->opt_level >= 2 ? options->vectorize : VECTOR_NONE;
+        if (per_unit) {
+            pipe.gen = codegen;
+            gen_prologue(codegen);
+            generate_units(&pipe, tac, asm_out);
+            gen_epilogue(codegen);
+        } else {
+            generate_assembly(codegen, tac);
+        }
+        close_code_generator(codegen);
+    }
+    end_phase(timing, &mark);
+
+    if (pipe.cache) {
+        log_message(LOG_NORMAL, "[CACHE] %d function(s) reused, %d recompiled (cache: %s)\n\n",
+               pipe.cache->hits, pipe.cache->misses, pipe.cache->dir);
+    }
+
+    if (status != 0) {
+        fprintf(stderr, "\n[X] COMPILATION FAILED: Bytecode lowering failed\n\n");
+        free_tac(tac);
+        free_security_results(security_results);
+        free_unit_pipeline(&pipe);
+        free_profile(profile);
+        return finish_compilation(ctx, 1);
+    }
+
+    /* ===================================================================
+     * COMPILATION COMPLETE
+     * ================================================================ */
+    print_summary(1);
+
+    log_message(LOG_NORMAL, "[OK] Compilation successful!\n");
+
+    /* ===================================================================
+     * PHASE 7: EXECUTION (--run / --interp)
+     * Load the machine code into this process and call main, or
+     * interpret the bytecode
+     * ================================================================ */
+    if (bytecode) {
+        print_phase_separator("PHASE 7: PROGRAM EXECUTION (INTERPRETER)");
+        fflush(stdout);
+
+        InterpResult run;
+        begin_phase(timing, &mark, "run", 0);
+        status = run_bytecode(bytecode, &run);
+        end_phase(timing, &mark);
+        if (status == 0) {
+            ctx->exit_code = run.exit_code;
+            ctx->run_ms = run.run_ms;
+            log_message(LOG_NORMAL, "\n[INTERP] main returned %lld (exit code %d) in %.3f ms (%lld instructions)\n\n",
+                        run.return_value, run.exit_code, run.run_ms, run.instructions);
+            if (profile && write_profile(profile, bytecode->counters, bytecode->counter_count) != 0) {
+                status = 1;
+            }
+        }
+    } else if (options->run_program && elf_gen) {
+        print_phase_separator("PHASE 7: PROGRAM EXECUTION (JIT)");
+        fflush(stdout);
+
+        JitResult run;
+        begin_phase(timing, &mark, "run", 0);
+        status = jit_run(elf_gen->object, &run);
+        end_phase(timing, &mark);
+        if (status == 0) {
+            ctx->exit_code = run.exit_code;
+            ctx->run_ms = run.run_ms;
+            log_message(LOG_NORMAL, "\n[RUN] main returned %ld (exit code %d) in %.3f ms\n\n",
+                        run.return_value, run.exit_code, run.run_ms);
+        }
+    }
+
+    /* Cleanup (the AST and symbol table stay with the context) */
+    close_elf_code_generator(elf_gen);
+    free_bytecode(bytecode);
+    free_tac(tac);
+    free_security_results(security_results);
+    free_unit_pipeline(&pipe);
+    free_profile(profile);
+
+    return finish_compilation(ctx, status);
+}
+
+/* Helper: read a whole source file into memory */
+static char* read_source_file(const char* filename, size_t* length) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+
+    char* text = (char*)safe_malloc(size > 0 ? size + 1 : 1, "source buffer");
+    *length = size > 0 ? fread(text, 1, size, file) : 0;
+    text[*length] = '\0';
+
+    fclose(file);
+    return text;
+}
+
+/* Compile a source buffer; returns 0 on success, 1 on failure */
+int compile_buffer(CompilerContext* ctx, const char* source, size_t length,
+                   const CompileOptions* options, OutputSink* asm_out, OutputSink* ir_out) {
+    ThreadState caller;
+    save_thread_state(&caller);
+
+    int status = run_compilation(ctx, source, length, options, asm_out, ir_out);
+    ctx->alloc_stats.bytes = alloc_stats.bytes - caller.alloc_stats.bytes;
+    ctx->alloc_stats.count = alloc_stats.count - caller.alloc_stats.count;
+
+    restore_thread_state(&caller);
+    return status;
+}
+
+/* Helper: compile_file() with the caller's state put aside */
+static int compile_source_file(CompilerContext* ctx, const char* input_filename,
+                               const char* output_filename, const char* ir_filename,
+                               const CompileOptions* options) {
+    size_t length;
+    char* source = read_source_file(input_filename, &length);
+    if (!source) {
+        fprintf(stderr, "Error: Cannot open input file '%s'\n", input_filename);
+        return 1;
+    }
+
+    /* Progress output follows this compilation's options */
+    diag_config.log_level = options->log_level;
+
+    log_message(LOG_NORMAL, "Input file: %s\n", input_filename);
+    log_message(LOG_NORMAL, "Output file: %s\n", output_filename ? output_filename : "(none)");
+    log_message(LOG_NORMAL, "Target: %s\n\n", options->use_mips ? "MIPS (QtSpim/MARS)" :
+                options->interpret ? "bytecode interpreter" :
+                options->run_program ? "x86-64 (in-process JIT)" :
+                options->emit_object ? "x86-64 (ELF64 object)" : "x86-64 (NASM)");
+
+    /* Profiles default to the source file's name with .profile */
+    CompileOptions file_options = *options;
+    char generate_path[1024];
+    char use_path[1024];
+    if (options->profile_generate && !options->profile_generate[0]) {
+        default_profile_path(generate_path, sizeof(generate_path), input_filename);
+        file_options.profile_generate = generate_path;
+    }
+    if (options->profile_use && !options->profile_use[0]) {
+        default_profile_path(use_path, sizeof(use_path), input_filename);
+        file_options.profile_use = use_path;
+    }
+
+    OutputSink* asm_out = create_buffer_sink();
+    OutputSink* ir_out = ir_filename ? create_buffer_sink() : NULL;
+
+    int status = compile_buffer(ctx, source, length, &file_options, asm_out, ir_out);
+    free(source);
+
+    TimeReport* timing = options->time_report ? &ctx->timing : NULL;
+    PhaseMark mark;
+    begin_phase(timing, &mark, "write output", 0);
+
+    /* Save the IR whenever it was generated */
+    if (ir_out && ir_out->length > 0) {
+        if (save_sink(ir_out, ir_filename) == 0) {
+            log_message(LOG_NORMAL, "[OK] Intermediate code saved to: %s\n\n", ir_filename);
+        } else {
+            fprintf(stderr, "Warning: Cannot write IR file '%s'\n", ir_filename);
+        }
+    }
+    close_sink(ir_out);
+
+    if (status == 0 && output_filename && save_sink(asm_out, output_filename) != 0) {
+        fprintf(stderr, "Error: Cannot write output file '%s'\n", output_filename);
+        status = 1;
+    }
+    close_sink(asm_out);
+    end_phase(timing, &mark);
+
+    if (options->time_report == TIME_REPORT_JSON) {
+        write_time_report_json(&ctx->timing, input_filename, stdout);
+    } else if (options->time_report == TIME_REPORT_TABLE) {
+        print_time_report(&ctx->timing, input_filename, stdout);
+    }
+
+    if (status != 0) {
+        return status;
+    }
+
+    if (!output_filename) {
+        /* Nothing written (the program was run in-process or interpreted) */
+    } else if (options->use_mips) {
+        log_message(LOG_NORMAL, "[OK] Assembly code written to: %s\n\n", output_filename);
+        log_message(LOG_NORMAL, "To run on QtSpim or MARS:\n");
+        log_message(LOG_NORMAL, "  1. Open %s in QtSpim or MARS simulator\n", output_filename);
+        log_message(LOG_NORMAL, "  2. Assemble and run the program\n\n");
+    } else if (options->emit_object) {
+        log_message(LOG_NORMAL, "[OK] Object file written to: %s\n\n", output_filename);
+        log_message(LOG_NORMAL, "To link (on Linux):\n");
+        log_message(LOG_NORMAL, "  gcc %s -o program\n", output_filename);
+        log_message(LOG_NORMAL, "  ./program\n\n");
+    } else {
+        log_message(LOG_NORMAL, "[OK] Assembly code written to: %s\n\n", output_filename);
+        log_message(LOG_NORMAL, "To assemble and link (on Linux):\n");
+        log_message(LOG_NORMAL, "  nasm -f elf64 %s -o output.o\n", output_filename);
+        log_message(LOG_NORMAL, "  gcc output.o -o program -no-pie\n");
+        log_message(LOG_NORMAL, "  ./program\n\n");
+    }
+
+    /* ===================================================================
+     * FINAL DIAGNOSTICS
+     * ================================================================ */
+    if (LOG_ENABLED(LOG_NORMAL)) {
+        print_diagnostic_summary();
+    }
+
+    return 0;
+}
+
+/* Compile one source file; returns 0 on success, 1 on failure */
+int compile_file(CompilerContext* ctx, const char* input_filename,
+                 const char* output_filename, const char* ir_filename,
+                 const CompileOptions* options) {
+    ThreadState caller;
+    save_thread_state(&caller);
+
+    int status = compile_source_file(ctx, input_filename, output_filename, ir_filename, options);
+
+    restore_thread_state(&caller);
+    return status;
+}
+
+/* Helper: add one unit's optimization counts to the totals */
+static void add_stats(OptimizationStats* total, const OptimizationStats* unit) {
+    total->constant_folds += unit->constant_folds;
+    total->dead_code_eliminated += unit->dead_code_eliminated;
+    total->copy_propagations += unit->copy_propagations;
+    total->peephole_opts += unit->peephole_opts;
+    total->total_optimizations += unit->total_optimizations;
+    if (unit->iterations > total->iterations) {
+        total->iterations = unit->iterations;
+    }
+    total->worklist_visits += unit->worklist_visits;
+    total->worklist_ms += unit->worklist_ms;
+    for (int p = 0; p < PASS_COUNT; p++) {
+        total->passes[p].runs += unit->passes[p].runs;
+        total->passes[p].changes += unit->passes[p].changes;
+        total->passes[p].ms += unit->passes[p].ms;
+    }
+    for (int a = 0; a < ANALYSIS_COUNT; a++) {
+        total->analyses_computed[a] += unit->analyses_computed[a];
+    }
+}
+
+/* Worker: optimize one unit (units reused from the cache are skipped).
+ * Per-pass messages would interleave across threads, so workers are quiet
+ * and the results are summarized afterwards. */
+static void optimize_unit_worker(void* context, int index) {
+    UnitPipeline* pipe = (UnitPipeline*)context;
+
+    set_optimizer_logging(pipe->jobs <= 1);
+    if (!pipe->from_cache[index] && pipe->parts[index]->head) {
+        optimize_tac(pipe->parts[index], pipe->pipeline, &pipe->stats[index]);
+    }
+}
+
+/* Per-unit optimization: split the program into top-level units, reuse
+ * cached functions and optimize everything else (on pipe->jobs threads) */
+static void optimize_units(UnitPipeline* pipe, TACCode* tac, OptimizationStats* total) {
+    int count;
+    pipe->parts = split_tac_units(tac, &count);
+    pipe->units = tac->units;
+    pipe->unit_count = count;
+    pipe->keys = (Fingerprint*)safe_calloc(count + 1, sizeof(Fingerprint), "unit pipeline");
+    pipe->from_cache = (int*)safe_calloc(count + 1, sizeof(int), "unit pipeline");
+    pipe->asm_text = (char**)safe_calloc(count + 1, sizeof(char*), "unit pipeline");
+    pipe->stats = (OptimizationStats*)safe_calloc(count + 1, sizeof(OptimizationStats),
+                                                  "unit pipeline");
+
+    /* Take cached functions in place of their fresh units */
+    for (int i = 0; pipe->cache && i < count; i++) {
+        TACUnit* unit = &pipe->units[i];
+        if (unit->node->type != NODE_FUNCTION_DEF) continue;
+
+        pipe->keys[i] = fingerprint_function(pipe->cache, unit->node);
+        CacheEntry* entry = cache_lookup(pipe->cache, pipe->keys[i], unit);
+        if (!entry) continue;
+
+        log_message(LOG_VERBOSE, "[CACHE] Reusing function '%s'\n", unit->node->data.function.func_name);
+        free_tac(pipe->parts[i]);
+        pipe->parts[i] = entry->tac;
+        pipe->asm_text[i] = entry->asm_text;
+        pipe->stats[i] = entry->stats;
+        pipe->from_cache[i] = 1;
+        entry->tac = NULL;
+        entry->asm_text = NULL;
+        free_cache_entry(entry);
+    }
+
+    /* Units are independent, so they can be optimized concurrently */
+    if (pipe->jobs > 1) {
+        log_message(LOG_NORMAL, "[OPTIMIZER] Optimizing %d units on %d threads\n", count, pipe->jobs);
+    }
+    run_parallel(pipe->jobs, count, optimize_unit_worker, pipe);
+    set_optimizer_logging(1);
+
+    memset(total, 0, sizeof(*total));
+    for (int i = 0; i < count; i++) {
+        add_stats(total, &pipe->stats[i]);
+
+        if (pipe->jobs > 1 && pipe->units[i].node->type == NODE_FUNCTION_DEF &&
+            !pipe->from_cache[i]) {
+            log_message(LOG_VERBOSE, "[OPTIMIZER] Function '%s': %d optimizations applied\n",
+                        pipe->units[i].node->data.function.func_name,
+                        pipe->stats[i].total_optimizations);
+        }
+    }
+
+    join_tac_units(tac, pipe->parts, count);
+    pipe->parts = NULL;
+}
+
+/* Worker: translate one unit into its own assembly buffer */
+static void generate_unit_worker(void* context, int index) {
+    UnitPipeline* pipe = (UnitPipeline*)context;
+    TACUnit* unit = &pipe->units[index];
+
+    if (pipe->from_cache[index] || !unit->first) return;
+
+    OutputSink* scratch = create_buffer_sink();
+
+    /* Private generator copy so each worker writes to its own buffer */
+    CodeGenerator x86_gen;
+    MIPSCodeGenerator mips_gen;
+    if (pipe->use_mips) {
+        mips_gen = *(MIPSCodeGenerator*)pipe->gen;
+        mips_gen.emit.out = scratch;
+    } else {
+        copy_code_generator(&x86_gen, (CodeGenerator*)pipe->gen, scratch);
+    }
+
+    for (TACInstruction* inst = unit->first; inst; inst = inst->next) {
+        if (pipe->use_mips) {
+            gen_mips_instruction(&mips_gen, inst);
+        } else {
+            gen_tac_instruction(&x86_gen, inst);
+        }
+        if (inst == unit->last) break;
+    }
+    if (!pipe->use_mips) {
+        release_code_generator_copy(&x86_gen);
+    }
+
+    char* text = take_sink_text(scratch, NULL);
+    close_sink(scratch);
+
+    pipe->asm_text[index] = text;
+}
+
+/* Per-unit code generation: translate the units that were not reused
+ * (on pipe->jobs threads), then write every unit in source order and store
+ * newly compiled functions in the cache */
+static void generate_units(UnitPipeline* pipe, TACCode* tac, OutputSink* output) {
+    if (pipe->jobs > 1) {
+        log_message(LOG_NORMAL, "[CODEGEN] Generating %d units on %d threads\n", pipe->unit_count, pipe->jobs);
+    }
+    run_parallel(pipe->jobs, pipe->unit_count, generate_unit_worker, pipe);
+
+    for (int i = 0; i < pipe->unit_count; i++) {
+        if (pipe->asm_text[i]) sink_puts(output, pipe->asm_text[i]);
+    }
+    store_units(pipe);
+    log_message(LOG_NORMAL, "Assembly code generated for %d instructions\n", tac->instruction_count);
+}
+
+/* Store newly compiled functions in the cache (with no assembly text when
+ * the code went into an object file) */
+static void store_units(UnitPipeline* pipe) {
+    if (!pipe->cache) return;
+
+    for (int i = 0; i < pipe->unit_count; i++) {
+        if (pipe->from_cache[i] || pipe->units[i].node->type != NODE_FUNCTION_DEF ||
+            !pipe->units[i].first) continue;
+        cache_store(pipe->cache, pipe->keys[i], &pipe->units[i],
+                    pipe->asm_text[i] ? pipe->asm_text[i] : "", &pipe->stats[i]);
+    }
+}
+
+/* Release per-unit compilation state */
+static void free_unit_pipeline(UnitPipeline* pipe) {
+    if (pipe->asm_text) {
+        for (int i = 0; i < pipe->unit_count; i++) {
+            free(pipe->asm_text[i]);
+        }
+    }
+    free(pipe->asm_text);
+    free(pipe->keys);
+    free(pipe->from_cache);
+    free(pipe->stats);
+    close_compile_cache(pipe->cache);
+}
+
+/* Print phase separator */
+static void print_phase_separator(const char* phase_name) {
+    if (!LOG_ENABLED(LOG_NORMAL)) return;
+
+    printf("+============================================================+\n");
+    printf("| %-57s |\n", phase_name);
+    printf("+============================================================+\n\n");
+}
+
+/* Print compilation summary */
+static void print_summary(int success) {
+    if (!LOG_ENABLED(LOG_NORMAL)) return;
+
+    printf("+============================================================+\n");
+    printf("|                   COMPILATION SUMMARY                     |\n");
+    printf("+============================================================+\n");
+
+    if (success) {
+        printf("|  Status:           [OK] SUCCESS                           |\n");
+        printf("|  Lexical errors:   0                                      |\n");
+        printf("|  Syntax errors:    0                                      |\n");
+        printf("|  Semantic errors:  0                                      |\n");
+        printf("|  Optimization:     Enabled                                |\n");
+        printf("|  Code generated:   Yes                                    |\n");
+    } else {
+        printf("|  Status:           [X] FAILED                             |\n");
+    }
+
+    printf("+============================================================+\n\n");
+}
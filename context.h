@@ -0,0 +1,120 @@
+/*
+ * CONTEXT.H - Compiler Library API
+ * CST-405 Compiler Project
+ *
+ * This file exposes the complete compiler (parsing through code generation)
+ * as a library call. Everything a compilation produces - the AST, the symbol
+ * table, the scanner position and the error counts - lives in a
+ * CompilerContext instead of in globals, and the parser and scanner are
+ * reentrant, so a long-running process can compile many programs one after
+ * another or concurrently on different threads (one context per thread).
+ *
+ * The diagnostics settings and counters (diagnostics.h) and the parser's
+ * line number (ast.h) remain per-thread globals that the whole compiler
+ * reads. compile_buffer() and compile_file() put the calling thread's
+ * values aside, run the compilation with values of its own and restore
+ * the caller's before returning; the compilation's counts are left in the
+ * context. Contexts used in turn on one thread therefore stay independent,
+ * and the caller's settings survive. Only the allocation counters are
+ * shared: they keep counting for the caller.
+ */
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ast.h"
+#include "symtable.h"
+#include "diagnostics.h"
+#include "output.h"
+#include "timing.h"
+
+/* Options for one compilation */
+typedef struct {
+    int use_mips;                 /* Target MIPS instead of x86-64 */
+    int verbose;                  /* Verbose output */
+    int warnings_as_errors;       /* Treat warnings as errors */
+    int show_warnings;            /* Show warning messages */
+    int incremental;              /* Reuse unchanged functions from the cache */
+    const char* cache_dir;        /* Cache directory for incremental builds */
+    int jobs;                     /* Worker threads for optimization/code generation */
+    int opt_level;                /* Optimization level 0-3 (-O<n>) */
+    const char* passes;           /* Custom pass list (--passes=a,b,c; NULL = level default) */
+    int asm_comments;             /* Annotate the generated assembly with comments */
+    int emit_object;              /* Write an x86-64 ELF object instead of assembly */
+    int run_program;              /* Run the program in-process after compiling (x86-64) */
+    int interpret;                /* Run the program on the bytecode interpreter instead of generating code */
+    const char* profile_generate; /* Instrument the program to write this profile (NULL = no; "" = <source>.profile) */
+    const char* profile_use;      /* Optimize with the counts of this profile (NULL = no; "" = <source>.profile) */
+    int bounds_check;             /* Check array indexes at run time (--bounds-check) */
+    int vectorize;                /* Loop vectorization at -O2 and up (VectorISA: SSE2, --avx2, --no-vectorize) */
+    int log_level;                /* Console progress output (LogLevel) */
+    int dump_ast;                 /* Print the AST after semantic analysis */
+    int dump_tac;                 /* Print the TAC before and after optimization */
+    int dump_symtab;              /* Print the symbol table */
+    int time_report;              /* Per-phase time/memory report (TIME_REPORT_*) */
+    FILE* log_file;               /* Diagnostic log shared by all compilations (NULL = none) */
+} CompileOptions;
+
+/* Compilation context - the state of one compilation */
+typedef struct CompilerContext {
+    ASTNode* ast_root;            /* Root of the parsed program */
+    SymbolTable* symtab;          /* Symbol table */
+
+    int line_num;                 /* Scanner position: current line */
+    int col_num;                  /* Scanner position: current column */
+    int char_count;               /* Scanner position: characters read */
+
+    int syntax_errors;            /* Syntax errors reported by the parser */
+    int semantic_errors;          /* Semantic errors found */
+    DiagnosticStats diag_stats;   /* Diagnostics reported during the compilation */
+    AllocationStats alloc_stats;  /* Heap allocations the compilation made on this thread */
+    TimeReport timing;            /* Phase measurements (when options->time_report is set) */
+    int exit_code;                /* Exit status of the program (run_program, interpret) */
+    double run_ms;                /* Time the program ran (run_program, interpret) */
+} CompilerContext;
+
+/* LIBRARY FUNCTIONS */
+
+/* Set compile options to their defaults (x86-64, -O2, SSE2 loop
+ * vectorization, warnings on, one job, commented assembly, phase banners
+ * but no dumps) */
+void init_compile_options(CompileOptions* options);
+
+/* Create an empty compilation context */
+CompilerContext* create_compiler_context(void);
+
+/* Release the AST and symbol table of the last compilation and reset the
+ * context for the next one */
+void reset_compiler_context(CompilerContext* ctx);
+
+/* Free a compilation context and everything it holds */
+void free_compiler_context(CompilerContext* ctx);
+
+/* Compile length bytes of source text, writing the assembly (or with
+ * emit_object the object file bytes) to asm_out and the unoptimized TAC to
+ * ir_out (may be NULL). With run_program the program is then executed and
+ * its exit status stored in ctx->exit_code; with interpret no code is
+ * generated and the program runs on the bytecode interpreter instead.
+ * profile_generate instruments the program (an interpreted program writes
+ * its profile when it finishes) and profile_use reads a profile back into
+ * the optimizer. bounds_check adds runtime array bounds checks. The
+ * context is reset first;
+ * afterwards it holds the AST, symbol table and error counts of this
+ * compilation. Returns 0 on success, 1 on failure. */
+int compile_buffer(CompilerContext* ctx, const char* source, size_t length,
+                   const CompileOptions* options, OutputSink* asm_out, OutputSink* ir_out);
+
+/* Compile a source file into an assembly or object file (none if
+ * output_filename is NULL) and (if ir_filename is not NULL) an IR file. Output is collected in memory and each file is written
+ * in one go. Returns 0 on success, 1 on failure. */
+int compile_file(CompilerContext* ctx, const char* input_filename,
+                 const char* output_filename, const char* ir_filename,
+                 const CompileOptions* options);
+
+/* Parse source text into ctx->ast_root with a private reentrant scanner
+ * (defined in scanner_new.l). Returns 0 on success. */
+int parse_buffer(CompilerContext* ctx, const char* source, size_t length);
+
+#endif /* CONTEXT_H */
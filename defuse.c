@@ -0,0 +1,200 @@
+/*
+ * DEFUSE.C - Def-Use and Use-Def Chains Implementation
+ * CST-405 Compiler Project
+ *
+ * Each operand slot of an instruction owns at most one DefUseLink, found
+ * through inst->chain[slot], and the link sits in a doubly linked list on
+ * its variable. Linking and unlinking an instruction are therefore O(1),
+ * and links are recycled through a free list instead of going back to
+ * malloc on every rewrite.
+ */
+
+#include "defuse.h"
+#include "diagnostics.h"
+#include <string.h>
+
+#define LINK_BLOCK_SIZE 256
+
+/* Helper: FNV-1a hash of a name */
+static unsigned hash_name(const char* name) {
+    unsigned hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+/* Helper: slot of name in the table (empty slot if it is not there) */
+static int table_slot(const DefUseChains* chains, const char* name) {
+    unsigned mask = (unsigned)chains->table_size - 1;
+    unsigned slot = hash_name(name) & mask;
+    while (chains->table[slot] && strcmp(chains->table[slot]->name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return (int)slot;
+}
+
+/* Helper: value for a name, created on first reference */
+static ChainValue* intern_value(DefUseChains* chains, const char* name) {
+    int slot = table_slot(chains, name);
+    if (chains->table[slot]) return chains->table[slot];
+
+    /* Keep the table at most half full */
+    if ((chains->value_count + 1) * 2 > chains->table_size) {
+        ChainValue** old = chains->table;
+        int old_size = chains->table_size;
+        chains->table_size *= 2;
+        chains->table = (ChainValue**)safe_calloc(chains->table_size, sizeof(ChainValue*), "def-use table");
+        for (int i = 0; i < old_size; i++) {
+            if (old[i]) chains->table[table_slot(chains, old[i]->name)] = old[i];
+        }
+        free(old);
+        slot = table_slot(chains, name);
+    }
+
+    if (chains->value_count == chains->value_capacity) {
+        chains->value_capacity *= 2;
+        chains->values = (ChainValue**)safe_realloc(chains->values, chains->value_capacity * sizeof(ChainValue*),
+                                                    "def-use values");
+    }
+
+    ChainValue* value = (ChainValue*)safe_calloc(1, sizeof(ChainValue), "def-use value");
+    value->name = safe_strdup(name, "def-use value");
+    value->id = chains->value_count;
+    chains->values[chains->value_count++] = value;
+    chains->table[slot] = value;
+    return value;
+}
+
+/* Helper: take a link from the free list, refilling it a block at a time */
+static DefUseLink* new_link(DefUseChains* chains) {
+    if (!chains->free_links) {
+        DefUseLink* block = (DefUseLink*)safe_calloc(LINK_BLOCK_SIZE, sizeof(DefUseLink), "def-use links");
+        chains->link_blocks = (DefUseLink**)safe_realloc(chains->link_blocks,
+                                                         (chains->link_block_count + 1) * sizeof(DefUseLink*),
+                                                         "def-use links");
+        chains->link_blocks[chains->link_block_count++] = block;
+        for (int i = 0; i < LINK_BLOCK_SIZE; i++) {
+            block[i].next = chains->free_links;
+            chains->free_links = &block[i];
+        }
+    }
+
+    DefUseLink* link = chains->free_links;
+    chains->free_links = link->next;
+    return link;
+}
+
+/* Helper: put a reference to name on its value's definition or use list */
+static void add_link(DefUseChains* chains, TACInstruction* inst, int slot, const char* name) {
+    ChainValue* value = intern_value(chains, name);
+    DefUseLink* link = new_link(chains);
+    DefUseLink** list = slot == TAC_SLOT_RESULT ? &value->defs : &value->uses;
+
+    link->inst = inst;
+    link->slot = slot;
+    link->value = value;
+    link->prev = NULL;
+    link->next = *list;
+    if (*list) (*list)->prev = link;
+    *list = link;
+
+    if (slot == TAC_SLOT_RESULT) {
+        value->def_count++;
+    } else {
+        value->use_count++;
+    }
+    inst->chain[slot] = link;
+}
+
+/* Add the references of inst */
+void link_tac_chains(DefUseChains* chains, TACInstruction* inst) {
+    const char* def = tac_def(inst);
+    if (def) add_link(chains, inst, TAC_SLOT_RESULT, def);
+
+    int slots[2];
+    int count = tac_use_slots(inst, slots);
+    for (int i = 0; i < count; i++) {
+        add_link(chains, inst, slots[i], *tac_slot(inst, slots[i]));
+    }
+}
+
+/* Drop the references of inst */
+void unlink_tac_chains(DefUseChains* chains, TACInstruction* inst) {
+    for (int slot = 0; slot < TAC_SLOT_COUNT; slot++) {
+        DefUseLink* link = inst->chain[slot];
+        if (!link) continue;
+
+        ChainValue* value = link->value;
+        DefUseLink** list = slot == TAC_SLOT_RESULT ? &value->defs : &value->uses;
+        if (link->prev) {
+            link->prev->next = link->next;
+        } else {
+            *list = link->next;
+        }
+        if (link->next) link->next->prev = link->prev;
+
+        if (slot == TAC_SLOT_RESULT) {
+            value->def_count--;
+        } else {
+            value->use_count--;
+        }
+        inst->chain[slot] = NULL;
+        link->next = chains->free_links;
+        chains->free_links = link;
+    }
+}
+
+/* Build the chains for a TAC list */
+DefUseChains* build_def_use_chains(TACCode* code) {
+    DefUseChains* chains = (DefUseChains*)safe_calloc(1, sizeof(DefUseChains), "def-use chains");
+    chains->table_size = 256;
+    chains->table = (ChainValue**)safe_calloc(chains->table_size, sizeof(ChainValue*), "def-use table");
+    chains->value_capacity = 128;
+    chains->values = (ChainValue**)safe_calloc(chains->value_capacity, sizeof(ChainValue*), "def-use values");
+
+    for (TACInstruction* inst = code->head; inst; inst = inst->next) {
+        link_tac_chains(chains, inst);
+    }
+    return chains;
+}
+
+/* Free the chains */
+void free_def_use_chains(DefUseChains* chains) {
+    if (!chains) return;
+
+    for (int v = 0; v < chains->value_count; v++) {
+        ChainValue* value = chains->values[v];
+        for (DefUseLink* link = value->defs; link; link = link->next) link->inst->chain[link->slot] = NULL;
+        for (DefUseLink* link = value->uses; link; link = link->next) link->inst->chain[link->slot] = NULL;
+        free(value->name);
+        free(value);
+    }
+    for (int b = 0; b < chains->link_block_count; b++) {
+        free(chains->link_blocks[b]);
+    }
+    free(chains->link_blocks);
+    free(chains->values);
+    free(chains->table);
+    free(chains);
+}
+
+/* Value for a name */
+ChainValue* find_chain_value(const DefUseChains* chains, const char* name) {
+    return chains->table[table_slot(chains, name)];
+}
+
+/* Value an operand slot refers to */
+ChainValue* operand_value(const TACInstruction* inst, int slot) {
+    return inst->chain[slot] ? inst->chain[slot]->value : NULL;
+}
+
+/* The definition of a value if it has exactly one */
+TACInstruction* single_definition(const ChainValue* value) {
+    return value && value->def_count == 1 ? value->defs->inst : NULL;
+}
+
+/* Use-def: the one definition reaching an operand */
+TACInstruction* reaching_definition(const TACInstruction* inst, int slot) {
+    return single_definition(operand_value(inst, slot));
+}
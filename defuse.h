@@ -0,0 +1,86 @@
+/*
+ * DEFUSE.H - Def-Use and Use-Def Chains
+ * CST-405 Compiler Project
+ *
+ * This file links every operand of a TAC list to the variable it names.
+ * For each variable the chains hold the instructions that write it
+ * (definitions) and the operands that read it (uses); from an operand the
+ * chain leads back to the variable and, when it has one writer, to that
+ * definition. Passes that rewrite an instruction unlink it first and link
+ * it again afterwards, so the chains stay exact while the optimizer runs
+ * and a pass can visit all uses of a value without scanning the list.
+ *
+ * Variables are counted per name, like the rest of the optimizer: a
+ * temporary has one definition, a user variable may have many and then
+ * no single definition reaches its uses.
+ */
+
+#ifndef DEFUSE_H
+#define DEFUSE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ircode.h"
+#include "cfg.h"
+
+struct ChainValue;
+
+/* One reference to a variable - a definition or a use */
+typedef struct DefUseLink {
+    TACInstruction* inst;         /* Instruction holding the reference */
+    int slot;                     /* TAC_SLOT_RESULT (definition) or TAC_SLOT_OP1/OP2 (use) */
+    struct ChainValue* value;     /* Variable referenced */
+    struct DefUseLink* prev;      /* Other references of the same kind */
+    struct DefUseLink* next;
+} DefUseLink;
+
+/* A variable and all references to it */
+typedef struct ChainValue {
+    char* name;                   /* Variable name (owned copy) */
+    int id;                       /* Dense number (0 .. value_count-1) */
+    int def_count;                /* Instructions that write it */
+    int use_count;                /* Operands that read it */
+    DefUseLink* defs;             /* Definitions (unordered) */
+    DefUseLink* uses;             /* Uses (unordered) */
+} ChainValue;
+
+/* Chains over one TAC list */
+typedef struct {
+    ChainValue** table;           /* Open-addressing map name -> value */
+    int table_size;               /* Slots in table (power of two) */
+    ChainValue** values;          /* Values by id */
+    int value_count;              /* Number of values */
+    int value_capacity;
+    DefUseLink* free_links;       /* Recycled links */
+    DefUseLink** link_blocks;     /* Link storage, freed with the chains */
+    int link_block_count;
+} DefUseChains;
+
+/* CHAIN FUNCTIONS */
+
+/* Build the chains for every instruction in code */
+DefUseChains* build_def_use_chains(TACCode* code);
+
+/* Free the chains and clear the chain pointers of linked instructions */
+void free_def_use_chains(DefUseChains* chains);
+
+/* Add the references of inst (after it was created or rewritten) */
+void link_tac_chains(DefUseChains* chains, TACInstruction* inst);
+
+/* Drop the references of inst (before it is rewritten or removed) */
+void unlink_tac_chains(DefUseChains* chains, TACInstruction* inst);
+
+/* Value for a name (NULL if no instruction references it) */
+ChainValue* find_chain_value(const DefUseChains* chains, const char* name);
+
+/* Value an operand slot of inst refers to (NULL if none) */
+ChainValue* operand_value(const TACInstruction* inst, int slot);
+
+/* The definition of a value if it has exactly one (NULL otherwise) */
+TACInstruction* single_definition(const ChainValue* value);
+
+/* Use-def: the one definition that reaches an operand of inst, if the
+ * operand's variable has a single definition (NULL otherwise) */
+TACInstruction* reaching_definition(const TACInstruction* inst, int slot);
+
+#endif /* DEFUSE_H */
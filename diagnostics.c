@@ -6,19 +6,23 @@
 #include "diagnostics.h"
 #include <time.h>
 
-/* Global diagnostic configuration */
-DiagnosticConfig diag_config = {
+/* Diagnostic configuration (per thread) */
+THREAD_LOCAL DiagnosticConfig diag_config = {
     .verbose_mode = 0,
     .warnings_as_errors = 0,
     .show_warnings = 1,
     .show_notes = 0,
     .color_output = 0,
     .max_errors = 10,
-    .log_file = NULL
+    .log_file = NULL,
+    .log_level = LOG_NORMAL
 };
 
-/* Global diagnostic statistics */
-DiagnosticStats diag_stats = {0, 0, 0, 0};
+/* Diagnostic statistics (per thread) */
+THREAD_LOCAL DiagnosticStats diag_stats = {0, 0, 0, 0};
+
+/* Allocation counters (per thread) */
+THREAD_LOCAL AllocationStats alloc_stats = {0, 0};
 
 /* ANSI color codes (if supported) */
 #define COLOR_RESET   "\033[0m"
@@ -203,6 +207,16 @@ void diag_security_warning(int line, int col, const char* format, ...) {
     va_end(args);
 }
 
+/* Print a progress message */
+void log_message(LogLevel level, const char* format, ...) {
+    if (!LOG_ENABLED(level)) return;
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
 /* Print diagnostic summary */
 void print_diagnostic_summary(void) {
     printf("\n");
@@ -275,6 +289,9 @@ void close_diagnostics(void) {
 /* MEMORY SAFETY FUNCTIONS */
 
 void* safe_malloc(size_t size, const char* context) {
+    alloc_stats.bytes += size;
+    alloc_stats.count++;
+
     void* ptr = malloc(size);
     if (!ptr && size > 0) {
         diag_fatal(0, 0, "Memory allocation failed: %s (requested %zu bytes)",
@@ -284,6 +301,9 @@ void* safe_malloc(size_t size, const char* context) {
 }
 
 void* safe_calloc(size_t count, size_t size, const char* context) {
+    alloc_stats.bytes += count * size;
+    alloc_stats.count++;
+
     void* ptr = calloc(count, size);
     if (!ptr && count > 0 && size > 0) {
         diag_fatal(0, 0, "Memory allocation failed: %s (requested %zu x %zu bytes)",
@@ -293,6 +313,9 @@ void* safe_calloc(size_t count, size_t size, const char* context) {
 }
 
 void* safe_realloc(void* ptr, size_t size, const char* context) {
+    alloc_stats.bytes += size;
+    alloc_stats.count++;
+
     void* new_ptr = realloc(ptr, size);
     if (!new_ptr && size > 0) {
         diag_fatal(0, 0, "Memory reallocation failed: %s (requested %zu bytes)",
@@ -304,6 +327,9 @@ void* safe_realloc(void* ptr, size_t size, const char* context) {
 char* safe_strdup(const char* str, const char* context) {
     if (!str) return NULL;
 
+    alloc_stats.bytes += strlen(str) + 1;
+    alloc_stats.count++;
+
     char* new_str = strdup(str);
     if (!new_str) {
         diag_fatal(0, 0, "String duplication failed: %s",
@@ -33,6 +33,14 @@ typedef enum {
     DIAG_CAT_GENERAL
 } DiagnosticCategory;
 
+/* Console output levels for progress messages on stdout. Errors and
+ * warnings go to stderr and are not affected. */
+typedef enum {
+    LOG_QUIET,       /* No progress output */
+    LOG_NORMAL,      /* Phase banners and summaries (default) */
+    LOG_VERBOSE      /* Per-item progress from every phase */
+} LogLevel;
+
 /* Diagnostic statistics */
 typedef struct {
     int note_count;
@@ -41,6 +49,12 @@ typedef struct {
     int fatal_count;
 } DiagnosticStats;
 
+/* Heap allocation counters, updated by the safe_* allocators */
+typedef struct {
+    size_t bytes;               /* Bytes requested */
+    size_t count;               /* Number of allocations */
+} AllocationStats;
+
 /* Global diagnostics configuration */
 typedef struct {
     int verbose_mode;           /* Verbose output */
@@ -50,11 +64,25 @@ typedef struct {
     int color_output;           /* Use colored output (if terminal supports) */
     int max_errors;             /* Maximum errors before stopping (0 = unlimited) */
     FILE* log_file;             /* Optional log file */
+    int log_level;              /* Console output level (LogLevel) */
 } DiagnosticConfig;
 
-/* Global diagnostic state */
-extern DiagnosticConfig diag_config;
-extern DiagnosticStats diag_stats;
+/* Thread-local storage qualifier */
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/* Diagnostic state - one copy per thread, so compilations running on
+ * different threads keep separate settings and counts */
+extern THREAD_LOCAL DiagnosticConfig diag_config;
+extern THREAD_LOCAL DiagnosticStats diag_stats;
+extern THREAD_LOCAL AllocationStats alloc_stats;
+
+/* True if progress messages at this level are shown - a plain field test,
+ * cheap enough to guard messages inside the parser and optimizer loops */
+#define LOG_ENABLED(level) (diag_config.log_level >= (level))
 
 /* DIAGNOSTIC FUNCTIONS */
 
@@ -74,6 +102,9 @@ void diag_fatal(int line, int col, const char* format, ...);
 /* Security-specific diagnostics */
 void diag_security_warning(int line, int col, const char* format, ...);
 
+/* Print a progress message to stdout if the console log level allows it */
+void log_message(LogLevel level, const char* format, ...);
+
 /* Print diagnostic summary */
 void print_diagnostic_summary(void);
 
@@ -92,7 +123,9 @@ void set_diagnostic_log_file(const char* filename);
 /* Close diagnostics system */
 void close_diagnostics(void);
 
-/* MEMORY SAFETY CHECKS */
+/* MEMORY SAFETY CHECKS
+ * Allocations through these functions are counted in alloc_stats (per
+ * thread) for the --time-report phase measurements. */
 
 /* Safe malloc with error checking */
 void* safe_malloc(size_t size, const char* context);
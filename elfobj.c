@@ -0,0 +1,327 @@
+/*
+ * ELFOBJ.C - ELF64 Relocatable Object Writer Implementation
+ * CST-405 Compiler Project
+ *
+ * File layout: ELF header, section contents (.text, .data, .symtab,
+ * .strtab, .rela.text, .shstrtab), then the section header table.
+ * Section symbols for .text, .data and .bss come first in the symbol
+ * table, then the local symbols, then the globals - ELF requires every
+ * local symbol to come before the first global one.
+ */
+
+#include "elfobj.h"
+#include "diagnostics.h"
+#include <string.h>
+
+/* Section header table: index 0 is the null section */
+enum {
+    SHDR_NULL, SHDR_TEXT, SHDR_DATA, SHDR_BSS, SHDR_NOTE,
+    SHDR_SYMTAB, SHDR_STRTAB, SHDR_RELA_TEXT, SHDR_SHSTRTAB, SHDR_COUNT
+};
+
+/* ELF constants (from the System V gABI and the x86-64 psABI) */
+#define ELF_HEADER_SIZE   64
+#define SECTION_HDR_SIZE  64
+#define SYMBOL_SIZE       24
+#define RELA_SIZE         24
+#define ET_REL            1
+#define EM_X86_64         62
+#define SHT_PROGBITS      1
+#define SHT_SYMTAB        2
+#define SHT_STRTAB        3
+#define SHT_RELA          4
+#define SHT_NOBITS        8
+#define SHF_WRITE         0x1
+#define SHF_ALLOC         0x2
+#define SHF_EXECINSTR     0x4
+#define SHF_INFO_LINK     0x40
+#define STT_SECTION       3
+#define SHN_UNDEF         0
+
+/* Create an empty object */
+ElfObject* create_elf_object(void) {
+    ElfObject* object = (ElfObject*)safe_calloc(1, sizeof(ElfObject), "ELF object");
+    object->sections[ELF_TEXT].align = 16;
+    object->sections[ELF_DATA].align = 8;
+    object->sections[ELF_BSS].align = 8;
+    return object;
+}
+
+/* Free an object */
+void free_elf_object(ElfObject* object) {
+    if (!object) return;
+    for (int s = 0; s < ELF_SECTION_COUNT; s++) {
+        free(object->sections[s].data);
+    }
+    for (int i = 0; i < object->symbol_count; i++) {
+        free(object->symbols[i].name);
+    }
+    free(object->symbols);
+    free(object->relocations);
+    free(object);
+}
+
+/* Helper: make room for extra more bytes in a section */
+static void grow_section(ElfSection* section, size_t extra) {
+    if (section->size + extra <= section->capacity) return;
+
+    size_t capacity = section->capacity ? section->capacity : 4096;
+    while (capacity < section->size + extra) capacity *= 2;
+    section->data = (unsigned char*)safe_realloc(section->data, capacity, "section contents");
+    section->capacity = capacity;
+}
+
+/* Append bytes to a section */
+void elf_append(ElfObject* object, ElfSectionId id, const void* bytes, size_t length) {
+    ElfSection* section = &object->sections[id];
+    grow_section(section, length);
+    memcpy(section->data + section->size, bytes, length);
+    section->size += length;
+}
+
+/* Reserve aligned space in a section */
+size_t elf_reserve(ElfObject* object, ElfSectionId id, size_t size, size_t align) {
+    ElfSection* section = &object->sections[id];
+    size_t offset = (section->size + align - 1) & ~(align - 1);
+    if (align > section->align) section->align = align;
+
+    if (id != ELF_BSS) {
+        grow_section(section, offset + size - section->size);
+        memset(section->data + section->size, 0, offset + size - section->size);
+    }
+    section->size = offset + size;
+    return offset;
+}
+
+/* Overwrite a 32-bit field */
+void elf_patch32(ElfObject* object, ElfSectionId id, size_t offset, long value) {
+    unsigned char* field = object->sections[id].data + offset;
+    for (int i = 0; i < 4; i++) {
+        field[i] = (unsigned char)((unsigned long)value >> (8 * i));
+    }
+}
+
+/* Add a symbol */
+int elf_add_symbol(ElfObject* object, const char* name, int section, size_t value,
+                   size_t size, int binding, int type) {
+    if (object->symbol_count == object->symbol_capacity) {
+        object->symbol_capacity = object->symbol_capacity ? object->symbol_capacity * 2 : 64;
+        object->symbols = (ElfSymbol*)safe_realloc(object->symbols, object->symbol_capacity * sizeof(ElfSymbol),
+                                                   "symbol table");
+    }
+
+    ElfSymbol* symbol = &object->symbols[object->symbol_count];
+    symbol->name = safe_strdup(name, "ELF symbol");
+    symbol->section = section;
+    symbol->value = value;
+    symbol->size = size;
+    symbol->binding = binding;
+    symbol->type = type;
+    return object->symbol_count++;
+}
+
+/* Record a relocation */
+void elf_add_relocation(ElfObject* object, size_t offset, int symbol, int type, long addend) {
+    if (object->relocation_count == object->relocation_capacity) {
+        object->relocation_capacity = object->relocation_capacity ? object->relocation_capacity * 2 : 256;
+        object->relocations = (ElfRelocation*)safe_realloc(object->relocations,
+                                                           object->relocation_capacity * sizeof(ElfRelocation),
+                                                           "relocations");
+    }
+
+    ElfRelocation* reloc = &object->relocations[object->relocation_count++];
+    reloc->offset = offset;
+    reloc->symbol = symbol;
+    reloc->type = type;
+    reloc->addend = addend;
+}
+
+/* ============================================================
+ * FILE OUTPUT
+ * ============================================================ */
+
+/* Little-endian writer that tracks the file offset */
+typedef struct {
+    OutputSink* out;
+    size_t offset;
+} ElfWriter;
+
+static void put_bytes(ElfWriter* w, const void* bytes, size_t length) {
+    sink_write(w->out, (const char*)bytes, length);
+    w->offset += length;
+}
+
+static void put_uint(ElfWriter* w, unsigned long long value, int size) {
+    unsigned char bytes[8];
+    for (int i = 0; i < size; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    put_bytes(w, bytes, size);
+}
+
+/* Helper: zero padding up to an aligned file offset */
+static void pad_to(ElfWriter* w, size_t offset) {
+    static const char zeros[16] = { 0 };
+    while (w->offset < offset) {
+        size_t chunk = offset - w->offset;
+        put_bytes(w, zeros, chunk < sizeof(zeros) ? chunk : sizeof(zeros));
+    }
+}
+
+static size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+/* Helper: add a name to a string table, returning its offset */
+static unsigned add_string(OutputSink* table, const char* name) {
+    unsigned offset = (unsigned)table->length;
+    sink_write(table, name, strlen(name) + 1);
+    return offset;
+}
+
+/* Helper: one section header */
+static void put_section_header(ElfWriter* w, unsigned name, unsigned type, unsigned long long flags,
+                               size_t offset, size_t size, unsigned link, unsigned info,
+                               size_t align, size_t entry_size) {
+    put_uint(w, name, 4);
+    put_uint(w, type, 4);
+    put_uint(w, flags, 8);
+    put_uint(w, 0, 8);                  /* sh_addr */
+    put_uint(w, offset, 8);
+    put_uint(w, size, 8);
+    put_uint(w, link, 4);
+    put_uint(w, info, 4);
+    put_uint(w, align, 8);
+    put_uint(w, entry_size, 8);
+}
+
+/* Helper: one symbol table entry */
+static void put_symbol(OutputSink* table, unsigned name, int binding, int type,
+                       unsigned section, size_t value, size_t size) {
+    ElfWriter w = { table, 0 };
+    put_uint(&w, name, 4);
+    put_uint(&w, (unsigned)((binding << 4) | type), 1);
+    put_uint(&w, 0, 1);                 /* st_other: default visibility */
+    put_uint(&w, section, 2);
+    put_uint(&w, value, 8);
+    put_uint(&w, size, 8);
+}
+
+/* Write the object file */
+void write_elf_object(const ElfObject* object, OutputSink* out) {
+    static const unsigned section_index[ELF_SECTION_COUNT] = { SHDR_TEXT, SHDR_DATA, SHDR_BSS };
+
+    /* Symbol table: null, section symbols, locals, globals */
+    OutputSink* symtab = create_buffer_sink();
+    OutputSink* strtab = create_buffer_sink();
+    int* order = (int*)safe_calloc(object->symbol_count + 1, sizeof(int), "symbol order");
+    add_string(strtab, "");
+
+    put_symbol(symtab, 0, 0, 0, SHN_UNDEF, 0, 0);
+    for (int s = 0; s < ELF_SECTION_COUNT; s++) {
+        put_symbol(symtab, 0, ELF_LOCAL, STT_SECTION, section_index[s], 0, 0);
+    }
+    int next = 1 + ELF_SECTION_COUNT;
+    int first_global = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        int binding = pass == 0 ? ELF_LOCAL : ELF_GLOBAL;
+        if (pass == 1) first_global = next;
+        for (int i = 0; i < object->symbol_count; i++) {
+            const ElfSymbol* sym = &object->symbols[i];
+            if (sym->binding != binding) continue;
+            unsigned shndx = sym->section == ELF_UNDEFINED ? SHN_UNDEF : section_index[sym->section];
+            put_symbol(symtab, add_string(strtab, sym->name), sym->binding, sym->type,
+                       shndx, sym->value, sym->size);
+            order[i] = next++;
+        }
+    }
+
+    /* Relocations, with symbol numbers in table order */
+    OutputSink* rela = create_buffer_sink();
+    for (int r = 0; r < object->relocation_count; r++) {
+        const ElfRelocation* reloc = &object->relocations[r];
+        ElfWriter w = { rela, 0 };
+        put_uint(&w, reloc->offset, 8);
+        put_uint(&w, ((unsigned long long)order[reloc->symbol] << 32) | (unsigned)reloc->type, 8);
+        put_uint(&w, (unsigned long long)(long long)reloc->addend, 8);
+    }
+
+    OutputSink* shstrtab = create_buffer_sink();
+    unsigned names[SHDR_COUNT];
+    names[SHDR_NULL] = add_string(shstrtab, "");
+    names[SHDR_TEXT] = add_string(shstrtab, ".text");
+    names[SHDR_DATA] = add_string(shstrtab, ".data");
+    names[SHDR_BSS] = add_string(shstrtab, ".bss");
+    names[SHDR_NOTE] = add_string(shstrtab, ".note.GNU-stack");
+    names[SHDR_SYMTAB] = add_string(shstrtab, ".symtab");
+    names[SHDR_STRTAB] = add_string(shstrtab, ".strtab");
+    names[SHDR_RELA_TEXT] = add_string(shstrtab, ".rela.text");
+    names[SHDR_SHSTRTAB] = add_string(shstrtab, ".shstrtab");
+
+    /* File offsets */
+    const ElfSection* text = &object->sections[ELF_TEXT];
+    const ElfSection* data = &object->sections[ELF_DATA];
+    const ElfSection* bss = &object->sections[ELF_BSS];
+    size_t text_offset = align_up(ELF_HEADER_SIZE, text->align);
+    size_t data_offset = align_up(text_offset + text->size, data->align);
+    size_t symtab_offset = align_up(data_offset + data->size, 8);
+    size_t strtab_offset = symtab_offset + symtab->length;
+    size_t rela_offset = align_up(strtab_offset + strtab->length, 8);
+    size_t shstrtab_offset = rela_offset + rela->length;
+    size_t header_offset = align_up(shstrtab_offset + shstrtab->length, 8);
+
+    /* ELF header */
+    static const unsigned char ident[16] = { 0x7f, 'E', 'L', 'F', 2, 1, 1, 0 };
+    ElfWriter w = { out, 0 };
+    put_bytes(&w, ident, sizeof(ident));
+    put_uint(&w, ET_REL, 2);
+    put_uint(&w, EM_X86_64, 2);
+    put_uint(&w, 1, 4);                 /* e_version */
+    put_uint(&w, 0, 8);                 /* e_entry */
+    put_uint(&w, 0, 8);                 /* e_phoff */
+    put_uint(&w, header_offset, 8);     /* e_shoff */
+    put_uint(&w, 0, 4);                 /* e_flags */
+    put_uint(&w, ELF_HEADER_SIZE, 2);
+    put_uint(&w, 0, 2);                 /* e_phentsize */
+    put_uint(&w, 0, 2);                 /* e_phnum */
+    put_uint(&w, SECTION_HDR_SIZE, 2);
+    put_uint(&w, SHDR_COUNT, 2);
+    put_uint(&w, SHDR_SHSTRTAB, 2);
+
+    /* Section contents */
+    pad_to(&w, text_offset);
+    put_bytes(&w, text->data, text->size);
+    pad_to(&w, data_offset);
+    put_bytes(&w, data->data, data->size);
+    pad_to(&w, symtab_offset);
+    put_bytes(&w, symtab->data, symtab->length);
+    put_bytes(&w, strtab->data, strtab->length);
+    pad_to(&w, rela_offset);
+    put_bytes(&w, rela->data, rela->length);
+    put_bytes(&w, shstrtab->data, shstrtab->length);
+    pad_to(&w, header_offset);
+
+    /* Section headers */
+    put_section_header(&w, names[SHDR_NULL], 0, 0, 0, 0, 0, 0, 0, 0);
+    put_section_header(&w, names[SHDR_TEXT], SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+                       text_offset, text->size, 0, 0, text->align, 0);
+    put_section_header(&w, names[SHDR_DATA], SHT_PROGBITS, SHF_ALLOC | SHF_WRITE,
+                       data_offset, data->size, 0, 0, data->align, 0);
+    put_section_header(&w, names[SHDR_BSS], SHT_NOBITS, SHF_ALLOC | SHF_WRITE,
+                       symtab_offset, bss->size, 0, 0, bss->align, 0);
+    put_section_header(&w, names[SHDR_NOTE], SHT_PROGBITS, 0, symtab_offset, 0, 0, 0, 1, 0);
+    put_section_header(&w, names[SHDR_SYMTAB], SHT_SYMTAB, 0, symtab_offset, symtab->length,
+                       SHDR_STRTAB, first_global, 8, SYMBOL_SIZE);
+    put_section_header(&w, names[SHDR_STRTAB], SHT_STRTAB, 0, strtab_offset, strtab->length,
+                       0, 0, 1, 0);
+    put_section_header(&w, names[SHDR_RELA_TEXT], SHT_RELA, SHF_INFO_LINK, rela_offset, rela->length,
+                       SHDR_SYMTAB, SHDR_TEXT, 8, RELA_SIZE);
+    put_section_header(&w, names[SHDR_SHSTRTAB], SHT_STRTAB, 0, shstrtab_offset, shstrtab->length,
+                       0, 0, 1, 0);
+
+    free(order);
+    close_sink(symtab);
+    close_sink(strtab);
+    close_sink(rela);
+    close_sink(shstrtab);
+}
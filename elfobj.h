@@ -0,0 +1,107 @@
+/*
+ * ELFOBJ.H - ELF64 Relocatable Object Writer Header
+ * CST-405 Compiler Project
+ *
+ * This file builds an x86-64 ELF64 relocatable object (.o) in memory:
+ * the .text, .data and .bss sections, a symbol table and the relocations
+ * the linker applies to .text. It is the same kind of object "nasm -f
+ * elf64" makes from the generated assembly, so it links the same way.
+ *
+ * The ELF structures are written field by field (little-endian) instead
+ * of through <elf.h>, so the writer also builds on hosts without it.
+ */
+
+#ifndef ELFOBJ_H
+#define ELFOBJ_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "output.h"
+
+/* Sections an object can put bytes or symbols in */
+typedef enum {
+    ELF_TEXT,                     /* Machine code */
+    ELF_DATA,                     /* Initialized data */
+    ELF_BSS,                      /* Zero-initialized data (size only) */
+    ELF_SECTION_COUNT
+} ElfSectionId;
+
+#define ELF_UNDEFINED (-1)        /* Section of an external symbol */
+
+/* Symbol binding and type */
+#define ELF_LOCAL    0
+#define ELF_GLOBAL   1
+#define ELF_NOTYPE   0
+#define ELF_OBJECT   1
+#define ELF_FUNCTION 2
+
+/* Relocation types used by the code generator (x86-64 psABI numbers) */
+#define ELF_RELOC_PC32  2         /* S + A - P, 32-bit (RIP-relative data) */
+#define ELF_RELOC_PLT32 4         /* L + A - P, 32-bit (calls) */
+
+/* Contents of one section */
+typedef struct {
+    unsigned char* data;          /* Bytes (NULL for .bss) */
+    size_t size;                  /* Size in bytes */
+    size_t capacity;              /* Allocated bytes */
+    size_t align;                 /* Required alignment */
+} ElfSection;
+
+/* A symbol */
+typedef struct {
+    char* name;                   /* Symbol name (owned copy) */
+    int section;                  /* ElfSectionId, or ELF_UNDEFINED */
+    size_t value;                 /* Offset in the section */
+    size_t size;                  /* Size in bytes (0 if unknown) */
+    int binding;                  /* ELF_LOCAL or ELF_GLOBAL */
+    int type;                     /* ELF_NOTYPE, ELF_OBJECT or ELF_FUNCTION */
+} ElfSymbol;
+
+/* A relocation in .text */
+typedef struct {
+    size_t offset;                /* Position of the field in .text */
+    int symbol;                   /* Index into the symbol list */
+    int type;                     /* ELF_RELOC_* */
+    long addend;                  /* Constant added to the symbol value */
+} ElfRelocation;
+
+/* Object file under construction */
+typedef struct {
+    ElfSection sections[ELF_SECTION_COUNT];
+    ElfSymbol* symbols;           /* Symbols in the order they were added */
+    int symbol_count;
+    int symbol_capacity;
+    ElfRelocation* relocations;   /* Relocations against .text */
+    int relocation_count;
+    int relocation_capacity;
+} ElfObject;
+
+/* OBJECT FUNCTIONS */
+
+/* Create an empty object */
+ElfObject* create_elf_object(void);
+
+/* Free an object */
+void free_elf_object(ElfObject* object);
+
+/* Append bytes to a section (not .bss) */
+void elf_append(ElfObject* object, ElfSectionId section, const void* bytes, size_t length);
+
+/* Reserve size bytes aligned to align in a section (zero-filled outside
+ * .bss) and return their offset */
+size_t elf_reserve(ElfObject* object, ElfSectionId section, size_t size, size_t align);
+
+/* Overwrite a 32-bit little-endian field already in a section */
+void elf_patch32(ElfObject* object, ElfSectionId section, size_t offset, long value);
+
+/* Add a symbol; returns its index */
+int elf_add_symbol(ElfObject* object, const char* name, int section, size_t value,
+                   size_t size, int binding, int type);
+
+/* Record a relocation of the 32-bit field at offset in .text */
+void elf_add_relocation(ElfObject* object, size_t offset, int symbol, int type, long addend);
+
+/* Write the object file to out */
+void write_elf_object(const ElfObject* object, OutputSink* out);
+
+#endif /* ELFOBJ_H */
@@ -0,0 +1,123 @@
+/*
+ * EMIT.C - Assembly Emitter Implementation
+ * CST-405 Compiler Project
+ */
+
+#include "emit.h"
+#include <stdarg.h>
+
+/* Set up an emitter */
+void init_emitter(AsmEmitter* emit, OutputSink* out, char comment_char, int comments) {
+    emit->out = out;
+    emit->comments = comments;
+    emit->comment_char = comment_char;
+    emit->operands = 0;
+}
+
+/* Helper: separator before the next operand (" " first, then ", ") */
+static void operand_separator(AsmEmitter* emit) {
+    if (emit->operands++ == 0) {
+        sink_write(emit->out, " ", 1);
+    } else {
+        sink_write(emit->out, ", ", 2);
+    }
+}
+
+/* Start an instruction line */
+void emit_insn(AsmEmitter* emit, const char* mnemonic) {
+    sink_write(emit->out, "    ", 4);
+    sink_puts(emit->out, mnemonic);
+    emit->operands = 0;
+}
+
+/* Append a register operand */
+void emit_reg(AsmEmitter* emit, const char* reg) {
+    operand_separator(emit);
+    sink_puts(emit->out, reg);
+}
+
+/* Append a label or symbol operand */
+void emit_sym(AsmEmitter* emit, const char* name) {
+    operand_separator(emit);
+    sink_puts(emit->out, name);
+}
+
+/* Append a memory operand */
+void emit_mem(AsmEmitter* emit, const char* name) {
+    operand_separator(emit);
+    sink_write(emit->out, "[", 1);
+    sink_puts(emit->out, name);
+    sink_write(emit->out, "]", 1);
+}
+
+/* Append a memory operand with a prefixed symbol */
+void emit_mem_symbol(AsmEmitter* emit, const char* prefix, const char* name) {
+    operand_separator(emit);
+    sink_write(emit->out, "[", 1);
+    sink_puts(emit->out, prefix);
+    sink_puts(emit->out, name);
+    sink_write(emit->out, "]", 1);
+}
+
+/* Append an immediate operand */
+void emit_imm(AsmEmitter* emit, long value) {
+    operand_separator(emit);
+    emit_int(emit, value);
+}
+
+/* End the current line */
+void emit_end(AsmEmitter* emit, const char* comment) {
+    if (comment && emit->comments) {
+        sink_puts(emit->out, comment);
+    }
+    sink_write(emit->out, "\n", 1);
+}
+
+/* Write a complete fixed line */
+void emit_line(AsmEmitter* emit, const char* code, const char* comment) {
+    sink_puts(emit->out, code);
+    emit_end(emit, comment);
+}
+
+/* Write a label definition */
+void emit_label(AsmEmitter* emit, const char* label) {
+    sink_puts(emit->out, label);
+    sink_write(emit->out, ":\n", 2);
+}
+
+/* Write an annotation line */
+void emit_note(AsmEmitter* emit, const char* first, ...) {
+    if (!emit->comments) return;
+
+    char prefix[6] = { ' ', ' ', ' ', ' ', emit->comment_char, ' ' };
+    sink_write(emit->out, prefix, sizeof(prefix));
+
+    va_list args;
+    va_start(args, first);
+    for (const char* piece = first; piece; piece = va_arg(args, const char*)) {
+        sink_puts(emit->out, piece);
+    }
+    va_end(args);
+
+    sink_write(emit->out, "\n", 1);
+}
+
+/* Append raw text */
+void emit_text(AsmEmitter* emit, const char* text) {
+    sink_puts(emit->out, text);
+}
+
+/* Append a decimal number */
+void emit_int(AsmEmitter* emit, long value) {
+    char digits[24];
+    int pos = sizeof(digits);
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+
+    do {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[--pos] = '-';
+
+    sink_write(emit->out, digits + pos, sizeof(digits) - pos);
+}
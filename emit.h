@@ -0,0 +1,66 @@
+/*
+ * EMIT.H - Assembly Emitter Header
+ * CST-405 Compiler Project
+ *
+ * The code generators build each assembly line from pieces - mnemonic,
+ * registers, memory operands, immediates, labels - that are appended
+ * straight to the output sink. Nothing goes through a format string.
+ * Annotation comments (the "; t0 = a + b" lines and trailing remarks) are
+ * only written when comments are enabled (--no-asm-comments turns them off).
+ */
+
+#ifndef EMIT_H
+#define EMIT_H
+
+#include "output.h"
+
+/* Assembly emitter */
+typedef struct {
+    OutputSink* out;            /* Destination sink */
+    int comments;               /* Write annotation comments */
+    char comment_char;          /* Comment character (';' for NASM, '#' for MIPS) */
+    int operands;               /* Operands written on the current line */
+} AsmEmitter;
+
+/* EMITTER FUNCTIONS */
+
+/* Set up an emitter writing to out */
+void init_emitter(AsmEmitter* emit, OutputSink* out, char comment_char, int comments);
+
+/* Start an instruction line: "    mnemonic" */
+void emit_insn(AsmEmitter* emit, const char* mnemonic);
+
+/* Append a register operand */
+void emit_reg(AsmEmitter* emit, const char* reg);
+
+/* Append a label or symbol operand */
+void emit_sym(AsmEmitter* emit, const char* name);
+
+/* Append a memory operand: [name] */
+void emit_mem(AsmEmitter* emit, const char* name);
+
+/* Append a memory operand with a prefixed symbol: [prefix name] */
+void emit_mem_symbol(AsmEmitter* emit, const char* prefix, const char* name);
+
+/* Append an immediate operand */
+void emit_imm(AsmEmitter* emit, long value);
+
+/* End the line, with a trailing comment (including the spacing before it)
+ * if comments are enabled and comment is not NULL */
+void emit_end(AsmEmitter* emit, const char* comment);
+
+/* Write a complete fixed line: code, optional trailing comment, newline */
+void emit_line(AsmEmitter* emit, const char* code, const char* comment);
+
+/* Write a label definition: "label:" */
+void emit_label(AsmEmitter* emit, const char* label);
+
+/* Write an annotation line "    ; piece piece..." from a NULL-terminated
+ * list of strings (nothing is written when comments are disabled) */
+void emit_note(AsmEmitter* emit, const char* first, ...);
+
+/* Append raw text / a decimal number (always written) */
+void emit_text(AsmEmitter* emit, const char* text);
+void emit_int(AsmEmitter* emit, long value);
+
+#endif /* EMIT_H */
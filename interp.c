@@ -0,0 +1,716 @@
+/*
+ * INTERP.C - Bytecode Interpreter Implementation
+ * CST-405 Compiler Project
+ *
+ * Lowering reuses the stack frame layout of the x86-64 generator
+ * (build_function_frame), so a name is a frame cell exactly when it has a
+ * stack slot in the generated code. A frame of f cells holds the locals and
+ * temporaries (an array occupies consecutive cells) followed by the
+ * parameters in declaration order. A RELOP whose result is only read by
+ * the IF_FALSE or IF_TRUE right after it becomes one compare-and-branch
+ * instruction.
+ *
+ * Dispatch is threaded with computed goto under GCC and Clang: every
+ * handler ends with its own indirect jump to the next handler, which the
+ * branch predictor tracks per instruction. Other compilers use a switch.
+ */
+
+#include "interp.h"
+#include "codegen.h"
+#include "defuse.h"
+#include "diagnostics.h"
+#include "timing.h"
+#include <string.h>
+#include <limits.h>
+
+#if defined(__GNUC__)
+#define INTERP_THREADED 1
+#else
+#define INTERP_THREADED 0
+#endif
+
+/* Deepest call nesting before the program is stopped */
+#define MAX_CALL_DEPTH 1000000
+
+/* ============================================================
+ * LOWERING
+ * ============================================================ */
+
+/* Name -> number map (open addressing, kept at most half full) */
+typedef struct {
+    const char** names;           /* Names (borrowed) */
+    unsigned* hashes;
+    int* values;
+    int* lengths;                 /* Cells of a global (arrays) */
+    int size;                     /* Slots (power of two) */
+    int count;
+} NameIndex;
+
+/* A jump whose target label is resolved at the end */
+typedef struct {
+    int insn;                     /* Instruction number */
+    const char* label;            /* Target label */
+} PendingJump;
+
+/* Lowering state */
+typedef struct {
+    BytecodeProgram* program;
+    CodeGenerator* frames;        /* Frame layout of the current function */
+    SymbolTable* symtab;
+    DefUseChains* chains;         /* Use counts of RELOP results */
+    NameIndex labels;             /* Label -> instruction */
+    NameIndex functions;          /* Function -> function number */
+    NameIndex globals;            /* Global variable or literal -> global cell */
+    PendingJump* jumps;
+    int jump_count;
+    int jump_capacity;
+    int local_cells;              /* Cells below the parameters */
+    int param_count;              /* Parameters of the current function */
+} Lowering;
+
+/* Helper: grow an array to hold one more element */
+static void* grow_array(void* array, int* capacity, int count, size_t size, const char* what) {
+    if (count < *capacity) return array;
+    *capacity = *capacity ? *capacity * 2 : 64;
+    return safe_realloc(array, (size_t)*capacity * size, what);
+}
+
+/* Helper: slot of name in the map (empty slot if it is not there) */
+static int name_slot(const NameIndex* index, const char* name, unsigned h) {
+    unsigned mask = (unsigned)index->size - 1;
+    unsigned slot = h & mask;
+    while (index->names[slot] && (index->hashes[slot] != h || strcmp(index->names[slot], name) != 0)) {
+        slot = (slot + 1) & mask;
+    }
+    return (int)slot;
+}
+
+/* Helper: number stored for name, or -1 */
+static int find_index(const NameIndex* index, const char* name, int* length) {
+    if (index->count == 0) return -1;
+    int slot = name_slot(index, name, hash(name));
+    if (!index->names[slot]) return -1;
+    if (length) *length = index->lengths[slot];
+    return index->values[slot];
+}
+
+/* Helper: store a number for a name that is not in the map yet */
+static void add_index(NameIndex* index, const char* name, int value, int length) {
+    if (2 * (index->count + 1) > index->size) {
+        NameIndex old = *index;
+        index->size = old.size ? old.size * 2 : 64;
+        index->names = (const char**)safe_calloc(index->size, sizeof(const char*), "name index");
+        index->hashes = (unsigned*)safe_calloc(index->size, sizeof(unsigned), "name index");
+        index->values = (int*)safe_calloc(index->size, sizeof(int), "name index");
+        index->lengths = (int*)safe_calloc(index->size, sizeof(int), "name index");
+        for (int i = 0; i < old.size; i++) {
+            if (!old.names[i]) continue;
+            int slot = name_slot(index, old.names[i], old.hashes[i]);
+            index->names[slot] = old.names[i];
+            index->hashes[slot] = old.hashes[i];
+            index->values[slot] = old.values[i];
+            index->lengths[slot] = old.lengths[i];
+        }
+        free(old.names);
+        free(old.hashes);
+        free(old.values);
+        free(old.lengths);
+    }
+
+    unsigned h = hash(name);
+    int slot = name_slot(index, name, h);
+    index->names[slot] = name;
+    index->hashes[slot] = h;
+    index->values[slot] = value;
+    index->lengths[slot] = length;
+    index->count++;
+}
+
+static void free_index(NameIndex* index) {
+    free(index->names);
+    free(index->hashes);
+    free(index->values);
+    free(index->lengths);
+}
+
+/* Helper: reserve cells in the global area, returning the first */
+static int add_global_cells(BytecodeProgram* program, int count, long long value) {
+    while (program->global_count + count > program->global_capacity) {
+        program->global_capacity = program->global_capacity ? program->global_capacity * 2 : 256;
+        program->global_init = (long long*)safe_realloc(program->global_init,
+                                                        program->global_capacity * sizeof(long long),
+                                                        "global cells");
+    }
+    int first = program->global_count;
+    for (int i = 0; i < count; i++) program->global_init[first + i] = value;
+    program->global_count += count;
+    return first;
+}
+
+/* Helper: cell of an operand: its frame cell, or a global cell for globals
+ * and literals (one shared cell per literal); *length is its element count */
+static int operand_cell(Lowering* low, const char* name, int* length) {
+    int unused;
+    if (!length) length = &unused;
+
+    FrameSlot* slot = find_frame_slot(low->frames, name);
+    if (slot) {
+        *length = slot->size;
+        if (slot->is_param) {
+            return low->local_cells + low->param_count - 1 - (slot->offset - 16) / 8;
+        }
+        return (low->frames->stack_offset + slot->offset) / 8;
+    }
+
+    int cell = find_index(&low->globals, name, length);
+    if (cell < 0) {
+        if (is_literal(name)) {
+            *length = 1;
+            cell = add_global_cells(low->program, 1, strtoll(name, NULL, 10));
+        } else {
+            Symbol* sym = low->symtab ? lookup_symbol(low->symtab, name) : NULL;
+            *length = sym && sym->is_array ? sym->array_size : 1;
+            cell = add_global_cells(low->program, *length, 0);
+        }
+        add_index(&low->globals, name, cell, *length);
+    }
+    return ~cell;
+}
+
+/* Helper: number of a function, registered on first reference */
+static int function_number(Lowering* low, const char* name) {
+    int number = find_index(&low->functions, name, NULL);
+    if (number >= 0) return number;
+
+    BytecodeProgram* program = low->program;
+    program->functions = (BytecodeFunction*)grow_array(program->functions, &program->function_capacity,
+                                                       program->function_count, sizeof(BytecodeFunction),
+                                                       "bytecode functions");
+    number = program->function_count++;
+    BytecodeFunction* function = &program->functions[number];
+    function->name = name;
+    function->entry = -1;
+    function->frame_size = 0;
+    function->param_count = 0;
+    add_index(&low->functions, name, number, 0);
+    return number;
+}
+
+/* Helper: append an instruction */
+static BytecodeInsn* emit(Lowering* low, int op, int a, int b, int c) {
+    BytecodeProgram* program = low->program;
+    program->code = (BytecodeInsn*)grow_array(program->code, &program->code_capacity, program->code_count,
+                                              sizeof(BytecodeInsn), "bytecode");
+    BytecodeInsn* insn = &program->code[program->code_count++];
+    insn->op = op;
+    insn->a = a;
+    insn->b = b;
+    insn->c = c;
+    insn->d = 0;
+    return insn;
+}
+
+/* Helper: append a jump to a label */
+static void emit_jump(Lowering* low, int op, const char* label, int b, int c) {
+    low->jumps = (PendingJump*)grow_array(low->jumps, &low->jump_capacity, low->jump_count,
+                                          sizeof(PendingJump), "jump list");
+    low->jumps[low->jump_count].insn = low->program->code_count;
+    low->jumps[low->jump_count].label = label;
+    low->jump_count++;
+    emit(low, op, -1, b, c);
+}
+
+/* Helper: comparison operator of a RELOP as a bytecode offset from BC_LT */
+static int relop_index(const char* op) {
+    if (strcmp(op, "<") == 0) return 0;
+    if (strcmp(op, ">") == 0) return 1;
+    if (strcmp(op, "<=") == 0) return 2;
+    if (strcmp(op, ">=") == 0) return 3;
+    if (strcmp(op, "==") == 0) return 4;
+    if (strcmp(op, "!=") == 0) return 5;
+    return -1;
+}
+
+/* Helper: bytecode operation of a TAC arithmetic opcode */
+static int arithmetic_op(TACOpcode opcode) {
+    switch (opcode) {
+        case TAC_SUB: return BC_SUB;
+        case TAC_MUL: return BC_MUL;
+        case TAC_DIV: return BC_DIV;
+        case TAC_MOD: return BC_MOD;
+        default:      return BC_ADD;
+    }
+}
+
+/* Helper: start a function - lay out its frame and record its entry */
+static void lower_function_label(Lowering* low, TACInstruction* inst) {
+    build_function_frame(low->frames, inst);
+
+    low->param_count = 0;
+    for (int s = 0; s < low->frames->slot_count; s++) {
+        if (low->frames->slots[s].is_param) low->param_count++;
+    }
+    low->local_cells = low->frames->stack_offset / 8;
+
+    int number = function_number(low, inst->label);
+    BytecodeFunction* function = &low->program->functions[number];
+    if (function->entry < 0) {
+        function->entry = low->program->code_count;
+        function->frame_size = low->local_cells + low->param_count;
+        function->param_count = low->param_count;
+    }
+}
+
+/* Helper: lower one instruction; returns the instruction to continue
+ * after (the branch when a RELOP was fused with it) */
+static TACInstruction* lower_instruction(Lowering* low, TACInstruction* inst) {
+    switch (inst->opcode) {
+        case TAC_LOAD_CONST:
+        case TAC_ASSIGN:
+            emit(low, BC_MOV, operand_cell(low, inst->result, NULL), operand_cell(low, inst->op1, NULL), 0);
+            break;
+
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_MOD:
+            emit(low, arithmetic_op(inst->opcode), operand_cell(low, inst->result, NULL), operand_cell(low, inst->op1, NULL),
+                 operand_cell(low, inst->op2, NULL));
+            break;
+
+        case TAC_RELOP: {
+            int relop = relop_index(inst->label);
+            if (relop < 0) relop = 4;
+
+            /* RELOP t; IF_FALSE/IF_TRUE t L with no other reader of t: one branch */
+            TACInstruction* next = inst->next;
+            ChainValue* value = operand_value(inst, TAC_SLOT_RESULT);
+            if (next && (next->opcode == TAC_IF_FALSE || next->opcode == TAC_IF_TRUE) &&
+                strcmp(next->op1, inst->result) == 0 &&
+                value && value->use_count == 1 && value->def_count == 1) {
+                int op = next->opcode == TAC_IF_TRUE ? BC_JUMP_LT : BC_JUMP_NLT;
+                emit_jump(low, op + relop, next->label,
+                          operand_cell(low, inst->op1, NULL), operand_cell(low, inst->op2, NULL));
+                return next;
+            }
+            emit(low, BC_LT + relop, operand_cell(low, inst->result, NULL),
+                 operand_cell(low, inst->op1, NULL), operand_cell(low, inst->op2, NULL));
+            break;
+        }
+
+        case TAC_LABEL:
+            if (find_index(&low->labels, inst->label, NULL) < 0) {
+                add_index(&low->labels, inst->label, low->program->code_count, 0);
+            }
+            break;
+
+        case TAC_GOTO:
+            emit_jump(low, BC_JUMP, inst->label, 0, 0);
+            break;
+
+        case TAC_IF_FALSE:
+            emit_jump(low, BC_JUMP_FALSE, inst->label, operand_cell(low, inst->op1, NULL), 0);
+            break;
+
+        case TAC_IF_TRUE:
+            emit_jump(low, BC_JUMP_TRUE, inst->label, operand_cell(low, inst->op1, NULL), 0);
+            break;
+
+        case TAC_ARRAY_LOAD: {
+            int length;
+            int array = operand_cell(low, inst->op1, &length);
+            BytecodeInsn* insn = emit(low, BC_LOAD_ELEMENT, operand_cell(low, inst->result, NULL), array,
+                                      operand_cell(low, inst->op2, NULL));
+            insn->d = length;
+            break;
+        }
+
+        case TAC_ARRAY_STORE: {
+            int length;
+            int array = operand_cell(low, inst->result, &length);
+            BytecodeInsn* insn = emit(low, BC_STORE_ELEMENT, array, operand_cell(low, inst->op1, NULL),
+                                      operand_cell(low, inst->op2, NULL));
+            insn->d = length;
+            break;
+        }
+
+        case TAC_PRINT:
+            emit(low, BC_PRINT, operand_cell(low, inst->op1, NULL), 0, 0);
+            break;
+
+        case TAC_PARAM:
+            emit(low, BC_PARAM, operand_cell(low, inst->op1, NULL), 0, 0);
+            break;
+
+        case TAC_CALL:
+            emit(low, BC_CALL, inst->result ? operand_cell(low, inst->result, NULL) : BC_NO_CELL,
+                 function_number(low, inst->label), atoi(inst->op1));
+            break;
+
+        case TAC_RETURN:
+            emit(low, BC_RETURN, operand_cell(low, inst->op1, NULL), 0, 0);
+            break;
+
+        case TAC_RETURN_VOID:
+            emit(low, BC_RETURN_ZERO, 0, 0, 0);
+            break;
+
+        case TAC_PROFILE: {
+            int counter = atoi(inst->op1);
+            if (counter >= low->program->counter_count) low->program->counter_count = counter + 1;
+            emit(low, BC_PROFILE, counter, 0, 0);
+            break;
+        }
+
+        case TAC_BOUNDS_CHECK:
+            /* Every array access is checked here anyway */
+            break;
+
+        default:
+            break;
+    }
+    return inst;
+}
+
+/* Lower optimized TAC to bytecode */
+BytecodeProgram* lower_to_bytecode(TACCode* tac, SymbolTable* symtab) {
+    Lowering low;
+    memset(&low, 0, sizeof(low));
+    low.program = (BytecodeProgram*)safe_calloc(1, sizeof(BytecodeProgram), "bytecode program");
+    low.frames = create_code_generator(NULL, symtab, 0);
+    low.symtab = symtab;
+    low.chains = build_def_use_chains(tac);
+
+    /* Code before the first function is never reached (as in the
+     * generated assembly), so lowering starts at the first function */
+    TACInstruction* inst = tac->head;
+    while (inst && inst->opcode != TAC_FUNCTION_LABEL) inst = inst->next;
+
+    for (; inst; inst = inst->next) {
+        if (inst->opcode == TAC_FUNCTION_LABEL) {
+            lower_function_label(&low, inst);
+            continue;
+        }
+        inst = lower_instruction(&low, inst);
+
+        /* Falling off the end of a function returns 0 */
+        if (inst == low.frames->function_end && inst->opcode != TAC_RETURN &&
+            inst->opcode != TAC_RETURN_VOID && inst->opcode != TAC_GOTO) {
+            emit(&low, BC_RETURN_ZERO, 0, 0, 0);
+        }
+    }
+
+    BytecodeProgram* program = low.program;
+    int status = 0;
+    for (int j = 0; j < low.jump_count; j++) {
+        int target = find_index(&low.labels, low.jumps[j].label, NULL);
+        if (target < 0) {
+            fprintf(stderr, "Error: Jump to undefined label '%s'\n", low.jumps[j].label);
+            status = 1;
+        }
+        program->code[low.jumps[j].insn].a = target;
+    }
+    for (int f = 0; f < program->function_count; f++) {
+        if (program->functions[f].entry < 0) {
+            fprintf(stderr, "Error: Function '%s' is called but never defined\n", program->functions[f].name);
+            status = 1;
+        }
+    }
+    program->main_function = find_index(&low.functions, "main", NULL);
+    program->counters = (long long*)safe_calloc(program->counter_count + 1, sizeof(long long), "profile counters");
+
+    free_def_use_chains(low.chains);
+    close_code_generator(low.frames);
+    free_index(&low.labels);
+    free_index(&low.functions);
+    free_index(&low.globals);
+    free(low.jumps);
+
+    log_message(LOG_NORMAL, "Bytecode: %d instructions, %d functions, %d global cells\n",
+                program->code_count, program->function_count, program->global_count);
+
+    if (status != 0) {
+        free_bytecode(program);
+        return NULL;
+    }
+    return program;
+}
+
+/* Free a lowered program */
+void free_bytecode(BytecodeProgram* program) {
+    if (!program) return;
+    free(program->code);
+    free(program->functions);
+    free(program->global_init);
+    free(program->counters);
+    free(program);
+}
+
+/* Print the bytecode listing */
+void print_bytecode(const BytecodeProgram* program, FILE* out) {
+    static const char* names[BC_OPCODE_COUNT] = {
+        "mov", "add", "sub", "mul", "div", "mod", "lt", "gt", "le", "ge", "eq", "ne",
+        "jump", "jump_false", "jump_true", "jump_nlt", "jump_ngt", "jump_nle", "jump_nge", "jump_neq",
+        "jump_nne", "jump_lt", "jump_gt", "jump_le", "jump_ge", "jump_eq", "jump_ne",
+        "load_element", "store_element", "print", "param", "call", "return", "return_zero",
+        "profile"
+    };
+
+    fprintf(out, "=============== BYTECODE ==================\n\n");
+    for (int pc = 0; pc < program->code_count; pc++) {
+        for (int f = 0; f < program->function_count; f++) {
+            const BytecodeFunction* function = &program->functions[f];
+            if (function->entry == pc) {
+                fprintf(out, "%s: (frame %d cells, %d params)\n", function->name,
+                        function->frame_size, function->param_count);
+            }
+        }
+        const BytecodeInsn* insn = &program->code[pc];
+        fprintf(out, "  %5d  %-14s %d, %d, %d", pc, names[insn->op], insn->a, insn->b, insn->c);
+        if (insn->d) fprintf(out, "  [%d]", insn->d);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "\n");
+}
+
+/* ============================================================
+ * INTERPRETER
+ * ============================================================ */
+
+/* Return address of an active call */
+typedef struct {
+    const BytecodeInsn* return_to;  /* Instruction after the call */
+    int frame;                      /* Caller's frame (first cell in the stack) */
+    int result;                     /* Caller's cell for the result (BC_NO_CELL = none) */
+    int function;                   /* Caller's function */
+} CallRecord;
+
+/* Helper: grow a stack array */
+static void* grow_stack(void* stack, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return stack;
+    while (*capacity < needed) *capacity = *capacity ? *capacity * 2 : 4096;
+    return safe_realloc(stack, (size_t)*capacity * size, "interpreter stack");
+}
+
+/* Wrapping 64-bit arithmetic, like the machine registers */
+#define WRAP(x, op, y) ((long long)((unsigned long long)(x) op (unsigned long long)(y)))
+
+/* Run the program from main */
+int run_bytecode(const BytecodeProgram* program, InterpResult* result) {
+    result->return_value = 0;
+    result->exit_code = 0;
+    result->run_ms = 0;
+    result->instructions = 0;
+    memset(program->counters, 0, program->counter_count * sizeof(long long));
+    if (program->main_function < 0) {
+        /* A program without main exits with 0, like the linked one */
+        return 0;
+    }
+
+    const BytecodeInsn* code = program->code;
+    const BytecodeFunction* functions = program->functions;
+    long long* globals = (long long*)safe_calloc(program->global_count + 1, sizeof(long long), "global cells");
+    memcpy(globals, program->global_init, program->global_count * sizeof(long long));
+
+    int stack_capacity = 0, arg_capacity = 0, call_capacity = 0;
+    long long* stack = NULL;
+    long long* args = NULL;
+    CallRecord* calls = NULL;
+    int arg_count = 0, call_depth = 0;
+
+    /* Frame of main */
+    const BytecodeFunction* entry = &functions[program->main_function];
+    int function = program->main_function;
+    int frame = 0;
+    int top = entry->frame_size;
+    stack = (long long*)grow_stack(stack, &stack_capacity, top + 1, sizeof(long long));
+    memset(stack, 0, top * sizeof(long long));
+    long long* fp = stack;
+
+    const BytecodeInsn* ip = code + entry->entry;
+    const BytecodeInsn* insn;
+    long long executed = 0;
+    long long value = 0;
+    const char* error = NULL;
+
+#define CELL(n) ((n) >= 0 ? fp + (n) : globals + ~(n))
+#define A (*CELL(insn->a))
+#define B (*CELL(insn->b))
+#define C (*CELL(insn->c))
+
+    /* Pop the caller's frame back and store the returned value */
+#define RETURN_TO_CALLER() do { \
+        CallRecord* record = &calls[--call_depth]; \
+        top = frame; \
+        frame = record->frame; \
+        fp = stack + frame; \
+        function = record->function; \
+        ip = record->return_to; \
+        if (record->result != BC_NO_CELL) *CELL(record->result) = value; \
+    } while (0)
+
+#if INTERP_THREADED
+    static const void* dispatch[BC_OPCODE_COUNT] = {
+        [BC_MOV] = &&op_MOV, [BC_ADD] = &&op_ADD, [BC_SUB] = &&op_SUB, [BC_MUL] = &&op_MUL,
+        [BC_DIV] = &&op_DIV, [BC_MOD] = &&op_MOD, [BC_LT] = &&op_LT, [BC_GT] = &&op_GT,
+        [BC_LE] = &&op_LE, [BC_GE] = &&op_GE, [BC_EQ] = &&op_EQ, [BC_NE] = &&op_NE,
+        [BC_JUMP] = &&op_JUMP, [BC_JUMP_FALSE] = &&op_JUMP_FALSE, [BC_JUMP_TRUE] = &&op_JUMP_TRUE,
+        [BC_JUMP_NLT] = &&op_JUMP_NLT, [BC_JUMP_NGT] = &&op_JUMP_NGT, [BC_JUMP_NLE] = &&op_JUMP_NLE,
+        [BC_JUMP_NGE] = &&op_JUMP_NGE, [BC_JUMP_NEQ] = &&op_JUMP_NEQ, [BC_JUMP_NNE] = &&op_JUMP_NNE,
+        [BC_JUMP_LT] = &&op_JUMP_LT, [BC_JUMP_GT] = &&op_JUMP_GT, [BC_JUMP_LE] = &&op_JUMP_LE,
+        [BC_JUMP_GE] = &&op_JUMP_GE, [BC_JUMP_EQ] = &&op_JUMP_EQ, [BC_JUMP_NE] = &&op_JUMP_NE,
+        [BC_LOAD_ELEMENT] = &&op_LOAD_ELEMENT, [BC_STORE_ELEMENT] = &&op_STORE_ELEMENT,
+        [BC_PRINT] = &&op_PRINT, [BC_PARAM] = &&op_PARAM, [BC_CALL] = &&op_CALL,
+        [BC_RETURN] = &&op_RETURN, [BC_RETURN_ZERO] = &&op_RETURN_ZERO, [BC_PROFILE] = &&op_PROFILE
+    };
+#define TARGET(op) op_##op:
+#define NEXT() do { insn = ip++; executed++; goto *dispatch[insn->op]; } while (0)
+#else
+#define TARGET(op) case BC_##op:
+#define NEXT() continue
+#endif
+
+    double start = monotonic_ms();
+
+#if INTERP_THREADED
+    NEXT();
+    {
+#else
+    for (;;) {
+        insn = ip++;
+        executed++;
+        switch (insn->op) {
+#endif
+        TARGET(MOV)     A = B; NEXT();
+        TARGET(ADD)     A = WRAP(B, +, C); NEXT();
+        TARGET(SUB)     A = WRAP(B, -, C); NEXT();
+        TARGET(MUL)     A = WRAP(B, *, C); NEXT();
+        TARGET(DIV)
+            if (C == 0) { error = "division by zero"; goto stop; }
+            if (C == -1 && B == LLONG_MIN) { error = "division overflow"; goto stop; }
+            A = B / C;
+            NEXT();
+        TARGET(MOD)
+            if (C == 0) { error = "division by zero"; goto stop; }
+            A = C == -1 ? 0 : B % C;
+            NEXT();
+        TARGET(LT)      A = B < C; NEXT();
+        TARGET(GT)      A = B > C; NEXT();
+        TARGET(LE)      A = B <= C; NEXT();
+        TARGET(GE)      A = B >= C; NEXT();
+        TARGET(EQ)      A = B == C; NEXT();
+        TARGET(NE)      A = B != C; NEXT();
+        TARGET(JUMP)    ip = code + insn->a; NEXT();
+        TARGET(JUMP_FALSE)
+            if (B == 0) ip = code + insn->a;
+            NEXT();
+        TARGET(JUMP_TRUE)
+            if (B != 0) ip = code + insn->a;
+            NEXT();
+        TARGET(JUMP_NLT) if (!(B < C)) ip = code + insn->a; NEXT();
+        TARGET(JUMP_NGT) if (!(B > C)) ip = code + insn->a; NEXT();
+        TARGET(JUMP_NLE) if (!(B <= C)) ip = code + insn->a; NEXT();
+        TARGET(JUMP_NGE) if (!(B >= C)) ip = code + insn->a; NEXT();
+        TARGET(JUMP_NEQ) if (!(B == C)) ip = code + insn->a; NEXT();
+        TARGET(JUMP_NNE) if (!(B != C)) ip = code + insn->a; NEXT();
+        TARGET(JUMP_LT)  if (B < C) ip = code + insn->a; NEXT();
+        TARGET(JUMP_GT)  if (B > C) ip = code + insn->a; NEXT();
+        TARGET(JUMP_LE)  if (B <= C) ip = code + insn->a; NEXT();
+        TARGET(JUMP_GE)  if (B >= C) ip = code + insn->a; NEXT();
+        TARGET(JUMP_EQ)  if (B == C) ip = code + insn->a; NEXT();
+        TARGET(JUMP_NE)  if (B != C) ip = code + insn->a; NEXT();
+        TARGET(LOAD_ELEMENT) {
+            long long index = C;
+            if (index < 0 || index >= insn->d) { error = "array index out of range"; goto stop; }
+            A = CELL(insn->b)[index];
+            NEXT();
+        }
+        TARGET(STORE_ELEMENT) {
+            long long index = B;
+            if (index < 0 || index >= insn->d) { error = "array index out of range"; goto stop; }
+            CELL(insn->a)[index] = C;
+            NEXT();
+        }
+        TARGET(PRINT)
+            printf("%d\n", (int)A);
+            NEXT();
+        TARGET(PARAM)
+            if (arg_count == arg_capacity) {
+                args = (long long*)grow_stack(args, &arg_capacity, arg_count + 1, sizeof(long long));
+            }
+            args[arg_count++] = A;
+            NEXT();
+        TARGET(CALL) {
+            const BytecodeFunction* callee = &functions[insn->b];
+            if (call_depth == MAX_CALL_DEPTH) { error = "call depth limit exceeded"; goto stop; }
+            calls = (CallRecord*)grow_stack(calls, &call_capacity, call_depth + 1, sizeof(CallRecord));
+            calls[call_depth].return_to = ip;
+            calls[call_depth].frame = frame;
+            calls[call_depth].result = insn->a;
+            calls[call_depth].function = function;
+            call_depth++;
+
+            /* New frame above the caller's, parameters from the pushed arguments */
+            stack = (long long*)grow_stack(stack, &stack_capacity, top + callee->frame_size + 1, sizeof(long long));
+            frame = top;
+            top += callee->frame_size;
+            fp = stack + frame;
+            memset(fp, 0, callee->frame_size * sizeof(long long));
+
+            int count = insn->c;
+            int first_param = callee->frame_size - callee->param_count;
+            for (int i = 0; i < count && i < callee->param_count; i++) {
+                fp[first_param + i] = args[arg_count - count + i];
+            }
+            arg_count -= count;
+            function = insn->b;
+            ip = code + callee->entry;
+            NEXT();
+        }
+        TARGET(RETURN)
+            value = A;
+            if (call_depth == 0) goto stop;
+            RETURN_TO_CALLER();
+            NEXT();
+        TARGET(RETURN_ZERO)
+            value = 0;
+            if (call_depth == 0) goto stop;
+            RETURN_TO_CALLER();
+            NEXT();
+        TARGET(PROFILE)
+            program->counters[insn->a]++;
+            NEXT();
+#if !INTERP_THREADED
+        default:
+            error = "invalid bytecode";
+            goto stop;
+        }
+#endif
+    }
+
+stop:
+    result->run_ms = monotonic_ms() - start;
+    result->instructions = executed;
+    fflush(stdout);
+    if (error) {
+        fprintf(stderr, "Runtime error: %s in function '%s'\n", error, functions[function].name);
+    } else {
+        result->return_value = value;
+        result->exit_code = (int)(value & 0xFF);
+    }
+
+    free(globals);
+    free(stack);
+    free(args);
+    free(calls);
+    return error ? 1 : 0;
+
+#undef CELL
+#undef A
+#undef B
+#undef C
+#undef RETURN_TO_CALLER
+#undef TARGET
+#undef NEXT
+}
@@ -0,0 +1,125 @@
+/*
+ * INTERP.H - Bytecode Interpreter Header
+ * CST-405 Compiler Project
+ *
+ * This file lowers the optimized TAC into a compact bytecode and runs it
+ * (--interp). Every operand is resolved while lowering: variables become
+ * cell numbers in the current frame (parameters, locals and temporaries)
+ * or in the global area (global variables and constants), labels become
+ * instruction numbers and calls refer to functions by number. The
+ * interpreter never looks at a name.
+ *
+ * Programs behave like the generated x86-64 code: 64-bit arithmetic,
+ * print() shows the low 32 bits, falling off the end of a function returns
+ * 0. Division by zero and out-of-range array indexes stop the program with
+ * a runtime error instead of crashing.
+ */
+
+#ifndef INTERP_H
+#define INTERP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ircode.h"
+#include "symtable.h"
+
+/* Bytecode operations */
+typedef enum {
+    BC_MOV,                       /* a = b */
+    BC_ADD,                       /* a = b + c */
+    BC_SUB,                       /* a = b - c */
+    BC_MUL,                       /* a = b * c */
+    BC_DIV,                       /* a = b / c */
+    BC_MOD,                       /* a = b % c */
+    BC_LT,                        /* a = b < c (likewise GT .. NE) */
+    BC_GT,
+    BC_LE,
+    BC_GE,
+    BC_EQ,
+    BC_NE,
+    BC_JUMP,                      /* goto a */
+    BC_JUMP_FALSE,                /* if b == 0 goto a */
+    BC_JUMP_TRUE,                 /* if b != 0 goto a */
+    BC_JUMP_NLT,                  /* if !(b < c) goto a (RELOP + IF_FALSE fused) */
+    BC_JUMP_NGT,
+    BC_JUMP_NLE,
+    BC_JUMP_NGE,
+    BC_JUMP_NEQ,
+    BC_JUMP_NNE,
+    BC_JUMP_LT,                   /* if b < c goto a (RELOP + IF_TRUE fused) */
+    BC_JUMP_GT,
+    BC_JUMP_LE,
+    BC_JUMP_GE,
+    BC_JUMP_EQ,
+    BC_JUMP_NE,
+    BC_LOAD_ELEMENT,              /* a = b[c], b has d elements */
+    BC_STORE_ELEMENT,             /* a[b] = c, a has d elements */
+    BC_PRINT,                     /* print(a) */
+    BC_PARAM,                     /* push argument a */
+    BC_CALL,                      /* a = call function b with c arguments */
+    BC_RETURN,                    /* return a */
+    BC_RETURN_ZERO,               /* return 0 (void return, end of function) */
+    BC_PROFILE,                   /* profile counter a += 1 */
+    BC_OPCODE_COUNT
+} BytecodeOp;
+
+/* Operand cells: n >= 0 is cell n of the current frame, n < 0 is global
+ * cell ~n; BC_NO_CELL marks a call whose result is not used */
+#define BC_NO_CELL 0x7fffffff
+
+/* One instruction */
+typedef struct {
+    int op;                       /* BytecodeOp */
+    int a, b, c;                  /* Cells, jump target, function or count */
+    int d;                        /* Array length (element operations) */
+} BytecodeInsn;
+
+/* A function */
+typedef struct {
+    const char* name;             /* Function name (borrowed from the TAC) */
+    int entry;                    /* First instruction (-1 = not defined) */
+    int frame_size;               /* Cells in a frame */
+    int param_count;              /* Parameters (cells frame_size-param_count ..) */
+} BytecodeFunction;
+
+/* A lowered program */
+typedef struct {
+    BytecodeInsn* code;           /* Instructions of every function */
+    int code_count;
+    int code_capacity;
+    BytecodeFunction* functions;  /* Functions, defined or only called */
+    int function_count;
+    int function_capacity;
+    long long* global_init;       /* Initial global cells (globals 0, constants) */
+    int global_count;
+    int global_capacity;
+    int main_function;            /* Index of main (-1 = no main) */
+    long long* counters;          /* Profile counters (TAC_PROFILE), zeroed by each run */
+    int counter_count;
+} BytecodeProgram;
+
+/* Outcome of one run */
+typedef struct {
+    long long return_value;       /* Value main returned */
+    int exit_code;                /* Exit status a linked program would have */
+    double run_ms;                /* Wall-clock time spent interpreting */
+    long long instructions;       /* Bytecode instructions executed */
+} InterpResult;
+
+/* INTERPRETER FUNCTIONS */
+
+/* Lower optimized TAC to bytecode. Returns NULL (after reporting the
+ * problem) if the program calls a function that is not defined. */
+BytecodeProgram* lower_to_bytecode(TACCode* tac, SymbolTable* symtab);
+
+/* Run the program from main. Returns 0 if it finished, 1 after a runtime
+ * error. */
+int run_bytecode(const BytecodeProgram* program, InterpResult* result);
+
+/* Print the bytecode listing */
+void print_bytecode(const BytecodeProgram* program, FILE* out);
+
+/* Free a lowered program */
+void free_bytecode(BytecodeProgram* program);
+
+#endif /* INTERP_H */
@@ -8,35 +8,32 @@
  */
 
 #include "ircode.h"
-
-/* Global counters for generating unique names */
-int temp_count = 0;
-int label_count = 0;
+#include "diagnostics.h"
 
 /* Create a new empty TAC code list */
 TACCode* create_tac_code() {
-    TACCode* code = (TACCode*)malloc(sizeof(TACCode));
-    if (!code) {
-        fprintf(stderr, "Fatal Error: Failed to allocate TAC code\n");
-        exit(1);
-    }
+    TACCode* code = (TACCode*)safe_malloc(sizeof(TACCode), "TAC code");
     code->head = NULL;
     code->tail = NULL;
     code->instruction_count = 0;
+    code->units = NULL;
+    code->unit_count = 0;
+    code->temp_count = 0;
+    code->label_count = 0;
     return code;
 }
 
 /* Generate a new temporary variable name: t0, t1, t2, ... */
-char* new_temp() {
-    char* temp = (char*)malloc(20);
-    snprintf(temp, 20, "t%d", temp_count++);
+char* new_temp(TACCode* code) {
+    char* temp = (char*)safe_malloc(20, "temporary name");
+    snprintf(temp, 20, "t%d", code->temp_count++);
     return temp;
 }
 
 /* Generate a new label name: L0, L1, L2, ... */
-char* new_label() {
-    char* label = (char*)malloc(20);
-    snprintf(label, 20, "L%d", label_count++);
+char* new_label(TACCode* code) {
+    char* label = (char*)safe_malloc(20, "label name");
+    snprintf(label, 20, "L%d", code->label_count++);
     return label;
 }
 
@@ -46,18 +43,20 @@ TACInstruction* create_tac_instruction(TACOpcode opcode,
                                        const char* op1,
                                        const char* op2,
                                        const char* label) {
-    TACInstruction* inst = (TACInstruction*)malloc(sizeof(TACInstruction));
-    if (!inst) {
-        fprintf(stderr, "Fatal Error: Failed to allocate TAC instruction\n");
-        exit(1);
-    }
+    TACInstruction* inst = (TACInstruction*)safe_malloc(sizeof(TACInstruction), "TAC instruction");
 
     inst->opcode = opcode;
-    inst->result = result ? strdup(result) : NULL;
-    inst->op1 = op1 ? strdup(op1) : NULL;
-    inst->op2 = op2 ? strdup(op2) : NULL;
-    inst->label = label ? strdup(label) : NULL;
+    inst->result = safe_strdup(result, "TAC operand");
+    inst->op1 = safe_strdup(op1, "TAC operand");
+    inst->op2 = safe_strdup(op2, "TAC operand");
+    inst->label = safe_strdup(label, "TAC operand");
+    inst->flags = 0;
+    inst->count = 0;
+    inst->taken = 0;
+    inst->line = 0;
+    inst->chain[0] = inst->chain[1] = inst->chain[2] = NULL;
     inst->next = NULL;
+    inst->prev = NULL;
 
     return inst;
 }
@@ -71,11 +70,57 @@ void append_tac(TACCode* code, TACInstruction* inst) {
     } else {
         /* Append to end */
         code->tail->next = inst;
+        inst->prev = code->tail;
         code->tail = inst;
     }
     code->instruction_count++;
 }
 
+/* Link an instruction into the TAC code list after another */
+void insert_tac(TACCode* code, TACInstruction* after, TACInstruction* inst) {
+    inst->prev = after;
+    inst->next = after->next;
+    if (after->next) {
+        after->next->prev = inst;
+    } else {
+        code->tail = inst;
+    }
+    after->next = inst;
+    code->instruction_count++;
+}
+
+/* Unlink an instruction from the TAC code list */
+void remove_tac(TACCode* code, TACInstruction* inst) {
+    if (inst->prev) {
+        inst->prev->next = inst->next;
+    } else {
+        code->head = inst->next;
+    }
+
+    if (inst->next) {
+        inst->next->prev = inst->prev;
+    } else {
+        code->tail = inst->prev;
+    }
+    code->instruction_count--;
+}
+
+/* Free one instruction */
+void free_tac_instruction(TACInstruction* inst) {
+    free(inst->result);
+    free(inst->op1);
+    free(inst->op2);
+    free(inst->label);
+    free(inst);
+}
+
+/* Helper: name the TAC uses for the variable a node refers to - its
+ * storage name once semantic analysis has resolved it, which differs from
+ * the source name when the variable shadows another */
+static char* storage_name(ASTNode* node, char* name) {
+    return node->symbol ? node->symbol->storage_name : name;
+}
+
 /* Generate TAC for an expression - returns name of result variable/temp */
 char* gen_expression(ASTNode* node, TACCode* code) {
     if (!node) return NULL;
@@ -83,7 +128,7 @@ char* gen_expression(ASTNode* node, TACCode* code) {
     switch (node->type) {
         case NODE_NUMBER: {
             /* Integer literal: create temp and load constant */
-            char* temp = new_temp();
+            char* temp = new_temp(code);
             char num_str[20];
             snprintf(num_str, 20, "%d", node->data.num_value);
 
@@ -95,8 +140,8 @@ char* gen_expression(ASTNode* node, TACCode* code) {
         }
 
         case NODE_IDENTIFIER: {
-            /* Variable reference: just return the variable name */
-            return strdup(node->data.str_value);
+            /* Variable reference: just return the variable's storage name */
+            return safe_strdup(storage_name(node, node->data.str_value), "TAC operand");
         }
 
         case NODE_BINARY_OP: {
@@ -104,7 +149,7 @@ char* gen_expression(ASTNode* node, TACCode* code) {
             char* left = gen_expression(node->data.binary_op.left, code);
             char* right = gen_expression(node->data.binary_op.right, code);
 
-            char* result = new_temp();
+            char* result = new_temp(code);
 
             /* Determine the opcode based on operator */
             TACOpcode opcode;
@@ -125,6 +170,7 @@ char* gen_expression(ASTNode* node, TACCode* code) {
             TACInstruction* inst = create_tac_instruction(opcode,
                                                           result, left, right,
                                                           NULL);
+            inst->line = node->line_number;
             append_tac(code, inst);
 
             return result;
@@ -135,7 +181,7 @@ char* gen_expression(ASTNode* node, TACCode* code) {
             char* left = gen_expression(node->data.binary_op.left, code);
             char* right = gen_expression(node->data.binary_op.right, code);
 
-            char* result = new_temp();
+            char* result = new_temp(code);
 
             /* Create relational operation instruction */
             TACInstruction* inst = create_tac_instruction(TAC_RELOP,
@@ -148,10 +194,10 @@ char* gen_expression(ASTNode* node, TACCode* code) {
 
         case NODE_ARRAY_ACCESS: {
             /* Array access: arr[index] */
-            char* array_name = node->data.array_access.array_name;
+            char* array_name = storage_name(node, node->data.array_access.array_name);
             char* index = gen_expression(node->data.array_access.index, code);
 
-            char* result = new_temp();
+            char* result = new_temp(code);
 
             /* TAC_ARRAY_LOAD: result = array[index] */
             TACInstruction* inst = create_tac_instruction(TAC_ARRAY_LOAD,
@@ -195,7 +241,7 @@ char* gen_expression(ASTNode* node, TACCode* code) {
             }
 
             /* Generate call instruction */
-            char* result = new_temp();
+            char* result = new_temp(code);
             char arg_count_str[20];
             snprintf(arg_count_str, 20, "%d", arg_count);
 
@@ -222,11 +268,24 @@ void gen_statement(ASTNode* node, TACCode* code) {
             break;
 
         case NODE_ASSIGNMENT: {
+            if (node->data.assignment.index) {
+                /* Element assignment: arr[index] = expr */
+                char* index = gen_expression(node->data.assignment.index, code);
+                char* value = gen_expression(node->data.assignment.expr, code);
+
+                /* TAC_ARRAY_STORE: array[index] = value (result, op1, op2) */
+                TACInstruction* inst = create_tac_instruction(TAC_ARRAY_STORE,
+                                                              storage_name(node, node->data.assignment.var_name),
+                                                              index, value, NULL);
+                append_tac(code, inst);
+                break;
+            }
+
             /* Assignment: var = expr */
             char* expr_result = gen_expression(node->data.assignment.expr, code);
 
             TACInstruction* inst = create_tac_instruction(TAC_ASSIGN,
-                                                          node->data.assignment.var_name,
+                                                          storage_name(node, node->data.assignment.var_name),
                                                           expr_result,
                                                           NULL, NULL);
             append_tac(code, inst);
@@ -246,42 +305,46 @@ void gen_statement(ASTNode* node, TACCode* code) {
 
         case NODE_WHILE: {
             /* While loop: while (condition) { body }
+             *
+             * The loop is rotated: the test sits at the bottom, so each
+             * iteration takes one branch, and a copy of it in front of
+             * the loop skips the body when it would not run at all.
              *
              * Generated code structure:
-             *   L_start:                  // Loop start label
-             *     temp = condition        // Evaluate condition
-             *     if_false temp goto L_end  // Exit if false
+             *     temp = condition        // Guard: evaluate condition once
+             *     if_false temp goto L_end  // Skip the loop if false
+             *   L_start:                  // Loop body label
              *     <body>                  // Loop body
-             *     goto L_start            // Jump back to start
+             *     temp2 = condition       // Evaluate condition again
+             *     if_true temp2 goto L_start  // Loop while true
              *   L_end:                    // Loop end label
              */
 
-            char* label_start = new_label();
-            char* label_end = new_label();
-
-            /* L_start: */
-            TACInstruction* start_label = create_tac_instruction(TAC_LABEL,
-                                                                 NULL, NULL,
-                                                                 NULL, label_start);
-            append_tac(code, start_label);
+            char* label_start = new_label(code);
+            char* label_end = new_label(code);
 
-            /* Evaluate condition */
+            /* Guard: if_false cond_result goto L_end */
             char* cond_result = gen_expression(node->data.while_loop.condition, code);
-
-            /* if_false cond_result goto L_end */
             TACInstruction* if_false = create_tac_instruction(TAC_IF_FALSE,
                                                               NULL, cond_result,
                                                               NULL, label_end);
             append_tac(code, if_false);
 
+            /* L_start: */
+            TACInstruction* start_label = create_tac_instruction(TAC_LABEL,
+                                                                 NULL, NULL,
+                                                                 NULL, label_start);
+            append_tac(code, start_label);
+
             /* Generate code for loop body */
             gen_statement(node->data.while_loop.body, code);
 
-            /* goto L_start */
-            TACInstruction* goto_start = create_tac_instruction(TAC_GOTO,
-                                                                NULL, NULL,
-                                                                NULL, label_start);
-            append_tac(code, goto_start);
+            /* Bottom test: if_true cond_result goto L_start */
+            cond_result = gen_expression(node->data.while_loop.condition, code);
+            TACInstruction* if_true = create_tac_instruction(TAC_IF_TRUE,
+                                                             NULL, cond_result,
+                                                             NULL, label_start);
+            append_tac(code, if_true);
 
             /* L_end: */
             TACInstruction* end_label = create_tac_instruction(TAC_LABEL,
@@ -294,50 +357,52 @@ void gen_statement(ASTNode* node, TACCode* code) {
 
         case NODE_FOR: {
             /* For loop: for (init; condition; update) { body }
+             *
+             * Rotated like the while loop.
              *
              * Generated code structure:
-             *   <init>                    // Initialization
-             *   L_start:                  // Loop start label
-             *     temp = condition        // Evaluate condition
-             *     if_false temp goto L_end  // Exit if false
+             *     <init>                  // Initialization
+             *     temp = condition        // Guard: evaluate condition once
+             *     if_false temp goto L_end  // Skip the loop if false
+             *   L_start:                  // Loop body label
              *     <body>                  // Loop body
              *     <update>                // Update statement
-             *     goto L_start            // Jump back to start
+             *     temp2 = condition       // Evaluate condition again
+             *     if_true temp2 goto L_start  // Loop while true
              *   L_end:                    // Loop end label
              */
 
             /* Generate initialization */
             gen_statement(node->data.for_loop.init, code);
 
-            char* label_start = new_label();
-            char* label_end = new_label();
+            char* label_start = new_label(code);
+            char* label_end = new_label(code);
 
-            /* L_start: */
-            TACInstruction* start_label = create_tac_instruction(TAC_LABEL,
-                                                                 NULL, NULL,
-                                                                 NULL, label_start);
-            append_tac(code, start_label);
-
-            /* Evaluate condition */
+            /* Guard: if_false cond_result goto L_end */
             char* cond_result = gen_expression(node->data.for_loop.condition, code);
-
-            /* if_false cond_result goto L_end */
             TACInstruction* if_false = create_tac_instruction(TAC_IF_FALSE,
                                                               NULL, cond_result,
                                                               NULL, label_end);
             append_tac(code, if_false);
 
+            /* L_start: */
+            TACInstruction* start_label = create_tac_instruction(TAC_LABEL,
+                                                                 NULL, NULL,
+                                                                 NULL, label_start);
+            append_tac(code, start_label);
+
             /* Generate code for loop body */
             gen_statement(node->data.for_loop.body, code);
 
             /* Generate update statement */
             gen_statement(node->data.for_loop.update, code);
 
-            /* goto L_start */
-            TACInstruction* goto_start = create_tac_instruction(TAC_GOTO,
-                                                                NULL, NULL,
-                                                                NULL, label_start);
-            append_tac(code, goto_start);
+            /* Bottom test: if_true cond_result goto L_start */
+            cond_result = gen_expression(node->data.for_loop.condition, code);
+            TACInstruction* if_true = create_tac_instruction(TAC_IF_TRUE,
+                                                             NULL, cond_result,
+                                                             NULL, label_start);
+            append_tac(code, if_true);
 
             /* L_end: */
             TACInstruction* end_label = create_tac_instruction(TAC_LABEL,
@@ -356,10 +421,9 @@ void gen_statement(ASTNode* node, TACCode* code) {
              *     <body>                  // Loop body (executes first)
              *     temp = condition        // Evaluate condition
              *     if_true temp goto L_start  // Continue if true
-             *   L_end:                    // Loop end label (implicit)
              */
 
-            char* label_start = new_label();
+            char* label_start = new_label(code);
 
             /* L_start: */
             TACInstruction* start_label = create_tac_instruction(TAC_LABEL,
@@ -373,31 +437,11 @@ void gen_statement(ASTNode* node, TACCode* code) {
             /* Evaluate condition */
             char* cond_result = gen_expression(node->data.do_while_loop.condition, code);
 
-            /* For do-while, we want to continue if condition is TRUE */
-            /* We can use a temporary to invert the logic or create a new TAC instruction */
-            /* For simplicity, we'll generate: if_true cond_result goto L_start */
-            /* However, TAC_IF_FALSE is available, so we need to work around it */
-            
-            /* Create a label for fallthrough (end of loop) */
-            char* label_end = new_label();
-            
-            /* if_false cond_result goto L_end */
-            TACInstruction* if_false = create_tac_instruction(TAC_IF_FALSE,
-                                                              NULL, cond_result,
-                                                              NULL, label_end);
-            append_tac(code, if_false);
-
-            /* goto L_start (if condition was true) */
-            TACInstruction* goto_start = create_tac_instruction(TAC_GOTO,
-                                                                NULL, NULL,
-                                                                NULL, label_start);
-            append_tac(code, goto_start);
-
-            /* L_end: */
-            TACInstruction* end_label = create_tac_instruction(TAC_LABEL,
-                                                               NULL, NULL,
-                                                               NULL, label_end);
-            append_tac(code, end_label);
+            /* if_true cond_result goto L_start */
+            TACInstruction* if_true = create_tac_instruction(TAC_IF_TRUE,
+                                                             NULL, cond_result,
+                                                             NULL, label_start);
+            append_tac(code, if_true);
 
             break;
         }
@@ -415,7 +459,7 @@ void gen_statement(ASTNode* node, TACCode* code) {
              *                                L_end:
              */
 
-            char* label_end = new_label();
+            char* label_end = new_label(code);
             char* label_else = NULL;
 
             /* Evaluate condition */
@@ -423,7 +467,7 @@ void gen_statement(ASTNode* node, TACCode* code) {
 
             if (node->data.if_stmt.else_branch != NULL) {
                 /* Has else branch */
-                label_else = new_label();
+                label_else = new_label(code);
 
                 /* if_false cond_result goto L_else */
                 TACInstruction* if_false = create_tac_instruction(TAC_IF_FALSE,
@@ -552,7 +596,7 @@ void gen_statement(ASTNode* node, TACCode* code) {
             }
 
             /* Generate call instruction */
-            char* result = new_temp();
+            char* result = new_temp(code);
             char arg_count_str[20];
             snprintf(arg_count_str, 20, "%d", arg_count);
 
@@ -599,35 +643,132 @@ void gen_statement(ASTNode* node, TACCode* code) {
 
 /* Generate TAC for the entire program */
 TACCode* generate_tac(ASTNode* root) {
-    printf("\n=========== INTERMEDIATE CODE GENERATION STARTED ==========\n\n");
+    log_message(LOG_NORMAL, "\n=========== INTERMEDIATE CODE GENERATION STARTED ==========\n\n");
 
     TACCode* code = create_tac_code();
 
-    /* Reset counters for each compilation */
-    temp_count = 0;
-    label_count = 0;
-
     if (root && root->type == NODE_PROGRAM) {
         /* Handle program with declaration list (may include functions) */
         ASTNode* current = root->data.program.statements;
+        int capacity = 0;
 
         while (current) {
+            ASTNode* item = current;
             if (current->type == NODE_STATEMENT_LIST) {
-                gen_statement(current->data.stmt_list.statement, code);
+                item = current->data.stmt_list.statement;
                 current = current->data.stmt_list.next;
             } else {
-                gen_statement(current, code);
-                break;
+                current = NULL;
             }
+
+            /* Record the unit boundaries while generating */
+            if (code->unit_count == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                code->units = (TACUnit*)safe_realloc(code->units, capacity * sizeof(TACUnit), "TAC units");
+            }
+            TACUnit* unit = &code->units[code->unit_count++];
+            TACInstruction* before = code->tail;
+            unit->node = item;
+            unit->temp_base = code->temp_count;
+            unit->label_base = code->label_count;
+
+            gen_statement(item, code);
+
+            unit->first = before ? before->next : code->head;
+            unit->last = unit->first ? code->tail : NULL;
         }
     }
 
-    printf("Generated %d TAC instructions\n", code->instruction_count);
-    printf("\n=========== INTERMEDIATE CODE GENERATION COMPLETE =========\n");
+    log_message(LOG_NORMAL, "Generated %d TAC instructions\n", code->instruction_count);
+    log_message(LOG_NORMAL, "\n=========== INTERMEDIATE CODE GENERATION COMPLETE =========\n");
 
     return code;
 }
 
+/* Split the program TAC into one list per top-level unit */
+TACCode** split_tac_units(TACCode* code, int* count) {
+    TACCode** parts = (TACCode**)safe_malloc((code->unit_count + 1) * sizeof(TACCode*), "TAC unit lists");
+
+    for (int i = 0; i < code->unit_count; i++) {
+        TACUnit* unit = &code->units[i];
+        TACCode* part = create_tac_code();
+
+        if (unit->first) {
+            part->head = unit->first;
+            part->tail = unit->last;
+            for (TACInstruction* inst = unit->first; inst; inst = inst->next) {
+                part->instruction_count++;
+                if (inst == unit->last) break;
+            }
+            unit->first->prev = NULL;
+            unit->last->next = NULL;
+        }
+        parts[i] = part;
+    }
+
+    *count = code->unit_count;
+    code->head = NULL;
+    code->tail = NULL;
+    code->instruction_count = 0;
+    return parts;
+}
+
+/* Rejoin per-unit lists into the program TAC */
+void join_tac_units(TACCode* code, TACCode** parts, int count) {
+    for (int i = 0; i < count; i++) {
+        TACCode* part = parts[i];
+
+        if (i < code->unit_count) {
+            code->units[i].first = part->head;
+            code->units[i].last = part->tail;
+        }
+
+        if (part->head) {
+            if (!code->head) {
+                code->head = part->head;
+            } else {
+                code->tail->next = part->head;
+                part->head->prev = code->tail;
+            }
+            code->tail = part->tail;
+            code->instruction_count += part->instruction_count;
+        }
+
+        part->head = NULL;
+        part->tail = NULL;
+        free_tac(part);
+    }
+    free(parts);
+}
+
+/* Is the operand an integer literal? */
+int is_literal(const char* operand) {
+    if (!operand) return 0;
+    if (*operand == '-') operand++;
+    if (!*operand) return 0;
+    for (; *operand; operand++) {
+        if (*operand < '0' || *operand > '9') return 0;
+    }
+    return 1;
+}
+
+/* Shift count of a power-of-two divisor */
+int divisor_shift(const TACInstruction* inst) {
+    const char* divisor = inst->op2;
+    TACInstruction* load = inst->prev;
+    if (divisor && load && load->opcode == TAC_LOAD_CONST && load->result &&
+        strcmp(load->result, divisor) == 0) {
+        divisor = load->op1;
+    }
+    if (!divisor || !*divisor || strspn(divisor, "0123456789") != strlen(divisor)) return -1;
+
+    long long value = strtoll(divisor, NULL, 10);
+    for (int k = 0; k <= 30; k++) {
+        if (value == (1LL << k)) return k;
+    }
+    return -1;
+}
+
 /* Convert opcode to string for printing */
 const char* opcode_to_string(TACOpcode opcode) {
     switch (opcode) {
@@ -642,6 +783,7 @@ const char* opcode_to_string(TACOpcode opcode) {
         case TAC_LABEL:      return "LABEL";
         case TAC_GOTO:       return "GOTO";
         case TAC_IF_FALSE:   return "IF_FALSE";
+        case TAC_IF_TRUE:    return "IF_TRUE";
         case TAC_RELOP:      return "RELOP";
         case TAC_ARRAY_STORE: return "ARRAY_STORE";
         case TAC_ARRAY_LOAD:  return "ARRAY_LOAD";
@@ -650,10 +792,24 @@ const char* opcode_to_string(TACOpcode opcode) {
         case TAC_CALL:        return "CALL";
         case TAC_RETURN:      return "RETURN";
         case TAC_RETURN_VOID: return "RETURN_VOID";
+        case TAC_PROFILE:     return "PROFILE";
+        case TAC_BOUNDS_CHECK: return "BOUNDS_CHECK";
         default:             return "UNKNOWN";
     }
 }
 
+/* Write the TAC in the .ir file format */
+void write_tac(TACCode* code, OutputSink* out) {
+    for (TACInstruction* inst = code->head; inst; inst = inst->next) {
+        sink_puts(out, opcode_to_string(inst->opcode));
+        if (inst->result) { sink_write(out, " ", 1); sink_puts(out, inst->result); }
+        if (inst->op1) { sink_write(out, " ", 1); sink_puts(out, inst->op1); }
+        if (inst->op2) { sink_write(out, " ", 1); sink_puts(out, inst->op2); }
+        if (inst->label) { sink_write(out, " ", 1); sink_puts(out, inst->label); }
+        sink_write(out, "\n", 1);
+    }
+}
+
 /* Print the TAC code in a readable format */
 void print_tac(TACCode* code) {
     printf("\n=============== THREE-ADDRESS CODE (TAC) ==================\n\n");
@@ -702,6 +858,7 @@ void print_tac(TACCode* code) {
                 break;
 
             case TAC_IF_FALSE:
+            case TAC_IF_TRUE:
                 printf(" %-10s %-10s %-10s %-10s\n",
                        "-", current->op1, "-", current->label);
                 break;
@@ -743,6 +900,15 @@ void print_tac(TACCode* code) {
                 printf("\n");
                 break;
 
+            case TAC_PROFILE:
+                printf(" %-10s %-10s (counter)\n", "-", current->op1);
+                break;
+
+            case TAC_BOUNDS_CHECK:
+                printf(" %-10s %-10s %-10s (bounds check)\n",
+                       current->result, current->op1, current->op2);
+                break;
+
             default:
                 printf("\n");
                 break;
@@ -762,15 +928,10 @@ void free_tac(TACCode* code) {
     TACInstruction* current = code->head;
     while (current) {
         TACInstruction* next = current->next;
-
-        free(current->result);
-        free(current->op1);
-        free(current->op2);
-        free(current->label);
-        free(current);
-
+        free_tac_instruction(current);
         current = next;
     }
 
+    free(code->units);
     free(code);
 }
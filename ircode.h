@@ -19,6 +19,7 @@
 #include <string.h>
 #include "ast.h"
 #include "symtable.h"
+#include "output.h"
 
 /* TAC Instruction Types */
 typedef enum {
@@ -33,6 +34,7 @@ typedef enum {
     TAC_LABEL,         /* label: (for control flow) */
     TAC_GOTO,          /* goto label (unconditional jump) */
     TAC_IF_FALSE,      /* if_false op1 goto label (conditional jump) */
+    TAC_IF_TRUE,       /* if_true op1 goto label (conditional jump) */
     TAC_RELOP,         /* result = op1 relop op2 (for conditions) */
     TAC_ARRAY_STORE,   /* array[index] = value (arr, index, value) */
     TAC_ARRAY_LOAD,    /* result = array[index] (result, arr, index) */
@@ -40,9 +42,13 @@ typedef enum {
     TAC_PARAM,         /* param value */
     TAC_CALL,          /* result = call function_name, num_args */
     TAC_RETURN,        /* return value */
-    TAC_RETURN_VOID    /* return (no value) */
+    TAC_RETURN_VOID,   /* return (no value) */
+    TAC_PROFILE,       /* add 1 to profile counter op1 (--profile-generate) */
+    TAC_BOUNDS_CHECK   /* stop unless 0 <= index < size (arr, index, size; --bounds-check) */
 } TACOpcode;
 
+struct DefUseLink;
+
 /* Three-Address Code Instruction */
 typedef struct TACInstruction {
     TACOpcode opcode;                /* Operation type */
@@ -50,30 +56,55 @@ typedef struct TACInstruction {
     char* op1;                       /* First operand */
     char* op2;                       /* Second operand (if needed) */
     char* label;                     /* Label (for jumps and labels) */
+    unsigned flags;                  /* Optimizer bookkeeping (TAC_FLAG_*) */
+    long long count;                 /* Times executed (TAC_FLAG_COUNTED, --profile-use) */
+    long long taken;                 /* Times a conditional jump was taken (likewise) */
+    int line;                        /* Source line of an arithmetic operation (0 = unknown) */
+    struct DefUseLink* chain[3];     /* Def-use chain entries for result/op1/op2 (defuse.h) */
     struct TACInstruction* next;     /* Next instruction in sequence */
+    struct TACInstruction* prev;     /* Previous instruction (O(1) removal) */
 } TACInstruction;
 
+/* Instruction flags used while optimizing */
+#define TAC_FLAG_QUEUED  1u          /* On the optimizer worklist */
+#define TAC_FLAG_REMOVED 2u          /* Unlinked, waiting to be freed */
+#define TAC_FLAG_TARGET  4u          /* LABEL some jump refers to (block layout) */
+#define TAC_FLAG_COUNTED 8u          /* count (and taken for jumps) come from a profile */
+#define TAC_FLAG_NONNEG  16u         /* DIV/MOD whose operands are never negative (range.h) */
+
+/* Top-level unit - The slice of the TAC list generated for one top-level
+ * item (function definition or global statement). Units are contiguous and
+ * cover the list in program order, so each one can be optimized and
+ * translated on its own. Valid until the list is modified. */
+typedef struct {
+    ASTNode* node;                   /* Top-level AST node it was generated from */
+    TACInstruction* first;           /* First instruction (NULL if none generated) */
+    TACInstruction* last;            /* Last instruction */
+    int temp_base;                   /* First temporary number it may use */
+    int label_base;                  /* First label number it may use */
+} TACUnit;
+
 /* TAC Code List - Holds all generated instructions */
 typedef struct {
     TACInstruction* head;            /* First instruction */
     TACInstruction* tail;            /* Last instruction (for efficient append) */
     int instruction_count;           /* Number of instructions */
+    TACUnit* units;                  /* Top-level units (filled by generate_tac) */
+    int unit_count;                  /* Number of units */
+    int temp_count;                  /* Next temporary number */
+    int label_count;                 /* Next label number */
 } TACCode;
 
-/* Temporary variable and label generation */
-extern int temp_count;               /* Counter for temporary variables */
-extern int label_count;              /* Counter for labels */
-
 /* INTERMEDIATE CODE GENERATION FUNCTIONS */
 
 /* Create a new TAC code list */
 TACCode* create_tac_code();
 
-/* Generate a new temporary variable name (t0, t1, t2, ...) */
-char* new_temp();
+/* Generate a new temporary variable name (t0, t1, t2, ...) for code */
+char* new_temp(TACCode* code);
 
-/* Generate a new label name (L0, L1, L2, ...) */
-char* new_label();
+/* Generate a new label name (L0, L1, L2, ...) for code */
+char* new_label(TACCode* code);
 
 /* Create a new TAC instruction */
 TACInstruction* create_tac_instruction(TACOpcode opcode,
@@ -85,6 +116,16 @@ TACInstruction* create_tac_instruction(TACOpcode opcode,
 /* Append an instruction to the TAC code list */
 void append_tac(TACCode* code, TACInstruction* inst);
 
+/* Link inst into the list right after the instruction after */
+void insert_tac(TACCode* code, TACInstruction* after, TACInstruction* inst);
+
+/* Unlink an instruction from the list in O(1) without freeing it. Its own
+ * next pointer is left alone, so a walk that is standing on it can go on. */
+void remove_tac(TACCode* code, TACInstruction* inst);
+
+/* Free one instruction (not linked into any list) */
+void free_tac_instruction(TACInstruction* inst);
+
 /* Generate TAC for the entire program (main entry point) */
 TACCode* generate_tac(ASTNode* root);
 
@@ -95,12 +136,32 @@ void gen_statement(ASTNode* node, TACCode* code);
  * Returns the name of the temporary/variable holding the result */
 char* gen_expression(ASTNode* node, TACCode* code);
 
+/* Split a program's TAC into one list per top-level unit (program order).
+ * The instructions move into the returned lists; code is left empty. */
+TACCode** split_tac_units(TACCode* code, int* count);
+
+/* Inverse of split_tac_units - append the unit lists to code in order,
+ * refresh the unit boundaries and free the lists */
+void join_tac_units(TACCode* code, TACCode** parts, int count);
+
 /* Print TAC code in readable format */
 void print_tac(TACCode* code);
 
+/* Write TAC in the .ir file format (one "OPCODE operands..." line each) */
+void write_tac(TACCode* code, OutputSink* out);
+
 /* Free TAC code memory */
 void free_tac(TACCode* code);
 
+/* Is an operand an integer literal ("42", "-7") rather than a variable,
+ * temporary or label? NULL is not. */
+int is_literal(const char* operand);
+
+/* k if the divisor of a DIV or MOD is the constant 2^k (0 <= k <= 30), as
+ * a literal or loaded by the instruction just before; otherwise -1. Lets
+ * the code generators divide a TAC_FLAG_NONNEG division by shifting. */
+int divisor_shift(const TACInstruction* inst);
+
 /* Get string representation of opcode (for debugging) */
 const char* opcode_to_string(TACOpcode opcode);
 
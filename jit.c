@@ -0,0 +1,208 @@
+/*
+ * JIT.C - In-Process Execution Implementation
+ * CST-405 Compiler Project
+ *
+ * Memory layout of a loaded program (one anonymous mapping, so every
+ * RIP-relative reference stays within +-2 GB):
+ *
+ *   .text | call stubs   read + execute
+ *   .data | .bss         read + write
+ *
+ * External calls (R_X86_64_PLT32) go through a stub "mov r11, imm64;
+ * jmp r11" placed after .text, because the helper in the compiler is
+ * usually too far away for a rel32.
+ *
+ * atexit() only records the handler; the handlers run when main returns,
+ * before the program is unloaded (an instrumented program writes its
+ * profile from one). The file functions such a handler uses are the C
+ * library's own. exit() (a failed --bounds-check check) jumps back into
+ * jit_run, which then finishes as if main had returned the status.
+ */
+
+#include "jit.h"
+#include "diagnostics.h"
+#include "timing.h"
+#include <string.h>
+#include <setjmp.h>
+
+#if (defined(__x86_64__) || defined(__amd64__)) && !defined(_WIN32)
+#define JIT_HOST 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define JIT_HOST 0
+#endif
+
+#define STUB_SIZE 13
+#define MAX_EXIT_HANDLERS 32
+
+/* Can programs be run in-process on this host? */
+int jit_supported(void) {
+    return JIT_HOST;
+}
+
+#if JIT_HOST
+
+/* print(x) in a running program: called as printf(fmt_int, x) */
+static int jit_print(const char* format, long value) {
+    (void)format;
+    return printf("%d\n", (int)value);
+}
+
+/* Exit handlers the running program registered */
+static THREAD_LOCAL void (*exit_handlers[MAX_EXIT_HANDLERS])(void);
+static THREAD_LOCAL int exit_handler_count;
+
+/* atexit(handler) in a running program */
+static int jit_atexit(void (*handler)(void)) {
+    if (exit_handler_count == MAX_EXIT_HANDLERS) return -1;
+    exit_handlers[exit_handler_count++] = handler;
+    return 0;
+}
+
+/* Where exit() in a running program returns to */
+static THREAD_LOCAL jmp_buf* exit_target;
+static THREAD_LOCAL int exit_status;
+
+/* exit(status) in a running program: unwind to jit_run */
+static void jit_exit(int status) {
+    exit_status = status;
+    longjmp(*exit_target, 1);
+}
+
+/* Helper: address of an external function the program may call */
+static void* external_function(const char* name) {
+    if (strcmp(name, "printf") == 0) return (void*)jit_print;
+    if (strcmp(name, "atexit") == 0) return (void*)jit_atexit;
+    if (strcmp(name, "fopen") == 0) return (void*)fopen;
+    if (strcmp(name, "fputs") == 0) return (void*)fputs;
+    if (strcmp(name, "fprintf") == 0) return (void*)fprintf;
+    if (strcmp(name, "fclose") == 0) return (void*)fclose;
+    if (strcmp(name, "dprintf") == 0) return (void*)dprintf;
+    if (strcmp(name, "exit") == 0) return (void*)jit_exit;
+    return NULL;
+}
+
+static size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+/* Load the object, call main and unload it */
+int jit_run(const ElfObject* object, JitResult* result) {
+    const ElfSection* text = &object->sections[ELF_TEXT];
+    const ElfSection* data = &object->sections[ELF_DATA];
+    const ElfSection* bss = &object->sections[ELF_BSS];
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* Layout: stubs follow .text, data starts on the next page */
+    size_t stub_offset = align_up(text->size, 16);
+    size_t code_size = align_up(stub_offset + STUB_SIZE * (size_t)object->symbol_count, page);
+    size_t section_base[ELF_SECTION_COUNT];
+    section_base[ELF_TEXT] = 0;
+    section_base[ELF_DATA] = code_size;
+    section_base[ELF_BSS] = align_up(code_size + data->size, bss->align ? bss->align : 8);
+    size_t total = align_up(section_base[ELF_BSS] + bss->size, page);
+    if (total == code_size) total += page;
+
+    unsigned char* base = (unsigned char*)mmap(NULL, total, PROT_READ | PROT_WRITE,
+                                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot allocate memory for the program\n");
+        return 1;
+    }
+    if (text->size) memcpy(base, text->data, text->size);
+    if (data->size) memcpy(base + section_base[ELF_DATA], data->data, data->size);
+
+    /* Symbol addresses; external functions get a stub */
+    unsigned char** address = (unsigned char**)safe_calloc(object->symbol_count + 1,
+                                                           sizeof(unsigned char*), "JIT symbols");
+    int status = 0;
+    unsigned char* main_entry = NULL;
+    for (int i = 0; i < object->symbol_count; i++) {
+        const ElfSymbol* sym = &object->symbols[i];
+        if (sym->section != ELF_UNDEFINED) {
+            address[i] = base + section_base[sym->section] + sym->value;
+            if (sym->binding == ELF_GLOBAL && strcmp(sym->name, "main") == 0) main_entry = address[i];
+            continue;
+        }
+
+        void* target = external_function(sym->name);
+        if (!target) continue;          /* Reported if something refers to it */
+
+        unsigned char* stub = base + stub_offset + STUB_SIZE * (size_t)i;
+        unsigned long long target_address = (unsigned long long)(size_t)target;
+        stub[0] = 0x49;                 /* mov r11, imm64 */
+        stub[1] = 0xBB;
+        for (int b = 0; b < 8; b++) stub[2 + b] = (unsigned char)(target_address >> (8 * b));
+        stub[10] = 0x41;                /* jmp r11 */
+        stub[11] = 0xFF;
+        stub[12] = 0xE3;
+        address[i] = stub;
+    }
+
+    /* Relocations: S + A - P into the 32-bit field */
+    for (int r = 0; r < object->relocation_count && status == 0; r++) {
+        const ElfRelocation* reloc = &object->relocations[r];
+        if (!address[reloc->symbol]) {
+            fprintf(stderr, "Error: Undefined symbol '%s' in the program\n",
+                    object->symbols[reloc->symbol].name);
+            status = 1;
+            break;
+        }
+        unsigned char* field = base + reloc->offset;
+        long long value = (long long)(address[reloc->symbol] - field) + reloc->addend;
+        for (int b = 0; b < 4; b++) field[b] = (unsigned char)((unsigned long long)value >> (8 * b));
+    }
+    free(address);
+
+    if (status == 0 && !main_entry) {
+        fprintf(stderr, "Error: The program has no main function\n");
+        status = 1;
+    }
+    if (status == 0 && mprotect(base, code_size, PROT_READ | PROT_EXEC) != 0) {
+        fprintf(stderr, "Error: Cannot make the program executable\n");
+        status = 1;
+    }
+
+    if (status == 0) {
+        /* The generated code follows the C calling convention for main */
+        long (*entry)(void);
+        memcpy(&entry, &main_entry, sizeof(entry));
+
+        jmp_buf exit_buffer;
+        long value;
+        exit_target = &exit_buffer;
+        exit_handler_count = 0;
+        double start = monotonic_ms();
+        if (setjmp(exit_buffer) == 0) {
+            value = entry();
+        } else {
+            value = exit_status;
+        }
+        result->run_ms = monotonic_ms() - start;
+
+        /* Like exit(): handlers in reverse order of registration */
+        while (exit_handler_count > 0) {
+            exit_handlers[--exit_handler_count]();
+        }
+        fflush(stdout);
+
+        result->return_value = value;
+        result->exit_code = (int)(value & 0xFF);
+    }
+
+    munmap(base, total);
+    return status;
+}
+
+#else
+
+/* Load the object, call main and unload it */
+int jit_run(const ElfObject* object, JitResult* result) {
+    (void)object;
+    (void)result;
+    fprintf(stderr, "Error: --run needs an x86-64 host with the System V calling convention\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * JIT.H - In-Process Execution Header
+ * CST-405 Compiler Project
+ *
+ * This file runs a program straight from the in-memory object built by
+ * the object code generator (--run): the sections are copied into an
+ * executable mapping, relocations are applied in place, print calls go to
+ * a helper inside the compiler and main is called like a C function. No
+ * assembler, linker or new process is involved.
+ *
+ * Only available on x86-64 hosts with the System V calling convention
+ * (Linux, macOS, BSD); elsewhere jit_supported() returns 0.
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "elfobj.h"
+
+/* Outcome of one run */
+typedef struct {
+    long return_value;            /* Value main returned */
+    int exit_code;                /* Exit status a linked program would have */
+    double run_ms;                /* Wall-clock time spent in the program */
+} JitResult;
+
+/* JIT FUNCTIONS */
+
+/* Can programs be run in-process on this host? */
+int jit_supported(void);
+
+/* Load the object into executable memory, call main and unload it.
+ * Returns 0 after the program ran, 1 if it could not be loaded (an
+ * undefined symbol or no executable memory). */
+int jit_run(const ElfObject* object, JitResult* result);
+
+#endif /* JIT_H */
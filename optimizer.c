@@ -7,7 +7,39 @@
  */
 
 #include "optimizer.h"
+#include "defuse.h"
+#include "range.h"
+#include "diagnostics.h"
 #include <ctype.h>
+#include <stdarg.h>
+
+/* Progress messages are on by default; parallel runs turn them off.
+ * The setting is per thread, like the rest of the compiler's state. */
+static THREAD_LOCAL int logging_enabled = 1;
+
+/* Enable or disable optimizer progress messages */
+void set_optimizer_logging(int enabled) {
+    logging_enabled = enabled;
+}
+
+/* Report receiving per-pass timings (NULL = not timed); per thread as well */
+static THREAD_LOCAL TimeReport* pass_timing = NULL;
+
+/* Attach a time report to the optimizer on the calling thread */
+void set_optimizer_timing(TimeReport* report) {
+    pass_timing = report;
+}
+
+/* Helper: print a progress message if logging is enabled and the console
+ * log level allows it (per-optimization messages are LOG_VERBOSE) */
+static void opt_log(LogLevel level, const char* format, ...) {
+    if (!logging_enabled || !LOG_ENABLED(level)) return;
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
 
 /* Helper function: Check if a string represents a number */
 int is_number(const char* str) {
@@ -42,434 +74,1614 @@ int evaluate_binary_op(const char* op, int left, int right) {
     return 0;
 }
 
+/* ============================================================
+ * OPTIMIZER STATE
+ * Passes are written as rules that look at one instruction. A sweep
+ * applies a rule to every instruction; after that, a change re-queues only
+ * the instructions it can affect (the changed one, its neighbours and the
+ * definition of any value whose last reader went away), and the
+ * worklist is drained until no rule applies anywhere. The def-use chains
+ * (defuse.h) are kept exact through every rewrite, so rules find the
+ * uses and the definition of a value directly.
+ * ============================================================ */
+
+/* State of one optimize_tac() run */
+typedef struct {
+    TACCode* code;              /* Instructions being optimized */
+    FlowGraph* graph;           /* Analyses over the code */
+    DefUseChains* chains;       /* Def-use chains over the code */
+    TACInstruction** queue;     /* Worklist (stack) */
+    int queue_count;
+    int queue_capacity;
+    TACInstruction** removed;   /* Unlinked instructions, freed at the end */
+    int removed_count;
+    int removed_capacity;
+    ChainValue* pending[2];     /* Values an instruction read before a rewrite */
+    int pending_count;
+    TACInstruction** labels;    /* Open-addressing map label name -> LABEL (built on first use) */
+    int label_slots;            /* Slots in labels (power of two, 0 = not built) */
+    int label_count;            /* Labels in the map */
+} Optimizer;
+
+/* Helper: grow a pointer array */
+static TACInstruction** grow_list(TACInstruction** list, int* capacity) {
+    *capacity = *capacity ? *capacity * 2 : 256;
+    list = (TACInstruction**)safe_realloc(list, *capacity * sizeof(TACInstruction*), "optimizer worklist");
+    return list;
+}
+
+/* Helper: put an instruction on the worklist (once) */
+static void enqueue(Optimizer* opt, TACInstruction* inst) {
+    if (!inst || (inst->flags & (TAC_FLAG_QUEUED | TAC_FLAG_REMOVED))) return;
+    if (opt->queue_count == opt->queue_capacity) {
+        opt->queue = grow_list(opt->queue, &opt->queue_capacity);
+    }
+    inst->flags |= TAC_FLAG_QUEUED;
+    opt->queue[opt->queue_count++] = inst;
+}
+
+/* Helper: queue an instruction and its neighbours after it changed */
+static void touch(Optimizer* opt, TACInstruction* inst) {
+    enqueue(opt, inst->prev);
+    enqueue(opt, inst);
+    enqueue(opt, inst->next);
+}
+
+/* Helper: a value lost a reader - with none or one left, its definition
+ * may now be removable or mergeable */
+static void lost_reader(Optimizer* opt, ChainValue* value) {
+    if (value->use_count <= 1) {
+        enqueue(opt, single_definition(value));
+    }
+}
+
+/* Helper: unlink an instruction's chains, remembering what it read */
+static void unlink_operands(Optimizer* opt, TACInstruction* inst) {
+    opt->pending_count = 0;
+    for (int slot = TAC_SLOT_OP1; slot <= TAC_SLOT_OP2; slot++) {
+        ChainValue* value = operand_value(inst, slot);
+        if (value) opt->pending[opt->pending_count++] = value;
+    }
+    unlink_tac_chains(opt->chains, inst);
+}
+
+/* Helper: call before rewriting an instruction */
+static void begin_change(Optimizer* opt, TACInstruction* inst) {
+    unlink_operands(opt, inst);
+}
+
+/* Helper: call after the rewrite. changed = something was modified;
+ * invalidated = analyses (AnalysisKind bits) the change broke. */
+static void end_change(Optimizer* opt, TACInstruction* inst, int changed, unsigned invalidated) {
+    link_tac_chains(opt->chains, inst);
+    for (int p = 0; p < opt->pending_count; p++) {
+        lost_reader(opt, opt->pending[p]);
+    }
+    opt->pending_count = 0;
+
+    if (changed) {
+        touch(opt, inst);
+        invalidate_analyses(opt->graph, invalidated);
+    }
+}
+
+/* Helper: unlink an instruction in O(1); it is freed when the run ends */
+static void delete_instruction(Optimizer* opt, TACInstruction* inst) {
+    unlink_operands(opt, inst);
+    enqueue(opt, inst->prev);
+    enqueue(opt, inst->next);
+    remove_tac(opt->code, inst);
+    inst->flags |= TAC_FLAG_REMOVED;
+    for (int p = 0; p < opt->pending_count; p++) {
+        lost_reader(opt, opt->pending[p]);
+    }
+    opt->pending_count = 0;
+
+    if (opt->removed_count == opt->removed_capacity) {
+        opt->removed = grow_list(opt->removed, &opt->removed_capacity);
+    }
+    opt->removed[opt->removed_count++] = inst;
+    invalidate_analyses(opt->graph, ANALYSIS_ALL);
+}
+
+/* Helper: replace an operand string */
+static void set_operand(char** operand, const char* value) {
+    free(*operand);
+    *operand = value ? safe_strdup(value, "TAC operand") : NULL;
+}
+
+/* Helper: link a new instruction into the list after another one */
+static void insert_instruction(Optimizer* opt, TACInstruction* after, TACInstruction* inst) {
+    inst->prev = after;
+    inst->next = after->next;
+    if (after->next) {
+        after->next->prev = inst;
+    } else {
+        opt->code->tail = inst;
+    }
+    after->next = inst;
+    opt->code->instruction_count++;
+
+    link_tac_chains(opt->chains, inst);
+    enqueue(opt, inst);
+    invalidate_analyses(opt->graph, ANALYSIS_ALL);
+}
+
+/* Helper: FNV-1a hash of a label name */
+static unsigned label_hash(const char* name) {
+    unsigned hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+/* Helper: put a LABEL into the label map */
+static void add_label_entry(Optimizer* opt, TACInstruction* inst) {
+    unsigned mask = (unsigned)opt->label_slots - 1;
+    unsigned slot = label_hash(inst->label) & mask;
+    while (opt->labels[slot]) slot = (slot + 1) & mask;
+    opt->labels[slot] = inst;
+    opt->label_count++;
+}
+
+/* Helper: (re)build the label map from the list */
+static void index_labels(Optimizer* opt) {
+    int count = 0;
+    for (TACInstruction* inst = opt->code->head; inst; inst = inst->next) {
+        if (inst->opcode == TAC_LABEL && inst->label) count++;
+    }
+
+    free(opt->labels);
+    opt->label_slots = 64;
+    while (opt->label_slots < count * 2 + 2) opt->label_slots *= 2;
+    opt->labels = (TACInstruction**)safe_calloc(opt->label_slots, sizeof(TACInstruction*), "label map");
+
+    opt->label_count = 0;
+    for (TACInstruction* inst = opt->code->head; inst; inst = inst->next) {
+        if (inst->opcode == TAC_LABEL && inst->label) add_label_entry(opt, inst);
+    }
+}
+
+/* Helper: record a LABEL that was just linked into the list */
+static void remember_label(Optimizer* opt, TACInstruction* inst) {
+    if (opt->label_slots == 0) return;
+    if ((opt->label_count + 1) * 2 > opt->label_slots) {
+        index_labels(opt);
+    } else {
+        add_label_entry(opt, inst);
+    }
+}
+
+/* Helper: the LABEL instruction named name (NULL if there is none or it
+ * was removed). New labels are added as they are made, so the map stays
+ * valid once it is built. */
+static TACInstruction* find_label(Optimizer* opt, const char* name) {
+    if (opt->label_slots == 0) index_labels(opt);
+
+    unsigned mask = (unsigned)opt->label_slots - 1;
+    for (unsigned slot = label_hash(name) & mask; opt->labels[slot]; slot = (slot + 1) & mask) {
+        TACInstruction* inst = opt->labels[slot];
+        if (!(inst->flags & TAC_FLAG_REMOVED) && strcmp(inst->label, name) == 0) return inst;
+    }
+    return NULL;
+}
+
+/* Set up the optimizer for code */
+static void init_optimizer(Optimizer* opt, TACCode* code, FlowGraph* graph) {
+    memset(opt, 0, sizeof(*opt));
+    opt->code = code;
+    opt->graph = graph;
+    opt->chains = build_def_use_chains(code);
+}
+
+/* Release the optimizer state and the removed instructions */
+static void finish_optimizer(Optimizer* opt) {
+    for (int i = 0; i < opt->queue_count; i++) {
+        opt->queue[i]->flags &= ~TAC_FLAG_QUEUED;
+    }
+    free_def_use_chains(opt->chains);
+    for (int i = 0; i < opt->removed_count; i++) {
+        free_tac_instruction(opt->removed[i]);
+    }
+    free(opt->queue);
+    free(opt->removed);
+    free(opt->labels);
+}
+
+/* Helper: uses of a temporary in the whole list (-1 if not a temporary) */
+static int temporary_uses(Optimizer* opt, const char* name) {
+    if (!is_temporary(name)) return -1;
+    ChainValue* value = find_chain_value(opt->chains, name);
+    return value ? value->use_count : 0;
+}
+
+/* Helper: per-value counters for a sweep, indexed by ChainValue id */
+static int* value_counters(Optimizer* opt, size_t size) {
+    int* counters = (int*)safe_calloc(opt->chains->value_count + 1, size, "optimizer counters");
+    return counters;
+}
+
+/* ============================================================
+ * RULES (one instruction at a time)
+ * ============================================================ */
+
 /* Constant Folding: Evaluate constant expressions at compile time
  * Example: t0 = 3 + 5 becomes t0 = 8
  */
-int constant_folding(TACCode* code) {
+static int fold_instruction(Optimizer* opt, TACInstruction* inst) {
+    if (inst->opcode != TAC_ADD && inst->opcode != TAC_SUB && inst->opcode != TAC_MUL &&
+        inst->opcode != TAC_DIV && inst->opcode != TAC_MOD) {
+        return 0;
+    }
+    if (!inst->op1 || !inst->op2 || !is_number(inst->op2)) return 0;
+
     int optimizations = 0;
-    TACInstruction* inst = code->head;
-
-    while (inst) {
-        /* Check for binary operations with constant operands */
-        if ((inst->opcode == TAC_ADD || inst->opcode == TAC_SUB ||
-             inst->opcode == TAC_MUL || inst->opcode == TAC_DIV ||
-             inst->opcode == TAC_MOD) &&
-            inst->op1 && inst->op2 &&
-            is_number(inst->op1) && is_number(inst->op2)) {
-
-            /* Both operands are constants - fold them! */
-            int left = atoi(inst->op1);
-            int right = atoi(inst->op2);
-            int result = evaluate_binary_op(opcode_to_string(inst->opcode), left, right);
-
-            /* Convert to LOAD_CONST instruction */
-            free(inst->op1);
-            free(inst->op2);
-
-            char result_str[32];
-            snprintf(result_str, sizeof(result_str), "%d", result);
-            inst->opcode = TAC_LOAD_CONST;
-            inst->op1 = strdup(result_str);
-            inst->op2 = NULL;
+    begin_change(opt, inst);
+
+    /* Check for binary operations with constant operands */
+    if (is_number(inst->op1)) {
+        /* Both operands are constants - fold them! */
+        int left = atoi(inst->op1);
+        int right = atoi(inst->op2);
+        int result = evaluate_binary_op(opcode_to_string(inst->opcode), left, right);
+
+        /* Convert to LOAD_CONST instruction */
+        char result_str[32];
+        snprintf(result_str, sizeof(result_str), "%d", result);
+        inst->opcode = TAC_LOAD_CONST;
+        set_operand(&inst->op1, result_str);
+        set_operand(&inst->op2, NULL);
+
+        optimizations++;
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Constant folding: Folded constant expression to %d\n", result);
+    }
+
+    /* Algebraic simplifications */
+    else if (inst->opcode == TAC_MUL) {
+        int multiplier = atoi(inst->op2);
 
+        /* x * 0 = 0 */
+        if (multiplier == 0) {
+            inst->opcode = TAC_LOAD_CONST;
+            set_operand(&inst->op1, "0");
+            set_operand(&inst->op2, NULL);
             optimizations++;
-            printf("[OPTIMIZER] Constant folding: Folded constant expression to %d\n", result);
-        }
-
-        /* Algebraic simplifications */
-        if (inst->opcode == TAC_MUL && inst->op2 && is_number(inst->op2)) {
-            int multiplier = atoi(inst->op2);
-
-            /* x * 0 = 0 */
-            if (multiplier == 0) {
-                inst->opcode = TAC_LOAD_CONST;
-                free(inst->op1);
-                free(inst->op2);
-                inst->op1 = strdup("0");
-                inst->op2 = NULL;
-                optimizations++;
-                printf("[OPTIMIZER] Algebraic simplification: x * 0 = 0\n");
-            }
-            /* x * 1 = x (convert to assignment) */
-            else if (multiplier == 1) {
-                free(inst->op2);
-                inst->opcode = TAC_ASSIGN;
-                inst->op2 = NULL;
-                optimizations++;
-                printf("[OPTIMIZER] Algebraic simplification: x * 1 = x\n");
-            }
+            opt_log(LOG_VERBOSE, "[OPTIMIZER] Algebraic simplification: x * 0 = 0\n");
         }
-
-        /* x + 0 = x or x - 0 = x */
-        if ((inst->opcode == TAC_ADD || inst->opcode == TAC_SUB) &&
-            inst->op2 && is_number(inst->op2) && atoi(inst->op2) == 0) {
-            free(inst->op2);
+        /* x * 1 = x (convert to assignment) */
+        else if (multiplier == 1) {
             inst->opcode = TAC_ASSIGN;
-            inst->op2 = NULL;
+            set_operand(&inst->op2, NULL);
             optimizations++;
-            printf("[OPTIMIZER] Algebraic simplification: x +/- 0 = x\n");
+            opt_log(LOG_VERBOSE, "[OPTIMIZER] Algebraic simplification: x * 1 = x\n");
         }
+    }
 
-        inst = inst->next;
+    /* x + 0 = x or x - 0 = x */
+    else if ((inst->opcode == TAC_ADD || inst->opcode == TAC_SUB) && atoi(inst->op2) == 0) {
+        inst->opcode = TAC_ASSIGN;
+        set_operand(&inst->op2, NULL);
+        optimizations++;
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Algebraic simplification: x +/- 0 = x\n");
     }
 
+    end_change(opt, inst, optimizations, ANALYSIS_LIVENESS);
     return optimizations;
 }
 
-/* Dead Code Elimination: Remove unreachable or unused code
- * - Remove code after unconditional jumps
- * - Remove unused temporary variables (basic version)
+/* Copy Propagation (rule): after t = y, read y wherever t is read
+ * Example: t0 = x; t1 = t0 + 5; becomes t1 = x + 5;
+ * The uses of t come from its def-use chain. When y is a temporary it
+ * never changes, so every use is rewritten; a user variable y may be
+ * reassigned, so only the uses that follow in the same block are.
  */
-int eliminate_dead_code(TACCode* code) {
-    int optimizations = 0;
-    TACInstruction* inst = code->head;
-    TACInstruction* prev = NULL;
-
-    while (inst && inst->next) {
-        /* Remove instructions after unconditional GOTO until next label */
-        if (inst->opcode == TAC_GOTO) {
-            TACInstruction* next = inst->next;
-
-            /* Skip instructions until we hit a label */
-            while (next && next->opcode != TAC_LABEL &&
-                   next->opcode != TAC_FUNCTION_LABEL) {
-                TACInstruction* to_remove = next;
-                next = next->next;
+static int propagate_copy(Optimizer* opt, TACInstruction* inst) {
+    ChainValue* temp = operand_value(inst, TAC_SLOT_RESULT);
+    ChainValue* original = operand_value(inst, TAC_SLOT_OP1);
 
-                /* Remove the dead instruction */
-                inst->next = next;
+    if (inst->opcode != TAC_ASSIGN || !temp || !original || temp == original ||
+        !is_temporary(temp->name) || temp->def_count != 1 || temp->use_count == 0) {
+        return 0;
+    }
 
-                printf("[OPTIMIZER] Dead code elimination: Removed unreachable instruction after GOTO\n");
+    int replaced = 0;
+    if (is_temporary(original->name) && original->def_count == 1) {
+        /* Rewriting a use unlinks it, so the chain shrinks to nothing */
+        while (temp->uses) {
+            DefUseLink* use = temp->uses;
+            TACInstruction* user = use->inst;
+            begin_change(opt, user);
+            set_operand(tac_slot(user, use->slot), original->name);
+            end_change(opt, user, 1, ANALYSIS_LIVENESS);
+            replaced++;
+        }
+    } else {
+        /* Walk the block until every use of t has been seen, stopping
+         * where y may change (a store to it, a call, a label) */
+        for (TACInstruction* next = inst->next; next && temp->use_count > 0; next = next->next) {
+            if (next->opcode == TAC_LABEL || next->opcode == TAC_FUNCTION_LABEL ||
+                next->opcode == TAC_CALL) {
+                break;
+            }
 
-                free(to_remove->result);
-                free(to_remove->op1);
-                free(to_remove->op2);
-                free(to_remove->label);
-                free(to_remove);
+            for (int slot = TAC_SLOT_OP1; slot <= TAC_SLOT_OP2; slot++) {
+                if (operand_value(next, slot) != temp) continue;
+                begin_change(opt, next);
+                set_operand(tac_slot(next, slot), original->name);
+                end_change(opt, next, 1, ANALYSIS_LIVENESS);
+                replaced++;
+            }
 
-                optimizations++;
-                code->instruction_count--;
+            if (operand_value(next, TAC_SLOT_RESULT) == original ||
+                next->opcode == TAC_GOTO || next->opcode == TAC_IF_FALSE ||
+                next->opcode == TAC_IF_TRUE || next->opcode == TAC_RETURN ||
+                next->opcode == TAC_RETURN_VOID) {
+                break;
             }
         }
+    }
 
-        /* Remove consecutive identical assignments: x = y; x = y; */
-        if (inst->opcode == TAC_ASSIGN && inst->next &&
-            inst->next->opcode == TAC_ASSIGN &&
-            inst->result && inst->next->result &&
-            inst->op1 && inst->next->op1 &&
-            strcmp(inst->result, inst->next->result) == 0 &&
-            strcmp(inst->op1, inst->next->op1) == 0) {
+    if (replaced > 0) {
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Copy propagation: Replaced %d uses of %s with %s\n",
+                replaced, temp->name, original->name);
+    }
+    return replaced;
+}
 
-            TACInstruction* duplicate = inst->next;
-            inst->next = duplicate->next;
+/* A copy x = y that is still available */
+typedef struct {
+    ChainValue* source;         /* y */
+    int source_version;         /* Definitions of y seen when the copy was made */
+    int version;                /* Definitions of x seen, including the copy */
+    int block;                  /* Block the copy was made in */
+} AvailableCopy;
+
+/* Copy Propagation (sweep): one walk over the code, keeping the copies
+ * into temporaries available in the current block. A copy dies when
+ * either side is written again, at a label, or at a call (the source may
+ * be a global the callee writes). Counting the definitions of each value
+ * as the walk passes them makes the check O(1), so the pass is linear in
+ * the code. Copies into user variables are left alone: the copy stays
+ * anyway, and reading the source instead only keeps it alive longer.
+ */
+static int copy_propagation_sweep(Optimizer* opt) {
+    int value_count = opt->chains->value_count;
+    int* versions = value_counters(opt, sizeof(int));
+    AvailableCopy* copies = (AvailableCopy*)value_counters(opt, sizeof(AvailableCopy));
+    int block = 1;
+    int replaced = 0;
+
+    for (TACInstruction* inst = opt->code->head; inst; inst = inst->next) {
+        if (inst->opcode == TAC_LABEL || inst->opcode == TAC_FUNCTION_LABEL ||
+            inst->opcode == TAC_CALL) {
+            block++;
+        }
 
-            free(duplicate->result);
-            free(duplicate->op1);
-            free(duplicate->op2);
-            free(duplicate->label);
-            free(duplicate);
+        /* Replace reads of a copy with its source */
+        int changed = 0;
+        for (int slot = TAC_SLOT_OP1; slot <= TAC_SLOT_OP2; slot++) {
+            ChainValue* value = operand_value(inst, slot);
+            if (!value || value->id >= value_count) continue;
 
-            optimizations++;
-            code->instruction_count--;
-            printf("[OPTIMIZER] Dead code elimination: Removed duplicate assignment\n");
+            AvailableCopy* copy = &copies[value->id];
+            if (copy->block != block || copy->version != versions[value->id] ||
+                copy->source_version != versions[copy->source->id]) {
+                continue;
+            }
+            if (!changed) begin_change(opt, inst);
+            set_operand(tac_slot(inst, slot), copy->source->name);
+            changed++;
+        }
+        if (changed) {
+            end_change(opt, inst, 1, ANALYSIS_LIVENESS);
+            replaced += changed;
         }
 
-        prev = inst;
-        inst = inst->next;
+        /* Record the definition, and the copy if it is one */
+        ChainValue* def = operand_value(inst, TAC_SLOT_RESULT);
+        if (!def || def->id >= value_count) continue;
+        versions[def->id]++;
+
+        ChainValue* source = operand_value(inst, TAC_SLOT_OP1);
+        if (inst->opcode == TAC_ASSIGN && source && source != def && source->id < value_count &&
+            is_temporary(def->name)) {
+            AvailableCopy* copy = &copies[def->id];
+            copy->source = source;
+            copy->source_version = versions[source->id];
+            copy->version = versions[def->id];
+            copy->block = block;
+        }
     }
 
-    return optimizations;
+    if (replaced > 0) {
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Copy propagation: Replaced %d copied values\n", replaced);
+    }
+    free(versions);
+    free(copies);
+    return replaced;
 }
 
-/* Copy Propagation: Replace variable copies with direct references
- * Example: t0 = x; t1 = t0 + 5; becomes t1 = x + 5;
- */
-int copy_propagation(TACCode* code) {
-    int optimizations = 0;
-    TACInstruction* inst = code->head;
+/* An expression computed earlier in the block */
+typedef struct {
+    TACInstruction* inst;       /* Instruction that computed it */
+    int block;                  /* Block it was computed in (stale otherwise) */
+    int versions[2];            /* Definitions of its operands seen then (-1 = literal) */
+    int memory;                 /* Array/global generation it read (loads, globals) */
+} AvailableExpr;
+
+/* Helper: can an instruction's value be reused? (pure, single result) */
+static int is_cse_candidate(const TACInstruction* inst) {
+    switch (inst->opcode) {
+        case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_MOD:
+        case TAC_RELOP: case TAC_ARRAY_LOAD:
+            return inst->result && inst->op1 && inst->op2;
+        default:
+            return 0;
+    }
+}
+
+/* Helper: operands of a candidate in canonical order (commutative
+ * operations sort them, so a + b and b + a match); slots[] says which
+ * operand slot each one came from */
+static void cse_operands(const TACInstruction* inst, const char* operands[2], int slots[2]) {
+    operands[0] = inst->op1;
+    operands[1] = inst->op2;
+    slots[0] = TAC_SLOT_OP1;
+    slots[1] = TAC_SLOT_OP2;
+    if ((inst->opcode == TAC_ADD || inst->opcode == TAC_MUL) &&
+        strcmp(operands[0], operands[1]) > 0) {
+        operands[0] = inst->op2;
+        operands[1] = inst->op1;
+        slots[0] = TAC_SLOT_OP2;
+        slots[1] = TAC_SLOT_OP1;
+    }
+}
 
-    while (inst) {
-        /* Look for simple assignments: t0 = x */
-        if (inst->opcode == TAC_ASSIGN && inst->result && inst->op1 &&
-            !inst->op2 && !is_number(inst->op1)) {
+/* Helper: does reusing this expression depend on memory or globals?
+ * Array loads read memory; user variables may be globals a call writes. */
+static int cse_reads_memory(const TACInstruction* inst) {
+    if (inst->opcode == TAC_ARRAY_LOAD) return 1;
+    for (int slot = TAC_SLOT_OP1; slot <= TAC_SLOT_OP2; slot++) {
+        ChainValue* value = operand_value(inst, slot);
+        if (value && !is_temporary(value->name)) return 1;
+    }
+    return 0;
+}
 
-            char* temp = inst->result;
-            char* original = inst->op1;
+/* Helper: FNV-1a hash of an expression */
+static unsigned cse_hash(const TACInstruction* inst, const char* operands[2]) {
+    unsigned hash = 2166136261u ^ (unsigned)inst->opcode;
+    const char* parts[3] = { inst->opcode == TAC_RELOP ? inst->label : "", operands[0], operands[1] };
+    for (int i = 0; i < 3; i++) {
+        for (const char* p = parts[i] ? parts[i] : ""; *p; p++) {
+            hash = (hash ^ (unsigned char)*p) * 16777619u;
+        }
+        hash = (hash ^ 0xffu) * 16777619u;
+    }
+    return hash;
+}
 
-            /* Look ahead for uses of this temp and replace with original */
-            TACInstruction* next = inst->next;
-            int replaced = 0;
+/* Common Subexpression Elimination: reuse a value computed earlier in
+ * the block instead of computing it again
+ * Example: t3 = a * b; ... t7 = a * b; becomes t7 = t3;
+ * The earlier result must be a temporary (it is written exactly once)
+ * and its operands must not have been written since. Array loads and
+ * expressions over user variables also die at array stores and calls.
+ * Copy propagation then sends the readers of t7 to t3.
+ */
+static int common_subexpression_sweep(Optimizer* opt) {
+    int value_count = opt->chains->value_count;
+    int* versions = value_counters(opt, sizeof(int));
+    int table_size = 64;
+    while (table_size < opt->code->instruction_count * 2) table_size *= 2;
+    AvailableExpr* table = (AvailableExpr*)safe_calloc(table_size, sizeof(AvailableExpr), "expression table");
+
+    int block = 1;
+    int memory = 0;
+    int eliminated = 0;
+    unsigned mask = (unsigned)table_size - 1;
+
+    for (TACInstruction* inst = opt->code->head; inst; inst = inst->next) {
+        if (inst->opcode == TAC_LABEL || inst->opcode == TAC_FUNCTION_LABEL) {
+            block++;
+            continue;
+        }
+        if (inst->opcode == TAC_CALL || inst->opcode == TAC_ARRAY_STORE) {
+            memory++;
+        }
 
-            /* Only propagate within a small window to avoid issues */
-            int window = 0;
-            while (next && window < 10) {
-                /* Stop at labels (scope boundaries) */
-                if (next->opcode == TAC_LABEL || next->opcode == TAC_FUNCTION_LABEL) {
+        if (is_cse_candidate(inst)) {
+            const char* operands[2];
+            int slots[2];
+            int current[2];
+            cse_operands(inst, operands, slots);
+            for (int i = 0; i < 2; i++) {
+                ChainValue* value = operand_value(inst, slots[i]);
+                current[i] = value && value->id < value_count ? versions[value->id] : -1;
+            }
+            int reads_memory = cse_reads_memory(inst);
+
+            /* Probe until an empty or stale slot; a matching entry with
+             * out-of-date operands is skipped, not reused */
+            unsigned slot = cse_hash(inst, operands) & mask;
+            TACInstruction* found = NULL;
+            while (table[slot].inst && table[slot].block == block) {
+                AvailableExpr* entry = &table[slot];
+                const char* earlier[2];
+                int earlier_slots[2];
+                cse_operands(entry->inst, earlier, earlier_slots);
+
+                if (entry->inst->opcode == inst->opcode &&
+                    strcmp(earlier[0], operands[0]) == 0 && strcmp(earlier[1], operands[1]) == 0 &&
+                    (inst->opcode != TAC_RELOP || strcmp(entry->inst->label, inst->label) == 0) &&
+                    entry->versions[0] == current[0] && entry->versions[1] == current[1] &&
+                    (!reads_memory || entry->memory == memory)) {
+                    found = entry->inst;
                     break;
                 }
+                slot = (slot + 1) & mask;
+            }
 
-                /* Replace uses in op1 */
-                if (next->op1 && strcmp(next->op1, temp) == 0) {
-                    free(next->op1);
-                    next->op1 = strdup(original);
-                    replaced++;
+            if (found) {
+                begin_change(opt, inst);
+                inst->opcode = TAC_ASSIGN;
+                set_operand(&inst->op1, found->result);
+                set_operand(&inst->op2, NULL);
+                set_operand(&inst->label, NULL);
+                end_change(opt, inst, 1, ANALYSIS_LIVENESS);
+                eliminated++;
+                opt_log(LOG_VERBOSE, "[OPTIMIZER] CSE: %s reuses %s\n", inst->result, found->result);
+            } else {
+                ChainValue* result = operand_value(inst, TAC_SLOT_RESULT);
+                if (result && is_temporary(result->name) && result->def_count == 1) {
+                    table[slot].inst = inst;
+                    table[slot].block = block;
+                    table[slot].versions[0] = current[0];
+                    table[slot].versions[1] = current[1];
+                    table[slot].memory = memory;
                 }
+            }
+        }
 
-                /* Replace uses in op2 */
-                if (next->op2 && strcmp(next->op2, temp) == 0) {
-                    free(next->op2);
-                    next->op2 = strdup(original);
-                    replaced++;
-                }
+        ChainValue* def = operand_value(inst, TAC_SLOT_RESULT);
+        if (def && def->id < value_count) versions[def->id]++;
+    }
 
-                /* Stop if temp is reassigned */
-                if (next->result && strcmp(next->result, temp) == 0) {
-                    break;
-                }
+    free(versions);
+    free(table);
+    return eliminated;
+}
 
-                /* Stop if original is reassigned */
-                if (next->result && strcmp(next->result, original) == 0) {
-                    break;
-                }
+/* Peephole Optimization: Optimize small instruction sequences
+ * - Remove redundant loads
+ * - Strength reduction (detected only)
+ */
+static int peephole_instruction(Optimizer* opt, TACInstruction* inst) {
+    TACInstruction* assign = inst->next;
+
+    /* Remove redundant load followed by assignment
+     * Pattern: t0 = 5; x = t0; becomes x = 5;
+     * (only if the assignment is the last reader of t0)
+     */
+    if (inst->opcode == TAC_LOAD_CONST && assign && assign->opcode == TAC_ASSIGN &&
+        inst->result && assign->op1 &&
+        strcmp(inst->result, assign->op1) == 0 &&
+        temporary_uses(opt, inst->result) == 1) {
+
+        /* Change assignment to load_const directly */
+        begin_change(opt, assign);
+        set_operand(&assign->op1, inst->op1);
+        assign->opcode = TAC_LOAD_CONST;
+        end_change(opt, assign, 1, ANALYSIS_LIVENESS);
+
+        /* Remove the load */
+        delete_instruction(opt, inst);
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Peephole: Merged load and assignment\n");
+        return 1;
+    }
 
-                next = next->next;
-                window++;
-            }
+    /* Strength reduction: Division by power of 2 -> shift
+     * Note: We track this but don't change the TAC
+     * (the code generator could handle this)
+     */
+    if (inst->opcode == TAC_DIV && inst->op2 && is_number(inst->op2)) {
+        int divisor = atoi(inst->op2);
+        if (divisor > 0 && (divisor & (divisor - 1)) == 0) {
+            opt_log(LOG_VERBOSE, "[OPTIMIZER] Peephole: Division by power of 2 detected (can use shift)\n");
+        }
+    }
 
-            if (replaced > 0) {
-                optimizations += replaced;
-                printf("[OPTIMIZER] Copy propagation: Replaced %d uses of %s with %s\n",
-                       replaced, temp, original);
-            }
+    return 0;
+}
+
+/* Helper: is inst a jump to a label? */
+static int is_jump(const TACInstruction* inst) {
+    return inst->opcode == TAC_GOTO || inst->opcode == TAC_IF_FALSE || inst->opcode == TAC_IF_TRUE;
+}
+
+/* Helper: first instruction a jump to label runs (past the labels) */
+static TACInstruction* jump_destination(Optimizer* opt, const char* label) {
+    TACInstruction* inst = find_label(opt, label);
+    while (inst && inst->opcode == TAC_LABEL) inst = inst->next;
+    return inst;
+}
+
+/* Helper: does a label named label come next, before any code? */
+static int label_follows(const TACInstruction* inst, const char* label) {
+    for (inst = inst->next; inst && inst->opcode == TAC_LABEL; inst = inst->next) {
+        if (inst->label && strcmp(inst->label, label) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Helper: turn IF_FALSE into IF_TRUE and back; a profiled jump is now
+ * taken the times it used to fall through */
+static void invert_branch(TACInstruction* inst) {
+    inst->opcode = inst->opcode == TAC_IF_FALSE ? TAC_IF_TRUE : TAC_IF_FALSE;
+    inst->taken = inst->count - inst->taken;
+}
+
+/* Flow Optimization: Optimize control flow
+ * - Remove jumps to the next instruction
+ * - Resolve conditional jumps on constants
+ * - Invert a branch over a goto (if_false t goto L1; goto L2; L1:
+ *   becomes if_true t goto L2; L1:)
+ * - Thread jumps to gotos straight to the final target
+ * - Replace a goto to a return with the return itself
+ */
+static int flow_instruction(Optimizer* opt, TACInstruction* inst) {
+    if (!is_jump(inst) || !inst->label) return 0;
+
+    /* Remove jump to next instruction
+     * Pattern: goto L1; L1: ... becomes L1: ...
+     */
+    if (label_follows(inst, inst->label)) {
+        delete_instruction(opt, inst);
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Flow: Removed jump to next instruction\n");
+        return 1;
+    }
+
+    /* Remove a conditional jump with a constant condition */
+    if (inst->opcode != TAC_GOTO && inst->op1 && is_number(inst->op1)) {
+        int taken = (atoi(inst->op1) != 0) == (inst->opcode == TAC_IF_TRUE);
+        if (taken) {
+            /* Condition always holds - convert to unconditional jump */
+            begin_change(opt, inst);
+            inst->opcode = TAC_GOTO;
+            set_operand(&inst->op1, NULL);
+            end_change(opt, inst, 1, ANALYSIS_ALL);
+            opt_log(LOG_VERBOSE, "[OPTIMIZER] Flow: Converted constant conditional jump to goto\n");
+        } else {
+            /* Condition never holds - remove the jump */
+            delete_instruction(opt, inst);
+            opt_log(LOG_VERBOSE, "[OPTIMIZER] Flow: Removed conditional jump that is never taken\n");
         }
+        return 1;
+    }
 
-        inst = inst->next;
+    /* Branch over a goto: jump straight to the goto's target on the
+     * opposite condition and fall through to the label */
+    TACInstruction* next = inst->next;
+    if (inst->opcode != TAC_GOTO && next && next->opcode == TAC_GOTO && next->label &&
+        label_follows(next, inst->label)) {
+        begin_change(opt, inst);
+        invert_branch(inst);
+        set_operand(&inst->label, next->label);
+        end_change(opt, inst, 1, ANALYSIS_ALL);
+        delete_instruction(opt, next);
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Flow: Inverted branch over goto\n");
+        return 1;
     }
 
-    return optimizations;
+    /* Jump threading: follow a chain of gotos to where it ends (a chain
+     * that loops or runs on too long is left alone)
+     * Pattern: goto L1; ... L1: goto L2 becomes goto L2
+     */
+    const char* target = inst->label;
+    TACInstruction* dest = jump_destination(opt, target);
+    int hops = 0;
+    while (dest && dest->opcode == TAC_GOTO && dest->label && hops < 8) {
+        target = dest->label;
+        dest = jump_destination(opt, target);
+        hops++;
+    }
+    if (hops > 0 && !(dest && dest->opcode == TAC_GOTO)) {
+        begin_change(opt, inst);
+        set_operand(&inst->label, target);
+        end_change(opt, inst, 1, ANALYSIS_ALL);
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Flow: Threaded jump through %d goto(s) to %s\n", hops, target);
+        return 1;
+    }
+
+    /* Jump to a return: return right here instead */
+    if (inst->opcode == TAC_GOTO && dest &&
+        (dest->opcode == TAC_RETURN || dest->opcode == TAC_RETURN_VOID)) {
+        begin_change(opt, inst);
+        inst->opcode = dest->opcode;
+        set_operand(&inst->op1, dest->op1);
+        set_operand(&inst->label, NULL);
+        end_change(opt, inst, 1, ANALYSIS_ALL);
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Flow: Replaced jump to return with the return\n");
+        return 1;
+    }
+
+    return 0;
 }
 
-/* Peephole Optimization: Optimize small instruction sequences
- * - Remove redundant loads
- * - Combine operations
- * - Strength reduction
+/* Dead temporary: a temporary with an empty use chain (calls stay for
+ * their effects) */
+static int dead_temporary(Optimizer* opt, TACInstruction* inst) {
+    const char* def = tac_def(inst);
+    if (!def || inst->opcode == TAC_CALL || temporary_uses(opt, def) != 0) return 0;
+
+    delete_instruction(opt, inst);
+    opt_log(LOG_VERBOSE, "[OPTIMIZER] Dead stores: Removed unused temporary %s\n", def);
+    return 1;
+}
+
+/* Dead Code Elimination: Remove unreachable, duplicate or unused code
+ * - Remove code after unconditional jumps and returns
+ * - Remove consecutive identical assignments and self-copies
+ * - Remove temporaries nobody reads
  */
-int peephole_optimization(TACCode* code) {
+static int dead_code_instruction(Optimizer* opt, TACInstruction* inst) {
     int optimizations = 0;
-    TACInstruction* inst = code->head;
-
-    while (inst && inst->next) {
-        /* Remove redundant load followed by assignment
-         * Pattern: t0 = 5; x = t0; becomes x = 5;
-         */
-        if (inst->opcode == TAC_LOAD_CONST && inst->next->opcode == TAC_ASSIGN &&
-            inst->result && inst->next->op1 &&
-            strcmp(inst->result, inst->next->op1) == 0) {
-
-            /* Merge the two instructions */
-            TACInstruction* assign = inst->next;
-
-            /* Change assignment to load_const directly */
-            free(assign->op1);
-            assign->op1 = strdup(inst->op1);
-            assign->opcode = TAC_LOAD_CONST;
-
-            /* Remove the first instruction */
-            TACInstruction* to_remove = inst;
-
-            /* Adjust pointers */
-            if (code->head == inst) {
-                code->head = inst->next;
-            } else {
-                /* Find previous instruction */
-                TACInstruction* prev = code->head;
-                while (prev && prev->next != inst) {
-                    prev = prev->next;
-                }
-                if (prev) {
-                    prev->next = inst->next;
-                }
-            }
 
-            inst = inst->next;
+    /* Remove instructions after unconditional GOTO (or a return) until next label */
+    if (inst->opcode == TAC_GOTO || inst->opcode == TAC_RETURN || inst->opcode == TAC_RETURN_VOID) {
+        while (inst->next && inst->next->opcode != TAC_LABEL &&
+               inst->next->opcode != TAC_FUNCTION_LABEL) {
+            delete_instruction(opt, inst->next);
+            optimizations++;
+            opt_log(LOG_VERBOSE, "[OPTIMIZER] Dead code elimination: Removed unreachable instruction after jump\n");
+        }
+    }
 
-            free(to_remove->result);
-            free(to_remove->op1);
-            free(to_remove->op2);
-            free(to_remove->label);
-            free(to_remove);
+    /* Remove consecutive identical assignments: x = y; x = y; */
+    TACInstruction* next = inst->next;
+    if (inst->opcode == TAC_ASSIGN && next && next->opcode == TAC_ASSIGN &&
+        inst->result && next->result && inst->op1 && next->op1 &&
+        strcmp(inst->result, next->result) == 0 &&
+        strcmp(inst->op1, next->op1) == 0) {
+        delete_instruction(opt, next);
+        optimizations++;
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Dead code elimination: Removed duplicate assignment\n");
+    }
 
-            code->instruction_count--;
-            optimizations++;
-            printf("[OPTIMIZER] Peephole: Merged load and assignment\n");
-            continue;
+    /* Remove x = x (copy propagation can leave these behind) */
+    if (inst->opcode == TAC_ASSIGN && inst->result && inst->op1 &&
+        strcmp(inst->result, inst->op1) == 0) {
+        delete_instruction(opt, inst);
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Dead code elimination: Removed self-assignment\n");
+        return optimizations + 1;
+    }
+
+    return optimizations + dead_temporary(opt, inst);
+}
+
+/* Dead Store Elimination (sweep): Remove assignments to temporaries that
+ * are not live afterwards. Liveness covers every path, so this also
+ * catches temporaries whose remaining readers are never reached.
+ * Calls are kept for their side effects; user variables are kept because
+ * a call may read them if they are global.
+ */
+static int dead_store_sweep(Optimizer* opt) {
+    FlowGraph* graph = opt->graph;
+    int optimizations = 0;
+    TACInstruction** insts = NULL;
+    int capacity = 0;
+    unsigned* live = NULL;
+    int live_words = 0;
+
+    /* Removing instructions invalidates the analyses but leaves the block
+     * array in place, and each block is collected before it is changed */
+    for (int b = 0; b < graph->block_count; b++) {
+        BasicBlock* block = &graph->blocks[b];
+        FlowRegion* region = &graph->regions[block->region];
+
+        /* Collect the block to walk it backwards */
+        int count = 0;
+        for (TACInstruction* inst = block->first; ; inst = inst->next) {
+            if (count == capacity) insts = grow_list(insts, &capacity);
+            insts[count++] = inst;
+            if (inst == block->last) break;
         }
 
-        /* Strength reduction: Division by power of 2 -> shift
-         * Note: We track this as an optimization but don't change the TAC
-         * (the code generator could handle this)
-         */
-        if (inst->opcode == TAC_DIV && inst->op2 && is_number(inst->op2)) {
-            int divisor = atoi(inst->op2);
-            /* Check if divisor is power of 2 */
-            if (divisor > 0 && (divisor & (divisor - 1)) == 0) {
-                /* This is a power of 2 - could be optimized to shift */
-                /* For now, just log it */
-                printf("[OPTIMIZER] Peephole: Division by power of 2 detected (can use shift)\n");
-            }
+        if (region->words > live_words) {
+            live_words = region->words;
+            live = (unsigned*)safe_realloc(live, live_words * sizeof(unsigned), "live set");
         }
+        memcpy(live, block->live_out, region->words * sizeof(unsigned));
+
+        /* A dead instruction is dropped before its operands are marked
+         * live, so chains of dead temporaries go in one walk */
+        for (int i = count - 1; i >= 0; i--) {
+            TACInstruction* inst = insts[i];
+            const char* def = tac_def(inst);
+
+            if (def) {
+                int v = live_variable_index(graph, b, def);
+                if (inst->opcode != TAC_CALL && is_temporary(def) && !LIVE_SET_HAS(live, v)) {
+                    delete_instruction(opt, inst);
+                    optimizations++;
+                    continue;
+                }
+                live[v / 32] &= ~(1u << (v % 32));
+            }
 
-        inst = inst->next;
+            const char* uses[2];
+            int use_count = tac_uses(inst, uses);
+            for (int u = 0; u < use_count; u++) {
+                int v = live_variable_index(graph, b, uses[u]);
+                live[v / 32] |= 1u << (v % 32);
+            }
+        }
     }
 
+    if (optimizations > 0) {
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Dead stores: Removed %d unused temporaries\n", optimizations);
+    }
+    free(insts);
+    free(live);
     return optimizations;
 }
 
-/* Flow Optimization: Optimize control flow
- * - Remove unreachable labels
- * - Simplify branch chains
- * - Remove redundant jumps
- */
-int flow_optimization(TACCode* code) {
-    int optimizations = 0;
-    TACInstruction* inst = code->head;
-    TACInstruction* prev = NULL;
-
-    while (inst) {
-        /* Remove jump to next instruction
-         * Pattern: goto L1; L1: ... becomes L1: ...
-         */
-        if (inst->opcode == TAC_GOTO && inst->next &&
-            inst->next->opcode == TAC_LABEL &&
-            inst->label && inst->next->label &&
-            strcmp(inst->label, inst->next->label) == 0) {
-
-            /* Remove the redundant goto */
-            TACInstruction* to_remove = inst;
-
-            if (prev) {
-                prev->next = inst->next;
-            } else {
-                code->head = inst->next;
+/* Value Ranges (sweep): Use the value range analysis (range.c) to drop
+ * the --bounds-check checks whose index always lies inside the array and
+ * to mark divisions whose operands are never negative (TAC_FLAG_NONNEG),
+ * which the code generators give an unsigned fast path. The checks are
+ * all found before the first is removed, while the analyses still hold. */
+typedef struct {
+    TACInstruction** checks;    /* Bounds checks that cannot fail */
+    int check_count;
+    int check_capacity;
+    int divisions;              /* Divisions newly marked non-negative */
+} RangeUses;
+
+static void use_ranges(void* context, TACInstruction* inst, ValueRange op1, ValueRange op2) {
+    RangeUses* uses = (RangeUses*)context;
+    if (inst->opcode == TAC_BOUNDS_CHECK && inst->op2 && RANGE_BOUNDED(op1) &&
+        op1.lo >= 0 && op1.hi < op2.lo) {
+        if (uses->check_count == uses->check_capacity) {
+            uses->check_capacity = uses->check_capacity ? uses->check_capacity * 2 : 16;
+            uses->checks = (TACInstruction**)safe_realloc(uses->checks,
+                uses->check_capacity * sizeof(TACInstruction*), "bounds checks");
+        }
+        uses->checks[uses->check_count++] = inst;
+    } else if ((inst->opcode == TAC_DIV || inst->opcode == TAC_MOD) && !(inst->flags & TAC_FLAG_NONNEG) &&
+               RANGE_BOUNDED(op1) && RANGE_BOUNDED(op2) && op1.lo >= 0 && op2.lo >= 0) {
+        inst->flags |= TAC_FLAG_NONNEG;
+        uses->divisions++;
+    }
+}
+
+/* Helper: can use_ranges do anything with this instruction? */
+static int range_use_wanted(const TACInstruction* inst) {
+    return inst->opcode == TAC_BOUNDS_CHECK ||
+           ((inst->opcode == TAC_DIV || inst->opcode == TAC_MOD) && !(inst->flags & TAC_FLAG_NONNEG));
+}
+
+static int value_range_sweep(Optimizer* opt) {
+    RangeUses uses;
+    memset(&uses, 0, sizeof(uses));
+    visit_value_ranges(opt->graph, range_use_wanted, use_ranges, &uses);
+    for (int i = 0; i < uses.check_count; i++) {
+        delete_instruction(opt, uses.checks[i]);
+    }
+    free(uses.checks);
+
+    if (uses.check_count > 0) {
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Value ranges: Removed %d bounds checks that cannot fail\n",
+                uses.check_count);
+    }
+    if (uses.divisions > 0) {
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Value ranges: %d divisions with non-negative operands\n",
+                uses.divisions);
+    }
+    return uses.check_count + uses.divisions;
+}
+
+/* ============================================================
+ * BLOCK LAYOUT
+ * Each function's blocks are put in an order where the likely successor
+ * of a block follows it, so the hot path falls through and taken
+ * branches go to the cold side. With --profile-use the block and branch
+ * counts measured by an instrumented run decide. Without a profile the
+ * likelihood comes from static rules: a block runs 8 times more often
+ * per loop around it, a branch that stays in (or enters) a loop is taken
+ * 9 times in 10, and a branch to a block that returns is taken 1 time
+ * in 5.
+ *
+ * Blocks are chained greedily, heaviest edge first, a chain growing only
+ * at its ends (Pettis-Hansen). Loop back edges are never made to fall
+ * through - loops are already rotated so the test is at the bottom - and
+ * the entry block stays first. The chains are then emitted in their
+ * original order, and every block whose fall-through successor moved
+ * gets its branch inverted or a goto added. A block that falls off the
+ * end of the function (returning 0) stays last. Labels that no jump
+ * refers to any more are dropped, joining the blocks they split.
+ * ============================================================ */
+
+/* A CFG edge that could become a fall-through */
+typedef struct {
+    int from;                   /* Source block */
+    int to;                     /* Destination block */
+    double weight;              /* Estimated times it is taken */
+    int falls;                  /* Already the fall-through edge */
+} LayoutEdge;
+
+/* What a block's last instruction needs after reordering */
+enum { LAYOUT_KEEP, LAYOUT_DROP_GOTO, LAYOUT_INVERT, LAYOUT_ADD_GOTO };
+
+/* Scratch arrays for one layout sweep, indexed by block */
+typedef struct {
+    int* depth;                 /* Loop nesting depth */
+    int* mark;                  /* Loop header whose body the block was last put in */
+    int* stack;                 /* Blocks still to walk while collecting a loop */
+    int* fall;                  /* Fall-through successor (-1 = none) */
+    int* jump;                  /* Jump target (-1 = none) */
+    int* chain;                 /* Union-find parent; a chain's blocks share a root */
+    int* next;                  /* Next block in its chain (-1 = tail) */
+    int* prev;                  /* Previous block in its chain (-1 = head) */
+    int* order;                 /* New order of the region's blocks */
+    int* action;                /* LAYOUT_* for the block's last instruction */
+    int* needs_label;           /* Block becomes a jump target */
+    LayoutEdge* edges;          /* Candidate edges of the region */
+} LayoutState;
+
+/* Helper: sort layout edges - heaviest first, then the current
+ * fall-through edges, then list order (qsort is not stable) */
+static int compare_layout_edges(const void* a, const void* b) {
+    const LayoutEdge* x = (const LayoutEdge*)a;
+    const LayoutEdge* y = (const LayoutEdge*)b;
+    if (x->weight != y->weight) return x->weight > y->weight ? -1 : 1;
+    if (x->falls != y->falls) return y->falls - x->falls;
+    if (x->from != y->from) return x->from - y->from;
+    return x->to - y->to;
+}
+
+/* Helper: root of a block's chain (with path halving) */
+static int chain_root(int* chain, int block) {
+    while (chain[block] != block) {
+        chain[block] = chain[chain[block]];
+        block = chain[block];
+    }
+    return block;
+}
+
+/* Helper: does a block end by returning? */
+static int block_returns(const BasicBlock* block) {
+    return block->last->opcode == TAC_RETURN || block->last->opcode == TAC_RETURN_VOID;
+}
+
+/* Helper: loop nesting depth of every block - each loop header collects
+ * the blocks that reach one of its back edges without passing through it */
+static void compute_loop_depths(FlowGraph* graph, LayoutState* state) {
+    for (int b = 0; b < graph->block_count; b++) {
+        state->depth[b] = 0;
+        state->mark[b] = -1;
+    }
+
+    for (int h = 0; h < graph->block_count; h++) {
+        BasicBlock* header = &graph->blocks[h];
+        if (header->rpo < 0) continue;
+
+        int top = 0;
+        for (int p = 0; p < header->pred_count; p++) {
+            int latch = header->preds[p];
+            if (state->mark[latch] != h && block_dominates(graph, h, latch)) {
+                if (top == 0) {
+                    state->mark[h] = h;
+                    state->depth[h]++;
+                }
+                if (latch != h) {
+                    state->mark[latch] = h;
+                    state->depth[latch]++;
+                    state->stack[top++] = latch;
+                }
             }
+        }
 
-            inst = inst->next;
+        while (top > 0) {
+            BasicBlock* block = &graph->blocks[state->stack[--top]];
+            for (int p = 0; p < block->pred_count; p++) {
+                int pred = block->preds[p];
+                if (state->mark[pred] == h || graph->blocks[pred].rpo < 0) continue;
+                state->mark[pred] = h;
+                state->depth[pred]++;
+                state->stack[top++] = pred;
+            }
+        }
+    }
+}
 
-            free(to_remove->result);
-            free(to_remove->op1);
-            free(to_remove->op2);
-            free(to_remove->label);
-            free(to_remove);
+/* Helper: times a block ran according to the profile (its first
+ * instruction with a count; 0 for code the profile does not cover) */
+static double profile_frequency(const BasicBlock* block) {
+    for (TACInstruction* inst = block->first; inst; inst = inst->next) {
+        if (inst->flags & TAC_FLAG_COUNTED) return (double)inst->count;
+        if (inst == block->last) break;
+    }
+    return 0.0;
+}
 
-            code->instruction_count--;
-            optimizations++;
-            printf("[OPTIMIZER] Flow: Removed jump to next instruction\n");
-            continue;
+/* Helper: estimated probability that block from goes on to block to */
+static double edge_probability(FlowGraph* graph, LayoutState* state, int from, int to) {
+    int fall = state->fall[from];
+    int jump = state->jump[from];
+    if (fall < 0 || jump < 0 || fall == jump) return 1.0;
+
+    /* Measured: the profile says how often the jump was taken */
+    TACInstruction* last = graph->blocks[from].last;
+    if ((last->flags & TAC_FLAG_COUNTED) && last->opcode != TAC_GOTO && last->count > 0) {
+        double taken = (double)last->taken / (double)last->count;
+        return to == jump ? taken : 1.0 - taken;
+    }
+
+    int other = to == fall ? jump : fall;
+    if (state->depth[to] != state->depth[other]) {
+        return state->depth[to] > state->depth[other] ? 0.9 : 0.1;
+    }
+    if (block_dominates(graph, to, from) != block_dominates(graph, other, from)) {
+        return block_dominates(graph, to, from) ? 0.9 : 0.1;
+    }
+    int returns = block_returns(&graph->blocks[to]);
+    if (returns != block_returns(&graph->blocks[other])) {
+        return returns ? 0.2 : 0.8;
+    }
+    return 0.5;
+}
+
+/* Helper: label for a block that is about to become a jump target,
+ * adding one named L<function>.<n> if it has none */
+static const char* layout_label(Optimizer* opt, BasicBlock* blocks, int entry, int block, int* counter) {
+    if (blocks[block].first->opcode == TAC_LABEL) return blocks[block].first->label;
+
+    const char* function = blocks[entry].first->label;
+    size_t length = strlen(function);
+    if (*counter < 0) {
+        /* Continue after the labels earlier layout runs made */
+        *counter = 0;
+        for (TACInstruction* inst = blocks[entry].first->next;
+             inst && inst->opcode != TAC_FUNCTION_LABEL; inst = inst->next) {
+            if (inst->opcode == TAC_LABEL && inst->label[0] == 'L' &&
+                strncmp(inst->label + 1, function, length) == 0 && inst->label[length + 1] == '.') {
+                int number = atoi(inst->label + length + 2);
+                if (number >= *counter) *counter = number + 1;
+            }
         }
+    }
 
-        /* Remove if_false with constant condition */
-        if (inst->opcode == TAC_IF_FALSE && inst->op1 && is_number(inst->op1)) {
-            int condition = atoi(inst->op1);
+    char* name = (char*)safe_malloc(length + 16, "label name");
+    snprintf(name, length + 16, "L%s.%d", function, (*counter)++);
+    TACInstruction* label = create_tac_instruction(TAC_LABEL, NULL, NULL, NULL, name);
+    free(name);
 
-            if (condition == 0) {
-                /* Condition is always false - convert to unconditional jump */
-                inst->opcode = TAC_GOTO;
-                free(inst->op1);
-                inst->op1 = NULL;
-                optimizations++;
-                printf("[OPTIMIZER] Flow: Converted if_false with constant to goto\n");
-            } else {
-                /* Condition is always true - remove the if_false */
-                TACInstruction* to_remove = inst;
+    insert_instruction(opt, blocks[block].first->prev, label);
+    remember_label(opt, label);
+    blocks[block].first = label;
+    return label->label;
+}
 
-                if (prev) {
-                    prev->next = inst->next;
-                } else {
-                    code->head = inst->next;
+/* Helper: lay out one function's blocks; returns the changes made */
+static int layout_region(Optimizer* opt, LayoutState* state, int entry, int count) {
+    FlowGraph* graph = opt->graph;
+    BasicBlock* blocks = graph->blocks;
+    int end = entry + count;
+
+    /* Fall-through and jump successors; a block falling off the end of
+     * the function must stay last */
+    int fixed = -1;
+    for (int b = entry; b < end; b++) {
+        TACInstruction* last = blocks[b].last;
+        int stops = last->opcode == TAC_GOTO || last->opcode == TAC_RETURN ||
+                    last->opcode == TAC_RETURN_VOID;
+        state->fall[b] = !stops && b + 1 < end ? b + 1 : -1;
+        state->jump[b] = -1;
+        if (is_jump(last)) {
+            for (int s = 0; s < blocks[b].succ_count; s++) {
+                if (blocks[b].succ[s] != state->fall[b] || blocks[b].succ_count == 1) {
+                    state->jump[b] = blocks[b].succ[s];
                 }
+            }
+        }
+        if (!stops && b + 1 == end) fixed = b;
 
-                inst = inst->next;
+        state->chain[b] = b;
+        state->next[b] = -1;
+        state->prev[b] = -1;
+        state->action[b] = LAYOUT_KEEP;
+        state->needs_label[b] = 0;
+    }
 
-                free(to_remove->result);
-                free(to_remove->op1);
-                free(to_remove->op2);
-                free(to_remove->label);
-                free(to_remove);
+    /* Weigh the edges that may become fall-throughs (by the profile's
+     * block counts when the function has them) */
+    int profiled = (blocks[entry].first->flags & TAC_FLAG_COUNTED) != 0;
+    int edge_count = 0;
+    for (int b = entry; b < end; b++) {
+        if (b == fixed) continue;
+        double frequency = 1.0;
+        if (profiled) {
+            frequency = profile_frequency(&blocks[b]);
+        } else {
+            for (int d = 0; d < state->depth[b] && d < 6; d++) frequency *= 8.0;
+        }
 
-                code->instruction_count--;
-                optimizations++;
-                printf("[OPTIMIZER] Flow: Removed if_false with constant true condition\n");
+        int targets[2] = { state->fall[b], state->jump[b] };
+        for (int t = 0; t < 2; t++) {
+            int to = targets[t];
+            if (to < 0 || to == entry || to == fixed || to == b ||
+                (t == 1 && to == targets[0]) || block_dominates(graph, to, b)) {
                 continue;
             }
+            LayoutEdge* edge = &state->edges[edge_count++];
+            edge->from = b;
+            edge->to = to;
+            edge->weight = frequency * edge_probability(graph, state, b, to);
+            edge->falls = t == 0;
         }
+    }
+    qsort(state->edges, edge_count, sizeof(LayoutEdge), compare_layout_edges);
+
+    /* Join chains, heaviest edge first */
+    for (int e = 0; e < edge_count; e++) {
+        int from = state->edges[e].from;
+        int to = state->edges[e].to;
+        if (state->next[from] >= 0 || state->prev[to] >= 0) continue;
+        int from_root = chain_root(state->chain, from);
+        int to_root = chain_root(state->chain, to);
+        if (from_root == to_root) continue;
+        state->next[from] = to;
+        state->prev[to] = from;
+        state->chain[to_root] = from_root;
+    }
 
-        prev = inst;
-        inst = inst->next;
+    /* Emit the chains: the entry's first, the rest in original order,
+     * the block falling off the end last */
+    int placed = 0;
+    int moved = 0;
+    for (int b = entry; b < end; b++) {
+        if (state->prev[b] >= 0 || b == fixed) continue;
+        for (int x = b; x >= 0; x = state->next[x]) {
+            if (x != entry + placed) moved++;
+            state->order[placed++] = x;
+        }
+    }
+    if (fixed >= 0) {
+        if (fixed != entry + placed) moved++;
+        state->order[placed++] = fixed;
     }
 
-    return optimizations;
+    /* Decide what each block's last instruction needs */
+    int rewrites = 0;
+    for (int i = 0; i < placed; i++) {
+        int b = state->order[i];
+        int next = i + 1 < placed ? state->order[i + 1] : -1;
+        int fall = state->fall[b];
+        TACOpcode op = blocks[b].last->opcode;
+
+        if (op == TAC_GOTO && state->jump[b] >= 0 && state->jump[b] == next) {
+            state->action[b] = LAYOUT_DROP_GOTO;
+        } else if (fall >= 0 && fall != next) {
+            state->action[b] = op != TAC_GOTO && is_jump(blocks[b].last) && next >= 0 &&
+                               state->jump[b] == next ? LAYOUT_INVERT : LAYOUT_ADD_GOTO;
+            state->needs_label[fall] = 1;
+        } else {
+            continue;
+        }
+        rewrites++;
+    }
+    if (moved == 0 && rewrites == 0) return 0;
+
+    /* Name the blocks that become jump targets */
+    int counter = -1;
+    for (int b = entry; b < end; b++) {
+        if (state->needs_label[b]) layout_label(opt, blocks, entry, b, &counter);
+    }
+
+    /* Relink the region's instructions in the new order */
+    TACInstruction* before = blocks[entry].first->prev;
+    TACInstruction* after = blocks[end - 1].last->next;
+    TACInstruction* tail = before;
+    for (int i = 0; i < placed; i++) {
+        BasicBlock* block = &blocks[state->order[i]];
+        if (tail) {
+            tail->next = block->first;
+        } else {
+            opt->code->head = block->first;
+        }
+        block->first->prev = tail;
+        tail = block->last;
+        enqueue(opt, block->last);
+    }
+    tail->next = after;
+    if (after) {
+        after->prev = tail;
+    } else {
+        opt->code->tail = tail;
+    }
+
+    /* Fix up the branches */
+    for (int i = 0; i < placed; i++) {
+        int b = state->order[i];
+        TACInstruction* last = blocks[b].last;
+        switch (state->action[b]) {
+            case LAYOUT_DROP_GOTO:
+                delete_instruction(opt, last);
+                break;
+            case LAYOUT_INVERT:
+                begin_change(opt, last);
+                invert_branch(last);
+                set_operand(&last->label, blocks[state->fall[b]].first->label);
+                end_change(opt, last, 1, ANALYSIS_ALL);
+                break;
+            case LAYOUT_ADD_GOTO:
+                insert_instruction(opt, last, create_tac_instruction(TAC_GOTO, NULL, NULL, NULL,
+                                                                     blocks[state->fall[b]].first->label));
+                break;
+            default:
+                break;
+        }
+    }
+
+    invalidate_analyses(graph, ANALYSIS_ALL);
+    opt_log(LOG_VERBOSE, "[OPTIMIZER] Block layout: %s: moved %d blocks, rewrote %d branches\n",
+            blocks[entry].first->label, moved, rewrites);
+    return moved + rewrites;
 }
 
-/* Main optimization driver: Apply all optimizations iteratively */
-TACCode* optimize_tac(TACCode* original_code, OptimizationStats* stats) {
-    printf("\n============ CODE OPTIMIZATION STARTED =============\n\n");
+/* Block Layout (sweep): reorder the blocks of every function */
+static int block_layout_sweep(Optimizer* opt) {
+    FlowGraph* graph = opt->graph;
+    int block_count = graph->block_count;
+    if (block_count == 0) return 0;
+
+    LayoutState state;
+    int** arrays[] = { &state.depth, &state.mark, &state.stack, &state.fall, &state.jump,
+                       &state.chain, &state.next, &state.prev, &state.order, &state.action,
+                       &state.needs_label };
+    int array_count = (int)(sizeof(arrays) / sizeof(arrays[0]));
+    for (int a = 0; a < array_count; a++) {
+        *arrays[a] = (int*)safe_malloc(block_count * sizeof(int), "block layout");
+    }
+    state.edges = (LayoutEdge*)safe_malloc(2 * block_count * sizeof(LayoutEdge), "block layout");
 
-    /* Initialize statistics */
-    stats->constant_folds = 0;
-    stats->dead_code_eliminated = 0;
-    stats->copy_propagations = 0;
-    stats->peephole_opts = 0;
-    stats->total_optimizations = 0;
+    compute_loop_depths(graph, &state);
 
-    /* Apply optimizations multiple times until no more improvements */
-    int iteration = 0;
-    int total_opts = 0;
+    /* Regions keep their blocks in place while earlier ones are rewritten */
+    int changes = 0;
+    for (int r = 0; r < graph->region_count; r++) {
+        FlowRegion* region = &graph->regions[r];
+        if (region->block_count < 2 ||
+            graph->blocks[region->first_block].first->opcode != TAC_FUNCTION_LABEL) {
+            continue;
+        }
+        changes += layout_region(opt, &state, region->first_block, region->block_count);
+    }
 
-    do {
-        total_opts = 0;
-        iteration++;
+    /* Drop the labels no jump refers to any more (inverted and threaded
+     * branches leave them behind), so the blocks they split join again */
+    for (TACInstruction* inst = opt->code->head; inst; inst = inst->next) {
+        if (!is_jump(inst) || !inst->label) continue;
+        TACInstruction* label = find_label(opt, inst->label);
+        if (label) label->flags |= TAC_FLAG_TARGET;
+    }
+    TACInstruction* next;
+    for (TACInstruction* inst = opt->code->head; inst; inst = next) {
+        next = inst->next;
+        if (inst->opcode != TAC_LABEL) continue;
+        if (inst->flags & TAC_FLAG_TARGET) {
+            inst->flags &= ~TAC_FLAG_TARGET;
+        } else {
+            delete_instruction(opt, inst);
+            changes++;
+        }
+    }
+
+    for (int a = 0; a < array_count; a++) free(*arrays[a]);
+    free(state.edges);
+    return changes;
+}
+
+/* ============================================================
+ * PASS MANAGER
+ * ============================================================ */
+
+/* How to run each pass */
+typedef struct {
+    const char* name;           /* --passes name */
+    const char* title;          /* Name in statistics and time reports */
+    int (*visit)(Optimizer* opt, TACInstruction* inst);  /* Rule for one instruction (NULL = sweep only) */
+    int (*sweep)(Optimizer* opt);   /* Whole-code version (NULL = visit every instruction) */
+    unsigned requires;          /* Analyses its sweep needs */
+} PassInfo;
+
+static const PassInfo pass_table[PASS_COUNT] = {
+    { "fold",      "constant folding", fold_instruction,      NULL, 0 },
+    { "copy-prop", "copy propagation", propagate_copy,        copy_propagation_sweep, 0 },
+    { "cse",       "common subexpr",   NULL,                  common_subexpression_sweep, 0 },
+    { "peephole",  "peephole",         peephole_instruction,  NULL, 0 },
+    { "flow",      "flow",             flow_instruction,      NULL, 0 },
+    { "dce",       "dead code",        dead_code_instruction, NULL, 0 },
+    { "dse",       "dead stores",      dead_temporary,        dead_store_sweep,
+      ANALYSIS_CFG | ANALYSIS_LIVENESS },
+    { "layout",    "block layout",     NULL,                  block_layout_sweep,
+      ANALYSIS_CFG | ANALYSIS_DOMINATORS },
+    { "ranges",    "value ranges",     NULL,                  value_range_sweep,
+      ANALYSIS_CFG | ANALYSIS_LIVENESS | ANALYSIS_DOMINATORS }
+};
+
+/* Helper: run one pass over all the code - compute the analyses it needs,
+ * record its statistics and time it when a report is attached */
+static int sweep_pass(Optimizer* opt, int pass, OptimizationStats* stats) {
+    const PassInfo* info = &pass_table[pass];
+    PhaseMark mark;
+    if (pass_timing) begin_phase(pass_timing, &mark, info->title, 1);
+    double start = monotonic_ms();
+
+    int count = 0;
+    require_analyses(opt->graph, info->requires);
+    if (info->sweep) {
+        count = info->sweep(opt);
+    } else {
+        /* A removed instruction keeps its next pointer, so the walk can
+         * step off it onto the first instruction still in the list */
+        TACInstruction* inst = opt->code->head;
+        while (inst) {
+            count += info->visit(opt, inst);
+            inst = inst->next;
+            while (inst && (inst->flags & TAC_FLAG_REMOVED)) inst = inst->next;
+        }
+    }
 
-        printf("[OPTIMIZER] === Optimization Pass %d ===\n", iteration);
+    stats->passes[pass].runs++;
+    stats->passes[pass].changes += count;
+    stats->passes[pass].ms += monotonic_ms() - start;
+    if (pass_timing) end_phase(pass_timing, &mark);
+    return count;
+}
 
-        /* Constant folding */
-        int cf = constant_folding(original_code);
-        stats->constant_folds += cf;
-        total_opts += cf;
+/* Helper: apply the pipeline's rules to queued instructions until the
+ * worklist is empty */
+static int drain_worklist(Optimizer* opt, const PassPipeline* pipeline, OptimizationStats* stats) {
+    PhaseMark mark;
+    if (pass_timing) begin_phase(pass_timing, &mark, "worklist", 1);
+    double start = monotonic_ms();
+    int total = 0;
+
+    while (opt->queue_count > 0) {
+        TACInstruction* inst = opt->queue[--opt->queue_count];
+        inst->flags &= ~TAC_FLAG_QUEUED;
+        if (inst->flags & TAC_FLAG_REMOVED) continue;
+
+        stats->worklist_visits++;
+        for (int i = 0; i < pipeline->pass_count; i++) {
+            int pass = pipeline->passes[i];
+            if (!pass_table[pass].visit) continue;
+            int count = pass_table[pass].visit(opt, inst);
+            stats->passes[pass].changes += count;
+            total += count;
+            if (inst->flags & TAC_FLAG_REMOVED) break;
+        }
+    }
 
-        /* Copy propagation */
-        int cp = copy_propagation(original_code);
-        stats->copy_propagations += cp;
-        total_opts += cp;
+    stats->worklist_ms += monotonic_ms() - start;
+    if (pass_timing) end_phase(pass_timing, &mark);
+    return total;
+}
 
-        /* Peephole optimization */
-        int po = peephole_optimization(original_code);
-        stats->peephole_opts += po;
-        total_opts += po;
+/* Helper: run one pass on its own (the public single-pass functions) */
+static int run_single_pass(TACCode* code, FlowGraph* graph, int pass) {
+    OptimizationStats stats;
+    Optimizer opt;
+    FlowGraph* own_graph = graph ? NULL : create_flow_graph(code);
+
+    memset(&stats, 0, sizeof(stats));
+    init_optimizer(&opt, code, graph ? graph : own_graph);
+    int count = sweep_pass(&opt, pass, &stats);
+    finish_optimizer(&opt);
+    free_flow_graph(own_graph);
+    return count;
+}
+
+/* Constant folding over the whole list */
+int constant_folding(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_CONSTANT_FOLDING);
+}
+
+/* Copy propagation over the whole list */
+int copy_propagation(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_COPY_PROPAGATION);
+}
 
-        /* Flow optimization */
-        int fo = flow_optimization(original_code);
-        total_opts += fo;
+/* Common subexpression elimination over the whole list */
+int common_subexpression_elimination(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_COMMON_SUBEXPRESSIONS);
+}
 
-        /* Dead code elimination (should be last) */
-        int dce = eliminate_dead_code(original_code);
-        stats->dead_code_eliminated += dce;
-        total_opts += dce;
+/* Peephole optimization over the whole list */
+int peephole_optimization(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_PEEPHOLE);
+}
 
-        printf("[OPTIMIZER] Pass %d: %d optimizations applied\n\n", iteration, total_opts);
+/* Flow optimization over the whole list */
+int flow_optimization(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_FLOW);
+}
 
-        /* Limit iterations to prevent infinite loops */
-        if (iteration >= 5) break;
+/* Block layout over the whole list */
+int block_layout(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_BLOCK_LAYOUT);
+}
 
-    } while (total_opts > 0);
+/* Dead code elimination over the whole list */
+int eliminate_dead_code(TACCode* code) {
+    return run_single_pass(code, NULL, PASS_DEAD_CODE);
+}
 
-    stats->total_optimizations = stats->constant_folds +
-                                 stats->copy_propagations +
-                                 stats->peephole_opts +
-                                 stats->dead_code_eliminated;
+/* Liveness-based dead store elimination over the whole list */
+int eliminate_dead_stores(TACCode* code, FlowGraph* graph) {
+    return run_single_pass(code, graph, PASS_DEAD_STORES);
+}
 
-    printf("============ CODE OPTIMIZATION COMPLETE ============\n");
-    printf("Total optimization passes: %d\n", iteration);
-    printf("Total optimizations applied: %d\n\n", stats->total_optimizations);
+/* --passes name of a pass */
+const char* optimization_pass_name(int pass) {
+    return pass >= 0 && pass < PASS_COUNT ? pass_table[pass].name : "unknown";
+}
+
+/* Set up the predefined pipeline for an optimization level */
+void init_pass_pipeline(PassPipeline* pipeline, int level) {
+    static const int basic[] = {
+        PASS_CONSTANT_FOLDING, PASS_COPY_PROPAGATION, PASS_PEEPHOLE, PASS_FLOW, PASS_DEAD_CODE
+    };
+    static const int full[] = {
+        PASS_CONSTANT_FOLDING, PASS_COPY_PROPAGATION, PASS_COMMON_SUBEXPRESSIONS,
+        PASS_PEEPHOLE, PASS_FLOW, PASS_DEAD_CODE, PASS_VALUE_RANGES, PASS_DEAD_STORES,
+        PASS_BLOCK_LAYOUT
+    };
+
+    if (level < 0) level = 0;
+    if (level > 3) level = 3;
+
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->level = level;
+    if (level == 0) return;
+
+    const int* passes = level == 1 ? basic : full;
+    int count = level == 1 ? (int)(sizeof(basic) / sizeof(basic[0]))
+                           : (int)(sizeof(full) / sizeof(full[0]));
+    for (int i = 0; i < count; i++) {
+        pipeline->passes[pipeline->pass_count++] = passes[i];
+    }
+    pipeline->max_iterations = level == 1 ? 1 : level == 2 ? 5 : 20;
+}
+
+/* Replace the pass list with a comma-separated list of names */
+int parse_pass_pipeline(PassPipeline* pipeline, const char* list) {
+    PassPipeline parsed = *pipeline;
+    parsed.pass_count = 0;
+    parsed.level = -1;
+    if (parsed.max_iterations == 0) parsed.max_iterations = 1;
+
+    const char* p = list;
+    while (*p && strcmp(list, "none") != 0) {
+        const char* end = strchr(p, ',');
+        size_t length = end ? (size_t)(end - p) : strlen(p);
+
+        int found = -1;
+        for (int i = 0; i < PASS_COUNT; i++) {
+            if (strlen(pass_table[i].name) == length && strncmp(pass_table[i].name, p, length) == 0) {
+                found = i;
+                break;
+            }
+        }
+        if (found < 0) {
+            fprintf(stderr, "Error: Unknown optimization pass '%.*s' (passes:", (int)length, p);
+            for (int i = 0; i < PASS_COUNT; i++) fprintf(stderr, " %s", pass_table[i].name);
+            fprintf(stderr, ")\n");
+            return -1;
+        }
+        if (parsed.pass_count == MAX_PIPELINE_PASSES) {
+            fprintf(stderr, "Error: More than %d passes in --passes\n", MAX_PIPELINE_PASSES);
+            return -1;
+        }
+        parsed.passes[parsed.pass_count++] = found;
+
+        if (!end) break;
+        p = end + 1;
+    }
+
+    *pipeline = parsed;
+    return 0;
+}
+
+/* Short description of a pipeline */
+void describe_pass_pipeline(const PassPipeline* pipeline, char* buffer, size_t size) {
+    if (pipeline->level >= 0) {
+        snprintf(buffer, size, "-O%d", pipeline->level);
+        return;
+    }
+
+    size_t used = (size_t)snprintf(buffer, size, "passes=");
+    for (int i = 0; i < pipeline->pass_count && used < size; i++) {
+        used += (size_t)snprintf(buffer + used, size - used, "%s%s", i > 0 ? "," : "",
+                                 optimization_pass_name(pipeline->passes[i]));
+    }
+    if (used < size) {
+        snprintf(buffer + used, size - used, " x%d", pipeline->max_iterations);
+    }
+}
+
+/* Main optimization driver. Round 1 sweeps every pass over the code;
+ * later rounds only re-sweep the passes that look past one instruction
+ * (copy-prop, cse, dse and layout).
+ * Between sweeps the worklist carries each change to the instructions
+ * it affects, so the local rules reach their fixed point without
+ * re-reading unchanged code. -O1 (one round) skips the worklist. */
+TACCode* optimize_tac(TACCode* original_code, const PassPipeline* pipeline, OptimizationStats* stats) {
+    PassPipeline default_pipeline;
+    if (!pipeline) {
+        init_pass_pipeline(&default_pipeline, DEFAULT_OPT_LEVEL);
+        pipeline = &default_pipeline;
+    }
+
+    opt_log(LOG_NORMAL, "\n============ CODE OPTIMIZATION STARTED =============\n\n");
+
+    /* Initialize statistics */
+    memset(stats, 0, sizeof(*stats));
+
+    FlowGraph* graph = create_flow_graph(original_code);
+    Optimizer opt;
+    init_optimizer(&opt, original_code, graph);
+
+    int global_passes = 0;
+    for (int i = 0; i < pipeline->pass_count; i++) {
+        if (pass_table[pipeline->passes[i]].sweep) global_passes++;
+    }
+
+    int iteration = 0;
+    while (iteration < pipeline->max_iterations && pipeline->pass_count > 0) {
+        iteration++;
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] === Optimization Pass %d ===\n", iteration);
+
+        int total_opts = 0;
+        for (int i = 0; i < pipeline->pass_count; i++) {
+            int pass = pipeline->passes[i];
+            if (iteration == 1 || pass_table[pass].sweep) {
+                total_opts += sweep_pass(&opt, pass, stats);
+            }
+        }
+        if (pipeline->max_iterations > 1) {
+            total_opts += drain_worklist(&opt, pipeline, stats);
+        }
+
+        opt_log(LOG_VERBOSE, "[OPTIMIZER] Pass %d: %d optimizations applied\n\n", iteration, total_opts);
+
+        /* The local rules are at a fixed point once the worklist is empty;
+         * only the passes that look past one instruction can find more */
+        if (total_opts == 0 || global_passes == 0) break;
+    }
+
+    finish_optimizer(&opt);
+    for (int a = 0; a < ANALYSIS_COUNT; a++) {
+        stats->analyses_computed[a] = graph->computed[a];
+    }
+    free_flow_graph(graph);
+
+    stats->iterations = iteration;
+    stats->constant_folds = stats->passes[PASS_CONSTANT_FOLDING].changes;
+    stats->copy_propagations = stats->passes[PASS_COPY_PROPAGATION].changes;
+    stats->peephole_opts = stats->passes[PASS_PEEPHOLE].changes;
+    stats->dead_code_eliminated = stats->passes[PASS_DEAD_CODE].changes +
+                                  stats->passes[PASS_DEAD_STORES].changes;
+    for (int p = 0; p < PASS_COUNT; p++) {
+        stats->total_optimizations += stats->passes[p].changes;
+    }
+
+    opt_log(LOG_NORMAL, "============ CODE OPTIMIZATION COMPLETE ============\n");
+    opt_log(LOG_NORMAL, "Total optimization passes: %d\n", iteration);
+    opt_log(LOG_NORMAL, "Total optimizations applied: %d\n\n", stats->total_optimizations);
 
     return original_code;
 }
@@ -483,5 +1695,19 @@ void print_optimization_stats(OptimizationStats* stats) {
     printf("Dead code eliminations:    %d\n", stats->dead_code_eliminated);
     printf("----------------------------------------\n");
     printf("Total optimizations:       %d\n", stats->total_optimizations);
-    printf("\n========================================================\n\n");
+    printf("Pipeline rounds:           %d\n", stats->iterations);
+    printf("Worklist visits:           %d\n", stats->worklist_visits);
+
+    printf("\n%-20s %6s %8s %10s\n", "Pass", "Sweeps", "Changes", "Time (ms)");
+    for (int p = 0; p < PASS_COUNT; p++) {
+        if (stats->passes[p].runs == 0) continue;
+        printf("%-20s %6d %8d %10.3f\n", pass_table[p].title, stats->passes[p].runs,
+               stats->passes[p].changes, stats->passes[p].ms);
+    }
+    printf("%-20s %6s %8s %10.3f\n", "worklist", "-", "-", stats->worklist_ms);
+    printf("Analyses computed:  ");
+    for (int a = 0; a < ANALYSIS_COUNT; a++) {
+        printf(" %s %d", analysis_name(a), stats->analyses_computed[a]);
+    }
+    printf("\n\n========================================================\n\n");
 }
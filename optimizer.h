@@ -8,6 +8,26 @@
  * - Dead code elimination
  * - Copy propagation
  * - Peephole optimization
+ * - Common subexpression elimination
+ * - Dead store elimination (liveness based)
+ * - Jump threading and branch inversion
+ * - Basic block layout (likely successors fall through)
+ * - Value range analysis: bounds checks that cannot fail (--bounds-check)
+ *   and unsigned division where operands are never negative
+ *
+ * The passes run under a pass manager. A PassPipeline lists the passes in
+ * order and how often the list may repeat while it keeps changing code;
+ * -O0 to -O3 select a predefined pipeline and --passes=a,b,c a custom
+ * one. Each pass declares the analyses it needs (see cfg.h); a change
+ * drops only the analyses it breaks, so the CFG, liveness and dominators
+ * are rebuilt only after something changed underneath them.
+ *
+ * Most passes are rules over single instructions. The first round sweeps
+ * every pass over the code; after that each change puts only the
+ * instructions it can affect on a worklist, and the worklist is drained
+ * until no rule applies. Instructions are unlinked from the doubly linked
+ * TAC list in O(1), and the def-use chains (defuse.h) give every use and
+ * the definition of a value directly, so no rule rescans the list.
  */
 
 #ifndef OPTIMIZER_H
@@ -17,6 +37,40 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ircode.h"
+#include "timing.h"
+#include "cfg.h"
+
+/* Optimization passes (--passes names in parentheses) */
+typedef enum {
+    PASS_CONSTANT_FOLDING,      /* Constant folding and algebraic identities (fold) */
+    PASS_COPY_PROPAGATION,      /* Copy propagation (copy-prop) */
+    PASS_COMMON_SUBEXPRESSIONS, /* Common subexpression elimination (cse) */
+    PASS_PEEPHOLE,              /* Peephole optimization (peephole) */
+    PASS_FLOW,                  /* Jump and branch cleanup (flow) */
+    PASS_DEAD_CODE,             /* Unreachable code and duplicate copies (dce) */
+    PASS_DEAD_STORES,           /* Temporaries that are never read (dse) */
+    PASS_BLOCK_LAYOUT,          /* Block order with hot paths falling through (layout) */
+    PASS_VALUE_RANGES,          /* Bounds checks and divisions by value ranges (ranges) */
+    PASS_COUNT
+} OptimizationPass;
+
+#define MAX_PIPELINE_PASSES 32
+#define DEFAULT_OPT_LEVEL   2
+
+/* Pass pipeline - which passes run, in what order, how often */
+typedef struct {
+    int passes[MAX_PIPELINE_PASSES];    /* OptimizationPass values in run order */
+    int pass_count;                     /* Number of passes in the list */
+    int max_iterations;                 /* Repeat the list while it changes code, at most this often */
+    int level;                          /* -O level it came from (-1 = custom --passes list) */
+} PassPipeline;
+
+/* Statistics for one pass */
+typedef struct {
+    int runs;                   /* Times the pass ran */
+    int changes;                /* Changes it made */
+    double ms;                  /* Time spent in it, including analyses it needed */
+} PassStats;
 
 /* Optimization statistics */
 typedef struct {
@@ -25,12 +79,37 @@ typedef struct {
     int copy_propagations;      /* Number of copy propagations */
     int peephole_opts;          /* Number of peephole optimizations */
     int total_optimizations;    /* Total optimizations performed */
+    int iterations;             /* Times the pass list ran */
+    int worklist_visits;        /* Instructions revisited after a change */
+    double worklist_ms;         /* Time spent draining the worklist */
+    PassStats passes[PASS_COUNT];            /* Per-pass counts and times */
+    int analyses_computed[ANALYSIS_COUNT];   /* Times each analysis was (re)computed */
 } OptimizationStats;
 
+/* PASS PIPELINE FUNCTIONS */
+
+/* Set up the predefined pipeline for -O<level> (0-3):
+ *   -O0  no optimization
+ *   -O1  fold, copy-prop, peephole, flow, dce - one round
+ *   -O2  -O1 plus cse, dse and layout, repeated up to 5 rounds while code changes (default)
+ *   -O3  -O2 repeated up to 20 rounds (runs to a fixed point in practice) */
+void init_pass_pipeline(PassPipeline* pipeline, int level);
+
+/* Replace the pass list with a comma-separated list of pass names (the
+ * round limit of the current level is kept). "none" or "" clears it.
+ * Returns 0, or -1 after reporting an unknown pass name on stderr. */
+int parse_pass_pipeline(PassPipeline* pipeline, const char* list);
+
+/* Short description of a pipeline ("-O2" or "passes=fold,dse x5") */
+void describe_pass_pipeline(const PassPipeline* pipeline, char* buffer, size_t size);
+
+/* --passes name of a pass */
+const char* optimization_pass_name(int pass);
+
 /* OPTIMIZATION FUNCTIONS */
 
-/* Main optimization driver - applies all optimizations */
-TACCode* optimize_tac(TACCode* original_code, OptimizationStats* stats);
+/* Main optimization driver - runs the pipeline (NULL = -O2) over the code */
+TACCode* optimize_tac(TACCode* original_code, const PassPipeline* pipeline, OptimizationStats* stats);
 
 /* Constant folding: evaluate constant expressions at compile time */
 int constant_folding(TACCode* code);
@@ -41,12 +120,32 @@ int eliminate_dead_code(TACCode* code);
 /* Copy propagation: replace copies with original values */
 int copy_propagation(TACCode* code);
 
+/* Common subexpression elimination: reuse values computed earlier in a block */
+int common_subexpression_elimination(TACCode* code);
+
 /* Peephole optimization: improve small sequences of instructions */
 int peephole_optimization(TACCode* code);
 
-/* Flow optimization: optimize control flow structures */
+/* Flow optimization: optimize control flow structures (constant
+ * branches, jumps to the next instruction, jump threading) */
 int flow_optimization(TACCode* code);
 
+/* Block layout: order each function's blocks so likely successors fall
+ * through (static estimates: loops are hot, returns are cold) */
+int block_layout(TACCode* code);
+
+/* Dead store elimination: remove temporaries that are not live after
+ * their assignment (graph must hold the CFG and liveness) */
+int eliminate_dead_stores(TACCode* code, FlowGraph* graph);
+
+/* Enable or disable progress messages on the calling thread (disabled
+ * while functions are optimized in parallel so the log stays deterministic) */
+void set_optimizer_logging(int enabled);
+
+/* Record the time of each optimization pass in report (NULL to stop) on
+ * the calling thread. Passes run on worker threads are not timed. */
+void set_optimizer_timing(TimeReport* report);
+
 /* Print optimization statistics */
 void print_optimization_stats(OptimizationStats* stats);
 
@@ -0,0 +1,151 @@
+/*
+ * OUTPUT.C - Output Sink Implementation
+ * CST-405 Compiler Project
+ *
+ * Text is appended to a growable buffer (doubling its capacity), so the
+ * code generators never go through stdio for individual lines. Stream
+ * sinks pass the buffer on with one fwrite whenever it passes
+ * SINK_FLUSH_THRESHOLD and when they are flushed or closed.
+ */
+
+#include "output.h"
+#include "diagnostics.h"
+#include <stdarg.h>
+
+/* Helper: allocate a sink */
+static OutputSink* create_sink(FILE* stream, int owns_stream) {
+    OutputSink* sink = (OutputSink*)safe_malloc(sizeof(OutputSink), "output sink");
+    sink->data = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+    sink->stream = stream;
+    sink->owns_stream = owns_stream;
+    sink->failed = 0;
+    return sink;
+}
+
+/* Helper: make room for `extra` more bytes */
+static void reserve(OutputSink* sink, size_t extra) {
+    if (sink->length + extra <= sink->capacity) return;
+
+    size_t capacity = sink->capacity ? sink->capacity : 4096;
+    while (capacity < sink->length + extra) {
+        capacity *= 2;
+    }
+
+    sink->data = (char*)safe_realloc(sink->data, capacity, "output buffer");
+    sink->capacity = capacity;
+}
+
+/* Helper: pass a full buffer on for stream sinks */
+static void check_flush(OutputSink* sink) {
+    if (sink->stream && sink->length >= SINK_FLUSH_THRESHOLD) {
+        flush_sink(sink);
+    }
+}
+
+/* Create an in-memory sink */
+OutputSink* create_buffer_sink(void) {
+    return create_sink(NULL, 0);
+}
+
+/* Create a sink writing to a new file */
+OutputSink* create_file_sink(const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) return NULL;
+    return create_sink(file, 1);
+}
+
+/* Create a sink writing to an open stream */
+OutputSink* create_stream_sink(FILE* stream) {
+    return create_sink(stream, 0);
+}
+
+/* Append length bytes of text */
+void sink_write(OutputSink* sink, const char* text, size_t length) {
+    reserve(sink, length);
+    memcpy(sink->data + sink->length, text, length);
+    sink->length += length;
+    check_flush(sink);
+}
+
+/* Append a NUL-terminated string */
+void sink_puts(OutputSink* sink, const char* text) {
+    sink_write(sink, text, strlen(text));
+}
+
+/* Append formatted text, formatting straight into the buffer */
+void sink_printf(OutputSink* sink, const char* format, ...) {
+    va_list args;
+
+    reserve(sink, 256);
+    va_start(args, format);
+    int needed = vsnprintf(sink->data + sink->length, sink->capacity - sink->length, format, args);
+    va_end(args);
+    if (needed < 0) return;
+
+    if ((size_t)needed >= sink->capacity - sink->length) {
+        /* Did not fit - grow and format again */
+        reserve(sink, (size_t)needed + 1);
+        va_start(args, format);
+        vsnprintf(sink->data + sink->length, sink->capacity - sink->length, format, args);
+        va_end(args);
+    }
+
+    sink->length += (size_t)needed;
+    check_flush(sink);
+}
+
+/* Pass buffered text on to the backing stream */
+int flush_sink(OutputSink* sink) {
+    if (!sink->stream) return 0;
+
+    if (sink->length > 0) {
+        if (fwrite(sink->data, 1, sink->length, sink->stream) != sink->length) {
+            sink->failed = 1;
+        }
+        sink->length = 0;
+    }
+    if (fflush(sink->stream) != 0) {
+        sink->failed = 1;
+    }
+    return sink->failed;
+}
+
+/* Write a memory buffer to a file in one write */
+int save_sink(const OutputSink* sink, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) return 1;
+
+    int failed = sink->length > 0 &&
+                 fwrite(sink->data, 1, sink->length, file) != sink->length;
+    if (fclose(file) != 0) failed = 1;
+    return failed;
+}
+
+/* Take the buffered text as a string */
+char* take_sink_text(OutputSink* sink, size_t* length) {
+    reserve(sink, 1);
+    sink->data[sink->length] = '\0';
+
+    char* text = sink->data;
+    if (length) *length = sink->length;
+
+    sink->data = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+    return text;
+}
+
+/* Flush and free the sink */
+int close_sink(OutputSink* sink) {
+    if (!sink) return 0;
+
+    int failed = flush_sink(sink);
+    if (sink->owns_stream && fclose(sink->stream) != 0) {
+        failed = 1;
+    }
+    free(sink->data);
+    free(sink);
+    return failed;
+}
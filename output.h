@@ -0,0 +1,70 @@
+/*
+ * OUTPUT.H - Output Sink Header
+ * CST-405 Compiler Project
+ *
+ * Generated assembly and IR are written to an OutputSink instead of
+ * straight to a FILE. Every sink collects text in a growable memory
+ * buffer:
+ *   - buffer sinks keep everything in memory (returned to the caller or
+ *     saved to disk with a single write),
+ *   - file and stream sinks (stdout, a pipe into nasm, ...) hand the
+ *     buffered text to the stream in large blocks.
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Stream sinks pass their buffer on once it holds this many bytes */
+#define SINK_FLUSH_THRESHOLD (64 * 1024)
+
+/* Output sink */
+typedef struct {
+    char* data;                 /* Buffered text (not NUL-terminated) */
+    size_t length;              /* Bytes in the buffer */
+    size_t capacity;            /* Allocated buffer size */
+    FILE* stream;               /* Backing stream (NULL for a memory buffer) */
+    int owns_stream;            /* Close the stream with the sink */
+    int failed;                 /* A write to the stream failed */
+} OutputSink;
+
+/* SINK FUNCTIONS */
+
+/* Create an in-memory sink */
+OutputSink* create_buffer_sink(void);
+
+/* Create a sink writing to a new file. Returns NULL if it cannot be opened. */
+OutputSink* create_file_sink(const char* filename);
+
+/* Create a sink writing to an open stream such as stdout or a pipe
+ * (the stream stays open when the sink is closed) */
+OutputSink* create_stream_sink(FILE* stream);
+
+/* Append length bytes of text */
+void sink_write(OutputSink* sink, const char* text, size_t length);
+
+/* Append a NUL-terminated string */
+void sink_puts(OutputSink* sink, const char* text);
+
+/* Append formatted text */
+void sink_printf(OutputSink* sink, const char* format, ...);
+
+/* Pass buffered text on to the backing stream (no-op for memory buffers).
+ * Returns 0 on success, 1 if a write failed. */
+int flush_sink(OutputSink* sink);
+
+/* Write the contents of a memory buffer to a file in one write.
+ * Returns 0 on success, 1 on failure. */
+int save_sink(const OutputSink* sink, const char* filename);
+
+/* Take the buffered text as a NUL-terminated string that the caller frees.
+ * The sink is left empty; the text length is stored in *length if given. */
+char* take_sink_text(OutputSink* sink, size_t* length);
+
+/* Flush and free the sink. Returns 0 on success, 1 if a write failed. */
+int close_sink(OutputSink* sink);
+
+#endif /* OUTPUT_H */
@@ -23,31 +23,28 @@
 #include <string.h>
 #include "ast.h"
 #include "symtable.h"
-
-/* External references from lexer */
-extern int yylex();
-extern int yyparse();
-extern FILE* yyin;
-extern int line_num;
-extern int col_num;
-
-/* Error handling */
-void yyerror(const char* s);
-
-/* Global AST root */
-ASTNode* ast_root = NULL;
-
-/* Global symbol table */
-SymbolTable* global_symtab = NULL;
-
-/* Statistics */
-int syntax_errors = 0;
+#include "context.h"
 
 %}
 
 %code requires {
-    /* Forward declaration for ASTNode (defined in ast.h) */
+    /* Forward declarations for ASTNode (ast.h) and CompilerContext (context.h) */
     typedef struct ASTNode ASTNode;
+    typedef struct CompilerContext CompilerContext;
+}
+
+/* Pure (reentrant) parser - the scanner handle and the compilation context
+ * are passed in, so any number of parses can run at once */
+%define api.pure full
+%parse-param {void* scanner} {CompilerContext* ctx}
+%lex-param {void* scanner}
+
+%code {
+    /* Reentrant scanner (scanner_new.l) */
+    int yylex(YYSTYPE* yylval, void* scanner);
+
+    /* Error handling */
+    void yyerror(void* scanner, CompilerContext* ctx, const char* s);
 }
 
 /* Union for semantic values - stores different types of data for tokens/non-terminals */
@@ -129,8 +126,8 @@ program:
     declaration_list
     {
         $$ = create_program_node($1);
-        ast_root = $$;  /* Store root for later processing */
-        printf("[PARSER] Program parsed successfully\n");
+        ctx->ast_root = $$;  /* Store root for later processing */
+        log_message(LOG_VERBOSE, "[PARSER] Program parsed successfully\n");
     }
     ;
 
@@ -215,24 +212,14 @@ var_declaration:
     INT ID SEMICOLON
     {
         $$ = create_declaration_node($2);
-        printf("[PARSER] Declaration: int %s;\n", $2);
-
-        /* Add to symbol table during parsing for early error detection */
-        if (global_symtab && !add_symbol(global_symtab, $2, TYPE_INT, line_num)) {
-            fprintf(stderr, "Semantic Error at line %d: Variable '%s' already declared\n",
-                    line_num, $2);
-        }
+        log_message(LOG_VERBOSE, "[PARSER] Declaration: int %s;\n", $2);
+        /* Declared in its scope by the semantic analyzer */
     }
     | INT ID LBRACKET NUM RBRACKET SEMICOLON
     {
         $$ = create_array_declaration_node($2, $4);
-        printf("[PARSER] Array Declaration: int %s[%d];\n", $2, $4);
-
-        /* Add array to symbol table during parsing for early error detection */
-        if (global_symtab && !add_array_symbol(global_symtab, $2, TYPE_INT, $4, line_num)) {
-            fprintf(stderr, "Semantic Error at line %d: Array '%s' already declared\n",
-                    line_num, $2);
-        }
+        log_message(LOG_VERBOSE, "[PARSER] Array Declaration: int %s[%d];\n", $2, $4);
+        /* Declared in its scope by the semantic analyzer */
     }
     ;
 
@@ -241,16 +228,12 @@ assignment:
     ID ASSIGN expression SEMICOLON
     {
         $$ = create_assignment_node($1, $3);
-        printf("[PARSER] Assignment: %s = <expression>;\n", $1);
+        log_message(LOG_VERBOSE, "[PARSER] Assignment: %s = <expression>;\n", $1);
     }
     | ID LBRACKET expression RBRACKET ASSIGN expression SEMICOLON
     {
-        ASTNode* array_access = create_array_access_node($1, $3);
-        $$ = create_assignment_node($1, $6);
-        /* Replace the identifier with array access in assignment */
-        free($$->data.assignment.var_name);
-        $$->data.assignment.var_name = strdup($1);
-        printf("[PARSER] Array Assignment: %s[<index>] = <expression>;\n", $1);
+        $$ = create_array_assignment_node($1, $3, $6);
+        log_message(LOG_VERBOSE, "[PARSER] Array Assignment: %s[<index>] = <expression>;\n", $1);
     }
     ;
 
@@ -259,7 +242,7 @@ print_stmt:
     PRINT LPAREN expression RPAREN SEMICOLON
     {
         $$ = create_print_node($3);
-        printf("[PARSER] Print statement: print(<expression>);\n");
+        log_message(LOG_VERBOSE, "[PARSER] Print statement: print(<expression>);\n");
     }
     ;
 
@@ -268,7 +251,7 @@ while_stmt:
     WHILE LPAREN condition RPAREN LBRACE statement_list RBRACE
     {
         $$ = create_while_node($3, $6);
-        printf("[PARSER] While loop: while (<condition>) { <statements> }\n");
+        log_message(LOG_VERBOSE, "[PARSER] While loop: while (<condition>) { <statements> }\n");
     }
     ;
 
@@ -277,7 +260,7 @@ for_stmt:
     FOR LPAREN assignment condition SEMICOLON assignment RPAREN LBRACE statement_list RBRACE
     {
         $$ = create_for_node($3, $4, $6, $9);
-        printf("[PARSER] For loop: for (<init>; <condition>; <update>) { <statements> }\n");
+        log_message(LOG_VERBOSE, "[PARSER] For loop: for (<init>; <condition>; <update>) { <statements> }\n");
     }
     ;
 
@@ -286,7 +269,7 @@ do_while_stmt:
     DO LBRACE statement_list RBRACE WHILE LPAREN condition RPAREN SEMICOLON
     {
         $$ = create_do_while_node($7, $3);
-        printf("[PARSER] Do-While loop: do { <statements> } while (<condition>);\n");
+        log_message(LOG_VERBOSE, "[PARSER] Do-While loop: do { <statements> } while (<condition>);\n");
     }
     ;
 
@@ -295,12 +278,12 @@ if_stmt:
     IF LPAREN condition RPAREN LBRACE statement_list RBRACE
     {
         $$ = create_if_node($3, $6, NULL);
-        printf("[PARSER] If statement: if (<condition>) { <statements> }\n");
+        log_message(LOG_VERBOSE, "[PARSER] If statement: if (<condition>) { <statements> }\n");
     }
     | IF LPAREN condition RPAREN LBRACE statement_list RBRACE ELSE LBRACE statement_list RBRACE
     {
         $$ = create_if_node($3, $6, $10);
-        printf("[PARSER] If-else statement: if (<condition>) { <statements> } else { <statements> }\n");
+        log_message(LOG_VERBOSE, "[PARSER] If-else statement: if (<condition>) { <statements> } else { <statements> }\n");
     }
     ;
 
@@ -309,7 +292,7 @@ return_stmt:
     RETURN expression SEMICOLON
     {
         $$ = create_return_node($2);
-        printf("[PARSER] Return statement: return <expression>;\n");
+        log_message(LOG_VERBOSE, "[PARSER] Return statement: return <expression>;\n");
     }
     ;
 
@@ -318,12 +301,12 @@ function_declaration:
     INT ID LPAREN param_list RPAREN SEMICOLON
     {
         $$ = create_function_decl_node("int", $2, $4);
-        printf("[PARSER] Function declaration: int %s(...);\n", $2);
+        log_message(LOG_VERBOSE, "[PARSER] Function declaration: int %s(...);\n", $2);
     }
     | VOID ID LPAREN param_list RPAREN SEMICOLON
     {
         $$ = create_function_decl_node("void", $2, $4);
-        printf("[PARSER] Function declaration: void %s(...);\n", $2);
+        log_message(LOG_VERBOSE, "[PARSER] Function declaration: void %s(...);\n", $2);
     }
     ;
 
@@ -332,12 +315,12 @@ function_definition:
     INT ID LPAREN param_list RPAREN LBRACE statement_list RBRACE
     {
         $$ = create_function_def_node("int", $2, $4, $7);
-        printf("[PARSER] Function definition: int %s(...) { ... }\n", $2);
+        log_message(LOG_VERBOSE, "[PARSER] Function definition: int %s(...) { ... }\n", $2);
     }
     | VOID ID LPAREN param_list RPAREN LBRACE statement_list RBRACE
     {
         $$ = create_function_def_node("void", $2, $4, $7);
-        printf("[PARSER] Function definition: void %s(...) { ... }\n", $2);
+        log_message(LOG_VERBOSE, "[PARSER] Function definition: void %s(...) { ... }\n", $2);
     }
     ;
 
@@ -370,7 +353,7 @@ param:
     INT ID
     {
         $$ = create_param_node("int", $2);
-        printf("[PARSER] Parameter: int %s\n", $2);
+        log_message(LOG_VERBOSE, "[PARSER] Parameter: int %s\n", $2);
     }
     ;
 
@@ -379,7 +362,7 @@ condition:
     expression RELOP expression
     {
         $$ = create_condition_node($1, $2, $3);
-        printf("[PARSER] Condition: <expr> %s <expr>\n", $2);
+        log_message(LOG_VERBOSE, "[PARSER] Condition: <expr> %s <expr>\n", $2);
     }
     ;
 
@@ -388,12 +371,12 @@ expression:
     expression PLUS term
     {
         $$ = create_binary_op_node("+", $1, $3);
-        printf("[PARSER] Binary operation: <expr> + <term>\n");
+        log_message(LOG_VERBOSE, "[PARSER] Binary operation: <expr> + <term>\n");
     }
     | expression MINUS term
     {
         $$ = create_binary_op_node("-", $1, $3);
-        printf("[PARSER] Binary operation: <expr> - <term>\n");
+        log_message(LOG_VERBOSE, "[PARSER] Binary operation: <expr> - <term>\n");
     }
     | term
     {
@@ -406,17 +389,17 @@ term:
     term MULT factor
     {
         $$ = create_binary_op_node("*", $1, $3);
-        printf("[PARSER] Binary operation: <term> * <factor>\n");
+        log_message(LOG_VERBOSE, "[PARSER] Binary operation: <term> * <factor>\n");
     }
     | term DIV factor
     {
         $$ = create_binary_op_node("/", $1, $3);
-        printf("[PARSER] Binary operation: <term> / <factor>\n");
+        log_message(LOG_VERBOSE, "[PARSER] Binary operation: <term> / <factor>\n");
     }
     | term MOD factor
     {
-        $$ = create_binary_op_node("%%", $1, $3);
-        printf("[PARSER] Binary operation: <term> %% <factor>\n");
+        $$ = create_binary_op_node("%", $1, $3);
+        log_message(LOG_VERBOSE, "[PARSER] Binary operation: <term> %% <factor>\n");
     }
     | factor
     {
@@ -429,17 +412,17 @@ factor:
     ID
     {
         $$ = create_id_node($1);
-        printf("[PARSER] Identifier: %s\n", $1);
+        log_message(LOG_VERBOSE, "[PARSER] Identifier: %s\n", $1);
     }
     | NUM
     {
         $$ = create_num_node($1);
-        printf("[PARSER] Number: %d\n", $1);
+        log_message(LOG_VERBOSE, "[PARSER] Number: %d\n", $1);
     }
     | ID LBRACKET expression RBRACKET
     {
         $$ = create_array_access_node($1, $3);
-        printf("[PARSER] Array Access: %s[<index>]\n", $1);
+        log_message(LOG_VERBOSE, "[PARSER] Array Access: %s[<index>]\n", $1);
     }
     | function_call
     {
@@ -448,7 +431,7 @@ factor:
     | LPAREN expression RPAREN
     {
         $$ = $2;
-        printf("[PARSER] Parenthesized expression\n");
+        log_message(LOG_VERBOSE, "[PARSER] Parenthesized expression\n");
     }
     ;
 
@@ -457,7 +440,7 @@ function_call:
     ID LPAREN arg_list RPAREN
     {
         $$ = create_function_call_node($1, $3);
-        printf("[PARSER] Function call: %s(...)\n", $1);
+        log_message(LOG_VERBOSE, "[PARSER] Function call: %s(...)\n", $1);
     }
     ;
 
@@ -490,12 +473,12 @@ arg_list_non_empty:
 /* ERROR HANDLING */
 
 /* Called when a syntax error is detected */
-void yyerror(const char* s) {
+void yyerror(void* scanner, CompilerContext* ctx, const char* s) {
     fprintf(stderr, "\n=============================================================\n");
     fprintf(stderr, "|| SYNTAX ERROR                                           ||\n");
     fprintf(stderr, "=============================================================\n");
-    fprintf(stderr, "|| Location: Line %d, Column %d                           ||\n", line_num, col_num);
+    fprintf(stderr, "|| Location: Line %d, Column %d                           ||\n", ctx->line_num, ctx->col_num);
     fprintf(stderr, "|| Message:  %s                                           ||\n", s);
     fprintf(stderr, "=============================================================\n\n");
-    syntax_errors++;
+    ctx->syntax_errors++;
 }
@@ -0,0 +1,344 @@
+/*
+ * PROFILE.C - Profile-Guided Optimization Implementation
+ * CST-405 Compiler Project
+ *
+ * Counter placement (the same walk for instrumenting and for reading a
+ * profile back, so counter n always means the same place):
+ *   - after a function label or a run of labels: the block's count;
+ *   - after a jump or return followed by an unlabeled instruction: the
+ *     count of the block that starts there;
+ *   - after a conditional jump followed by a label (or by nothing): the
+ *     count of its fall-through edge.
+ * The counter right after a conditional jump therefore always counts its
+ * fall-through, and the times it was taken are the block's count minus
+ * that.
+ */
+
+#include "profile.h"
+#include "diagnostics.h"
+#include <string.h>
+
+/* Helper: FNV-1a of an operand (a missing one hashes like a separator).
+ * Temporaries and labels are numbered from the unit's base, so a function
+ * keeps its checksum when the code before it changes. */
+static unsigned hash_operand(unsigned hash, const char* text, const TACUnit* unit) {
+    char renumbered[32];
+    if (text && (text[0] == 't' || text[0] == 'L') && text[1] >= '0' && text[1] <= '9' &&
+        strspn(text + 1, "0123456789") == strlen(text + 1)) {
+        long base = text[0] == 't' ? unit->temp_base : unit->label_base;
+        snprintf(renumbered, sizeof(renumbered), "%c%ld", text[0], strtol(text + 1, NULL, 10) - base);
+        text = renumbered;
+    }
+    for (; text && *text; text++) {
+        hash = (hash ^ (unsigned char)*text) * 16777619u;
+    }
+    return (hash ^ 0xFFu) * 16777619u;
+}
+
+/* Helper: checksum of a function unit's instructions */
+static unsigned function_checksum(const TACUnit* unit) {
+    unsigned hash = 2166136261u;
+    for (TACInstruction* inst = unit->first; inst; inst = inst->next) {
+        hash = (hash ^ (unsigned)inst->opcode) * 16777619u;
+        hash = hash_operand(hash, inst->result, unit);
+        hash = hash_operand(hash, inst->op1, unit);
+        hash = hash_operand(hash, inst->op2, unit);
+        hash = hash_operand(hash, inst->label, unit);
+        if (inst == unit->last) break;
+    }
+    return hash;
+}
+
+static int is_conditional(const TACInstruction* inst) {
+    return inst->opcode == TAC_IF_FALSE || inst->opcode == TAC_IF_TRUE;
+}
+
+/* Helper: does control leave the block after this instruction? */
+static int ends_block(const TACInstruction* inst) {
+    return inst->opcode == TAC_GOTO || is_conditional(inst) ||
+           inst->opcode == TAC_RETURN || inst->opcode == TAC_RETURN_VOID;
+}
+
+/* Helper: add counter number after an instruction of unit */
+static void add_counter(TACCode* tac, TACUnit* unit, TACInstruction* after, int number) {
+    char text[16];
+    snprintf(text, sizeof(text), "%d", number);
+    insert_tac(tac, after, create_tac_instruction(TAC_PROFILE, NULL, text, NULL, NULL));
+    if (unit->last == after) unit->last = after->next;
+}
+
+/* Helper: put counters numbered from counter into one function unit;
+ * returns the next free number */
+static int instrument_function(TACCode* tac, TACUnit* unit, int counter) {
+    TACInstruction* stop = unit->last;
+    TACInstruction* inst = unit->first;
+    for (;;) {
+        TACInstruction* following = inst == stop ? NULL : inst->next;
+        int label = inst->opcode == TAC_LABEL || inst->opcode == TAC_FUNCTION_LABEL;
+        int label_follows = following && following->opcode == TAC_LABEL;
+
+        if (label ? !label_follows
+                  : ends_block(inst) && ((following && !label_follows) || is_conditional(inst))) {
+            add_counter(tac, unit, inst, counter++);
+        }
+        if (!following) break;
+        inst = following;
+    }
+    return counter;
+}
+
+/* Helper: remove the counters of one function unit again */
+static void remove_counters(TACCode* tac, TACUnit* unit) {
+    TACInstruction* inst = unit->first;
+    while (inst) {
+        TACInstruction* next = inst == unit->last ? NULL : inst->next;
+        if (inst->opcode == TAC_PROFILE) {
+            if (inst == unit->last) unit->last = inst->prev;
+            remove_tac(tac, inst);
+            free_tac_instruction(inst);
+        }
+        inst = next;
+    }
+}
+
+/* Helper: an empty profile */
+static Profile* create_profile(const char* path) {
+    Profile* profile = (Profile*)safe_calloc(1, sizeof(Profile), "profile");
+    profile->path = safe_strdup(path, "profile path");
+    return profile;
+}
+
+/* Helper: append a function record */
+static ProfileFunction* add_function(Profile* profile, const char* name) {
+    if (profile->function_count == profile->function_capacity) {
+        profile->function_capacity = profile->function_capacity ? profile->function_capacity * 2 : 16;
+        profile->functions = (ProfileFunction*)safe_realloc(profile->functions,
+                                                            profile->function_capacity * sizeof(ProfileFunction),
+                                                            "profile functions");
+    }
+    ProfileFunction* function = &profile->functions[profile->function_count++];
+    function->name = safe_strdup(name, "profile function");
+    function->checksum = 0;
+    function->first = 0;
+    function->count = 0;
+    return function;
+}
+
+/* Add counters to every function */
+Profile* instrument_tac(TACCode* tac, const char* path) {
+    Profile* profile = create_profile(path);
+
+    for (int u = 0; u < tac->unit_count; u++) {
+        TACUnit* unit = &tac->units[u];
+        if (!unit->first || unit->first->opcode != TAC_FUNCTION_LABEL) continue;
+
+        ProfileFunction* function = add_function(profile, unit->first->label);
+        function->checksum = function_checksum(unit);
+        function->first = profile->counter_count;
+        profile->counter_count = instrument_function(tac, unit, profile->counter_count);
+        function->count = profile->counter_count - function->first;
+    }
+
+    /* The header the program writes before its counts */
+    OutputSink* header = create_buffer_sink();
+    sink_printf(header, "# CST-405 profile\n");
+    sink_printf(header, "profile %d %d %d\n", PROFILE_VERSION, profile->function_count, profile->counter_count);
+    for (int f = 0; f < profile->function_count; f++) {
+        const ProfileFunction* function = &profile->functions[f];
+        sink_printf(header, "function %08x %d %d %s\n", function->checksum, function->first,
+                    function->count, function->name);
+    }
+    sink_printf(header, "counts\n");
+    profile->header = take_sink_text(header, NULL);
+    close_sink(header);
+
+    log_message(LOG_NORMAL, "[PROFILE] %d counters in %d functions; the program writes them to %s\n\n",
+                profile->counter_count, profile->function_count, profile->path);
+    return profile;
+}
+
+/* Write a profile file */
+int write_profile(const Profile* profile, const long long* counts, int count) {
+    FILE* file = fopen(profile->path, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot write profile '%s'\n", profile->path);
+        return 1;
+    }
+
+    fputs(profile->header, file);
+    for (int c = 0; c < profile->counter_count; c++) {
+        fprintf(file, "%lld\n", c < count ? counts[c] : 0);
+    }
+    int status = fclose(file) == 0 ? 0 : 1;
+    if (status == 0) {
+        log_message(LOG_NORMAL, "[PROFILE] Wrote %d counters to %s\n\n", profile->counter_count, profile->path);
+    }
+    return status;
+}
+
+/* Read a profile file */
+Profile* read_profile(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Warning: Cannot open profile '%s' - compiling without it\n", path);
+        return NULL;
+    }
+
+    Profile* profile = create_profile(path);
+    char line[1024];
+    int version = 0, functions = 0, counters = 0;
+    int ok = 0;
+
+    /* Comment lines, then "profile <version> <functions> <counters>" */
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        ok = sscanf(line, "profile %d %d %d", &version, &functions, &counters) == 3 &&
+             version == PROFILE_VERSION && functions >= 0 && counters >= 0;
+        break;
+    }
+
+    for (int f = 0; ok && f < functions; f++) {
+        unsigned checksum;
+        int first, count;
+        char name[512];
+        ok = fgets(line, sizeof(line), file) &&
+             sscanf(line, "function %x %d %d %511s", &checksum, &first, &count, name) == 4 &&
+             first >= 0 && count >= 0 && first + count <= counters;
+        if (ok) {
+            ProfileFunction* function = add_function(profile, name);
+            function->checksum = checksum;
+            function->first = first;
+            function->count = count;
+        }
+    }
+
+    ok = ok && fgets(line, sizeof(line), file) && strncmp(line, "counts", 6) == 0;
+    if (ok) {
+        profile->counter_count = counters;
+        profile->counts = (long long*)safe_calloc(counters ? counters : 1, sizeof(long long), "profile counts");
+        for (int c = 0; ok && c < counters; c++) {
+            ok = fscanf(file, "%lld", &profile->counts[c]) == 1 && profile->counts[c] >= 0;
+        }
+    }
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "Warning: '%s' is not a valid profile - compiling without it\n", path);
+        free_profile(profile);
+        return NULL;
+    }
+    return profile;
+}
+
+/* Helper: the profile's record for the index-th function called name
+ * (profiles list functions in program order, so index is tried first) */
+static const ProfileFunction* find_function(const Profile* profile, int index, const char* name) {
+    if (index < profile->function_count && strcmp(profile->functions[index].name, name) == 0) {
+        return &profile->functions[index];
+    }
+    for (int f = 0; f < profile->function_count; f++) {
+        if (strcmp(profile->functions[f].name, name) == 0) return &profile->functions[f];
+    }
+    return NULL;
+}
+
+/* Helper: copy counts onto an instrumented function's instructions */
+static void annotate_function(TACUnit* unit, const long long* counts) {
+    TACInstruction* pending = NULL;      /* Conditional jump waiting for its fall-through count */
+    long long current = 0;
+    int known = 0;
+    int counter = 0;
+
+    for (TACInstruction* inst = unit->first; inst; inst = inst->next) {
+        if (inst->opcode == TAC_PROFILE) {
+            long long value = counts[counter++];
+            if (pending) {
+                pending->taken = pending->count > value ? pending->count - value : 0;
+                pending = NULL;
+            }
+
+            /* A block counter: the labels in front of it belong to the block */
+            if (inst == unit->last || inst->next->opcode != TAC_LABEL) {
+                current = value;
+                known = 1;
+                for (TACInstruction* label = inst->prev; label; label = label->prev) {
+                    if (label->opcode != TAC_LABEL && label->opcode != TAC_FUNCTION_LABEL) break;
+                    label->count = value;
+                    label->flags |= TAC_FLAG_COUNTED;
+                    if (label->opcode == TAC_FUNCTION_LABEL) break;
+                }
+            }
+        } else {
+            pending = NULL;
+            if (known) {
+                inst->count = current;
+                inst->flags |= TAC_FLAG_COUNTED;
+            }
+            if (is_conditional(inst)) pending = inst;
+        }
+        if (inst == unit->last) break;
+    }
+}
+
+/* Annotate TAC with the counts of a profile */
+int apply_profile(TACCode* tac, const Profile* profile) {
+    int matched = 0, functions = 0;
+    long long hottest = -1;
+    const char* hottest_name = NULL;
+
+    for (int u = 0; u < tac->unit_count; u++) {
+        TACUnit* unit = &tac->units[u];
+        if (!unit->first || unit->first->opcode != TAC_FUNCTION_LABEL) continue;
+
+        const char* name = unit->first->label;
+        unsigned checksum = function_checksum(unit);
+        int count = instrument_function(tac, unit, 0);
+        const ProfileFunction* function = find_function(profile, functions++, name);
+
+        if (!function) {
+            log_message(LOG_VERBOSE, "[PROFILE] No profile for function '%s'\n", name);
+        } else if (function->checksum != checksum || function->count != count) {
+            fprintf(stderr, "Warning: Profile for function '%s' is out of date - ignored\n", name);
+        } else {
+            annotate_function(unit, profile->counts + function->first);
+            matched++;
+            if (unit->first->count > hottest) {
+                hottest = unit->first->count;
+                hottest_name = name;
+            }
+            log_message(LOG_VERBOSE, "[PROFILE] Function '%s' ran %lld times\n", name, unit->first->count);
+        }
+        remove_counters(tac, unit);
+    }
+
+    log_message(LOG_NORMAL, "[PROFILE] Read %s: %d of %d functions matched", profile->path, matched, functions);
+    if (hottest_name) {
+        log_message(LOG_NORMAL, " (most calls: %s, %lld)", hottest_name, hottest);
+    }
+    log_message(LOG_NORMAL, "\n\n");
+    return matched;
+}
+
+/* Default profile file of a source file */
+void default_profile_path(char* path, size_t size, const char* source) {
+    const char* base = source;
+    for (const char* p = source; *p; p++) {
+        if (*p == '/' || *p == '\\') base = p + 1;
+    }
+    const char* dot = strrchr(base, '.');
+    int length = dot && dot != base ? (int)(dot - source) : (int)strlen(source);
+    snprintf(path, size, "%.*s%s", length, source, DEFAULT_PROFILE_SUFFIX);
+}
+
+/* Free a profile */
+void free_profile(Profile* profile) {
+    if (!profile) return;
+    for (int f = 0; f < profile->function_count; f++) {
+        free(profile->functions[f].name);
+    }
+    free(profile->functions);
+    free(profile->counts);
+    free(profile->path);
+    free(profile->header);
+    free(profile);
+}
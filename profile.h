@@ -0,0 +1,82 @@
+/*
+ * PROFILE.H - Profile-Guided Optimization Header
+ * CST-405 Compiler Project
+ *
+ * --profile-generate puts a counter at the start of every basic block of
+ * the unoptimized TAC (TAC_PROFILE), and one after every conditional jump
+ * whose fall-through successor can also be reached another way, so both
+ * block and edge counts are known. The instrumented program writes the
+ * counters to a profile file when it exits: the interpreter and --run do
+ * it in the compiler, a linked program from an atexit handler the code
+ * generator adds to main.
+ *
+ * --profile-use instruments the fresh TAC the same way, reads the counts
+ * back onto the instructions (TACInstruction.count, .taken and
+ * TAC_FLAG_COUNTED) and removes the counters again; block layout then
+ * uses measured frequencies in place of its static estimates. A function
+ * whose code changed since the profile was written (its checksum differs)
+ * is compiled without profile data.
+ *
+ * Profile file (text):
+ *   # CST-405 profile
+ *   profile 1 <functions> <counters>
+ *   function <checksum> <first counter> <counters> <name>   (one per function)
+ *   counts
+ *   <count>                                                  (one per counter)
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ircode.h"
+
+#define PROFILE_VERSION 1
+#define DEFAULT_PROFILE_SUFFIX ".profile"
+
+/* Counters of one function */
+typedef struct {
+    char* name;                   /* Function name */
+    unsigned checksum;            /* Hash of its unoptimized TAC */
+    int first;                    /* First counter */
+    int count;                    /* Number of counters */
+} ProfileFunction;
+
+/* Counter layout of a program, and the counts once they are read */
+typedef struct {
+    ProfileFunction* functions;   /* Functions in program order */
+    int function_count;
+    int function_capacity;
+    int counter_count;            /* Counters in the program */
+    long long* counts;            /* Counter values (read profiles; NULL otherwise) */
+    char* path;                   /* Profile file */
+    char* header;                 /* Text written before the counts */
+} Profile;
+
+/* PROFILING FUNCTIONS */
+
+/* Add counters to the functions of unoptimized TAC; the program will
+ * write them to path. Returns the counter layout. */
+Profile* instrument_tac(TACCode* tac, const char* path);
+
+/* Write a profile file with count counter values (missing ones are 0;
+ * the interpreter does this after the program ran). Returns 0 on success. */
+int write_profile(const Profile* profile, const long long* counts, int count);
+
+/* Read a profile file. Returns NULL (after reporting why) if it cannot
+ * be read. */
+Profile* read_profile(const char* path);
+
+/* Annotate unoptimized TAC with the counts of a profile read from the
+ * same program. Returns the number of functions that matched. */
+int apply_profile(TACCode* tac, const Profile* profile);
+
+/* Default profile file of a source file: the path without its extension
+ * plus DEFAULT_PROFILE_SUFFIX */
+void default_profile_path(char* path, size_t size, const char* source);
+
+/* Free a profile */
+void free_profile(Profile* profile);
+
+#endif /* PROFILE_H */
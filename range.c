@@ -0,0 +1,804 @@
+/*
+ * RANGE.C - Value Range Analysis Implementation
+ * CST-405 Compiler Project
+ *
+ * One region (function) at a time. Each reachable block gets the ranges
+ * of the variables live on its entry; walking the block's instructions
+ * turns them into the ranges passed along each outgoing edge, narrowed by
+ * the test of a conditional jump. The entry ranges of a block are the
+ * join of its incoming edges.
+ *
+ * 1. Ascending: a block is visited again whenever an incoming edge
+ *    changed, the first such block in reverse postorder next (so each
+ *    loop settles before the code behind it), until nothing changes. At
+ *    loop headers (targets of retreating edges) a bound that moves jumps
+ *    to the next threshold - a constant the region compares with or
+ *    checks against, plus or minus one - or to no bound, so every loop
+ *    settles after a few visits.
+ * 2. Narrowing: two more sweeps recompute every block from its incoming
+ *    edges without widening, which takes back what widening overshot
+ *    (a counter widened to [0, 100] by "i < 100" comes back to [0, 99]).
+ *    A region where no header was widened skips them.
+ * 3. The visitor is called during a final sweep over the blocks in list
+ *    order.
+ *
+ * Temporaries are kept in the block walk like variables, but only the
+ * live ones cross block boundaries, so the stored sets stay small.
+ */
+
+#include "range.h"
+#include "diagnostics.h"
+#include <string.h>
+
+#define THRESHOLD_SEARCH 8            /* Instructions searched back for a compared constant */
+#define WIDEN_LIMIT      8            /* Widenings of a header before its bounds are dropped */
+#define VISIT_LIMIT      64           /* Ascending visits per block before a region is given up */
+#define NARROW_SWEEPS    2
+#define FACT_LIMIT       8            /* Variables one jump test can narrow */
+
+/* Variable numbers of what an instruction defines and reads (-1 for
+ * none, literals and names the region does not use as scalars) */
+typedef struct {
+    int def;
+    int op1;
+    int op2;
+} OperandVars;
+
+/* Ranges known at the entry of a block and along its outgoing edges */
+typedef struct {
+    OperandVars* operands;            /* Per instruction of the block, in list order */
+    int* vars;                        /* Variables live on entry (region numbering) */
+    ValueRange* values;               /* Their ranges on entry */
+    int var_count;
+    int reached;                      /* Some feasible path reaches the block */
+    int header;                       /* Target of a retreating edge (widens) */
+    int widened;                      /* Times widened so far */
+    int pending;                      /* An incoming edge changed */
+    ValueRange* edge[2];              /* Ranges along succ[k], in the successor's vars order */
+    int feasible[2];                  /* succ[k] can be taken */
+} BlockRanges;
+
+/* target = source, assigned at clock at (block-local) */
+typedef struct {
+    int target;
+    int source;
+    int at;
+} Copy;
+
+/* Analysis state for one region */
+typedef struct {
+    FlowGraph* graph;
+    FlowRegion* region;
+    int first;                        /* First block of the region */
+    int count;                        /* Blocks in the region */
+    BlockRanges* blocks;              /* Indexed by block - first */
+    int* order;                       /* Reachable blocks in reverse postorder */
+    int order_count;
+    OperandVars* operands;            /* Storage for the blocks' operand numbers */
+    long long* thresholds;            /* Widening targets (ascending) */
+    int threshold_count;
+    char* temporary;                  /* Per variable: is it a temporary? */
+
+    /* Block walk: value[v] holds while set_at[v] >= block_start */
+    ValueRange* value;
+    int* set_at;                      /* Clock of the last assignment (block_start = on entry) */
+    int clock;
+    int block_start;
+    int last_call;                    /* Clock of the last call in the block (0 = none) */
+    TACInstruction* relop;            /* Last comparison of the block */
+    OperandVars relop_vars;
+    int relop_at;
+    Copy* copies;
+    int copy_count;
+    int copy_capacity;
+    ValueRange* scratch;              /* Edge ranges being built */
+    int scratch_size;
+} RangeState;
+
+/* ---------------------------------------------------------------------------
+ * Ranges
+ * ------------------------------------------------------------------------- */
+
+static ValueRange make_range(long long lo, long long hi) {
+    ValueRange range;
+    range.lo = lo <= -RANGE_LIMIT ? -RANGE_LIMIT : lo;
+    range.hi = hi >= RANGE_LIMIT ? RANGE_LIMIT : hi;
+    return range;
+}
+
+static ValueRange unbounded(void) {
+    return make_range(-RANGE_LIMIT, RANGE_LIMIT);
+}
+
+static int is_empty(ValueRange range) {
+    return range.lo > range.hi;
+}
+
+static int same_range(ValueRange a, ValueRange b) {
+    return a.lo == b.lo && a.hi == b.hi;
+}
+
+static ValueRange intersect(ValueRange a, ValueRange b) {
+    return make_range(a.lo > b.lo ? a.lo : b.lo, a.hi < b.hi ? a.hi : b.hi);
+}
+
+static ValueRange join(ValueRange a, ValueRange b) {
+    if (is_empty(a)) return b;
+    if (is_empty(b)) return a;
+    return make_range(a.lo < b.lo ? a.lo : b.lo, a.hi > b.hi ? a.hi : b.hi);
+}
+
+/* Helper: range of exact results lo..hi - unbounded unless it stays
+ * inside the limits, where no target wraps */
+static ValueRange exact_range(long long lo, long long hi) {
+    if (lo <= -RANGE_LIMIT || hi >= RANGE_LIMIT) return unbounded();
+    return make_range(lo, hi);
+}
+
+/* Helper: range of a + b, a - b or a * b */
+static ValueRange arithmetic(TACOpcode opcode, ValueRange a, ValueRange b) {
+    if (is_empty(a) || is_empty(b)) return make_range(1, 0);
+    if (!RANGE_BOUNDED(a) || !RANGE_BOUNDED(b)) return unbounded();
+    if (opcode == TAC_ADD) return exact_range(a.lo + b.lo, a.hi + b.hi);
+    if (opcode == TAC_SUB) return exact_range(a.lo - b.hi, a.hi - b.lo);
+
+    /* Bounded values are below 2^31, so the products fit */
+    long long corners[4] = { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+    long long lo = corners[0], hi = corners[0];
+    for (int i = 1; i < 4; i++) {
+        if (corners[i] < lo) lo = corners[i];
+        if (corners[i] > hi) hi = corners[i];
+    }
+    return exact_range(lo, hi);
+}
+
+/* Helper: range of a / b (C division, rounding toward zero) */
+static ValueRange quotient(ValueRange a, ValueRange b) {
+    if (!RANGE_BOUNDED(a) || !RANGE_BOUNDED(b)) return unbounded();
+
+    /* The negative and the positive divisors (zero traps) */
+    ValueRange parts[2] = { make_range(b.lo, b.hi < -1 ? b.hi : -1), make_range(b.lo > 1 ? b.lo : 1, b.hi) };
+    ValueRange result = make_range(1, 0);
+    for (int p = 0; p < 2; p++) {
+        if (is_empty(parts[p])) continue;
+        long long corners[4] = { a.lo / parts[p].lo, a.lo / parts[p].hi, a.hi / parts[p].lo, a.hi / parts[p].hi };
+        for (int i = 0; i < 4; i++) result = join(result, make_range(corners[i], corners[i]));
+    }
+    return is_empty(result) ? unbounded() : result;
+}
+
+/* Helper: range of a % b (the sign of a, smaller than b in magnitude) */
+static ValueRange remainder_range(ValueRange a, ValueRange b) {
+    long long limit = RANGE_LIMIT;
+    if (RANGE_BOUNDED(b)) {
+        long long magnitude = b.lo < 0 ? -b.lo : b.lo;
+        if ((b.hi < 0 ? -b.hi : b.hi) > magnitude) magnitude = b.hi < 0 ? -b.hi : b.hi;
+        if (magnitude == 0) return unbounded();
+        limit = magnitude - 1;
+    }
+    if (a.lo >= 0) return make_range(0, a.hi < limit ? a.hi : limit);
+    if (a.hi <= 0) return make_range(a.lo > -limit ? a.lo : -limit, 0);
+    if (limit >= RANGE_LIMIT) return unbounded();
+    return make_range(a.lo > -limit ? a.lo : -limit, a.hi < limit ? a.hi : limit);
+}
+
+/* Helper: one less / one more than a bound (no bound stays no bound) */
+static long long below(long long bound) {
+    return bound >= RANGE_LIMIT || bound <= -RANGE_LIMIT ? bound : bound - 1;
+}
+
+static long long above(long long bound) {
+    return bound >= RANGE_LIMIT || bound <= -RANGE_LIMIT ? bound : bound + 1;
+}
+
+/* Helper: the comparison that holds when op does not */
+static const char* negate_relation(const char* op) {
+    if (strcmp(op, "<") == 0) return ">=";
+    if (strcmp(op, "<=") == 0) return ">";
+    if (strcmp(op, ">") == 0) return "<=";
+    if (strcmp(op, ">=") == 0) return "<";
+    if (strcmp(op, "==") == 0) return "!=";
+    if (strcmp(op, "!=") == 0) return "==";
+    return NULL;
+}
+
+/* Helper: narrow a and b to the values for which "a op b" holds */
+static void refine_relation(const char* op, ValueRange* a, ValueRange* b) {
+    if (strcmp(op, ">") == 0 || strcmp(op, ">=") == 0) {
+        refine_relation(op[1] ? "<=" : "<", b, a);
+        return;
+    }
+    if (strcmp(op, "<") == 0) {
+        *a = intersect(*a, make_range(-RANGE_LIMIT, below(b->hi)));
+        *b = intersect(*b, make_range(above(a->lo), RANGE_LIMIT));
+    } else if (strcmp(op, "<=") == 0) {
+        *a = intersect(*a, make_range(-RANGE_LIMIT, b->hi));
+        *b = intersect(*b, make_range(a->lo, RANGE_LIMIT));
+    } else if (strcmp(op, "==") == 0) {
+        *a = intersect(*a, *b);
+        *b = *a;
+    } else if (strcmp(op, "!=") == 0) {
+        if (b->lo == b->hi) {
+            if (a->lo == b->lo) a->lo++;
+            if (a->hi == b->lo) a->hi--;
+        }
+        if (a->lo == a->hi) {
+            if (b->lo == a->lo) b->lo++;
+            if (b->hi == a->lo) b->hi--;
+        }
+    }
+}
+
+/* Helper: range of the 0/1 result of "a op b" */
+static ValueRange comparison(const char* op, ValueRange a, ValueRange b) {
+    if (!op || is_empty(a) || is_empty(b)) return make_range(0, 1);
+    ValueRange x = a, y = b;
+    refine_relation(op, &x, &y);
+    if (is_empty(x) || is_empty(y)) return make_range(0, 0);
+    const char* negated = negate_relation(op);
+    if (!negated) return make_range(0, 1);
+    x = a;
+    y = b;
+    refine_relation(negated, &x, &y);
+    if (is_empty(x) || is_empty(y)) return make_range(1, 1);
+    return make_range(0, 1);
+}
+
+/* ---------------------------------------------------------------------------
+ * Block walk
+ * ------------------------------------------------------------------------- */
+
+/* Helper: number of a variable in the region (-1 for literals and names
+ * the region does not use as scalars) */
+static int variable(RangeState* state, const char* name) {
+    if (!name || is_literal(name)) return -1;
+    return live_variable_index(state->graph, state->first, name);
+}
+
+static ValueRange variable_range(RangeState* state, int v) {
+    if (v < 0 || state->set_at[v] < state->block_start) return unbounded();
+    if (!state->temporary[v] && state->last_call > state->set_at[v]) return unbounded();
+    return state->value[v];
+}
+
+static void set_variable(RangeState* state, int v, ValueRange range) {
+    if (v < 0) return;
+    state->value[v] = range;
+    state->set_at[v] = ++state->clock;
+}
+
+/* Helper: range of an operand (variable number v) at the current point
+ * of the walk */
+static ValueRange operand_range(RangeState* state, const char* name, int v) {
+    if (v >= 0) return variable_range(state, v);
+    if (name && is_literal(name)) {
+        long long value = strtoll(name, NULL, 10);
+        return make_range(value, value);
+    }
+    return unbounded();
+}
+
+/* Helper: range of the value an instruction assigns */
+static ValueRange evaluate(RangeState* state, TACInstruction* inst, const OperandVars* vars) {
+    switch (inst->opcode) {
+        case TAC_LOAD_CONST:
+        case TAC_ASSIGN:
+            return operand_range(state, inst->op1, vars->op1);
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+            return arithmetic(inst->opcode, operand_range(state, inst->op1, vars->op1),
+                              operand_range(state, inst->op2, vars->op2));
+        case TAC_DIV:
+            return quotient(operand_range(state, inst->op1, vars->op1),
+                            operand_range(state, inst->op2, vars->op2));
+        case TAC_MOD:
+            return remainder_range(operand_range(state, inst->op1, vars->op1),
+                                   operand_range(state, inst->op2, vars->op2));
+        case TAC_RELOP:
+            return comparison(inst->label, operand_range(state, inst->op1, vars->op1),
+                              operand_range(state, inst->op2, vars->op2));
+        default:
+            return unbounded();      /* Array elements and call results */
+    }
+}
+
+/* Helper: apply one instruction to the ranges of the walk */
+static void step(RangeState* state, TACInstruction* inst, const OperandVars* vars) {
+    if (inst->opcode == TAC_CALL) {
+        state->last_call = ++state->clock;
+    } else if (inst->opcode == TAC_BOUNDS_CHECK && is_literal(inst->op2)) {
+        /* Execution only goes on with the index inside the array */
+        int v = vars->op1;
+        ValueRange inside = intersect(variable_range(state, v), make_range(0, strtoll(inst->op2, NULL, 10) - 1));
+        if (v >= 0 && !is_empty(inside)) set_variable(state, v, inside);
+    }
+
+    if (!tac_def(inst)) return;
+    int v = vars->def;
+    set_variable(state, v, evaluate(state, inst, vars));
+
+    if (inst->opcode == TAC_RELOP) {
+        state->relop = inst;
+        state->relop_vars = *vars;
+        state->relop_at = state->clock;
+    } else if (inst->opcode == TAC_ASSIGN) {
+        int source = vars->op1;
+        if (v < 0 || source < 0 || source == v) return;
+        if (state->copy_count == state->copy_capacity) {
+            state->copy_capacity = state->copy_capacity ? state->copy_capacity * 2 : 16;
+            state->copies = (Copy*)safe_realloc(state->copies, state->copy_capacity * sizeof(Copy), "range copies");
+        }
+        Copy* copy = &state->copies[state->copy_count++];
+        copy->target = v;
+        copy->source = source;
+        copy->at = state->clock;
+    }
+}
+
+/* Helper: has v kept the value it had at clock at? */
+static int unchanged_since(RangeState* state, int v, int at) {
+    return state->set_at[v] <= at && state->set_at[v] >= state->block_start &&
+           (state->temporary[v] || state->last_call < at);
+}
+
+/* Helper: add "v lies in range" to a list of facts */
+static int add_fact(int* vars, ValueRange* ranges, int count, int v, ValueRange range) {
+    for (int i = 0; i < count; i++) {
+        if (vars[i] == v) {
+            ranges[i] = intersect(ranges[i], range);
+            return count;
+        }
+    }
+    if (count == FACT_LIMIT) return count;
+    vars[count] = v;
+    ranges[count] = range;
+    return count + 1;
+}
+
+/* Helper: what the end of the walk knows about the variables when the
+ * value of cond (variable number c) is non-zero (holds) or zero. Returns
+ * 0 if that cannot be. */
+static int condition_facts(RangeState* state, const char* cond, int c, int holds, int* vars,
+                           ValueRange* ranges, int* count) {
+    *count = 0;
+    if (!cond) return 1;
+    if (is_literal(cond)) return (strtoll(cond, NULL, 10) != 0) == holds;
+    if (c < 0) return 1;
+    ValueRange range = variable_range(state, c);
+    if (holds) {
+        if (range.lo == 0) range.lo = 1;
+        if (range.hi == 0) range.hi = -1;
+    } else {
+        range = intersect(range, make_range(0, 0));
+    }
+    if (is_empty(range)) return 0;
+    *count = add_fact(vars, ranges, *count, c, range);
+
+    /* The comparison that computed cond, if its operands still hold */
+    TACInstruction* relop = state->relop;
+    if (relop && relop->label && relop->result && strcmp(relop->result, cond) == 0 &&
+        state->set_at[c] == state->relop_at) {
+        const char* op = holds ? relop->label : negate_relation(relop->label);
+        int x = state->relop_vars.op1;
+        int y = state->relop_vars.op2;
+        if (op && (x < 0 || unchanged_since(state, x, state->relop_at)) &&
+            (y < 0 || unchanged_since(state, y, state->relop_at))) {
+            ValueRange a = operand_range(state, relop->op1, x);
+            ValueRange b = operand_range(state, relop->op2, y);
+            refine_relation(op, &a, &b);
+            if (is_empty(a) || is_empty(b)) return 0;
+            if (x >= 0) *count = add_fact(vars, ranges, *count, x, a);
+            if (y >= 0) *count = add_fact(vars, ranges, *count, y, b);
+        }
+    }
+
+    /* Copies still equal to a narrowed variable narrow the same way */
+    int direct = *count;
+    for (int i = 0; i < state->copy_count; i++) {
+        Copy* copy = &state->copies[i];
+        if (state->set_at[copy->target] != copy->at || !unchanged_since(state, copy->source, copy->at) ||
+            (!state->temporary[copy->target] && state->last_call > copy->at)) {
+            continue;
+        }
+        for (int f = 0; f < direct; f++) {
+            if (vars[f] == copy->source) {
+                *count = add_fact(vars, ranges, *count, copy->target,
+                                  intersect(variable_range(state, copy->target), ranges[f]));
+            } else if (vars[f] == copy->target) {
+                *count = add_fact(vars, ranges, *count, copy->source,
+                                  intersect(variable_range(state, copy->source), ranges[f]));
+            }
+        }
+    }
+    for (int f = 0; f < *count; f++) {
+        if (is_empty(ranges[f])) return 0;
+    }
+    return 1;
+}
+
+/* Helper: walk block b from its entry ranges (calling visit for each
+ * instruction when given) and update the ranges along its edges. Marks
+ * the successors whose incoming ranges changed and returns the lowest
+ * reverse postorder number among them (order_count if none). */
+static int walk_block(RangeState* state, int b, RangeVisitor visit, void* context) {
+    FlowGraph* graph = state->graph;
+    BasicBlock* block = &graph->blocks[b];
+    BlockRanges* info = &state->blocks[b - state->first];
+
+    state->block_start = ++state->clock;
+    state->last_call = 0;
+    state->relop = NULL;
+    state->copy_count = 0;
+    for (int i = 0; i < info->var_count; i++) {
+        state->value[info->vars[i]] = info->values[i];
+        state->set_at[info->vars[i]] = state->block_start;
+    }
+
+    OperandVars* vars = info->operands;
+    for (TACInstruction* inst = block->first;; inst = inst->next, vars++) {
+        if (visit) {
+            visit(context, inst, operand_range(state, inst->op1, vars->op1),
+                  operand_range(state, inst->op2, vars->op2));
+        }
+        step(state, inst, vars);
+        if (inst == block->last) break;
+    }
+
+    /* Ranges along each edge, narrowed by the test of a conditional jump */
+    TACInstruction* jump = block->last;
+    int conditional = (jump->opcode == TAC_IF_TRUE || jump->opcode == TAC_IF_FALSE) &&
+                      block->succ_count == 2 && block->succ[0] != block->succ[1];
+    int lowest = state->order_count;
+    for (int k = 0; k < block->succ_count; k++) {
+        BlockRanges* target = &state->blocks[block->succ[k] - state->first];
+        int fact_vars[FACT_LIMIT];
+        ValueRange facts[FACT_LIMIT];
+        int fact_count = 0;
+        int feasible = 1;
+        if (conditional) {
+            int holds = (jump->opcode == TAC_IF_TRUE) == (k == 1);
+            feasible = condition_facts(state, jump->op1, vars->op1, holds, fact_vars, facts, &fact_count);
+        }
+
+        ValueRange* ranges = state->scratch;
+        for (int i = 0; i < target->var_count && feasible; i++) {
+            int v = target->vars[i];
+            ranges[i] = variable_range(state, v);
+            for (int f = 0; f < fact_count; f++) {
+                if (fact_vars[f] == v) ranges[i] = intersect(ranges[i], facts[f]);
+            }
+            if (is_empty(ranges[i])) feasible = 0;
+        }
+
+        int changed = feasible != info->feasible[k];
+        for (int i = 0; i < target->var_count && feasible && !changed; i++) {
+            changed = !same_range(ranges[i], info->edge[k][i]);
+        }
+        if (!changed) continue;
+        info->feasible[k] = feasible;
+        if (feasible) memcpy(info->edge[k], ranges, target->var_count * sizeof(ValueRange));
+        target->pending = 1;
+        if (graph->blocks[block->succ[k]].rpo < lowest) lowest = graph->blocks[block->succ[k]].rpo;
+    }
+    return lowest;
+}
+
+/* ---------------------------------------------------------------------------
+ * Fixed point
+ * ------------------------------------------------------------------------- */
+
+/* Helper: join of the ranges along the feasible edges into b. Returns 0
+ * if no edge into b can be taken. */
+static int incoming_ranges(RangeState* state, int b, ValueRange* out) {
+    FlowGraph* graph = state->graph;
+    BlockRanges* info = &state->blocks[b - state->first];
+    int any = 0;
+    for (int i = 0; i < info->var_count; i++) out[i] = make_range(1, 0);
+
+    for (int p = 0; p < graph->blocks[b].pred_count; p++) {
+        int pred = graph->blocks[b].preds[p];
+        BlockRanges* from = &state->blocks[pred - state->first];
+        if (!from->reached) continue;
+        for (int k = 0; k < graph->blocks[pred].succ_count; k++) {
+            if (graph->blocks[pred].succ[k] != b || !from->feasible[k]) continue;
+            for (int i = 0; i < info->var_count; i++) out[i] = join(out[i], from->edge[k][i]);
+            any = 1;
+        }
+    }
+    return any;
+}
+
+/* Helper: widen a bound that moved to the nearest threshold past it */
+static ValueRange widen(RangeState* state, BlockRanges* info, ValueRange old, ValueRange range) {
+    range = join(old, range);
+    if (range.lo < old.lo) {
+        long long bound = -RANGE_LIMIT;
+        for (int i = state->threshold_count - 1; i >= 0 && info->widened < WIDEN_LIMIT; i--) {
+            if (state->thresholds[i] <= range.lo) {
+                bound = state->thresholds[i];
+                break;
+            }
+        }
+        range.lo = bound;
+    }
+    if (range.hi > old.hi) {
+        long long bound = RANGE_LIMIT;
+        for (int i = 0; i < state->threshold_count && info->widened < WIDEN_LIMIT; i++) {
+            if (state->thresholds[i] >= range.hi) {
+                bound = state->thresholds[i];
+                break;
+            }
+        }
+        range.hi = bound;
+    }
+    return range;
+}
+
+static void add_threshold(RangeState* state, int* capacity, long long value) {
+    for (long long v = value - 1; v <= value + 1; v++) {
+        if (v <= -RANGE_LIMIT || v >= RANGE_LIMIT) continue;
+        if (state->threshold_count == *capacity) {
+            *capacity = *capacity ? *capacity * 2 : 16;
+            state->thresholds = (long long*)safe_realloc(state->thresholds, *capacity * sizeof(long long),
+                                                         "range thresholds");
+        }
+        state->thresholds[state->threshold_count++] = v;
+    }
+}
+
+static int compare_values(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Helper: constant operand of a comparison - a literal, or a temporary
+ * loaded with one shortly before */
+static int compared_constant(TACInstruction* at, const char* name, long long* value) {
+    if (!name) return 0;
+    if (is_literal(name)) {
+        *value = strtoll(name, NULL, 10);
+        return 1;
+    }
+    TACInstruction* inst = at->prev;
+    for (int i = 0; inst && i < THRESHOLD_SEARCH; i++, inst = inst->prev) {
+        const char* def = tac_def(inst);
+        if (!def || strcmp(def, name) != 0) continue;
+        if (inst->opcode != TAC_LOAD_CONST || !is_literal(inst->op1)) return 0;
+        *value = strtoll(inst->op1, NULL, 10);
+        return 1;
+    }
+    return 0;
+}
+
+/* Helper: collect the widening thresholds of the region */
+static void find_thresholds(RangeState* state) {
+    int capacity = 0;
+    add_threshold(state, &capacity, 0);
+    for (int b = state->first; b < state->first + state->count; b++) {
+        for (TACInstruction* inst = state->graph->blocks[b].first;; inst = inst->next) {
+            long long value;
+            if (inst->opcode == TAC_RELOP) {
+                if (compared_constant(inst, inst->op1, &value)) add_threshold(state, &capacity, value);
+                if (compared_constant(inst, inst->op2, &value)) add_threshold(state, &capacity, value);
+            } else if (inst->opcode == TAC_BOUNDS_CHECK && is_literal(inst->op2)) {
+                add_threshold(state, &capacity, strtoll(inst->op2, NULL, 10));
+            }
+            if (inst == state->graph->blocks[b].last) break;
+        }
+    }
+    qsort(state->thresholds, state->threshold_count, sizeof(long long), compare_values);
+    int unique = 0;
+    for (int i = 0; i < state->threshold_count; i++) {
+        if (unique == 0 || state->thresholds[unique - 1] != state->thresholds[i]) {
+            state->thresholds[unique++] = state->thresholds[i];
+        }
+    }
+    state->threshold_count = unique;
+}
+
+/* Helper: set up the per-block records of the region */
+static void init_region(RangeState* state) {
+    FlowGraph* graph = state->graph;
+    FlowRegion* region = state->region;
+    int largest = 1;
+
+    state->blocks = (BlockRanges*)safe_calloc(state->count, sizeof(BlockRanges), "range blocks");
+    state->order = (int*)safe_malloc(state->count * sizeof(int), "range blocks");
+
+    /* Operand variable numbers, looked up once instead of on every walk */
+    int instructions = 0;
+    for (int b = state->first; b < state->first + state->count; b++) {
+        for (TACInstruction* inst = graph->blocks[b].first;; inst = inst->next) {
+            instructions++;
+            if (inst == graph->blocks[b].last) break;
+        }
+    }
+    state->operands = (OperandVars*)safe_malloc(instructions * sizeof(OperandVars), "range operands");
+    OperandVars* vars = state->operands;
+    for (int b = 0; b < state->count; b++) {
+        BasicBlock* block = &graph->blocks[state->first + b];
+        state->blocks[b].operands = vars;
+        for (TACInstruction* inst = block->first;; inst = inst->next) {
+            vars->def = variable(state, tac_def(inst));
+            vars->op1 = variable(state, inst->op1);
+            vars->op2 = variable(state, inst->op2);
+            vars++;
+            if (inst == block->last) break;
+        }
+    }
+    for (int b = 0; b < state->count; b++) {
+        BasicBlock* block = &graph->blocks[state->first + b];
+        BlockRanges* info = &state->blocks[b];
+        for (int w = 0; w < region->words; w++) {
+            for (unsigned bits = block->live_in[w]; bits; bits &= bits - 1) info->var_count++;
+        }
+        info->vars = (int*)safe_malloc((info->var_count + 1) * sizeof(int), "range variables");
+        info->values = (ValueRange*)safe_malloc((info->var_count + 1) * sizeof(ValueRange), "range values");
+        int n = 0;
+        for (int w = 0; w < region->words; w++) {
+            for (int bit = 0; bit < 32 && block->live_in[w]; bit++) {
+                if ((block->live_in[w] >> bit) & 1u) info->vars[n++] = w * 32 + bit;
+            }
+        }
+        if (info->var_count > largest) largest = info->var_count;
+        if (block->rpo >= 0) state->order[block->rpo] = state->first + b;
+        if (block->rpo >= 0) state->order_count++;
+    }
+
+    for (int b = 0; b < state->count; b++) {
+        BasicBlock* block = &graph->blocks[state->first + b];
+        BlockRanges* info = &state->blocks[b];
+        for (int k = 0; k < block->succ_count; k++) {
+            BlockRanges* target = &state->blocks[block->succ[k] - state->first];
+            info->edge[k] = (ValueRange*)safe_malloc((target->var_count + 1) * sizeof(ValueRange), "range edges");
+            if (block->rpo >= 0 && graph->blocks[block->succ[k]].rpo <= block->rpo) target->header = 1;
+        }
+    }
+
+    state->value = (ValueRange*)safe_malloc((region->var_count + 1) * sizeof(ValueRange), "range values");
+    state->set_at = (int*)safe_calloc(region->var_count + 1, sizeof(int), "range clocks");
+    state->temporary = (char*)safe_malloc(region->var_count + 1, "range variables");
+    for (int v = 0; v < region->var_count; v++) state->temporary[v] = (char)is_temporary(region->vars[v]);
+    state->scratch = (ValueRange*)safe_malloc(largest * sizeof(ValueRange), "range values");
+    state->scratch_size = largest;
+    find_thresholds(state);
+}
+
+/* Helper: start over from "nothing known" (the region did not settle) */
+static void give_up(RangeState* state) {
+    for (int i = 0; i < state->order_count; i++) {
+        BlockRanges* info = &state->blocks[state->order[i] - state->first];
+        info->reached = 1;
+        for (int v = 0; v < info->var_count; v++) info->values[v] = unbounded();
+    }
+}
+
+/* Helper: solve the ranges of one region */
+static void solve_region(RangeState* state) {
+    int entry = state->first;
+    BlockRanges* start = &state->blocks[0];
+    if (state->order_count == 0) return;
+    start->reached = 1;
+    start->pending = 1;
+    for (int i = 0; i < start->var_count; i++) start->values[i] = unbounded();
+
+    ValueRange* incoming = (ValueRange*)safe_malloc(state->scratch_size * sizeof(ValueRange), "range values");
+
+    /* Ascending, widening at loop headers. The first pending block in
+     * reverse postorder goes next, so a loop settles before the code
+     * behind it is visited. */
+    int visits = 0;
+    int i = 0;
+    while (i < state->order_count && visits <= VISIT_LIMIT * state->order_count) {
+        int b = state->order[i];
+        BlockRanges* info = &state->blocks[b - state->first];
+        if (!info->pending) {
+            i++;
+            continue;
+        }
+        info->pending = 0;
+        visits++;
+
+        if (b != entry) {
+            int changed = 0;
+            if (incoming_ranges(state, b, incoming)) {
+                changed = !info->reached;
+                for (int v = 0; v < info->var_count; v++) {
+                    ValueRange range = !info->reached ? incoming[v]
+                                     : info->header ? widen(state, info, info->values[v], incoming[v])
+                                                    : join(info->values[v], incoming[v]);
+                    if (!same_range(range, info->values[v])) changed = 1;
+                    info->values[v] = range;
+                }
+                if (info->reached && info->header && changed) info->widened++;
+            }
+            if (!changed) {
+                i++;
+                continue;
+            }
+            info->reached = 1;
+        }
+        int lowest = walk_block(state, b, NULL, NULL);
+        i = lowest <= i ? lowest : i + 1;
+    }
+
+    /* Without a widening the ascending ranges are already the tightest */
+    int widened = 0;
+    for (int b = 0; b < state->count; b++) widened |= state->blocks[b].widened;
+
+    if (i < state->order_count) {
+        give_up(state);
+    } else if (widened) {
+        /* Narrowing: recompute every block from its incoming edges */
+        for (int sweep = 0; sweep < NARROW_SWEEPS; sweep++) {
+            for (int i = 0; i < state->order_count; i++) {
+                int b = state->order[i];
+                BlockRanges* info = &state->blocks[b - state->first];
+                if (!info->reached) continue;
+                if (b != entry) {
+                    if (!incoming_ranges(state, b, incoming)) {
+                        info->reached = 0;
+                        continue;
+                    }
+                    for (int v = 0; v < info->var_count; v++) {
+                        info->values[v] = intersect(info->values[v], incoming[v]);
+                    }
+                }
+                walk_block(state, b, NULL, NULL);
+            }
+        }
+    }
+    free(incoming);
+}
+
+static void free_region(RangeState* state) {
+    for (int b = 0; b < state->count; b++) {
+        free(state->blocks[b].vars);
+        free(state->blocks[b].values);
+        free(state->blocks[b].edge[0]);
+        free(state->blocks[b].edge[1]);
+    }
+    free(state->blocks);
+    free(state->order);
+    free(state->operands);
+    free(state->thresholds);
+    free(state->value);
+    free(state->set_at);
+    free(state->temporary);
+    free(state->copies);
+    free(state->scratch);
+}
+
+/* Helper: does any instruction of the blocks first .. first + count - 1
+ * pass the filter? */
+static int region_wanted(FlowGraph* graph, int first, int count, RangeFilter wanted) {
+    if (!wanted) return 1;
+    for (int b = first; b < first + count; b++) {
+        for (TACInstruction* inst = graph->blocks[b].first;; inst = inst->next) {
+            if (wanted(inst)) return 1;
+            if (inst == graph->blocks[b].last) break;
+        }
+    }
+    return 0;
+}
+
+/* Compute the value ranges and visit every reachable instruction */
+void visit_value_ranges(FlowGraph* graph, RangeFilter wanted, RangeVisitor visit, void* context) {
+    for (int r = 0; r < graph->region_count; r++) {
+        RangeState state;
+        memset(&state, 0, sizeof(state));
+        state.graph = graph;
+        state.region = &graph->regions[r];
+        state.first = graph->regions[r].first_block;
+        state.count = graph->regions[r].block_count;
+        if (state.count == 0 || !region_wanted(graph, state.first, state.count, wanted)) continue;
+
+        init_region(&state);
+        solve_region(&state);
+        for (int b = state.first; b < state.first + state.count; b++) {
+            if (state.blocks[b - state.first].reached) walk_block(&state, b, visit, context);
+        }
+        free_region(&state);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * RANGE.H - Value Range Analysis Header
+ * CST-405 Compiler Project
+ *
+ * Interval analysis over the CFG: for every point of a function it finds
+ * a range [lo, hi] each scalar variable lies in. Ranges come from
+ * constants, arithmetic, the tests of conditional jumps (the edge taken
+ * by "if i < 10" has i <= 9) and --bounds-check checks (code after a
+ * check has 0 <= index < size). Loops are solved by iterating to a fixed
+ * point, widening the ranges at loop headers to constants the function
+ * compares with (so a counter jumps to its loop bound instead of growing
+ * one step per iteration), then narrowing them again.
+ *
+ * The analysis is shared: the security checker uses it for overflow and
+ * division by zero warnings, the optimizer's ranges pass to drop bounds
+ * checks that cannot fail and to mark divisions whose operands are never
+ * negative (the code generators give those an unsigned fast path).
+ *
+ * Bounds at or beyond RANGE_LIMIT mean "unbounded", which keeps every
+ * bounded value in 32 bits: arithmetic that could leave that range gives
+ * an unbounded result, so the ranges hold on MIPS, where it wraps, too.
+ * A call may change any global, so it makes every user variable
+ * unbounded.
+ */
+
+#ifndef RANGE_H
+#define RANGE_H
+
+#include "ircode.h"
+#include "cfg.h"
+
+#define RANGE_LIMIT (1LL << 31)
+
+/* Values a variable may have (lo <= hi; lo = -RANGE_LIMIT and
+ * hi = RANGE_LIMIT stand for no bound) */
+typedef struct {
+    long long lo;
+    long long hi;
+} ValueRange;
+
+/* Both ends bounded? */
+#define RANGE_BOUNDED(range) ((range).lo > -RANGE_LIMIT && (range).hi < RANGE_LIMIT)
+
+/* Called for each instruction that can run, with the ranges of its op1
+ * and op2 just before it (unbounded for array names and missing ones) */
+typedef void (*RangeVisitor)(void* context, TACInstruction* inst, ValueRange op1, ValueRange op2);
+
+/* Does the visitor care about this instruction? A region (function) with
+ * no such instruction is not analyzed at all. */
+typedef int (*RangeFilter)(const TACInstruction* inst);
+
+/* VALUE RANGE FUNCTIONS */
+
+/* Compute the value ranges of the code graph describes (needs
+ * ANALYSIS_CFG, ANALYSIS_LIVENESS and ANALYSIS_DOMINATORS, which numbers
+ * the blocks in reverse postorder) and call visit for every instruction
+ * of every reachable block, in list order. Only regions with an
+ * instruction wanted accepts are analyzed (NULL = all of them). */
+void visit_value_ranges(FlowGraph* graph, RangeFilter wanted, RangeVisitor visit, void* context);
+
+#endif /* RANGE_H */
@@ -4,6 +4,7 @@
 $tests = @(
     'test_math.c',
     'test_order_of_operations.c',
+    'test_remainder.c',
     'test_if.c',
     'test_if_else.c',
     'test_nested_if.c',
@@ -13,7 +14,19 @@ $tests = @(
     'test_do_while.c',
     'test_nested_loops.c',
     'test_arrays.c',
+    'test_array_store.c',
     'test_functions.c',
+    'test_recursion.c',
+    'test_names.c',
+    'test_print_calls.c',
+    'test_scopes.c',
+    'test_const_copies.c',
+    'test_copy_calls.c',
+    'test_layout.c',
+    'test_profile.c',
+    'test_bounds.c',
+    'test_ranges.c',
+    'test_vector.c',
     'test_security.c',
     'test_comprehensive.c'
 )
@@ -18,34 +18,41 @@ static int is_constant_node(ASTNode* node, int* value) {
     return 0;
 }
 
+/* Helper: check one array element read or write against the array bounds */
+static void check_array_index(ASTNode* node, const char* array_name, ASTNode* index,
+                              SecurityCheckResults* results) {
+    /* Symbol resolved by the semantic analyzer (scopes are closed by now) */
+    Symbol* sym = node->symbol;
+    if (!sym || !sym->is_array) return;
+
+    int index_val;
+    if (is_constant_node(index, &index_val)) {
+        /* Static array bounds check */
+        if (index_val < 0 || index_val >= sym->array_size) {
+            diag_security_warning(node->line_number, 0,
+                "Array '%s' access with index %d is out of bounds [0..%d]",
+                array_name, index_val, sym->array_size - 1);
+            results->buffer_overflow_risks++;
+        }
+    } else {
+        /* Dynamic index - warn about potential overflow */
+        debug_print("Array '%s' accessed with non-constant index - potential buffer overflow",
+                   array_name);
+        results->array_access_risks++;
+    }
+}
+
 /* Check for buffer overflow vulnerabilities */
 void check_buffer_overflow(ASTNode* node, SymbolTable* symtab, SecurityCheckResults* results) {
     if (!node) return;
 
-    /* Check array access with potentially out-of-bounds index */
+    /* Check array reads and writes with potentially out-of-bounds index */
     if (node->type == NODE_ARRAY_ACCESS) {
-        const char* array_name = node->data.array_access.array_name;
-        ASTNode* index = node->data.array_access.index;
-
-        /* Look up array in symbol table */
-        Symbol* sym = lookup_symbol(symtab, array_name);
-        if (sym && sym->is_array) {
-            int index_val;
-            if (is_constant_node(index, &index_val)) {
-                /* Static array bounds check */
-                if (index_val < 0 || index_val >= sym->array_size) {
-                    diag_security_warning(node->line_number, 0,
-                        "Array '%s' access with index %d is out of bounds [0..%d]",
-                        array_name, index_val, sym->array_size - 1);
-                    results->buffer_overflow_risks++;
-                }
-            } else {
-                /* Dynamic index - warn about potential overflow */
-                debug_print("Array '%s' accessed with non-constant index - potential buffer overflow",
-                           array_name);
-                results->array_access_risks++;
-            }
-        }
+        check_array_index(node, node->data.array_access.array_name,
+                          node->data.array_access.index, results);
+    } else if (node->type == NODE_ASSIGNMENT && node->data.assignment.index) {
+        check_array_index(node, node->data.assignment.var_name,
+                          node->data.assignment.index, results);
     }
 
     /* Recursively check children */
@@ -63,6 +70,7 @@ void check_buffer_overflow(ASTNode* node, SymbolTable* symtab, SecurityCheckResu
             check_buffer_overflow(node->data.binary_op.right, symtab, results);
             break;
         case NODE_ASSIGNMENT:
+            check_buffer_overflow(node->data.assignment.index, symtab, results);
             check_buffer_overflow(node->data.assignment.expr, symtab, results);
             break;
         case NODE_PRINT:
@@ -83,6 +91,16 @@ void check_buffer_overflow(ASTNode* node, SymbolTable* symtab, SecurityCheckResu
             check_buffer_overflow(node->data.for_loop.update, symtab, results);
             check_buffer_overflow(node->data.for_loop.body, symtab, results);
             break;
+        case NODE_DO_WHILE:
+            check_buffer_overflow(node->data.do_while_loop.body, symtab, results);
+            check_buffer_overflow(node->data.do_while_loop.condition, symtab, results);
+            break;
+        case NODE_FUNCTION_DEF:
+            check_buffer_overflow(node->data.function.body, symtab, results);
+            break;
+        case NODE_RETURN:
+            check_buffer_overflow(node->data.return_stmt.expr, symtab, results);
+            break;
         case NODE_FUNCTION_CALL:
             check_buffer_overflow(node->data.func_call.args, symtab, results);
             break;
@@ -95,96 +113,95 @@ void check_buffer_overflow(ASTNode* node, SymbolTable* symtab, SecurityCheckResu
     }
 }
 
-/* Check for integer overflow/underflow */
-void check_integer_overflow(ASTNode* node, SecurityCheckResults* results) {
-    if (!node) return;
-
-    /* Check arithmetic operations with constants */
-    if (node->type == NODE_BINARY_OP) {
-        int left_val, right_val;
-        if (is_constant_node(node->data.binary_op.left, &left_val) &&
-            is_constant_node(node->data.binary_op.right, &right_val)) {
-
-            const char* op = node->data.binary_op.operator;
-            long long result;
-
-            if (strcmp(op, "+") == 0) {
-                result = (long long)left_val + right_val;
-                if (result > INT_MAX || result < INT_MIN) {
-                    diag_security_warning(node->line_number, 0,
-                        "Integer overflow in addition: %d + %d",
-                        left_val, right_val);
-                    results->integer_overflow_risks++;
-                }
-            } else if (strcmp(op, "*") == 0) {
-                result = (long long)left_val * right_val;
-                if (result > INT_MAX || result < INT_MIN) {
-                    diag_security_warning(node->line_number, 0,
-                        "Integer overflow in multiplication: %d * %d",
-                        left_val, right_val);
-                    results->integer_overflow_risks++;
-                }
-            }
-        }
+/* Helper: name of an arithmetic operation for messages */
+static const char* operation_name(TACOpcode opcode) {
+    switch (opcode) {
+        case TAC_ADD: return "addition";
+        case TAC_SUB: return "subtraction";
+        case TAC_MUL: return "multiplication";
+        default:      return "arithmetic";
     }
+}
 
-    /* Recursively check children */
-    switch (node->type) {
-        case NODE_PROGRAM:
-            check_integer_overflow(node->data.program.statements, results);
-            break;
-        case NODE_STATEMENT_LIST:
-            check_integer_overflow(node->data.stmt_list.statement, results);
-            check_integer_overflow(node->data.stmt_list.next, results);
-            break;
-        case NODE_BINARY_OP:
-            check_integer_overflow(node->data.binary_op.left, results);
-            check_integer_overflow(node->data.binary_op.right, results);
-            break;
-        default:
-            break;
+static const char* operation_symbol(TACOpcode opcode) {
+    switch (opcode) {
+        case TAC_ADD: return "+";
+        case TAC_SUB: return "-";
+        default:      return "*";
     }
 }
 
-/* Check for division by zero */
-void check_division_by_zero(ASTNode* node, SecurityCheckResults* results) {
-    if (!node) return;
+/* Check for integer overflow/underflow */
+int check_integer_overflow(TACInstruction* inst, ValueRange op1, ValueRange op2, SecurityCheckResults* results) {
+    if (inst->opcode != TAC_ADD && inst->opcode != TAC_SUB && inst->opcode != TAC_MUL) return 0;
+
+    /* An operand with no known bound says nothing either way */
+    if (!RANGE_BOUNDED(op1) || !RANGE_BOUNDED(op2)) return 0;
+
+    long long corners[4];
+    if (inst->opcode == TAC_ADD) {
+        corners[0] = op1.lo + op2.lo;
+        corners[1] = op1.hi + op2.hi;
+        corners[2] = corners[0];
+        corners[3] = corners[1];
+    } else if (inst->opcode == TAC_SUB) {
+        corners[0] = op1.lo - op2.hi;
+        corners[1] = op1.hi - op2.lo;
+        corners[2] = corners[0];
+        corners[3] = corners[1];
+    } else {
+        corners[0] = op1.lo * op2.lo;
+        corners[1] = op1.lo * op2.hi;
+        corners[2] = op1.hi * op2.lo;
+        corners[3] = op1.hi * op2.hi;
+    }
+    long long lo = corners[0], hi = corners[0];
+    for (int i = 1; i < 4; i++) {
+        if (corners[i] < lo) lo = corners[i];
+        if (corners[i] > hi) hi = corners[i];
+    }
+    if (lo >= INT_MIN && hi <= INT_MAX) return 0;
 
-    /* Check division and modulo operations */
-    if (node->type == NODE_BINARY_OP) {
-        const char* op = node->data.binary_op.operator;
-
-        if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
-            int divisor;
-            if (is_constant_node(node->data.binary_op.right, &divisor)) {
-                if (divisor == 0) {
-                    diag_error(node->line_number, 0,
-                        "Division by zero detected");
-                    results->division_by_zero_risks++;
-                }
-            } else {
-                /* Non-constant divisor - potential risk */
-                debug_print("Division by non-constant value - potential division by zero");
-            }
-        }
+    if (op1.lo == op1.hi && op2.lo == op2.hi) {
+        diag_security_warning(inst->line, 0, "Integer overflow in %s: %lld %s %lld",
+                              operation_name(inst->opcode), op1.lo, operation_symbol(inst->opcode), op2.lo);
+    } else {
+        diag_security_warning(inst->line, 0,
+                              "Possible integer overflow in %s: operands range over [%lld, %lld] and [%lld, %lld]",
+                              operation_name(inst->opcode), op1.lo, op1.hi, op2.lo, op2.hi);
     }
+    results->integer_overflow_risks++;
+    return 1;
+}
 
-    /* Recursively check children */
-    switch (node->type) {
-        case NODE_PROGRAM:
-            check_division_by_zero(node->data.program.statements, results);
-            break;
-        case NODE_STATEMENT_LIST:
-            check_division_by_zero(node->data.stmt_list.statement, results);
-            check_division_by_zero(node->data.stmt_list.next, results);
-            break;
-        case NODE_BINARY_OP:
-            check_division_by_zero(node->data.binary_op.left, results);
-            check_division_by_zero(node->data.binary_op.right, results);
-            break;
-        default:
-            break;
+/* Check for division by zero */
+int check_division_by_zero(TACInstruction* inst, ValueRange op1, ValueRange op2, SecurityCheckResults* results) {
+    (void)op1;
+    if (inst->opcode != TAC_DIV && inst->opcode != TAC_MOD) return 0;
+
+    if (!RANGE_BOUNDED(op2)) {
+        /* Non-constant divisor - potential risk */
+        debug_print("Division by non-constant value - potential division by zero");
+        return 0;
     }
+    if (op2.lo > 0 || op2.hi < 0) return 0;
+
+    if (op2.lo == 0 && op2.hi == 0) {
+        /* A literal 0 is loaded right before the division that uses it */
+        TACInstruction* load = inst->prev;
+        int literal = load && load->opcode == TAC_LOAD_CONST && load->result && inst->op2 &&
+                      strcmp(load->result, inst->op2) == 0;
+        if (literal) {
+            diag_error(inst->line, 0, "Division by zero detected");
+        } else {
+            diag_security_warning(inst->line, 0, "Division by zero: the divisor is always 0");
+        }
+    } else {
+        diag_security_warning(inst->line, 0, "Possible division by zero: the divisor ranges over [%lld, %lld]",
+                              op2.lo, op2.hi);
+    }
+    results->division_by_zero_risks++;
+    return 1;
 }
 
 /* Check for unsafe array accesses */
@@ -253,6 +270,7 @@ void check_uninitialized_use(ASTNode* node, SymbolTable* symtab, SecurityCheckRe
             check_uninitialized_use(node->data.binary_op.right, symtab, results);
             break;
         case NODE_ASSIGNMENT:
+            check_uninitialized_use(node->data.assignment.index, symtab, results);
             check_uninitialized_use(node->data.assignment.expr, symtab, results);
             break;
         case NODE_PRINT:
@@ -278,8 +296,58 @@ void check_uninitialized_use(ASTNode* node, SymbolTable* symtab, SecurityCheckRe
     }
 }
 
+/* Per-instruction checks over the value ranges. A rotated loop repeats
+ * its condition, so each source line reports a kind of risk once. */
+typedef struct {
+    SecurityCheckResults* results;
+    int* reported;                  /* line * 2 + kind (0 overflow, 1 division) */
+    int reported_count;
+    int reported_capacity;
+} RangeChecks;
+
+/* Helper: is inst an operation check_ranges looks at? Functions without
+ * one skip the range analysis. */
+static int range_check_wanted(const TACInstruction* inst) {
+    switch (inst->opcode) {
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_MOD:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void check_ranges(void* context, TACInstruction* inst, ValueRange op1, ValueRange op2) {
+    RangeChecks* checks = (RangeChecks*)context;
+    int kind;
+    if (inst->opcode == TAC_ADD || inst->opcode == TAC_SUB || inst->opcode == TAC_MUL) {
+        kind = 0;
+    } else if (inst->opcode == TAC_DIV || inst->opcode == TAC_MOD) {
+        kind = 1;
+    } else {
+        return;
+    }
+
+    int key = inst->line * 2 + kind;
+    for (int i = 0; i < checks->reported_count; i++) {
+        if (checks->reported[i] == key) return;
+    }
+    int found = kind == 0 ? check_integer_overflow(inst, op1, op2, checks->results)
+                          : check_division_by_zero(inst, op1, op2, checks->results);
+    if (!found) return;
+    if (checks->reported_count == checks->reported_capacity) {
+        checks->reported_capacity = checks->reported_capacity ? checks->reported_capacity * 2 : 8;
+        checks->reported = (int*)safe_realloc(checks->reported, checks->reported_capacity * sizeof(int),
+                                              "security reports");
+    }
+    checks->reported[checks->reported_count++] = key;
+}
+
 /* Main security analysis function */
-SecurityCheckResults* analyze_security(ASTNode* root, SymbolTable* symtab) {
+SecurityCheckResults* analyze_security(ASTNode* root, SymbolTable* symtab, TACCode* tac) {
     SecurityCheckResults* results = (SecurityCheckResults*)safe_calloc(1,
         sizeof(SecurityCheckResults), "security results");
 
@@ -287,10 +355,20 @@ SecurityCheckResults* analyze_security(ASTNode* root, SymbolTable* symtab) {
 
     /* Perform all security checks */
     check_buffer_overflow(root, symtab, results);
-    check_integer_overflow(root, results);
-    check_division_by_zero(root, results);
     check_infinite_loops(root, results);
 
+    /* Overflow and division by zero use the value ranges of the TAC */
+    if (tac && tac->head) {
+        RangeChecks checks;
+        memset(&checks, 0, sizeof(checks));
+        checks.results = results;
+        FlowGraph* graph = create_flow_graph(tac);
+        require_analyses(graph, ANALYSIS_CFG | ANALYSIS_LIVENESS | ANALYSIS_DOMINATORS);
+        visit_value_ranges(graph, range_check_wanted, check_ranges, &checks);
+        free_flow_graph(graph);
+        free(checks.reported);
+    }
+
     /* Calculate total */
     results->total_security_issues =
         results->buffer_overflow_risks +
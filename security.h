@@ -11,6 +11,8 @@
 
 #include "ast.h"
 #include "symtable.h"
+#include "ircode.h"
+#include "range.h"
 
 /* Security check results */
 typedef struct {
@@ -25,17 +27,19 @@ typedef struct {
 
 /* SECURITY CHECK FUNCTIONS */
 
-/* Perform comprehensive security analysis on AST */
-SecurityCheckResults* analyze_security(ASTNode* root, SymbolTable* symtab);
+/* Perform comprehensive security analysis on the AST and the unoptimized
+ * TAC (overflow and division by zero follow the value ranges, range.h) */
+SecurityCheckResults* analyze_security(ASTNode* root, SymbolTable* symtab, TACCode* tac);
 
 /* Check for buffer overflow vulnerabilities */
 void check_buffer_overflow(ASTNode* node, SymbolTable* symtab, SecurityCheckResults* results);
 
-/* Check for integer overflow/underflow */
-void check_integer_overflow(ASTNode* node, SecurityCheckResults* results);
+/* Check one arithmetic instruction for integer overflow/underflow, given
+ * the ranges of its operands. Returns 1 if it reported something. */
+int check_integer_overflow(TACInstruction* inst, ValueRange op1, ValueRange op2, SecurityCheckResults* results);
 
-/* Check for division by zero */
-void check_division_by_zero(ASTNode* node, SecurityCheckResults* results);
+/* Check one division or modulo for division by zero (likewise) */
+int check_division_by_zero(TACInstruction* inst, ValueRange op1, ValueRange op2, SecurityCheckResults* results);
 
 /* Check for unsafe array accesses */
 void check_unsafe_array_access(ASTNode* node, SymbolTable* symtab, SecurityCheckResults* results);
@@ -9,11 +9,8 @@
 #include <string.h>
 #include "semantic.h"
 
-/* Global error counter */
-int semantic_errors = 0;
-
-/* Current function scope for scoped symbol lookup */
-static const char* current_function_scope = "global";
+/* Error counter for the analysis running on this thread */
+THREAD_LOCAL int semantic_errors = 0;
 
 /* Report a semantic error with location information */
 void semantic_error(const char* message, int line) {
@@ -25,10 +22,15 @@ void semantic_error(const char* message, int line) {
     semantic_errors++;
 }
 
+/* Resolve the name referenced by an AST node using its precomputed hash.
+ * The result is cached on the node so later phases never look it up again. */
+static Symbol* resolve_symbol(ASTNode* node, const char* name, SymbolTable* symtab) {
+    node->symbol = lookup_symbol_hashed(symtab, name, node->name_hash);
+    return node->symbol;
+}
+
 /* Check if a variable has been declared */
-int check_declared(const char* var_name, SymbolTable* symtab, int line) {
-    /* Use scope-aware lookup */
-    Symbol* symbol = lookup_symbol_in_scope(symtab, var_name, current_function_scope);
+int check_declared(Symbol* symbol, const char* var_name, int line) {
     if (!symbol) {
         char error_msg[100];
         snprintf(error_msg, sizeof(error_msg),
@@ -40,9 +42,7 @@ int check_declared(const char* var_name, SymbolTable* symtab, int line) {
 }
 
 /* Check if a variable has been initialized before use */
-int check_initialized(const char* var_name, SymbolTable* symtab, int line) {
-    /* Use scope-aware lookup */
-    Symbol* symbol = lookup_symbol_in_scope(symtab, var_name, current_function_scope);
+int check_initialized(Symbol* symbol, const char* var_name, int line) {
     if (symbol && !symbol->is_initialized) {
         char error_msg[100];
         snprintf(error_msg, sizeof(error_msg),
@@ -65,18 +65,18 @@ DataType analyze_expression(ASTNode* node, SymbolTable* symtab) {
         case NODE_IDENTIFIER: {
             /* Variable reference - check if declared and initialized */
             const char* var_name = node->data.str_value;
+            Symbol* symbol = resolve_symbol(node, var_name, symtab);
 
-            if (!check_declared(var_name, symtab, node->line_number)) {
+            if (!check_declared(symbol, var_name, node->line_number)) {
                 return TYPE_UNKNOWN;
             }
 
-            if (!check_initialized(var_name, symtab, node->line_number)) {
+            if (!check_initialized(symbol, var_name, node->line_number)) {
                 return TYPE_UNKNOWN;
             }
 
             /* Return the variable's type from symbol table */
-            Symbol* symbol = lookup_symbol(symtab, var_name);
-            return symbol ? symbol->type : TYPE_UNKNOWN;
+            return symbol->type;
         }
 
         case NODE_BINARY_OP: {
@@ -111,7 +111,7 @@ DataType analyze_expression(ASTNode* node, SymbolTable* symtab) {
             const char* array_name = node->data.array_access.array_name;
 
             /* Check if array is declared */
-            Symbol* symbol = lookup_symbol(symtab, array_name);
+            Symbol* symbol = resolve_symbol(node, array_name, symtab);
             if (!symbol) {
                 char error_msg[100];
                 snprintf(error_msg, sizeof(error_msg),
@@ -145,7 +145,7 @@ DataType analyze_expression(ASTNode* node, SymbolTable* symtab) {
             const char* func_name = node->data.func_call.func_name;
 
             /* Check if function is declared */
-            Symbol* symbol = lookup_symbol(symtab, func_name);
+            Symbol* symbol = resolve_symbol(node, func_name, symtab);
             if (!symbol) {
                 char error_msg[100];
                 snprintf(error_msg, sizeof(error_msg),
@@ -227,9 +227,71 @@ DataType analyze_expression(ASTNode* node, SymbolTable* symtab) {
     }
 }
 
-/* Scoped analysis - These use lookup_symbol_in_scope instead of lookup_symbol */
-void analyze_statement_with_scope(ASTNode* node, SymbolTable* symtab, const char* scope);
-DataType analyze_expression_with_scope(ASTNode* node, SymbolTable* symtab, const char* scope);
+/* Convert a type name from the AST ("int"/"void") to a DataType */
+static DataType type_from_name(const char* type_name) {
+    if (strcmp(type_name, "void") == 0) {
+        return TYPE_VOID;
+    }
+    return TYPE_INT;  /* Default to int */
+}
+
+/* Register a function (prototype or definition) in the global scope if not already present */
+static void declare_function(ASTNode* node, SymbolTable* symtab) {
+    const char* func_name = node->data.function.func_name;
+    ASTNode* params = node->data.function.params;
+
+    if (lookup_symbol(symtab, func_name)) {
+        return;  /* Already declared (e.g. by a prototype) */
+    }
+
+    /* First pass: Count parameters */
+    int param_count = 0;
+    ASTNode* param_node = params;
+    while (param_node && param_node->type == NODE_PARAM_LIST) {
+        param_count++;
+        param_node = param_node->data.list.next;
+    }
+
+    /* Second pass: Collect parameter types and names */
+    DataType* param_types = NULL;
+    char** param_names = NULL;
+    if (param_count > 0) {
+        param_types = (DataType*)safe_malloc(param_count * sizeof(DataType), "parameter types");
+        param_names = (char**)safe_malloc(param_count * sizeof(char*), "parameter names");
+
+        param_node = params;
+        int idx = 0;
+        while (param_node && param_node->type == NODE_PARAM_LIST) {
+            ASTNode* param = param_node->data.list.item;
+            if (param && param->type == NODE_PARAM) {
+                param_types[idx] = type_from_name(param->data.param.type);
+                param_names[idx] = param->data.param.name;
+                idx++;
+            }
+            param_node = param_node->data.list.next;
+        }
+        param_count = idx;
+    }
+
+    /* The symbol table copies the parameter info */
+    add_function_symbol(symtab, func_name, type_from_name(node->data.function.return_type),
+                        param_count, param_types, param_names, node->line_number);
+    free(param_types);
+    free(param_names);
+
+    log_message(LOG_VERBOSE, "[SEMANTIC] Function '%s' added to symbol table\n", func_name);
+}
+
+/* Point the function's parameter list at the storage of parameter index
+ * (which has its own name when it shadows a global) */
+static void record_parameter_storage(SymbolTable* symtab, const char* func_name, int index,
+                                     const char* param_name) {
+    Symbol* func = lookup_symbol(symtab, func_name);
+    Symbol* param = lookup_symbol_current_scope(symtab, param_name);
+    if (func && func->kind == SYMBOL_FUNCTION && index < func->param_count && param) {
+        func->param_names[index] = param->storage_name;
+    }
+}
 
 /* Analyze a single statement */
 void analyze_statement(ASTNode* node, SymbolTable* symtab) {
@@ -237,10 +299,32 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
 
     switch (node->type) {
         case NODE_DECLARATION: {
-            /* Declaration is already handled in the parser
-             * (added to symbol table during parsing) */
-            printf("[SEMANTIC] Declaration verified: int %s\n",
-                   node->data.str_value);
+            /* Declaration: int x; - declared in the innermost scope */
+            if (!add_symbol(symtab, node->data.str_value, TYPE_INT, node->line_number)) {
+                char error_msg[100];
+                snprintf(error_msg, sizeof(error_msg),
+                         "Variable '%s' already declared in this scope", node->data.str_value);
+                semantic_error(error_msg, node->line_number);
+                break;
+            }
+            log_message(LOG_VERBOSE, "[SEMANTIC] Declaration verified: int %s\n",
+                        node->data.str_value);
+            break;
+        }
+
+        case NODE_ARRAY_DECLARATION: {
+            /* Array declaration: int arr[10]; - declared in the innermost scope */
+            const char* array_name = node->data.array_decl.var_name;
+            if (!add_array_symbol(symtab, array_name, TYPE_INT,
+                                  node->data.array_decl.size, node->line_number)) {
+                char error_msg[100];
+                snprintf(error_msg, sizeof(error_msg),
+                         "Array '%s' already declared in this scope", array_name);
+                semantic_error(error_msg, node->line_number);
+                break;
+            }
+            log_message(LOG_VERBOSE, "[SEMANTIC] Array declaration verified: int %s[%d]\n",
+                        array_name, node->data.array_decl.size);
             break;
         }
 
@@ -249,23 +333,38 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
             const char* var_name = node->data.assignment.var_name;
 
             /* Check if variable was declared */
-            if (!check_declared(var_name, symtab, node->line_number)) {
+            Symbol* symbol = resolve_symbol(node, var_name, symtab);
+            if (!check_declared(symbol, var_name, node->line_number)) {
                 break;
             }
 
+            /* Element assignment: the target must be an array, the index an int */
+            if (node->data.assignment.index) {
+                if (!symbol->is_array) {
+                    char error_msg[100];
+                    snprintf(error_msg, sizeof(error_msg),
+                             "'%s' is not an array", var_name);
+                    semantic_error(error_msg, node->line_number);
+                }
+
+                DataType index_type = analyze_expression(node->data.assignment.index, symtab);
+                if (index_type != TYPE_INT && index_type != TYPE_UNKNOWN) {
+                    semantic_error("Array index must be an integer", node->line_number);
+                }
+            }
+
             /* Analyze the expression on the right side */
             DataType expr_type = analyze_expression(node->data.assignment.expr, symtab);
 
             /* Check type compatibility */
-            Symbol* symbol = lookup_symbol(symtab, var_name);
-            if (symbol && expr_type != TYPE_UNKNOWN && symbol->type != expr_type) {
+            if (expr_type != TYPE_UNKNOWN && symbol->type != expr_type) {
                 semantic_error("Type mismatch in assignment", node->line_number);
             }
 
-            /* Mark variable as initialized (using current scope) */
-            mark_initialized_in_scope(symtab, var_name, current_function_scope);
+            /* Mark variable as initialized (the declaration visible from this scope) */
+            symbol->is_initialized = 1;
 
-            printf("[SEMANTIC] Assignment verified: %s = <expr>\n", var_name);
+            log_message(LOG_VERBOSE, "[SEMANTIC] Assignment verified: %s = <expr>\n", var_name);
             break;
         }
 
@@ -277,13 +376,13 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
                 /* Error already reported by analyze_expression */
             }
 
-            printf("[SEMANTIC] Print statement verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Print statement verified\n");
             break;
         }
 
         case NODE_WHILE: {
             /* While loop: while (condition) { body } */
-            printf("[SEMANTIC] Analyzing while loop...\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Analyzing while loop...\n");
 
             /* Analyze the condition */
             DataType cond_type = analyze_expression(node->data.while_loop.condition, symtab);
@@ -292,15 +391,16 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
                 /* Error already reported */
             }
 
-            /* Analyze the body (which may be a statement list) */
-            analyze_statement(node->data.while_loop.body, symtab);
+            /* Analyze the body in its own block scope */
+            analyze_statement_with_scope(node->data.while_loop.body, symtab, "block");
 
-            printf("[SEMANTIC] While loop verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] While loop verified\n");
             break;
+        }
 
         case NODE_FOR: {
             /* For loop: for (init; condition; update) { body } */
-            printf("[SEMANTIC] Analyzing for loop...\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Analyzing for loop...\n");
 
             /* Analyze the initialization */
             analyze_statement(node->data.for_loop.init, symtab);
@@ -315,19 +415,19 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
             /* Analyze the update */
             analyze_statement(node->data.for_loop.update, symtab);
 
-            /* Analyze the body (which may be a statement list) */
-            analyze_statement(node->data.for_loop.body, symtab);
+            /* Analyze the body in its own block scope */
+            analyze_statement_with_scope(node->data.for_loop.body, symtab, "block");
 
-            printf("[SEMANTIC] For loop verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] For loop verified\n");
             break;
         }
 
         case NODE_DO_WHILE: {
             /* Do-While loop: do { body } while (condition); */
-            printf("[SEMANTIC] Analyzing do-while loop...\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Analyzing do-while loop...\n");
 
             /* Analyze the body first (since it executes before condition check) */
-            analyze_statement(node->data.do_while_loop.body, symtab);
+            analyze_statement_with_scope(node->data.do_while_loop.body, symtab, "block");
 
             /* Analyze the condition */
             DataType cond_type = analyze_expression(node->data.do_while_loop.condition, symtab);
@@ -336,14 +436,13 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
                 /* Error already reported */
             }
 
-            printf("[SEMANTIC] Do-while loop verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Do-while loop verified\n");
             break;
         }
-        }
 
         case NODE_IF: {
             /* If statement: if (condition) { then_branch } [else { else_branch }] */
-            printf("[SEMANTIC] Analyzing if statement...\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Analyzing if statement...\n");
 
             /* Analyze the condition */
             DataType cond_type = analyze_expression(node->data.if_stmt.condition, symtab);
@@ -352,15 +451,15 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
                 /* Error already reported */
             }
 
-            /* Analyze the then branch */
-            analyze_statement(node->data.if_stmt.then_branch, symtab);
+            /* Analyze the then branch in its own block scope */
+            analyze_statement_with_scope(node->data.if_stmt.then_branch, symtab, "block");
 
             /* Analyze the else branch if it exists */
             if (node->data.if_stmt.else_branch) {
-                analyze_statement(node->data.if_stmt.else_branch, symtab);
+                analyze_statement_with_scope(node->data.if_stmt.else_branch, symtab, "block");
             }
 
-            printf("[SEMANTIC] If statement verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] If statement verified\n");
             break;
         }
 
@@ -371,106 +470,74 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
             break;
         }
 
+        case NODE_FUNCTION_DECL: {
+            /* Function prototype: type name(params); */
+            declare_function(node, symtab);
+            log_message(LOG_VERBOSE, "[SEMANTIC] Function declaration '%s' verified\n",
+                        node->data.function.func_name);
+            break;
+        }
+
         case NODE_FUNCTION_DEF: {
             /* Function definition: type name(params) { body } */
             const char* func_name = node->data.function.func_name;
-            const char* return_type = node->data.function.return_type;
-            ASTNode* params = node->data.function.params;
 
-            printf("[SEMANTIC] Analyzing function '%s'...\n", func_name);
-
-            /* Convert return type string to DataType */
-            DataType ret_type = TYPE_INT;  /* Default to int */
-            if (strcmp(return_type, "void") == 0) {
-                ret_type = TYPE_VOID;
-            }
+            log_message(LOG_VERBOSE, "[SEMANTIC] Analyzing function '%s'...\n", func_name);
 
-            /* First pass: Count parameters and collect their types */
-            int param_count = 0;
-            DataType* param_types = NULL;
-            char** param_names = NULL;
+            /* Add function to the global scope (unless a prototype already did) */
+            declare_function(node, symtab);
 
-            ASTNode* param_node = params;
-            while (param_node && param_node->type == NODE_PARAM_LIST) {
-                param_count++;
-                param_node = param_node->data.list.next;
-            }
+            /* Everything declared from here to pop_scope belongs to this function */
+            Symbol* declared_before = symtab->symbols_tail;
+            int count_before = symtab->num_symbols;
 
-            /* Allocate arrays for parameter info */
-            if (param_count > 0) {
-                param_types = (DataType*)malloc(param_count * sizeof(DataType));
-                param_names = (char**)malloc(param_count * sizeof(char*));
-
-                /* Second pass: Collect parameter types and names */
-                param_node = params;
-                int idx = 0;
-                while (param_node && param_node->type == NODE_PARAM_LIST) {
-                    ASTNode* param = param_node->data.list.item;
-                    if (param && param->type == NODE_PARAM) {
-                        const char* param_type = param->data.param.type;
-                        const char* param_name = param->data.param.name;
-
-                        /* Convert param type */
-                        DataType p_type = TYPE_INT;
-                        if (strcmp(param_type, "void") == 0) {
-                            p_type = TYPE_VOID;
-                        }
+            /* Parameters and the outermost body block share the function scope */
+            push_scope(symtab, func_name);
 
-                        param_types[idx] = p_type;
-                        param_names[idx] = strdup(param_name);
-                        idx++;
-                    }
-                    param_node = param_node->data.list.next;
-                }
-            }
-
-            /* Add function to symbol table if not already present */
-            Symbol* symbol = lookup_symbol(symtab, func_name);
-            if (!symbol) {
-                /* Add function to global symbol table with correct parameter info */
-                add_function_symbol(symtab, func_name, ret_type, param_count, param_types, param_names, node->line_number);
-                symbol = lookup_symbol(symtab, func_name);
-                printf("[SEMANTIC] Function '%s' added to symbol table\n", func_name);
-            }
-
-            /* Add function parameters to symbol table with function scope and mark as initialized */
-            param_node = params;
+            ASTNode* param_node = node->data.function.params;
+            int param_index = 0;
             while (param_node && param_node->type == NODE_PARAM_LIST) {
                 ASTNode* param = param_node->data.list.item;
                 if (param && param->type == NODE_PARAM) {
-                    const char* param_type = param->data.param.type;
                     const char* param_name = param->data.param.name;
 
-                    /* Convert param type */
-                    DataType p_type = TYPE_INT;
-                    if (strcmp(param_type, "void") == 0) {
-                        p_type = TYPE_VOID;
-                    }
-
-                    /* Add parameter with function scope */
-                    add_parameter(symtab, param_name, p_type, param->line_number, func_name);
-
-                    /* IMPORTANT: Mark parameter as initialized (parameters are initialized by caller) */
-                    Symbol* param_symbol = lookup_symbol_in_scope(symtab, param_name, func_name);
-                    if (param_symbol) {
-                        param_symbol->is_initialized = 1;
+                    if (!add_parameter(symtab, param_name, type_from_name(param->data.param.type),
+                                       param->line_number)) {
+                        char error_msg[100];
+                        snprintf(error_msg, sizeof(error_msg),
+                                 "Duplicate parameter '%s'", param_name);
+                        semantic_error(error_msg, param->line_number);
+                    } else {
+                        record_parameter_storage(symtab, func_name, param_index, param_name);
+                        log_message(LOG_VERBOSE, "[SEMANTIC] Parameter '%s' added to function '%s' scope\n",
+                                    param_name, func_name);
                     }
-
-                    printf("[SEMANTIC] Parameter '%s' added to function '%s' scope\n", param_name, func_name);
+                    param_index++;
                 }
                 param_node = param_node->data.list.next;
             }
 
             /* Analyze function body with function scope */
-            analyze_statement_with_scope(node->data.function.body, symtab, func_name);
+            analyze_statement(node->data.function.body, symtab);
+
+            pop_scope(symtab);
 
-            printf("[SEMANTIC] Function '%s' verified\n", func_name);
+            /* Record the function's parameters and locals (the code generator
+             * gives them stack slots) */
+            Symbol* func_symbol = lookup_symbol(symtab, func_name);
+            if (func_symbol && func_symbol->kind == SYMBOL_FUNCTION &&
+                symtab->num_symbols > count_before) {
+                func_symbol->locals = declared_before ? declared_before->next : symtab->symbols;
+                func_symbol->local_count = symtab->num_symbols - count_before;
+            }
+
+            log_message(LOG_VERBOSE, "[SEMANTIC] Function '%s' verified\n", func_name);
             break;
         }
 
         case NODE_RETURN: {
             /* Return statement: return expr; or return; */
-            printf("[SEMANTIC] Return statement verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Return statement verified\n");
 
             /* Analyze return expression if present */
             if (node->data.return_stmt.expr) {
@@ -487,7 +554,7 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
         case NODE_FUNCTION_CALL: {
             /* Function call as a statement (not used in expression) */
             analyze_expression(node, symtab);
-            printf("[SEMANTIC] Function call statement verified\n");
+            log_message(LOG_VERBOSE, "[SEMANTIC] Function call statement verified\n");
             break;
         }
 
@@ -498,7 +565,7 @@ void analyze_statement(ASTNode* node, SymbolTable* symtab) {
 
 /* Main semantic analysis function */
 int analyze_semantics(ASTNode* root, SymbolTable* symtab) {
-    printf("\n=============== SEMANTIC ANALYSIS STARTED ===============\n\n");
+    log_message(LOG_NORMAL, "\n=============== SEMANTIC ANALYSIS STARTED ===============\n\n");
 
     semantic_errors = 0;
 
@@ -512,7 +579,7 @@ int analyze_semantics(ASTNode* root, SymbolTable* symtab) {
         analyze_statement(root->data.program.statements, symtab);
     }
 
-    printf("\n=============== SEMANTIC ANALYSIS COMPLETE ==============\n\n");
+    log_message(LOG_NORMAL, "\n=============== SEMANTIC ANALYSIS COMPLETE ==============\n\n");
 
     return semantic_errors;
 }
@@ -529,19 +596,9 @@ void print_semantic_summary() {
     }
 }
 
-/* Scope-aware statement analysis */
+/* Analyze a statement inside a fresh innermost scope (e.g. a {} block) */
 void analyze_statement_with_scope(ASTNode* node, SymbolTable* symtab, const char* scope) {
-    const char* old_scope = current_function_scope;
-    current_function_scope = scope;
+    push_scope(symtab, scope);
     analyze_statement(node, symtab);
-    current_function_scope = old_scope;
-}
-
-/* Scope-aware expression analysis */
-DataType analyze_expression_with_scope(ASTNode* node, SymbolTable* symtab, const char* scope) {
-    const char* old_scope = current_function_scope;
-    current_function_scope = scope;
-    DataType result = analyze_expression(node, symtab);
-    current_function_scope = old_scope;
-    return result;
+    pop_scope(symtab);
 }
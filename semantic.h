@@ -16,9 +16,10 @@
 #include <stdlib.h>
 #include "ast.h"
 #include "symtable.h"
+#include "diagnostics.h"
 
-/* Semantic error tracking */
-extern int semantic_errors;
+/* Semantic error tracking (per thread, reset by analyze_semantics) */
+extern THREAD_LOCAL int semantic_errors;
 
 /* SEMANTIC ANALYSIS FUNCTIONS */
 
@@ -30,20 +31,17 @@ int analyze_semantics(ASTNode* root, SymbolTable* symtab);
 /* Analyze a single statement */
 void analyze_statement(ASTNode* node, SymbolTable* symtab);
 
-/* Analyze a statement with specific scope */
+/* Analyze a statement inside a new innermost scope named 'scope' */
 void analyze_statement_with_scope(ASTNode* node, SymbolTable* symtab, const char* scope);
 
 /* Analyze an expression and return its type */
 DataType analyze_expression(ASTNode* node, SymbolTable* symtab);
 
-/* Analyze an expression with specific scope */
-DataType analyze_expression_with_scope(ASTNode* node, SymbolTable* symtab, const char* scope);
-
-/* Check if a variable has been declared */
-int check_declared(const char* var_name, SymbolTable* symtab, int line);
+/* Check if a variable has been declared (symbol is the resolved lookup, NULL if none) */
+int check_declared(Symbol* symbol, const char* var_name, int line);
 
 /* Check if a variable has been initialized before use */
-int check_initialized(const char* var_name, SymbolTable* symtab, int line);
+int check_initialized(Symbol* symbol, const char* var_name, int line);
 
 /* Report a semantic error */
 void semantic_error(const char* message, int line);
@@ -2,15 +2,22 @@
  * SYMTABLE.C - Symbol Table Implementation
  * CST-405 Compiler Project
  *
- * This file implements a hash table-based symbol table for tracking
- * variables during compilation. Provides O(1) average-case lookup.
+ * This file implements a scoped symbol table for tracking variables
+ * during compilation. Every scope is an open-addressing hash map keyed
+ * by interned names, giving O(1) average-case lookup per scope and
+ * O(1) scope push/pop.
  */
 
 #include "symtable.h"
+#include "diagnostics.h"
 
-/* Hash function - Converts string to table index using djb2 algorithm */
-unsigned int hash(const char* str, int table_size) {
-    unsigned long hash_value = 5381;
+/* Maps grow when they are more than 3/4 full */
+#define MAP_MIN_CAPACITY 8
+#define MAP_NEEDS_GROWTH(count, capacity) (((count) + 1) * 4 > (capacity) * 3)
+
+/* Hash function - djb2 algorithm over the whole string */
+unsigned int hash(const char* str) {
+    unsigned int hash_value = 5381;
     int c;
 
     /* Process each character in the string */
@@ -18,203 +25,396 @@ unsigned int hash(const char* str, int table_size) {
         hash_value = ((hash_value << 5) + hash_value) + c; /* hash * 33 + c */
     }
 
-    return hash_value % table_size;
+    return hash_value;
+}
+
+/* Round a requested capacity up to a power of two */
+static int round_capacity(int requested) {
+    int capacity = MAP_MIN_CAPACITY;
+    while (capacity < requested) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+/* Allocate a zeroed array or abort */
+static void* table_calloc(int count, size_t size, const char* what) {
+    return safe_calloc(count, size, what);
+}
+
+/* INTERNED NAME POOL */
+
+/* Find a name in the pool; returns the interned copy or NULL */
+static char* find_interned(SymbolTable* table, const char* name, unsigned int h) {
+    int mask = table->name_capacity - 1;
+    int index = h & mask;
+
+    while (table->names[index]) {
+        if (table->name_hashes[index] == h && strcmp(table->names[index], name) == 0) {
+            return table->names[index];
+        }
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+/* Double the pool and rehash using the cached hashes */
+static void grow_name_pool(SymbolTable* table) {
+    int old_capacity = table->name_capacity;
+    char** old_names = table->names;
+    unsigned int* old_hashes = table->name_hashes;
+
+    table->name_capacity = old_capacity * 2;
+    table->names = (char**)table_calloc(table->name_capacity, sizeof(char*), "name pool");
+    table->name_hashes = (unsigned int*)table_calloc(table->name_capacity, sizeof(unsigned int),
+                                                     "name pool");
+
+    int mask = table->name_capacity - 1;
+    for (int i = 0; i < old_capacity; i++) {
+        if (!old_names[i]) continue;
+        int index = old_hashes[i] & mask;
+        while (table->names[index]) {
+            index = (index + 1) & mask;
+        }
+        table->names[index] = old_names[i];
+        table->name_hashes[index] = old_hashes[i];
+    }
+
+    free(old_names);
+    free(old_hashes);
+}
+
+/* Intern a name whose hash is already known */
+static char* intern_hashed(SymbolTable* table, const char* name, unsigned int h) {
+    char* existing = find_interned(table, name, h);
+    if (existing) {
+        return existing;
+    }
+
+    if (MAP_NEEDS_GROWTH(table->name_count, table->name_capacity)) {
+        grow_name_pool(table);
+    }
+
+    int mask = table->name_capacity - 1;
+    int index = h & mask;
+    while (table->names[index]) {
+        index = (index + 1) & mask;
+    }
+
+    table->names[index] = safe_strdup(name, "name pool");
+    table->name_hashes[index] = h;
+    table->name_count++;
+    return table->names[index];
+}
+
+/* Intern a name in the table's pool and return the shared copy */
+char* intern_name(SymbolTable* table, const char* name) {
+    return intern_hashed(table, name, hash(name));
 }
 
-/* Create a new symbol table with specified size */
-SymbolTable* create_symbol_table(int size) {
-    SymbolTable* table = (SymbolTable*)malloc(sizeof(SymbolTable));
-    if (!table) {
-        fprintf(stderr, "Fatal Error: Failed to allocate symbol table\n");
-        exit(1);
+/* PER-SCOPE MAPS (keyed by interned name pointer) */
+
+/* Find a symbol in one scope by interned name */
+static Symbol* scope_find(Scope* scope, const char* interned, unsigned int h) {
+    if (scope->capacity == 0) {
+        return NULL;
     }
 
-    /* Allocate array of symbol pointers (initially all NULL) */
-    table->table = (Symbol**)calloc(size, sizeof(Symbol*));
-    if (!table->table) {
-        fprintf(stderr, "Fatal Error: Failed to allocate symbol table array\n");
-        free(table);
-        exit(1);
+    int mask = scope->capacity - 1;
+    int index = h & mask;
+    while (scope->slots[index]) {
+        if (scope->slots[index]->name == interned) {
+            return scope->slots[index];
+        }
+        index = (index + 1) & mask;
     }
+    return NULL;
+}
 
-    table->size = size;
-    table->num_symbols = 0;
+/* Place a symbol into a slot array under hash h without checking for growth */
+static void slot_insert(Symbol** slots, int capacity, Symbol* symbol, unsigned int h) {
+    int mask = capacity - 1;
+    int index = h & mask;
+    while (slots[index]) {
+        index = (index + 1) & mask;
+    }
+    slots[index] = symbol;
+}
+
+/* Insert a symbol into a scope, growing the map on load factor */
+static void scope_insert(Scope* scope, Symbol* symbol) {
+    if (scope->capacity == 0 || MAP_NEEDS_GROWTH(scope->count, scope->capacity)) {
+        int new_capacity = scope->capacity ? scope->capacity * 2 : MAP_MIN_CAPACITY;
+        Symbol** new_slots = (Symbol**)table_calloc(new_capacity, sizeof(Symbol*), "scope map");
+
+        for (int i = 0; i < scope->capacity; i++) {
+            if (scope->slots[i]) {
+                slot_insert(new_slots, new_capacity, scope->slots[i], scope->slots[i]->name_hash);
+            }
+        }
+
+        free(scope->slots);
+        scope->slots = new_slots;
+        scope->capacity = new_capacity;
+    }
+
+    slot_insert(scope->slots, scope->capacity, symbol, symbol->name_hash);
+    scope->count++;
+}
+
+/* Create a scope; the global scope is pre-sized, others allocate on first insert */
+static Scope* create_scope(const char* name, Scope* parent, int initial_capacity) {
+    Scope* scope = (Scope*)table_calloc(1, sizeof(Scope), "scope");
+    scope->name = name;
+    scope->parent = parent;
+    scope->depth = parent ? parent->depth + 1 : 0;
+
+    if (initial_capacity > 0) {
+        scope->capacity = round_capacity(initial_capacity);
+        scope->slots = (Symbol**)table_calloc(scope->capacity, sizeof(Symbol*), "scope map");
+    }
+    return scope;
+}
+
+/* STORAGE OWNERS (one per distinct storage name) */
+
+/* Record a variable's storage need; the first variable with a storage name owns the slot */
+static void claim_storage(SymbolTable* table, Symbol* symbol) {
+    int needed = symbol->is_array ? symbol->array_size : 1;
+    unsigned int h = hash(symbol->storage_name);
+
+    if (table->storage_capacity > 0) {
+        int mask = table->storage_capacity - 1;
+        int index = h & mask;
+        while (table->storage[index]) {
+            Symbol* owner = table->storage[index];
+            if (owner->storage_name == symbol->storage_name) {
+                if (needed > owner->storage_size) {
+                    owner->storage_size = needed;
+                }
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    if (table->storage_capacity == 0 ||
+        MAP_NEEDS_GROWTH(table->storage_count, table->storage_capacity)) {
+        int new_capacity = table->storage_capacity ? table->storage_capacity * 2
+                                                   : MAP_MIN_CAPACITY;
+        Symbol** new_slots = (Symbol**)table_calloc(new_capacity, sizeof(Symbol*), "storage map");
+        for (int i = 0; i < table->storage_capacity; i++) {
+            if (table->storage[i]) {
+                slot_insert(new_slots, new_capacity, table->storage[i],
+                            hash(table->storage[i]->storage_name));
+            }
+        }
+        free(table->storage);
+        table->storage = new_slots;
+        table->storage_capacity = new_capacity;
+    }
+
+    slot_insert(table->storage, table->storage_capacity, symbol, h);
+    table->storage_count++;
+    symbol->owns_storage = 1;
+    symbol->storage_size = needed;
+}
+
+/* Create a new symbol table with the given global scope capacity */
+SymbolTable* create_symbol_table(int initial_capacity) {
+    SymbolTable* table = (SymbolTable*)table_calloc(1, sizeof(SymbolTable), "symbol table");
+
+    /* Interned names outnumber symbols (scope names, duplicates), so size generously */
+    table->name_capacity = round_capacity(initial_capacity * 2);
+    table->names = (char**)table_calloc(table->name_capacity, sizeof(char*), "name pool");
+    table->name_hashes = (unsigned int*)table_calloc(table->name_capacity, sizeof(unsigned int),
+                                                     "name pool");
+
+    table->global_scope = create_scope(intern_name(table, "global"), NULL, initial_capacity);
+    table->current_scope = table->global_scope;
 
     return table;
 }
 
-/* Add a new symbol to the table */
-int add_symbol(SymbolTable* table, const char* name, DataType type, int line) {
-    /* First check if symbol already exists (redeclaration error) */
-    if (lookup_symbol(table, name)) {
-        return 0;  /* Symbol already exists */
+/* Is the name visible from an enclosing scope of scope? */
+static int shadows_outer(Scope* scope, const char* interned, unsigned int h) {
+    for (Scope* outer = scope->parent; outer; outer = outer->parent) {
+        if (scope_find(outer, interned, h)) {
+            return 1;
+        }
     }
+    return 0;
+}
 
-    /* Calculate hash index */
-    unsigned int index = hash(name, table->size);
+/* Storage name of a symbol that shadows another: "name.depth" ('.' cannot
+ * appear in a source name, and only one scope per depth is open at a time) */
+static char* storage_name_at_depth(SymbolTable* table, const char* name, int depth) {
+    size_t size = strlen(name) + 16;
+    char* text = (char*)table_calloc((int)size, 1, "storage name");
+    snprintf(text, size, "%s.%d", name, depth);
+    char* interned = intern_name(table, text);
+    free(text);
+    return interned;
+}
 
-    /* Create new symbol */
-    Symbol* new_symbol = (Symbol*)malloc(sizeof(Symbol));
-    if (!new_symbol) {
-        fprintf(stderr, "Fatal Error: Failed to allocate symbol\n");
-        exit(1);
+/* Allocate a symbol with default fields and declare it in the given scope */
+static Symbol* declare_symbol(SymbolTable* table, Scope* scope, const char* name,
+                              SymbolKind kind, DataType type, int line) {
+    unsigned int h = hash(name);
+    char* interned = intern_hashed(table, name, h);
+
+    /* Redeclaration in the same scope is an error; shadowing an outer scope is fine */
+    if (scope_find(scope, interned, h)) {
+        return NULL;
     }
 
-    new_symbol->name = strdup(name);
-    new_symbol->kind = SYMBOL_VARIABLE;
+    Symbol* new_symbol = (Symbol*)safe_malloc(sizeof(Symbol), "symbol");
+
+    new_symbol->name = interned;
+    new_symbol->id = table->num_symbols;
+    new_symbol->name_hash = h;
+    new_symbol->kind = kind;
     new_symbol->type = type;
-    new_symbol->is_initialized = 0;  /* Not initialized until assigned */
+    new_symbol->is_initialized = 0;   /* Not initialized until assigned */
     new_symbol->is_array = 0;         /* Not an array by default */
     new_symbol->array_size = 0;       /* No array size by default */
     new_symbol->return_type = TYPE_UNKNOWN;
     new_symbol->param_count = 0;
     new_symbol->param_types = NULL;
     new_symbol->param_names = NULL;
-    new_symbol->scope = strdup("global");  /* Default to global scope */
+    new_symbol->locals = NULL;
+    new_symbol->local_count = 0;
+    new_symbol->scope = (char*)scope->name;
+    new_symbol->scope_depth = scope->depth;
+    new_symbol->storage_name = shadows_outer(scope, interned, h)
+                             ? storage_name_at_depth(table, name, scope->depth) : interned;
+    new_symbol->owns_storage = 0;
+    new_symbol->storage_size = 0;
     new_symbol->declaration_line = line;
     new_symbol->next = NULL;
 
-    /* Insert at the beginning of the chain (for collision handling) */
-    if (table->table[index] == NULL) {
-        table->table[index] = new_symbol;
+    scope_insert(scope, new_symbol);
+
+    /* Append to the declaration-order list used by later phases */
+    if (table->symbols_tail) {
+        table->symbols_tail->next = new_symbol;
     } else {
-        /* Collision: add to front of linked list */
-        new_symbol->next = table->table[index];
-        table->table[index] = new_symbol;
+        table->symbols = new_symbol;
     }
+    table->symbols_tail = new_symbol;
 
     table->num_symbols++;
-    return 1;  /* Success */
+    return new_symbol;
 }
 
-/* Add a new array symbol to the table */
-int add_array_symbol(SymbolTable* table, const char* name, DataType type, int size, int line) {
-    /* First check if symbol already exists (redeclaration error) */
-    if (lookup_symbol(table, name)) {
+/* Add a new variable to the current scope */
+int add_symbol(SymbolTable* table, const char* name, DataType type, int line) {
+    Symbol* symbol = declare_symbol(table, table->current_scope, name,
+                                    SYMBOL_VARIABLE, type, line);
+    if (!symbol) {
         return 0;  /* Symbol already exists */
     }
 
-    /* Calculate hash index */
-    unsigned int index = hash(name, table->size);
+    claim_storage(table, symbol);
+    return 1;  /* Success */
+}
 
-    /* Create new symbol */
-    Symbol* new_symbol = (Symbol*)malloc(sizeof(Symbol));
-    if (!new_symbol) {
-        fprintf(stderr, "Fatal Error: Failed to allocate symbol\n");
-        exit(1);
+/* Add a new array to the current scope */
+int add_array_symbol(SymbolTable* table, const char* name, DataType type, int size, int line) {
+    Symbol* symbol = declare_symbol(table, table->current_scope, name,
+                                    SYMBOL_VARIABLE, type, line);
+    if (!symbol) {
+        return 0;  /* Symbol already exists */
     }
 
-    new_symbol->name = strdup(name);
-    new_symbol->kind = SYMBOL_VARIABLE;
-    new_symbol->type = type;
-    new_symbol->is_initialized = 1;  /* Arrays are considered initialized upon declaration */
-    new_symbol->is_array = 1;         /* This is an array */
-    new_symbol->array_size = size;    /* Store array size */
-    new_symbol->return_type = TYPE_UNKNOWN;
-    new_symbol->param_count = 0;
-    new_symbol->param_types = NULL;
-    new_symbol->param_names = NULL;
-    new_symbol->scope = strdup("global");  /* Default to global scope */
-    new_symbol->declaration_line = line;
-    new_symbol->next = NULL;
-
-    /* Insert at the beginning of the chain (for collision handling) */
-    if (table->table[index] == NULL) {
-        table->table[index] = new_symbol;
-    } else {
-        /* Collision: add to front of linked list */
-        new_symbol->next = table->table[index];
-        table->table[index] = new_symbol;
-    }
+    symbol->is_initialized = 1;  /* Arrays are considered initialized upon declaration */
+    symbol->is_array = 1;
+    symbol->array_size = size;
 
-    table->num_symbols++;
+    claim_storage(table, symbol);
     return 1;  /* Success */
 }
 
-/* Add a new function symbol to the table */
+/* Add a new function symbol to the global scope */
 int add_function_symbol(SymbolTable* table, const char* name, DataType return_type,
                         int param_count, DataType* param_types, char** param_names, int line) {
-    /* First check if symbol already exists (redeclaration error) */
-    if (lookup_symbol(table, name)) {
+    Symbol* symbol = declare_symbol(table, table->global_scope, name,
+                                    SYMBOL_FUNCTION, return_type, line);
+    if (!symbol) {
         return 0;  /* Symbol already exists */
     }
 
-    /* Calculate hash index */
-    unsigned int index = hash(name, table->size);
-
-    /* Create new symbol */
-    Symbol* new_symbol = (Symbol*)malloc(sizeof(Symbol));
-    if (!new_symbol) {
-        fprintf(stderr, "Fatal Error: Failed to allocate symbol\n");
-        exit(1);
-    }
-
-    new_symbol->name = strdup(name);
-    new_symbol->kind = SYMBOL_FUNCTION;
-    new_symbol->type = return_type;
-    new_symbol->is_initialized = 1;  /* Functions are always "initialized" */
-    new_symbol->is_array = 0;
-    new_symbol->array_size = 0;
-    new_symbol->return_type = return_type;
-    new_symbol->param_count = param_count;
+    symbol->is_initialized = 1;  /* Functions are always "initialized" */
+    symbol->return_type = return_type;
+    symbol->param_count = param_count;
 
     /* Allocate and copy parameter types */
     if (param_count > 0) {
-        new_symbol->param_types = (DataType*)malloc(param_count * sizeof(DataType));
-        new_symbol->param_names = (char**)malloc(param_count * sizeof(char*));
+        symbol->param_types = (DataType*)safe_malloc(param_count * sizeof(DataType), "parameter types");
+        symbol->param_names = (char**)safe_malloc(param_count * sizeof(char*), "parameter names");
         for (int i = 0; i < param_count; i++) {
-            new_symbol->param_types[i] = param_types[i];
-            new_symbol->param_names[i] = strdup(param_names[i]);
+            symbol->param_types[i] = param_types[i];
+            symbol->param_names[i] = intern_name(table, param_names[i]);
         }
-    } else {
-        new_symbol->param_types = NULL;
-        new_symbol->param_names = NULL;
     }
 
-    new_symbol->scope = strdup("global");  /* Functions are in global scope */
-    new_symbol->declaration_line = line;
-    new_symbol->next = NULL;
+    return 1;  /* Success */
+}
 
-    /* Insert at the beginning of the chain (for collision handling) */
-    if (table->table[index] == NULL) {
-        table->table[index] = new_symbol;
-    } else {
-        /* Collision: add to front of linked list */
-        new_symbol->next = table->table[index];
-        table->table[index] = new_symbol;
+/* Add function parameter to the current (function) scope */
+int add_parameter(SymbolTable* table, const char* name, DataType type, int line) {
+    Symbol* symbol = declare_symbol(table, table->current_scope, name,
+                                    SYMBOL_VARIABLE, type, line);
+    if (!symbol) {
+        return 0;  /* Duplicate parameter name */
     }
 
-    table->num_symbols++;
+    symbol->is_initialized = 1;  /* Parameters are initialized by the caller */
+
+    claim_storage(table, symbol);
     return 1;  /* Success */
 }
 
-/* Look up a symbol by name */
+/* Look up a symbol by name, walking from the innermost scope outwards */
 Symbol* lookup_symbol(SymbolTable* table, const char* name) {
-    unsigned int index = hash(name, table->size);
-    Symbol* current = table->table[index];
+    if (!table || !name) return NULL;
+    return lookup_symbol_hashed(table, name, hash(name));
+}
 
-    /* Search through the chain at this index */
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current;  /* Found it */
+/* Look up a symbol whose name hash the caller already computed */
+Symbol* lookup_symbol_hashed(SymbolTable* table, const char* name, unsigned int h) {
+    if (!table || !name) return NULL;
+
+    const char* interned = find_interned(table, name, h);
+    if (!interned) {
+        return NULL;  /* Name never declared anywhere */
+    }
+
+    for (Scope* scope = table->current_scope; scope; scope = scope->parent) {
+        Symbol* symbol = scope_find(scope, interned, h);
+        if (symbol) {
+            return symbol;
         }
-        current = current->next;
     }
 
     return NULL;  /* Not found */
 }
 
-/* Mark a symbol as initialized (called after assignment) */
-void mark_initialized(SymbolTable* table, const char* name) {
-    Symbol* symbol = lookup_symbol(table, name);
-    if (symbol) {
-        symbol->is_initialized = 1;
+/* Look up a symbol declared in the innermost scope only */
+Symbol* lookup_symbol_current_scope(SymbolTable* table, const char* name) {
+    if (!table || !name) return NULL;
+
+    unsigned int h = hash(name);
+    const char* interned = find_interned(table, name, h);
+    if (!interned) {
+        return NULL;
     }
+    return scope_find(table->current_scope, interned, h);
 }
 
-/* Mark a symbol as initialized in a specific scope */
-void mark_initialized_in_scope(SymbolTable* table, const char* name, const char* scope) {
-    Symbol* symbol = lookup_symbol_in_scope(table, name, scope);
+/* Mark a symbol as initialized (called after assignment) */
+void mark_initialized(SymbolTable* table, const char* name) {
+    Symbol* symbol = lookup_symbol(table, name);
     if (symbol) {
         symbol->is_initialized = 1;
     }
@@ -242,28 +442,20 @@ const char* type_to_string(DataType type) {
 /* Print the entire symbol table in a formatted way */
 void print_symbol_table(SymbolTable* table) {
     printf("+============================================================+\n");
-    printf("| %-20s %-10s %-12s %-10s |\n", "Variable", "Type", "Initialized", "Line");
+    printf("| %-16s %-6s %-12s %-14s %-6s |\n", "Variable", "Type", "Initialized", "Scope", "Line");
     printf("+============================================================+\n");
 
-    int count = 0;
-
-    /* Iterate through all buckets */
-    for (int i = 0; i < table->size; i++) {
-        Symbol* current = table->table[i];
-
-        /* Traverse the chain at this bucket */
-        while (current != NULL) {
-            printf("| %-20s %-10s %-12s %-10d |\n",
-                   current->name,
-                   type_to_string(current->type),
-                   current->is_initialized ? "Yes" : "No",
-                   current->declaration_line);
-            count++;
-            current = current->next;
-        }
+    /* Symbols are listed in declaration order */
+    for (Symbol* current = table->symbols; current != NULL; current = current->next) {
+        printf("| %-16s %-6s %-12s %-14s %-6d |\n",
+               current->name,
+               type_to_string(current->type),
+               current->is_initialized ? "Yes" : "No",
+               current->scope,
+               current->declaration_line);
     }
 
-    if (count == 0) {
+    if (table->num_symbols == 0) {
         printf("| %-58s |\n", "(No symbols in table)");
     }
 
@@ -275,99 +467,48 @@ void print_symbol_table(SymbolTable* table) {
 void free_symbol_table(SymbolTable* table) {
     if (!table) return;
 
-    /* Free all symbols in all buckets */
-    for (int i = 0; i < table->size; i++) {
-        Symbol* current = table->table[i];
+    /* Close any scopes left open, then the global scope */
+    while (table->current_scope != table->global_scope) {
+        pop_scope(table);
+    }
+    free(table->global_scope->slots);
+    free(table->global_scope);
 
-        while (current != NULL) {
-            Symbol* next = current->next;
-            free(current->name);  /* Free the duplicated name string */
-            free(current);        /* Free the symbol structure */
-            current = next;
-        }
+    /* Free all symbols */
+    Symbol* current = table->symbols;
+    while (current != NULL) {
+        Symbol* next = current->next;
+        free(current->param_types);
+        free(current->param_names);  /* Names themselves live in the pool */
+        free(current);
+        current = next;
     }
 
-    /* Free the table array and the table structure itself */
-    free(table->table);
+    /* Free the interned names */
+    for (int i = 0; i < table->name_capacity; i++) {
+        free(table->names[i]);
+    }
+    free(table->names);
+    free(table->name_hashes);
+    free(table->storage);
     free(table);
 }
 
 /* SCOPE MANAGEMENT FUNCTIONS */
 
-/* Add a symbol with specific scope */
-int add_symbol_with_scope(SymbolTable* table, const char* name, DataType type, int line, const char* scope) {
-    /* For scoped lookup, we need to check only in the current scope */
-    Symbol* existing = lookup_symbol_in_scope(table, name, scope);
-    if (existing && strcmp(existing->scope, scope) == 0) {
-        return 0;  /* Symbol already exists in this scope */
-    }
-
-    /* Calculate hash index */
-    unsigned int index = hash(name, table->size);
-
-    /* Create new symbol */
-    Symbol* new_symbol = (Symbol*)malloc(sizeof(Symbol));
-    if (!new_symbol) {
-        fprintf(stderr, "Fatal Error: Failed to allocate symbol\n");
-        exit(1);
-    }
-
-    new_symbol->name = strdup(name);
-    new_symbol->kind = SYMBOL_VARIABLE;
-    new_symbol->type = type;
-    new_symbol->is_initialized = 0;
-    new_symbol->is_array = 0;
-    new_symbol->array_size = 0;
-    new_symbol->return_type = TYPE_UNKNOWN;
-    new_symbol->param_count = 0;
-    new_symbol->param_types = NULL;
-    new_symbol->param_names = NULL;
-    new_symbol->scope = strdup(scope);  /* Set scope */
-    new_symbol->declaration_line = line;
-    new_symbol->next = NULL;
-
-    /* Insert at the beginning of the chain */
-    if (table->table[index] == NULL) {
-        table->table[index] = new_symbol;
-    } else {
-        new_symbol->next = table->table[index];
-        table->table[index] = new_symbol;
-    }
-
-    table->num_symbols++;
-    return 1;  /* Success */
+/* Open a new innermost scope - O(1), its map is allocated on first insert */
+void push_scope(SymbolTable* table, const char* name) {
+    table->current_scope = create_scope(intern_name(table, name), table->current_scope, 0);
 }
 
-/* Lookup symbol in specific scope first, then global */
-Symbol* lookup_symbol_in_scope(SymbolTable* table, const char* name, const char* current_scope) {
-    if (!table || !name) return NULL;
-
-    unsigned int index = hash(name, table->size);
-    Symbol* current = table->table[index];
-
-    /* First, search in the current scope */
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0 &&
-            current->scope && strcmp(current->scope, current_scope) == 0) {
-            return current;
-        }
-        current = current->next;
-    }
-
-    /* If not found in current scope, search in global scope */
-    current = table->table[index];
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0 &&
-            current->scope && strcmp(current->scope, "global") == 0) {
-            return current;
-        }
-        current = current->next;
+/* Close the innermost scope - O(1), symbols remain owned by table->symbols */
+void pop_scope(SymbolTable* table) {
+    Scope* scope = table->current_scope;
+    if (scope == table->global_scope) {
+        return;  /* The global scope is never popped */
     }
 
-    return NULL;  /* Symbol not found */
-}
-
-/* Add function parameter to symbol table */
-int add_parameter(SymbolTable* table, const char* name, DataType type, int line, const char* function_scope) {
-    return add_symbol_with_scope(table, name, type, line, function_scope);
+    table->current_scope = scope->parent;
+    free(scope->slots);
+    free(scope);
 }
@@ -5,6 +5,11 @@
  * This file defines the symbol table structure used for tracking
  * variables, their types, and scope information during compilation.
  * Essential for semantic analysis and type checking.
+ *
+ * The table is a stack of scopes (global, function body, {} block).
+ * Each scope is an open-addressing hash map keyed by interned names,
+ * so a lookup compares pointers instead of strings and the maps grow
+ * automatically when they pass their load factor.
  */
 
 #ifndef SYMTABLE_H
@@ -29,7 +34,9 @@ typedef enum {
 
 /* Symbol table entry - Represents one variable or function */
 typedef struct Symbol {
-    char* name;              /* Symbol name (identifier) */
+    char* name;              /* Symbol name (interned - owned by the table) */
+    int id;                  /* Dense symbol ID (declaration order, 0-based) */
+    unsigned int name_hash;  /* Cached hash of the name */
     SymbolKind kind;         /* Variable or function */
     DataType type;           /* Data type (int, void, etc.) */
     int is_initialized;      /* Flag: has this variable been assigned a value? */
@@ -41,49 +48,88 @@ typedef struct Symbol {
     int param_count;         /* Number of parameters */
     DataType* param_types;   /* Array of parameter types */
     char** param_names;      /* Array of parameter names */
+    struct Symbol* locals;   /* First parameter or local declared by the definition */
+    int local_count;         /* Parameters and locals of the definition (consecutive in the list) */
 
     /* Scope management */
-    char* scope;             /* Scope name (e.g., "global", "main", "addNumbers") */
+    char* scope;             /* Scope name (e.g., "global", "main", "block") - interned */
+    int scope_depth;         /* Nesting depth of the declaring scope (0 = global) */
+
+    /* Storage - variables are emitted under their storage name. A variable
+     * that shadows a visible symbol gets "name.depth", so it never shares
+     * the outer one's slot; others keep their name, so same-named locals of
+     * different functions or sibling blocks share one slot */
+    char* storage_name;      /* Name the storage is emitted under (interned) */
+    int owns_storage;        /* Flag: first variable with this storage name (emits the storage) */
+    int storage_size;        /* Elements reserved by the owner (max over all variables sharing it) */
 
     int declaration_line;    /* Source line where symbol was declared */
-    struct Symbol* next;     /* Next symbol in the hash chain (for collision handling) */
+    struct Symbol* next;     /* Next symbol in declaration order */
 } Symbol;
 
-/* Symbol Table - Hash table for efficient variable lookup */
+/* Scope - One level of the scope stack, an open-addressing map of symbols */
+typedef struct Scope {
+    const char* name;        /* Scope name (interned) */
+    Symbol** slots;          /* Hash slots keyed by interned name (NULL until first insert) */
+    int capacity;            /* Number of slots (power of two) */
+    int count;               /* Number of symbols declared in this scope */
+    int depth;               /* Nesting depth (0 = global) */
+    struct Scope* parent;    /* Enclosing scope */
+} Scope;
+
+/* Symbol Table - Scope stack plus the interned name pool */
 typedef struct SymbolTable {
-    Symbol** table;          /* Array of symbol pointers (hash table buckets) */
-    int size;               /* Size of the hash table */
-    int num_symbols;        /* Number of symbols currently stored */
+    Scope* current_scope;    /* Innermost open scope (top of the scope stack) */
+    Scope* global_scope;     /* Outermost scope (never popped) */
+
+    Symbol* symbols;         /* Every symbol ever declared, in declaration order */
+    Symbol* symbols_tail;    /* Last declared symbol (for efficient append) */
+    int num_symbols;         /* Number of symbols currently stored */
+
+    char** names;            /* Interned name pool (open addressing) */
+    unsigned int* name_hashes; /* Cached hash for each pool slot */
+    int name_capacity;       /* Pool slots (power of two) */
+    int name_count;          /* Interned names in the pool */
+
+    Symbol** storage;        /* Storage owners keyed by interned name (open addressing) */
+    int storage_capacity;    /* Storage map slots (power of two) */
+    int storage_count;       /* Distinct storage names */
 } SymbolTable;
 
 /* SYMBOL TABLE MANAGEMENT FUNCTIONS */
 
-/* Create a new symbol table with given size */
-SymbolTable* create_symbol_table(int size);
+/* Create a new symbol table; initial_capacity sizes the global scope */
+SymbolTable* create_symbol_table(int initial_capacity);
 
-/* Add a symbol to the table
- * Returns 1 on success, 0 if symbol already exists (redeclaration error) */
+/* Add a variable to the current scope
+ * Returns 1 on success, 0 if it already exists in this scope (redeclaration error) */
 int add_symbol(SymbolTable* table, const char* name, DataType type, int line);
 
-/* Add an array symbol to the table
- * Returns 1 on success, 0 if symbol already exists (redeclaration error) */
+/* Add an array to the current scope
+ * Returns 1 on success, 0 if it already exists in this scope (redeclaration error) */
 int add_array_symbol(SymbolTable* table, const char* name, DataType type, int size, int line);
 
-/* Add a function symbol to the table
+/* Add a function symbol to the global scope
  * Returns 1 on success, 0 if symbol already exists (redeclaration error) */
 int add_function_symbol(SymbolTable* table, const char* name, DataType return_type,
                         int param_count, DataType* param_types, char** param_names, int line);
 
-/* Look up a symbol by name
+/* Add a function parameter to the current scope (parameters are initialized by the caller) */
+int add_parameter(SymbolTable* table, const char* name, DataType type, int line);
+
+/* Look up a symbol by name, innermost scope first
  * Returns pointer to symbol if found, NULL otherwise */
 Symbol* lookup_symbol(SymbolTable* table, const char* name);
 
+/* Same as lookup_symbol, for callers that already hold hash(name) */
+Symbol* lookup_symbol_hashed(SymbolTable* table, const char* name, unsigned int name_hash);
+
+/* Look up a symbol declared in the current scope only */
+Symbol* lookup_symbol_current_scope(SymbolTable* table, const char* name);
+
 /* Mark a symbol as initialized (for use-before-init checking) */
 void mark_initialized(SymbolTable* table, const char* name);
 
-/* Mark a symbol as initialized in a specific scope */
-void mark_initialized_in_scope(SymbolTable* table, const char* name, const char* scope);
-
 /* Check if a symbol is initialized */
 int is_initialized(SymbolTable* table, const char* name);
 
@@ -98,16 +144,16 @@ const char* type_to_string(DataType type);
 
 /* SCOPE MANAGEMENT FUNCTIONS */
 
-/* Add a symbol with specific scope */
-int add_symbol_with_scope(SymbolTable* table, const char* name, DataType type, int line, const char* scope);
+/* Open a new innermost scope (function body or {} block) */
+void push_scope(SymbolTable* table, const char* name);
 
-/* Lookup symbol in specific scope first, then global */
-Symbol* lookup_symbol_in_scope(SymbolTable* table, const char* name, const char* current_scope);
+/* Close the innermost scope; its symbols stay in table->symbols for later phases */
+void pop_scope(SymbolTable* table);
 
-/* Add function parameter to symbol table */
-int add_parameter(SymbolTable* table, const char* name, DataType type, int line, const char* function_scope);
+/* Intern a name in the table's pool and return the shared copy */
+char* intern_name(SymbolTable* table, const char* name);
 
-/* HASH FUNCTION (Internal use) */
-unsigned int hash(const char* str, int table_size);
+/* HASH FUNCTION - djb2 over the whole string (also cached on AST name nodes) */
+unsigned int hash(const char* str);
 
 #endif /* SYMTABLE_H */
@@ -0,0 +1,36 @@
+// Test program for array element assignment
+// arr[i] = e stores into element i only; the other elements keep their
+// values, and the index may itself read the array.
+
+int data[5];
+
+int main() {
+    int local[3];
+    int i;
+    i = 0;
+    while (i < 5) {
+        data[i] = i * 10;
+        i = i + 1;
+    }
+    data[2] = 7;
+    data[data[1] / 10 + 3] = data[4] + 1;
+
+    i = 0;
+    while (i < 5) {
+        print(data[i]);
+        i = i + 1;
+    }
+
+    local[0] = 5;
+    local[1] = 0;
+    local[2] = local[0] * 2;
+    print(local[2] + local[1]);
+    return 0;
+}
+
+// expect: 0
+// expect: 10
+// expect: 7
+// expect: 30
+// expect: 41
+// expect: 10
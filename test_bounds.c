@@ -0,0 +1,70 @@
+// Test program for bounds checking
+// Every array access stays inside its array, and with --bounds-check -O2
+// the ranges pass can prove it for each one: constant indexes, a load
+// repeated after an identical check, and loop counters kept inside the
+// array by the loop test (i < 10, i <= 9, counting down, a do-while and
+// a bound passed in a variable that the test also limits).
+
+int a[10];
+int b[5];
+
+int main() {
+    int i;
+    int j;
+    int s;
+    int n;
+
+    // Constant indexes
+    a[0] = 7;
+    a[9] = 3;
+    b[4] = a[0] + a[9];
+    print(b[4]);
+
+    // i < 10 over a[10]
+    for (i = 0; i < 10; i = i + 1;) {
+        a[i] = i * i;
+    }
+
+    // i <= 9, and the same element read twice
+    s = 0;
+    i = 0;
+    while (i <= 9) {
+        s = s + a[i] - a[i] / 2;
+        i = i + 1;
+    }
+    print(s);
+
+    // Counting down from the last element
+    s = 0;
+    i = 9;
+    while (i >= 0) {
+        s = s * 2 + a[i] % 3;
+        i = i - 1;
+    }
+    print(s);
+
+    // do-while over b[5]
+    j = 0;
+    do {
+        b[j] = a[j + 5] - j;
+        j = j + 1;
+    } while (j < 5);
+    print(b[0] + b[4]);
+
+    // A variable bound that the test keeps below the array size
+    n = 3;
+    s = 0;
+    for (i = 0; i < n; i = i + 1;) {
+        if (i < 5) {
+            s = s + b[i];
+        }
+    }
+    print(s);
+    return 0;
+}
+
+// expect: 10
+// expect: 145
+// expect: 438
+// expect: 102
+// expect: 107
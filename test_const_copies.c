@@ -0,0 +1,27 @@
+// Test program for copies of constants
+// A variable copied from another that was just given a constant keeps
+// that constant, also when both are later read again.
+
+int g;
+
+int main() {
+    int x;
+    int y;
+    int z;
+    g = 5;
+    x = g;
+    print(x);
+    print(g);
+
+    y = 7;
+    z = y;
+    y = 1;
+    print(z + y);
+    print(x * g);
+    return 0;
+}
+
+// expect: 5
+// expect: 5
+// expect: 8
+// expect: 25
@@ -0,0 +1,33 @@
+// Test program for copies across calls
+// A copy of a global taken before a call keeps the old value even when
+// the callee assigns the global.
+
+int g;
+
+int set(int v) {
+    g = v;
+    return v + 1;
+}
+
+int main() {
+    int x;
+    int y;
+    g = 5;
+    x = g;
+    y = set(9);
+    print(x);
+    print(g);
+    print(y);
+
+    y = g;
+    g = set(20) + y;
+    print(y);
+    print(g);
+    return 0;
+}
+
+// expect: 5
+// expect: 9
+// expect: 10
+// expect: 9
+// expect: 30
@@ -0,0 +1,206 @@
+// Test program for loop rotation, jump threading and block layout
+// Rotated loops that run 0, 1 and many times (the guard must skip a loop
+// that would not run), a return in the middle of a loop (layout moves it
+// behind the hot code and inverts the branch), else-if chains and nested
+// ifs whose gotos chain into each other or into a return (flow threads
+// them). The output must be the same at every level.
+
+int a[10];
+
+// while: the guard skips the body when n <= 0
+int count_up(int n) {
+    int i;
+    int s;
+    s = 0;
+    i = 0;
+    while (i < n) {
+        s = s + i + 1;
+        i = i + 1;
+    }
+    return s * 100 + i;
+}
+
+// for with an inclusive bound: 0, 1 and several iterations
+int sum_range(int lo, int hi) {
+    int i;
+    int s;
+    s = 0;
+    for (i = lo; i <= hi; i = i + 1;) {
+        s = s + i;
+    }
+    return s;
+}
+
+// do-while: not guarded, the body runs at least once
+int at_least_once(int n) {
+    int k;
+    k = 0;
+    do {
+        k = k + 1;
+        n = n - 1;
+    } while (n > 0);
+    return k;
+}
+
+// A return in the middle of a loop: the index of the first match, or -1
+int find(int x) {
+    int i;
+    i = 0;
+    while (i < 10) {
+        if (a[i] == x) {
+            return i;
+        }
+        i = i + 1;
+    }
+    return 0 - 1;
+}
+
+// Two returns inside nested loops
+int first_pair(int total) {
+    int i;
+    int j;
+    i = 0;
+    while (i < 10) {
+        j = i;
+        while (j < 10) {
+            if (a[i] + a[j] == total) {
+                return i * 10 + j;
+            }
+            if (a[j] > 100) {
+                return 0 - 2;
+            }
+            j = j + 1;
+        }
+        i = i + 1;
+    }
+    return 0 - 1;
+}
+
+// else-if chain: every branch ends in a goto to the same join
+int classify(int x) {
+    int c;
+    if (x < 0) {
+        c = 1;
+    } else {
+        if (x == 0) {
+            c = 2;
+        } else {
+            if (x < 10) {
+                c = 3;
+            } else {
+                c = 4;
+            }
+        }
+    }
+    return c;
+}
+
+// Branches straight to a return: the gotos become returns
+int pick(int x, int y) {
+    if (x > y) {
+        if (x > 100) {
+            return 100;
+        } else {
+            return x;
+        }
+    } else {
+        if (y > 100) {
+            return 100;
+        }
+    }
+    return y;
+}
+
+// A loop whose body is an if-else chain with nothing after it
+int zigzag(int n) {
+    int i;
+    int s;
+    s = 0;
+    i = 0;
+    while (i < n) {
+        if (i % 3 == 0) {
+            s = s + 1;
+        } else {
+            if (i % 3 == 1) {
+                s = s * 2;
+            } else {
+                s = s - 3;
+            }
+        }
+        i = i + 1;
+    }
+    return s;
+}
+
+int main() {
+    int i;
+    for (i = 0; i < 10; i = i + 1;) {
+        a[i] = i * i - 3 * i;
+    }
+
+    print(count_up(0));
+    print(count_up(0 - 5));
+    print(count_up(1));
+    print(count_up(7));
+
+    print(sum_range(3, 2));
+    print(sum_range(4, 4));
+    print(sum_range(0 - 2, 5));
+
+    print(at_least_once(0));
+    print(at_least_once(1));
+    print(at_least_once(6));
+
+    print(find(0));
+    print(find(10));
+    print(find(54));
+    print(find(7));
+
+    print(first_pair(8));
+    print(first_pair(0 - 4));
+    print(first_pair(1000));
+
+    print(classify(0 - 7));
+    print(classify(0));
+    print(classify(9));
+    print(classify(10));
+
+    print(pick(5, 3));
+    print(pick(500, 3));
+    print(pick(3, 5));
+    print(pick(3, 500));
+
+    print(zigzag(0));
+    print(zigzag(1));
+    print(zigzag(10));
+    return 0;
+}
+
+// expect: 0
+// expect: 0
+// expect: 101
+// expect: 2807
+// expect: 0
+// expect: 4
+// expect: 12
+// expect: 1
+// expect: 1
+// expect: 6
+// expect: 0
+// expect: 5
+// expect: 9
+// expect: -1
+// expect: 15
+// expect: 11
+// expect: -1
+// expect: 1
+// expect: 2
+// expect: 3
+// expect: 4
+// expect: 5
+// expect: 100
+// expect: 5
+// expect: 100
+// expect: 0
+// expect: 1
+// expect: -6
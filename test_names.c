@@ -0,0 +1,31 @@
+// Test program for names that are also assembler words
+// Functions and variables may be named like x86 instructions or
+// registers.
+
+int rax;
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int loop(int n) {
+    int ret;
+    ret = 0;
+    while (n > 0) {
+        ret = ret + n;
+        n = n - 1;
+    }
+    return ret;
+}
+
+int main() {
+    int div;
+    rax = 4;
+    div = add(rax, 3);
+    print(div);
+    print(loop(div));
+    return 0;
+}
+
+// expect: 7
+// expect: 28
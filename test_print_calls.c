@@ -0,0 +1,30 @@
+// Test program for printing inside calls
+// print() works at any call depth and with any number of pending
+// arguments on the stack.
+
+int show(int v) {
+    print(v);
+    return v + 1;
+}
+
+int show3(int a, int b, int c) {
+    print(a + b + c);
+    return show(c);
+}
+
+int main() {
+    int x;
+    x = show(1);
+    print(x);
+    x = show3(show(10), 20, show(30));
+    print(x);
+    return 0;
+}
+
+// expect: 1
+// expect: 2
+// expect: 10
+// expect: 30
+// expect: 62
+// expect: 31
+// expect: 32
@@ -0,0 +1,80 @@
+// Test program for profile-guided optimization
+// Branches whose measured counts disagree with the static estimates: a
+// loop that usually does not run, a branch to a return that is usually
+// taken, an if whose else is the hot side and a function called from a
+// hot loop. --profile-use must not change the output, and a profile
+// written by any target and level must be the same.
+
+int hits[8];
+
+// Usually called with n <= 0, so the loop guard is the hot exit
+int rarely_loops(int n) {
+    int i;
+    int s;
+    s = 0;
+    i = 0;
+    while (i < n) {
+        s = s + i * 2;
+        i = i + 1;
+    }
+    return s;
+}
+
+// The early return is the common case
+int early_exit(int x) {
+    if (x % 8 != 0) {
+        return x % 8;
+    }
+    hits[0] = hits[0] + 1;
+    return 0 - x;
+}
+
+// The else side runs 9 times out of 10
+int mostly_else(int x) {
+    int r;
+    if (x % 10 == 0) {
+        r = x * 3;
+        hits[1] = hits[1] + 1;
+    } else {
+        r = x - 1;
+    }
+    return r;
+}
+
+// A return in the middle of the loop that is found early
+int search(int key) {
+    int i;
+    i = 0;
+    while (i < 8) {
+        if (hits[i % 2] + i >= key) {
+            return i;
+        }
+        i = i + 1;
+    }
+    return 0 - 1;
+}
+
+int main() {
+    int i;
+    int total;
+    total = 0;
+    for (i = 0; i < 200; i = i + 1;) {
+        total = total + rarely_loops(i % 50 - 45);
+        total = total + early_exit(i);
+        total = total + mostly_else(i);
+    }
+    print(total);
+    print(hits[0]);
+    print(hits[1]);
+    print(search(0));
+    print(search(27));
+    print(search(100));
+    return 0;
+}
+
+// expect: 21900
+// expect: 25
+// expect: 20
+// expect: 0
+// expect: 2
+// expect: -1
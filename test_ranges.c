@@ -0,0 +1,104 @@
+// Test program for value range analysis
+// Divisions and remainders whose operands the ranges pass proves
+// non-negative (loop counters, constants, values limited by an if) become
+// unsigned at -O2: a shift or mask for a power-of-two divisor and an
+// unsigned divide otherwise. Operands that may be negative - a counter
+// that goes below zero, a parameter, a global after a call - must stay
+// signed, so -7 / 2 is -3 and -7 % 4 is -3. The output must be the same
+// at every level and from a warm --incremental build.
+
+int g;
+int a[8];
+
+int touch() {
+    g = 0 - 9;
+    return 0;
+}
+
+// A counter bounded by a constant: shift, mask and unsigned divide
+int nonneg(int n) {
+    int i;
+    int s;
+    s = 0;
+    for (i = 0; i < 100; i = i + 1;) {
+        if (i < n) {
+            s = s + i / 4 + i % 8 + i / 3 + i % 5;
+        }
+    }
+    return s;
+}
+
+// The counter runs from -10 to 9: every division stays signed
+int mixed() {
+    int i;
+    int s;
+    s = 0;
+    for (i = 0 - 10; i < 10; i = i + 1;) {
+        s = s * 3 + i / 4 + i % 8 - i / 3 + i % 5;
+        s = s % 100000;
+    }
+    return s;
+}
+
+// Only the branch where x >= 0 may divide unsigned
+int limited(int x) {
+    if (x >= 0) {
+        if (x < 1000) {
+            return x / 16 * 100 + x % 7;
+        }
+    }
+    return x / 16 * 100 + x % 7;
+}
+
+// g is non-negative until the call, and unbounded after it
+int after_call() {
+    int r;
+    int q;
+    g = 37;
+    q = g / 2 + g % 4;
+    r = touch();
+    return q * 1000 + g / 2 * 10 + g % 4;
+}
+
+// Array elements are unbounded, the index is not
+int elements() {
+    int i;
+    int s;
+    for (i = 0; i < 8; i = i + 1;) {
+        a[i] = i * 5 - 17;
+    }
+    s = 0;
+    for (i = 0; i < 8; i = i + 1;) {
+        s = s + a[i] / 4 + a[i] % 3 + a[i / 2] / 2;
+    }
+    return s;
+}
+
+int main() {
+    print(nonneg(0));
+    print(nonneg(1));
+    print(nonneg(100));
+    print(mixed());
+    print(limited(999));
+    print(limited(0 - 999));
+    print(limited(5000));
+    print(after_call());
+    print(elements());
+    print(0 - 7 / 2);
+    print((0 - 7) / 2);
+    print((0 - 7) % 4);
+    return 0;
+}
+
+// expect: 0
+// expect: 0
+// expect: 3359
+// expect: -56331
+// expect: 6205
+// expect: -6205
+// expect: 31202
+// expect: 18959
+// expect: -37
+// expect: -3
+// expect: -3
+// expect: -3
@@ -0,0 +1,42 @@
+// Test program for recursion
+// Every call gets its own parameters, locals and temporaries, so a
+// recursive call does not overwrite the values of its caller.
+
+int fact(int n) {
+    int rest;
+    if (n < 2) {
+        return 1;
+    }
+    rest = fact(n - 1);
+    return n * rest;
+}
+
+int fib(int n) {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+int sum_down(int n, int acc) {
+    int pair[2];
+    pair[0] = n - 1;
+    pair[1] = acc + n;
+    if (n == 0) {
+        return acc;
+    }
+    return sum_down(pair[0], pair[1]);
+}
+
+int main() {
+    print(fact(10));
+    print(fib(15));
+    print(sum_down(100, 0));
+    print(fact(5) - fib(5));
+    return 0;
+}
+
+// expect: 3628800
+// expect: 610
+// expect: 5050
+// expect: 115
@@ -0,0 +1,27 @@
+// Test program for the remainder operator
+// % computes the remainder of a division, with the same precedence as
+// * and /.
+
+int main() {
+    int a;
+    int b;
+    a = 17;
+    b = 5;
+    print(a % b);
+    print(b % a);
+    print(100 % 7);
+
+    a = 12;
+    b = 4;
+    print(a % b);
+    print((a + 3) % b * 2);
+    print(a - a % 5);
+    return 0;
+}
+
+// expect: 2
+// expect: 5
+// expect: 2
+// expect: 0
+// expect: 6
+// expect: 10
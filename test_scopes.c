@@ -0,0 +1,55 @@
+// Test program for block scopes
+// Inner declarations shadow outer variables of the same name; each keeps
+// its own storage, so the outer variables still hold their values after
+// the block ends.
+
+int x;
+
+// The parameter shadows the global x, the block's x the parameter
+int shadow(int x) {
+    int y;
+    y = x + 1;
+    if (y > 0) {
+        int x;
+        x = 50;
+        y = y + x;
+    }
+    return y + x;
+}
+
+int main() {
+    int y;
+    int z;
+    x = 100;
+    y = 7;
+    z = 0;
+
+    if (x > 0) {
+        int x;
+        int y;
+        x = 6;
+        y = 55;
+        while (z < 1) {
+            int y;
+            y = 56;
+            z = y - x;
+        }
+        print(x);
+        print(y);
+    }
+
+    print(x);
+    print(y);
+    print(z);
+    print(shadow(3));
+    print(x);
+    return 0;
+}
+
+// expect: 6
+// expect: 55
+// expect: 100
+// expect: 7
+// expect: 50
+// expect: 57
+// expect: 100
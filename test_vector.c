@@ -0,0 +1,102 @@
+// Test program for loop vectorization
+// Counted array loops that run in vector registers at -O2 (2 lanes with
+// SSE2, 4 with AVX2). Trip counts leave 0, 1 and 3 iterations for the
+// scalar loop after the vector one; bounds are exclusive and inclusive;
+// bodies store and sum products. The output must match -O2 --no-vectorize.
+
+int a[24];
+int b[24];
+int c[24];
+
+// Elementwise fill with multiply terms
+int fill(int n) {
+    int i;
+    i = 0;
+    while (i < n) {
+        a[i] = i * 3 - 5;
+        b[i] = 7 - i;
+        i = i + 1;
+    }
+    return 0;
+}
+
+// Sum of products, i < n
+int dot(int n) {
+    int i;
+    int s;
+    s = 0;
+    i = 0;
+    while (i < n) {
+        s = s + a[i] * b[i];
+        i = i + 1;
+    }
+    return s;
+}
+
+// Sum and difference, i <= n
+int inclusive(int n) {
+    int i;
+    int s;
+    int d;
+    s = 0;
+    d = 100;
+    i = 0;
+    while (i <= n) {
+        s = s + a[i];
+        d = d - b[i] * 2;
+        i = i + 1;
+    }
+    return s * 1000 + d;
+}
+
+// Store of a product with index and scalar terms, then its sum
+int combine(int n, int k) {
+    int i;
+    int s;
+    i = 0;
+    while (i < n) {
+        c[i] = a[i] * b[i] - i * 2 + k;
+        i = i + 1;
+    }
+    s = 0;
+    i = 0;
+    while (i < n) {
+        s = s + c[i];
+        i = i + 1;
+    }
+    return s;
+}
+
+int main() {
+    int r;
+    r = fill(24);
+
+    print(dot(8));
+    print(dot(9));
+    print(dot(11));
+    print(dot(1));
+    print(dot(3));
+
+    print(inclusive(7));
+    print(inclusive(8));
+    print(inclusive(10));
+
+    print(combine(12, 4));
+    print(combine(13, 4));
+    print(combine(15, 0 - 6));
+    print(c[14]);
+    return 0;
+}
+
+// expect: 28
+// expect: 9
+// expect: -110
+// expect: -35
+// expect: -42
+// expect: 44044
+// expect: 63046
+// expect: 110056
+// expect: -306
+// expect: -481
+// expect: -1140
+// expect: -293
@@ -0,0 +1,212 @@
+/*
+ * TIMING.C - Phase Timing and Memory Instrumentation Implementation
+ * CST-405 Compiler Project
+ *
+ * Clocks: QueryPerformanceCounter / GetProcessTimes on Windows,
+ * CLOCK_MONOTONIC / CLOCK_PROCESS_CPUTIME_ID elsewhere. Allocation counts
+ * come from the per-thread counters kept by the safe_* allocators.
+ */
+
+#include "timing.h"
+#include "diagnostics.h"
+#include <string.h>
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+/* Clear a report */
+void reset_time_report(TimeReport* report) {
+    memset(report, 0, sizeof(*report));
+}
+
+/* Helper: find the entry for a phase, creating it on first use */
+static int find_phase(TimeReport* report, const char* name, int depth) {
+    for (int i = 0; i < report->phase_count; i++) {
+        if (report->phases[i].depth == depth && strcmp(report->phases[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    if (report->phase_count >= MAX_TIMED_PHASES) return -1;
+
+    PhaseTiming* phase = &report->phases[report->phase_count];
+    memset(phase, 0, sizeof(*phase));
+    phase->name = name;
+    phase->depth = depth;
+    return report->phase_count++;
+}
+
+/* Start timing a phase */
+void begin_phase(TimeReport* report, PhaseMark* mark, const char* name, int depth) {
+    mark->phase = report ? find_phase(report, name, depth) : -1;
+    if (mark->phase < 0) return;
+
+    mark->alloc_bytes = alloc_stats.bytes;
+    mark->allocations = alloc_stats.count;
+    mark->cpu_ms = process_cpu_ms();
+    mark->wall_ms = monotonic_ms();
+}
+
+/* Finish timing a phase */
+void end_phase(TimeReport* report, const PhaseMark* mark) {
+    if (!report || mark->phase < 0) return;
+
+    double wall = monotonic_ms();
+    double cpu = process_cpu_ms();
+
+    PhaseTiming* phase = &report->phases[mark->phase];
+    phase->calls++;
+    phase->wall_ms += wall - mark->wall_ms;
+    phase->cpu_ms += cpu - mark->cpu_ms;
+    phase->alloc_bytes += alloc_stats.bytes - mark->alloc_bytes;
+    phase->allocations += alloc_stats.count - mark->allocations;
+    phase->peak_rss_kb = peak_rss_kb();
+}
+
+/* Helper: sum the top-level phases */
+static PhaseTiming report_total(const TimeReport* report) {
+    PhaseTiming total;
+    memset(&total, 0, sizeof(total));
+    total.name = "total";
+
+    for (int i = 0; i < report->phase_count; i++) {
+        const PhaseTiming* phase = &report->phases[i];
+        if (phase->depth != 0) continue;
+        total.calls++;
+        total.wall_ms += phase->wall_ms;
+        total.cpu_ms += phase->cpu_ms;
+        total.alloc_bytes += phase->alloc_bytes;
+        total.allocations += phase->allocations;
+        if (phase->peak_rss_kb > total.peak_rss_kb) total.peak_rss_kb = phase->peak_rss_kb;
+    }
+    return total;
+}
+
+/* Helper: one table row */
+static void print_phase_row(const PhaseTiming* phase, FILE* out) {
+    char label[40];
+    snprintf(label, sizeof(label), "%*s%s", phase->depth * 2, "", phase->name);
+    fprintf(out, "| %-21s %10.3f %10.3f %12zu %9zu %10ld |\n",
+            label, phase->wall_ms, phase->cpu_ms, phase->alloc_bytes,
+            phase->allocations, phase->peak_rss_kb);
+}
+
+/* Print the report as a table */
+void print_time_report(const TimeReport* report, const char* filename, FILE* out) {
+    PhaseTiming total = report_total(report);
+
+    fprintf(out, "\n+===============================================================================+\n");
+    fprintf(out, "| %-77s |\n", "TIME REPORT");
+    if (filename) {
+        fprintf(out, "| %-77.77s |\n", filename);
+    }
+    fprintf(out, "+===============================================================================+\n");
+    fprintf(out, "| %-21s %10s %10s %12s %9s %10s |\n",
+            "Phase", "Wall ms", "CPU ms", "Alloc bytes", "Allocs", "Peak KiB");
+    fprintf(out, "+-------------------------------------------------------------------------------+\n");
+    for (int i = 0; i < report->phase_count; i++) {
+        print_phase_row(&report->phases[i], out);
+    }
+    fprintf(out, "+-------------------------------------------------------------------------------+\n");
+    print_phase_row(&total, out);
+    fprintf(out, "+===============================================================================+\n\n");
+}
+
+/* Helper: write a JSON string value */
+static void write_json_string(const char* text, FILE* out) {
+    fputc('"', out);
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if ((unsigned char)*p < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* Helper: the measurement fields of one phase */
+static void write_json_fields(const PhaseTiming* phase, FILE* out) {
+    fprintf(out, "\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"alloc_bytes\": %zu, "
+                 "\"allocations\": %zu, \"peak_rss_kb\": %ld",
+            phase->wall_ms, phase->cpu_ms, phase->alloc_bytes,
+            phase->allocations, phase->peak_rss_kb);
+}
+
+/* Print the report as a single-line JSON object */
+void write_time_report_json(const TimeReport* report, const char* filename, FILE* out) {
+    PhaseTiming total = report_total(report);
+
+    fprintf(out, "{\"file\": ");
+    write_json_string(filename ? filename : "", out);
+    fprintf(out, ", \"phases\": [");
+    for (int i = 0; i < report->phase_count; i++) {
+        const PhaseTiming* phase = &report->phases[i];
+        fprintf(out, "%s{\"name\": ", i > 0 ? ", " : "");
+        write_json_string(phase->name, out);
+        fprintf(out, ", \"depth\": %d, \"calls\": %d, ", phase->depth, phase->calls);
+        write_json_fields(phase, out);
+        fprintf(out, "}");
+    }
+    fprintf(out, "], \"total\": {");
+    write_json_fields(&total, out);
+    fprintf(out, "}}\n");
+}
+
+/* Monotonic wall-clock time in milliseconds */
+double monotonic_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* CPU time used by the process, in milliseconds */
+double process_cpu_ms(void) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) / 10000.0;   /* 100 ns units */
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* Peak resident set size in KiB */
+long peak_rss_kb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;     /* bytes on macOS */
+#else
+    return usage.ru_maxrss;            /* KiB on Linux */
+#endif
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * TIMING.H - Phase Timing and Memory Instrumentation
+ * CST-405 Compiler Project
+ *
+ * Records, for each compiler phase, the wall-clock time (monotonic clock),
+ * the process CPU time, the heap bytes and allocations made through the
+ * safe_* allocators, and the process peak resident set size. The driver
+ * prints the result with --time-report (table) or --time-report=json
+ * (one JSON object per compiled file).
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Maximum number of distinct phases in one report */
+#define MAX_TIMED_PHASES 32
+
+/* Report formats */
+#define TIME_REPORT_OFF   0
+#define TIME_REPORT_TABLE 1
+#define TIME_REPORT_JSON  2
+
+/* Measurements for one phase (summed over every time it ran) */
+typedef struct {
+    const char* name;           /* Phase name (string literal) */
+    int depth;                  /* Nesting depth (0 = top-level phase) */
+    int calls;                  /* Times the phase ran */
+    double wall_ms;             /* Elapsed wall-clock time */
+    double cpu_ms;              /* Process CPU time (all threads) */
+    size_t alloc_bytes;         /* Bytes allocated on the calling thread */
+    size_t allocations;         /* Allocations made on the calling thread */
+    long peak_rss_kb;           /* Process peak RSS when the phase finished */
+} PhaseTiming;
+
+/* Timing report for one compilation */
+typedef struct {
+    PhaseTiming phases[MAX_TIMED_PHASES];
+    int phase_count;
+} TimeReport;
+
+/* Start-of-phase snapshot */
+typedef struct {
+    int phase;                  /* Index of the phase entry (-1 = not recorded) */
+    double wall_ms;
+    double cpu_ms;
+    size_t alloc_bytes;
+    size_t allocations;
+} PhaseMark;
+
+/* TIMING FUNCTIONS */
+
+/* Clear a report */
+void reset_time_report(TimeReport* report);
+
+/* Start timing a phase. Entries are created on first use, so phases are
+ * listed in the order they started; a phase that runs again (an optimizer
+ * pass in every iteration) accumulates into the same entry.
+ * Does nothing if report is NULL. */
+void begin_phase(TimeReport* report, PhaseMark* mark, const char* name, int depth);
+
+/* Add the time and allocations since begin_phase to the phase entry */
+void end_phase(TimeReport* report, const PhaseMark* mark);
+
+/* Print the report as an aligned table */
+void print_time_report(const TimeReport* report, const char* filename, FILE* out);
+
+/* Print the report as a single-line JSON object */
+void write_time_report_json(const TimeReport* report, const char* filename, FILE* out);
+
+/* Monotonic wall-clock time in milliseconds */
+double monotonic_ms(void);
+
+/* CPU time used by the process so far, in milliseconds */
+double process_cpu_ms(void);
+
+/* Peak resident set size of the process in KiB (0 if unavailable) */
+long peak_rss_kb(void);
+
+#endif /* TIMING_H */
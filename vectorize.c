@@ -0,0 +1,437 @@
+/*
+ * VECTORIZE.C - Loop Vectorizer Implementation
+ * CST-405 Compiler Project
+ *
+ * The body of a candidate loop is walked once, turning every variable
+ * into a value tree over the state at the top of the iteration: the
+ * variables it does not assign (scalars), the induction variable, array
+ * elements it loads and the values other variables had when the
+ * iteration began (carried). A load of an element the iteration already
+ * stored gets the stored value instead. The loop then qualifies if
+ *
+ *   - it ends with i = i + 1 and a test of i against a bound,
+ *   - every load and store uses the index i,
+ *   - the stored values and reduction terms read nothing carried, and
+ *   - every variable read before it is assigned is i or a sum reduction.
+ *
+ * Only the last store to each array matters. The stores are ordered so
+ * that no value reads an element a store before it already replaced.
+ */
+
+#include "vectorize.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BINDINGS (2 * VECTOR_MAX_BODY)
+
+/* What a variable holds during the walk */
+typedef struct {
+    const char* name;
+    int start;                        /* Node of its value at the top of the iteration (-1 = not read) */
+    int value;                        /* Node of its current value */
+    int assigned;                     /* The body writes it */
+} Binding;
+
+/* Body walk state */
+typedef struct {
+    VectorLoop* loop;
+    Binding vars[MAX_BINDINGS];
+    int var_count;
+    int indexes[VECTOR_MAX_BODY];     /* Index node of every load and store */
+    int index_count;
+    int stored[VECTOR_MAX_ARRAYS];    /* Node each array was last given (-1 = none) */
+} Walk;
+
+/* Helper: add a node (-1 when the description is full) */
+static int new_node(VectorLoop* loop, VectorOp op) {
+    if (loop->node_count == VECTOR_MAX_NODES) return -1;
+    VectorNode* node = &loop->nodes[loop->node_count];
+    memset(node, 0, sizeof(*node));
+    node->op = op;
+    node->left = node->right = node->index = -1;
+    node->shift = -1;
+    node->size = 1;
+    return loop->node_count++;
+}
+
+/* Helper: node of a constant (shared by equal constants) */
+static int constant(VectorLoop* loop, long long value) {
+    for (int n = 0; n < loop->node_count; n++) {
+        if (loop->nodes[n].op == VECTOR_CONST && loop->nodes[n].value == value) return n;
+    }
+    int n = new_node(loop, VECTOR_CONST);
+    if (n >= 0) loop->nodes[n].value = value;
+    return n;
+}
+
+/* Helper: binding of a variable, created on first use (NULL when full) */
+static Binding* binding(Walk* walk, const char* name) {
+    for (int v = 0; v < walk->var_count; v++) {
+        if (strcmp(walk->vars[v].name, name) == 0) return &walk->vars[v];
+    }
+    if (walk->var_count == MAX_BINDINGS) return NULL;
+    Binding* var = &walk->vars[walk->var_count++];
+    var->name = name;
+    var->start = -1;
+    var->value = -1;
+    var->assigned = 0;
+    return var;
+}
+
+/* Helper: node of an operand's current value (-1 if there is none) */
+static int operand(Walk* walk, const char* name) {
+    if (!name) return -1;
+    if (is_literal(name)) return constant(walk->loop, strtoll(name, NULL, 10));
+
+    Binding* var = binding(walk, name);
+    if (!var) return -1;
+    if (var->value < 0) {
+        /* Read before any write: the value the iteration starts with
+         * (a scalar until the walk shows the body assigns it) */
+        var->start = var->value = new_node(walk->loop, VECTOR_SCALAR);
+        if (var->start < 0) return -1;
+        walk->loop->nodes[var->start].name = name;
+    }
+    return var->value;
+}
+
+/* Helper: give a variable a new value */
+static int assign(Walk* walk, const char* name, int value) {
+    Binding* var = name && value >= 0 ? binding(walk, name) : NULL;
+    if (!var) return 0;
+    var->value = value;
+    var->assigned = 1;
+    return 1;
+}
+
+/* Helper: node of left op right; two constants are folded (wrapping, as
+ * the 64-bit registers do) and a constant factor goes to the right */
+static int binary(VectorLoop* loop, VectorOp op, int left, int right) {
+    if (left < 0 || right < 0) return -1;
+    VectorNode* a = &loop->nodes[left];
+    VectorNode* b = &loop->nodes[right];
+    if (a->op == VECTOR_CONST && b->op == VECTOR_CONST) {
+        unsigned long long x = (unsigned long long)a->value;
+        unsigned long long y = (unsigned long long)b->value;
+        return constant(loop, (long long)(op == VECTOR_ADD ? x + y : op == VECTOR_SUB ? x - y : x * y));
+    }
+    if (op == VECTOR_MUL && a->op == VECTOR_CONST) {
+        int swap = left;
+        left = right;
+        right = swap;
+    }
+
+    int n = new_node(loop, op);
+    if (n < 0) return -1;
+    VectorNode* node = &loop->nodes[n];
+    const VectorNode* l = &loop->nodes[left];
+    const VectorNode* r = &loop->nodes[right];
+    node->left = left;
+    node->right = right;
+    node->size = 1 + l->size + r->size;
+    if (node->size > VECTOR_MAX_TREE) node->size = VECTOR_MAX_TREE + 1;
+
+    /* The result goes to the first scratch register, the right operand
+     * to the next; a full multiply needs two more */
+    int need = l->registers > 1 ? l->registers : 1;
+    if (op == VECTOR_MUL && r->op == VECTOR_CONST && r->value > 0 && (r->value & (r->value - 1)) == 0) {
+        for (node->shift = 0; (1LL << node->shift) != r->value; node->shift++) { }
+    } else {
+        if (1 + r->registers > need) need = 1 + r->registers;
+        if (op == VECTOR_MUL && need < 4) need = 4;
+    }
+    node->registers = need;
+    return n;
+}
+
+/* Helper: number of an array in the description (-1 if there are too many) */
+static int array_number(VectorLoop* loop, const char* name) {
+    for (int a = 0; a < loop->array_count; a++) {
+        if (strcmp(loop->arrays[a], name) == 0) return a;
+    }
+    if (loop->array_count == VECTOR_MAX_ARRAYS) return -1;
+    loop->arrays[loop->array_count] = name;
+    return loop->array_count++;
+}
+
+/* Helper: record arrays[array][index] = value (a later store to the
+ * same array replaces the value) */
+static int store(Walk* walk, int array, int index, int value) {
+    VectorLoop* loop = walk->loop;
+    int s = 0;
+    while (s < loop->store_count && loop->stores[s].array != array) s++;
+    if (s == VECTOR_MAX_STORES) return 0;
+    if (s == loop->store_count) loop->store_count++;
+    loop->stores[s].array = array;
+    loop->stores[s].value = value;
+    walk->stored[array] = value;
+    walk->indexes[walk->index_count++] = index;
+    return 1;
+}
+
+/* Helper: order the stores so that each comes after every value reading
+ * the elements it overwrites; 0 if they read each other's arrays */
+static int order_stores(VectorLoop* loop) {
+    unsigned reads[VECTOR_MAX_NODES];  /* Arrays a node loads from (bit per array) */
+    for (int n = 0; n < loop->node_count; n++) {
+        const VectorNode* node = &loop->nodes[n];
+        reads[n] = node->op == VECTOR_LOAD ? 1u << node->array
+                 : node->left >= 0 ? reads[node->left] | reads[node->right] : 0;
+    }
+
+    VectorStore ordered[VECTOR_MAX_STORES];
+    int placed = 0;
+    while (placed < loop->store_count) {
+        /* Next: a store no value still to be stored reads from */
+        int s = 0;
+        for (; s < loop->store_count; s++) {
+            if (loop->stores[s].array < 0) continue;
+            int blocked = 0;
+            for (int t = 0; t < loop->store_count && !blocked; t++) {
+                blocked = t != s && loop->stores[t].array >= 0 &&
+                          (reads[loop->stores[t].value] & (1u << loop->stores[s].array));
+            }
+            if (!blocked) break;
+        }
+        if (s == loop->store_count) return 0;
+        ordered[placed++] = loop->stores[s];
+        loop->stores[s].array = -1;
+    }
+    memcpy(loop->stores, ordered, placed * sizeof(VectorStore));
+    return 1;
+}
+
+/* Helper: walk one body instruction (0 if the loop cannot be vectorized) */
+static int walk_instruction(Walk* walk, const TACInstruction* inst) {
+    VectorLoop* loop = walk->loop;
+    switch (inst->opcode) {
+        case TAC_LOAD_CONST:
+            if (!is_literal(inst->op1)) return 0;
+            return assign(walk, inst->result, constant(loop, strtoll(inst->op1, NULL, 10)));
+
+        case TAC_ASSIGN:
+            return assign(walk, inst->result, operand(walk, inst->op1));
+
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL: {
+            VectorOp op = inst->opcode == TAC_ADD ? VECTOR_ADD : inst->opcode == TAC_SUB ? VECTOR_SUB : VECTOR_MUL;
+            int left = operand(walk, inst->op1);
+            int right = operand(walk, inst->op2);
+            return assign(walk, inst->result, binary(loop, op, left, right));
+        }
+
+        case TAC_ARRAY_LOAD: {
+            int array = array_number(loop, inst->op1);
+            int index = operand(walk, inst->op2);
+            if (array < 0 || index < 0) return 0;
+            walk->indexes[walk->index_count++] = index;
+            if (walk->stored[array] >= 0) {
+                /* Element stored earlier in the iteration (at index i, or
+                 * the index check rejects the loop) */
+                return assign(walk, inst->result, walk->stored[array]);
+            }
+            int n = new_node(loop, VECTOR_LOAD);
+            if (n < 0) return 0;
+            loop->nodes[n].array = array;
+            loop->nodes[n].index = index;
+            loop->nodes[n].registers = 1;
+            return assign(walk, inst->result, n);
+        }
+
+        case TAC_ARRAY_STORE: {
+            int array = array_number(loop, inst->result);
+            int index = operand(walk, inst->op1);
+            int value = operand(walk, inst->op2);
+            return array >= 0 && index >= 0 && value >= 0 && store(walk, array, index, value);
+        }
+
+        case TAC_RELOP:
+            operand(walk, inst->op1);
+            operand(walk, inst->op2);
+            return assign(walk, inst->result, new_node(loop, VECTOR_OTHER));
+
+        default:
+            return 0;
+    }
+}
+
+/* Helper: is n the counter after its step, start + 1 with start the
+ * value some variable began the iteration with? Returns that variable. */
+static Binding* counter_step(Walk* walk, int n) {
+    const VectorLoop* loop = walk->loop;
+    if (n < 0 || loop->nodes[n].op != VECTOR_ADD) return NULL;
+    int start = loop->nodes[n].left;
+    int one = loop->nodes[n].right;
+    if (loop->nodes[start].op == VECTOR_CONST) {
+        start = one;
+        one = loop->nodes[n].left;
+    }
+    if (loop->nodes[one].op != VECTOR_CONST || loop->nodes[one].value != 1) return NULL;
+
+    for (int v = 0; v < walk->var_count; v++) {
+        Binding* var = &walk->vars[v];
+        if (var->start == start) return var->value == n ? var : NULL;
+    }
+    return NULL;
+}
+
+/* Helper: split the final value of reduction variable var into the terms
+ * added to (or subtracted from) its start value; 0 if it is not a sum */
+static int split_reduction(Walk* walk, const Binding* var, const char* tainted) {
+    VectorLoop* loop = walk->loop;
+    char depends[VECTOR_MAX_NODES];
+    for (int n = 0; n < loop->node_count; n++) {
+        const VectorNode* node = &loop->nodes[n];
+        depends[n] = n == var->start ||
+                     (node->left >= 0 && (depends[node->left] || depends[node->right]));
+    }
+    if (loop->accumulator_count == VECTOR_MAX_TERMS) return 0;
+    int accumulator = loop->accumulator_count++;
+    loop->accumulators[accumulator] = var->name;
+
+    int n = var->value;
+    while (n != var->start) {
+        const VectorNode* node = &loop->nodes[n];
+        int term;
+        int subtract = 0;
+        if (node->op == VECTOR_ADD && depends[node->left] && !depends[node->right]) {
+            term = node->right;
+            n = node->left;
+        } else if (node->op == VECTOR_ADD && depends[node->right] && !depends[node->left]) {
+            term = node->left;
+            n = node->right;
+        } else if (node->op == VECTOR_SUB && depends[node->left] && !depends[node->right]) {
+            term = node->right;
+            subtract = 1;
+            n = node->left;
+        } else {
+            return 0;
+        }
+        if (tainted[term] || loop->nodes[term].size > VECTOR_MAX_TREE ||
+            loop->term_count == VECTOR_MAX_TERMS) {
+            return 0;
+        }
+        VectorTerm* t = &loop->terms[loop->term_count++];
+        t->accumulator = accumulator;
+        t->value = term;
+        t->subtract = subtract;
+    }
+    return 1;
+}
+
+/* Helper: mark the nodes the vector loop evaluates */
+static void mark_used(VectorLoop* loop, int n) {
+    VectorNode* node = &loop->nodes[n];
+    if (node->used) return;
+    node->used = 1;
+    if (node->op == VECTOR_INDEX) loop->uses_index = 1;
+    if (node->left >= 0) {
+        mark_used(loop, node->left);
+        if (node->shift < 0) mark_used(loop, node->right);
+    }
+}
+
+/* Does the loop starting at label qualify? */
+int find_vector_loop(const TACInstruction* label, VectorLoop* loop) {
+    Walk walk;
+    memset(&walk, 0, sizeof(walk));
+    memset(loop, 0, sizeof(*loop));
+    walk.loop = loop;
+    for (int a = 0; a < VECTOR_MAX_ARRAYS; a++) walk.stored[a] = -1;
+
+    /* Straight-line body up to the relop and the jump back to label */
+    const TACInstruction* inst = label->next;
+    const TACInstruction* relop = NULL;
+    for (int count = 0; ; count++, inst = inst->next) {
+        if (!inst || count == VECTOR_MAX_BODY) return 0;
+        if (inst->opcode == TAC_IF_TRUE) break;
+        if (relop || !walk_instruction(&walk, inst)) return 0;
+        if (inst->opcode == TAC_RELOP) relop = inst;
+    }
+    if (!relop || strcmp(inst->label, label->label) != 0 || !inst->op1 ||
+        strcmp(inst->op1, relop->result) != 0) {
+        return 0;
+    }
+
+    /* i < n, i <= n, n > i or n >= i, with i just stepped by one */
+    const char* op = relop->label;
+    int reversed = strcmp(op, ">") == 0 || strcmp(op, ">=") == 0;
+    if (!reversed && strcmp(op, "<") != 0 && strcmp(op, "<=") != 0) return 0;
+    loop->inclusive = op[1] == '=';
+    Binding* counter = counter_step(&walk, operand(&walk, reversed ? relop->op2 : relop->op1));
+    int bound = operand(&walk, reversed ? relop->op1 : relop->op2);
+    if (!counter || bound < 0) return 0;
+    loop->index = counter->name;
+
+    /* Values the iteration starts with: the index, or carried if the
+     * body assigns the variable */
+    for (int v = 0; v < walk.var_count; v++) {
+        Binding* var = &walk.vars[v];
+        if (var->start < 0) continue;
+        if (var == counter) {
+            loop->nodes[var->start].op = VECTOR_INDEX;
+        } else if (var->assigned) {
+            loop->nodes[var->start].op = VECTOR_CARRIED;
+        }
+    }
+
+    const VectorNode* limit = &loop->nodes[bound];
+    if (limit->op == VECTOR_SCALAR) {
+        loop->bound = limit->name;
+    } else if (limit->op == VECTOR_CONST && limit->value > -(1LL << 31) && limit->value < (1LL << 31)) {
+        loop->bound_value = limit->value;
+    } else {
+        return 0;
+    }
+
+    /* Every access at index i */
+    for (int k = 0; k < walk.index_count; k++) {
+        if (walk.indexes[k] != counter->start) return 0;
+    }
+
+    /* Values that differ between iterations in ways the lanes cannot
+     * follow */
+    char tainted[VECTOR_MAX_NODES];
+    for (int n = 0; n < loop->node_count; n++) {
+        const VectorNode* node = &loop->nodes[n];
+        tainted[n] = node->op == VECTOR_CARRIED || node->op == VECTOR_OTHER ||
+                     (node->left >= 0 && (tainted[node->left] || tainted[node->right]));
+    }
+
+    /* Variables read before they are written must be sums */
+    for (int v = 0; v < walk.var_count; v++) {
+        const Binding* var = &walk.vars[v];
+        if (var->start >= 0 && var->assigned && var != counter && !split_reduction(&walk, var, tainted)) {
+            return 0;
+        }
+    }
+
+    for (int s = 0; s < loop->store_count; s++) {
+        int value = loop->stores[s].value;
+        if (tainted[value] || loop->nodes[value].size > VECTOR_MAX_TREE) return 0;
+    }
+    if (loop->store_count + loop->term_count == 0 || !order_stores(loop)) return 0;
+
+    /* Registers: accumulators, constants and scalars (loaded once), the
+     * index lanes and their step, and scratch for the deepest value */
+    int scratch = 2;
+    for (int s = 0; s < loop->store_count; s++) {
+        mark_used(loop, loop->stores[s].value);
+        if (loop->nodes[loop->stores[s].value].registers > scratch) {
+            scratch = loop->nodes[loop->stores[s].value].registers;
+        }
+    }
+    for (int t = 0; t < loop->term_count; t++) {
+        mark_used(loop, loop->terms[t].value);
+        if (loop->nodes[loop->terms[t].value].registers > scratch) {
+            scratch = loop->nodes[loop->terms[t].value].registers;
+        }
+    }
+    loop->registers = loop->accumulator_count + scratch + (loop->uses_index ? 2 : 0);
+    for (int n = 0; n < loop->node_count; n++) {
+        const VectorNode* node = &loop->nodes[n];
+        if (node->used && (node->op == VECTOR_CONST || node->op == VECTOR_SCALAR)) loop->registers++;
+    }
+    return loop->registers <= VECTOR_REGISTERS;
+}
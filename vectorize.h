@@ -0,0 +1,113 @@
+/*
+ * VECTORIZE.H - Loop Vectorizer Header
+ * CST-405 Compiler Project
+ *
+ * Finds the counted array loops of the optimized TAC that can run several
+ * iterations at once, one per lane of a vector register. A loop qualifies
+ * when it is one rotated block
+ *
+ *     L:  body
+ *         i = i + 1
+ *         t = i < n                (or i <= n; n a constant or a variable
+ *         if_true t goto L          the loop does not assign)
+ *
+ * whose body only adds, subtracts and multiplies scalars, reads a[i] and
+ * writes a[i] - always at index i, so no iteration sees what another one
+ * stored. Every scalar the body assigns must be either private (written
+ * before it is read, like the temporaries) or a sum reduction
+ * (s = s + e, s = s - e, with e independent of s). Calls, divisions,
+ * other branches, bounds checks and profile counters rule a loop out.
+ *
+ * The description is target-neutral: the x86-64 assembly generator
+ * (codegen.c) runs it as a vector loop in front of the scalar one, which
+ * then finishes the last iterations (always at least one, so private
+ * scalars end up with the values of the last iteration).
+ */
+
+#ifndef VECTORIZE_H
+#define VECTORIZE_H
+
+#include "ircode.h"
+
+#define VECTOR_MAX_BODY    64         /* Instructions in a loop body */
+#define VECTOR_MAX_NODES   256        /* Values a loop description holds */
+#define VECTOR_MAX_ARRAYS  6          /* Arrays a loop may access */
+#define VECTOR_MAX_STORES  16
+#define VECTOR_MAX_TERMS   16
+#define VECTOR_MAX_TREE    48         /* Operations one stored or summed value may take */
+#define VECTOR_REGISTERS   16         /* Vector registers of the target */
+
+/* Instruction sets the loops can be generated for */
+typedef enum {
+    VECTOR_NONE,                      /* Leave loops scalar */
+    VECTOR_SSE2,                      /* xmm registers, 2 lanes (every x86-64 CPU) */
+    VECTOR_AVX2                       /* ymm registers, 4 lanes (--avx2) */
+} VectorISA;
+
+/* Kind of value */
+typedef enum {
+    VECTOR_CONST,                     /* value in every lane */
+    VECTOR_SCALAR,                    /* name, a variable the loop does not assign */
+    VECTOR_INDEX,                     /* The induction variable: i, i+1, ... */
+    VECTOR_LOAD,                      /* arrays[array][i] */
+    VECTOR_ADD,                       /* left + right */
+    VECTOR_SUB,                       /* left - right */
+    VECTOR_MUL,                       /* left * right */
+    VECTOR_CARRIED,                   /* name as the previous iteration left it */
+    VECTOR_OTHER                      /* Anything else (a comparison) */
+} VectorOp;
+
+/* One value of the loop body, as a function of the lane's iteration */
+typedef struct {
+    VectorOp op;
+    long long value;                  /* VECTOR_CONST */
+    const char* name;                 /* VECTOR_SCALAR, VECTOR_CARRIED */
+    int array;                        /* VECTOR_LOAD: number in VectorLoop.arrays */
+    int index;                        /* VECTOR_LOAD: node of the index */
+    int left, right;                  /* Operand nodes of VECTOR_ADD/SUB/MUL */
+    int shift;                        /* VECTOR_MUL by a power of two: its log2 (right is unused), else -1 */
+    int size;                         /* Operations in the expanded tree (at most VECTOR_MAX_TREE + 1) */
+    int registers;                    /* Scratch registers evaluating it needs */
+    int used;                         /* Evaluated by the vector loop */
+} VectorNode;
+
+/* arrays[array][i] = value at the end of each iteration */
+typedef struct {
+    int array;
+    int value;
+} VectorStore;
+
+/* accumulators[accumulator] += value (or -= value) each iteration */
+typedef struct {
+    int accumulator;
+    int value;
+    int subtract;
+} VectorTerm;
+
+/* A loop that can be vectorized */
+typedef struct {
+    const char* index;                /* Induction variable */
+    const char* bound;                /* Variable it is compared with (NULL = bound_value) */
+    long long bound_value;            /* Constant bound (fits 32 bits) */
+    int inclusive;                    /* i <= bound instead of i < bound */
+    const char* arrays[VECTOR_MAX_ARRAYS];
+    int array_count;
+    const char* accumulators[VECTOR_MAX_TERMS];  /* Reduction variables */
+    int accumulator_count;
+    VectorNode nodes[VECTOR_MAX_NODES];
+    int node_count;
+    VectorStore stores[VECTOR_MAX_STORES];       /* In the order they are to be done */
+    int store_count;
+    VectorTerm terms[VECTOR_MAX_TERMS];
+    int term_count;
+    int uses_index;                   /* Some evaluated value reads the induction variable */
+    int registers;                    /* Vector registers the loop needs in all */
+} VectorLoop;
+
+/* VECTORIZER FUNCTIONS */
+
+/* Does the loop starting at label (a TAC_LABEL) qualify? Fills loop and
+ * returns 1 if it does, returns 0 otherwise */
+int find_vector_loop(const TACInstruction* label, VectorLoop* loop);
+
+#endif /* VECTORIZE_H */
@@ -0,0 +1,124 @@
+/*
+ * WORKPOOL.C - Parallel Work Pool Implementation
+ * CST-405 Compiler Project
+ *
+ * Each worker repeatedly claims the next unprocessed item index under a
+ * lock and runs the work function on it. POSIX threads are used on
+ * Linux/macOS and native threads on Windows.
+ */
+
+#include "workpool.h"
+#include "diagnostics.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE WorkThread;
+typedef CRITICAL_SECTION WorkLock;
+#define lock_init(l)    InitializeCriticalSection(l)
+#define lock_acquire(l) EnterCriticalSection(l)
+#define lock_release(l) LeaveCriticalSection(l)
+#define lock_destroy(l) DeleteCriticalSection(l)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t WorkThread;
+typedef pthread_mutex_t WorkLock;
+#define lock_init(l)    pthread_mutex_init(l, NULL)
+#define lock_acquire(l) pthread_mutex_lock(l)
+#define lock_release(l) pthread_mutex_unlock(l)
+#define lock_destroy(l) pthread_mutex_destroy(l)
+#endif
+
+/* Shared state for one run_parallel call */
+typedef struct {
+    WorkFunction fn;            /* Work function */
+    void* context;              /* Caller's context */
+    int count;                  /* Number of items */
+    int next;                   /* Next unclaimed item */
+    WorkLock lock;              /* Protects next */
+} WorkQueue;
+
+/* Worker loop - claim items until none are left */
+static void work_loop(WorkQueue* queue) {
+    for (;;) {
+        lock_acquire(&queue->lock);
+        int index = queue->next < queue->count ? queue->next++ : -1;
+        lock_release(&queue->lock);
+
+        if (index < 0) break;
+        queue->fn(queue->context, index);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) {
+    work_loop((WorkQueue*)arg);
+    return 0;
+}
+#else
+static void* worker_main(void* arg) {
+    work_loop((WorkQueue*)arg);
+    return NULL;
+}
+#endif
+
+/* Run every item on up to num_threads threads */
+void run_parallel(int num_threads, int count, WorkFunction fn, void* context) {
+    if (num_threads > count) num_threads = count;
+
+    if (num_threads <= 1) {
+        for (int i = 0; i < count; i++) {
+            fn(context, i);
+        }
+        return;
+    }
+
+    WorkQueue queue;
+    queue.fn = fn;
+    queue.context = context;
+    queue.count = count;
+    queue.next = 0;
+    lock_init(&queue.lock);
+
+    /* The calling thread works too, so start num_threads - 1 helpers */
+    WorkThread* threads = (WorkThread*)safe_malloc((num_threads - 1) * sizeof(WorkThread), "worker threads");
+
+    int started = 0;
+    for (int i = 0; i < num_threads - 1; i++) {
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, worker_main, &queue, 0, NULL);
+        if (!threads[i]) break;
+#else
+        if (pthread_create(&threads[i], NULL, worker_main, &queue) != 0) break;
+#endif
+        started++;
+    }
+
+    work_loop(&queue);
+
+    for (int i = 0; i < started; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    free(threads);
+    lock_destroy(&queue.lock);
+}
+
+/* Number of online processors */
+int available_processors(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
@@ -0,0 +1,25 @@
+/*
+ * WORKPOOL.H - Parallel Work Pool Header
+ * CST-405 Compiler Project
+ *
+ * A small thread pool for running independent work items (per-function
+ * optimization and code generation). Items are claimed in index order by
+ * the worker threads; callers write results into per-item slots so the
+ * final output can be assembled in source order and stays deterministic.
+ */
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+/* Work function - processes item `index` using the shared context */
+typedef void (*WorkFunction)(void* context, int index);
+
+/* Run fn(context, i) for every i in [0, count) on up to num_threads threads.
+ * Returns when every item has been processed. With num_threads <= 1 the
+ * items run on the calling thread in order. */
+void run_parallel(int num_threads, int count, WorkFunction fn, void* context);
+
+/* Number of online processors (at least 1) */
+int available_processors(void);
+
+#endif /* WORKPOOL_H */